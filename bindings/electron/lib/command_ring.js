@@ -0,0 +1,138 @@
+'use strict';
+
+// Producer side of the engine's shared command ring
+// (include/core/shared_command_ring.h). Commands are encoded into a
+// SharedArrayBuffer and published with Atomics; the audio callback drains
+// them directly, so a GO never crosses N-API on the hot path.
+//
+//   const { CommandRing } = require('shared-audio-core-node/lib/command_ring');
+//   const ring = CommandRing.create(256);
+//   audio.attachCommandRing(ring.view);
+//   ring.startCue('q12');
+//
+// One producer per ring. The ring may be handed to a worker with
+// postMessage(ring.buffer) and wrapped there with new CommandRing(buffer).
+
+const MAGIC = 0x52434153; // "SACR"
+const VERSION = 1;
+
+// Header (byte offsets)
+const WRITE_INDEX_OFFSET = 0;
+const READ_INDEX_OFFSET = 64;
+const CAPACITY_OFFSET = 128;
+const RECORD_BYTES_OFFSET = 132;
+const MAGIC_OFFSET = 136;
+const VERSION_OFFSET = 140;
+const DROPPED_OFFSET = 144;
+const HEADER_BYTES = 256;
+
+// Record (byte offsets)
+const RECORD_BYTES = 96;
+const TYPE_OFFSET = 0;
+const ID_LENGTH_OFFSET = 4;
+const PARAM1_OFFSET = 8;
+const PARAM2_OFFSET = 16;
+const ID_OFFSET = 24;
+const MAX_ID_BYTES = 63;
+
+// AudioThreadMessage::Type
+const CommandType = Object.freeze({
+    START_CUE: 1,
+    STOP_CUE: 2,
+    SET_VOLUME: 3,
+    SET_PAN: 4,
+    SEEK: 7
+});
+
+class CommandRing {
+    // New ring with room for `capacity` commands (rounded up to a power of two)
+    static create(capacity = 256) {
+        let size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        const buffer = new SharedArrayBuffer(HEADER_BYTES + size * RECORD_BYTES);
+        const header = new DataView(buffer);
+        header.setUint32(CAPACITY_OFFSET, size, true);
+        header.setUint32(RECORD_BYTES_OFFSET, RECORD_BYTES, true);
+        header.setUint32(MAGIC_OFFSET, MAGIC, true);
+        header.setUint32(VERSION_OFFSET, VERSION, true);
+        return new CommandRing(buffer);
+    }
+
+    constructor(buffer) {
+        this.buffer = buffer;
+        this.view = new Uint8Array(buffer); // pass to attachCommandRing
+        this.words = new Int32Array(buffer, 0, HEADER_BYTES / 4);
+        this.data = new DataView(buffer);
+        this.capacity = this.data.getUint32(CAPACITY_OFFSET, true);
+        this.mask = this.capacity - 1;
+        this.encoder = new TextEncoder();
+
+        if (this.data.getUint32(MAGIC_OFFSET, true) !== MAGIC || this.capacity === 0) {
+            throw new Error('Not a command ring buffer');
+        }
+
+        // Pre-built id views so encoding a command allocates nothing
+        this.idViews = [];
+        for (let i = 0; i < this.capacity; ++i) {
+            const offset = HEADER_BYTES + i * RECORD_BYTES + ID_OFFSET;
+            this.idViews.push(new Uint8Array(buffer, offset, MAX_ID_BYTES));
+        }
+    }
+
+    startCue(cueId) {
+        return this.push(CommandType.START_CUE, cueId, 0, 0);
+    }
+
+    stopCue(cueId) {
+        return this.push(CommandType.STOP_CUE, cueId, 0, 0);
+    }
+
+    setCueVolume(cueId, volume) {
+        return this.push(CommandType.SET_VOLUME, cueId, volume, 0);
+    }
+
+    setCuePan(cueId, pan) {
+        return this.push(CommandType.SET_PAN, cueId, pan, 0);
+    }
+
+    seekCue(cueId, positionSeconds) {
+        return this.push(CommandType.SEEK, cueId, positionSeconds, 0);
+    }
+
+    // Returns false (and counts a drop) if the engine has not caught up
+    push(type, cueId, param1, param2) {
+        const write = Atomics.load(this.words, WRITE_INDEX_OFFSET / 4) >>> 0;
+        const read = Atomics.load(this.words, READ_INDEX_OFFSET / 4) >>> 0;
+        if (((write - read) >>> 0) >= this.capacity) {
+            Atomics.add(this.words, DROPPED_OFFSET / 4, 1);
+            return false;
+        }
+
+        const slot = write & this.mask;
+        const record = HEADER_BYTES + slot * RECORD_BYTES;
+        const { written } = this.encoder.encodeInto(cueId, this.idViews[slot]);
+        this.data.setUint32(record + TYPE_OFFSET, type, true);
+        this.data.setUint32(record + ID_LENGTH_OFFSET, written, true);
+        this.data.setFloat64(record + PARAM1_OFFSET, param1, true);
+        this.data.setFloat32(record + PARAM2_OFFSET, param2, true);
+
+        // Publishes the record: Atomics are sequentially consistent
+        Atomics.store(this.words, WRITE_INDEX_OFFSET / 4, (write + 1) | 0);
+        return true;
+    }
+
+    get pending() {
+        const write = Atomics.load(this.words, WRITE_INDEX_OFFSET / 4) >>> 0;
+        const read = Atomics.load(this.words, READ_INDEX_OFFSET / 4) >>> 0;
+        return (write - read) >>> 0;
+    }
+
+    get dropped() {
+        return Atomics.load(this.words, DROPPED_OFFSET / 4) >>> 0;
+    }
+}
+
+module.exports = { CommandRing, CommandType };
@@ -1,12 +1,103 @@
 #include <napi.h>
 #include "shared_audio/shared_audio_core.h"
+#include "processing/mix_graph.h"
+#include "processing/plugin_host.h"
+#include "processing/level_meter.h"
+#include "processing/loudness_analyzer.h"
+#include "processing/audio_asset_cache.h"
+#include "processing/spectrum_analyzer.h"
+#include "processing/input_router.h"
+#include "io/multitrack_recorder.h"
+#include "io/multitrack_player.h"
+#include "io/read_scheduler.h"
+#include "show_control/cue_audio_manager.h"
+#include "show_control/scene_manager.h"
+#include "show_control/osc_server.h"
+#include "show_control/midi_trigger_input.h"
+#ifndef _WIN32
+#include "host/engine_host.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <map>
 
 using namespace SharedAudio;
 
-// Global audio core instance
-static std::unique_ptr<SharedAudioCore> g_audio_core = nullptr;
+// Spectrum analyzers created from JS, keyed by id. Shared so a frame buffer
+// still referenced by JS outlives destroySpectrumAnalyzer.
+struct SpectrumTapEntry {
+    std::shared_ptr<SpectrumAnalyzer> analyzer;
+    int bus_index; // -1 = device outputs
+};
+
+// Meter polling state - one per meter bank, only touched from the JS thread
+struct MeterPollState {
+    MeterBallistics ballistics;
+    std::vector<MeterValues> values;
+    std::vector<MeterReading> readings;
+    std::chrono::steady_clock::time_point last_poll = std::chrono::steady_clock::now();
+};
+
+// Everything one engine owns. Module-level functions act on the default
+// engine of the calling environment; every AudioEngine object owns its own,
+// so engines on different devices share nothing.
+struct EngineContext {
+    EngineContext() = default;
+    EngineContext(const EngineContext&) = delete;
+    EngineContext& operator=(const EngineContext&) = delete;
+    ~EngineContext();
+
+    std::unique_ptr<SharedAudioCore> core;
+    std::map<int, SpectrumTapEntry> spectrum_analyzers;
+    int next_spectrum_id = 1;
+
+    // View of the SharedArrayBuffer the engine drains commands from; the
+    // reference keeps the memory alive while the audio thread can see it
+    Napi::Reference<Napi::TypedArray> command_ring_view;
+
+    MeterPollState output_meter_state;
+    MeterPollState bus_meter_state;
+    MeterPollState voice_meter_state;
+    MeterPollState input_meter_state;
+
+    // Native OSC listener feeding this engine's command queue
+    std::unique_ptr<OscServer> osc_server;
+
+    // MSC and note triggers from MIDI, created on first use
+    std::unique_ptr<MidiTriggerInput> midi_input;
+};
+
+// Per-environment addon state (main thread and each worker get their own)
+struct AddonData {
+    EngineContext default_engine;
+    Napi::FunctionReference engine_constructor;
+
+#ifndef _WIN32
+    // Out-of-process engine. Independent of the in-process engines: a UI
+    // can drive a host without running an engine of its own.
+    std::unique_ptr<EngineHostClient> engine_host;
+    HostStatusFrame host_status;
+    HostMeterFrame host_meters;
+#endif
+};
+
+static AddonData* GetAddonData(Napi::Env env) {
+    return env.GetInstanceData<AddonData>();
+}
+
+static void DetachSpectrumAnalyzer(EngineContext& engine, SpectrumTapEntry& entry) {
+    auto* mix_graph = engine.core->get_mix_graph();
+    if (entry.bus_index < 0) {
+        mix_graph->remove_output_tap(entry.analyzer->get_tap(), entry.analyzer);
+    }
+    else {
+        mix_graph->remove_bus_tap(entry.bus_index, entry.analyzer->get_tap(), entry.analyzer);
+    }
+    entry.analyzer->stop();
+}
 
 // Convert C++ HardwareType to JavaScript string
 Napi::String HardwareTypeToJS(Napi::Env env, HardwareType type) {
@@ -36,6 +127,17 @@ Napi::Object PerformanceMetricsToJS(Napi::Env env, const PerformanceMetrics& met
     obj.Set("bufferUnderruns", Napi::Number::New(env, metrics.buffer_underruns));
     obj.Set("bufferOverruns", Napi::Number::New(env, metrics.buffer_overruns));
     obj.Set("isStable", Napi::Boolean::New(env, metrics.is_stable));
+    obj.Set("graphLatencySamples", Napi::Number::New(env, metrics.graph_latency_samples));
+    obj.Set("totalOutputLatencyMs", Napi::Number::New(env, metrics.total_output_latency_ms));
+    obj.Set("commandsPushed", Napi::Number::New(env, static_cast<double>(metrics.commands_pushed)));
+    obj.Set("commandsCoalesced", Napi::Number::New(env, static_cast<double>(metrics.commands_coalesced)));
+    obj.Set("commandsDropped", Napi::Number::New(env, static_cast<double>(metrics.commands_dropped)));
+    obj.Set("criticalCommandsDropped", Napi::Number::New(env, static_cast<double>(metrics.critical_commands_dropped)));
+    obj.Set("commandQueueHighWater", Napi::Number::New(env, metrics.command_queue_high_water));
+    obj.Set("criticalQueueHighWater", Napi::Number::New(env, metrics.critical_queue_high_water));
+    obj.Set("sharedRingDropped", Napi::Number::New(env, static_cast<double>(metrics.shared_ring_dropped)));
+    obj.Set("scheduledCommandsLate", Napi::Number::New(env, static_cast<double>(metrics.scheduled_commands_late)));
+    obj.Set("scheduledCommandsOverflow", Napi::Number::New(env, static_cast<double>(metrics.scheduled_commands_overflow)));
     return obj;
 }
 
@@ -63,14 +165,17 @@ Napi::Object AudioCueInfoToJS(Napi::Env env, const AudioCueInfo& info) {
     obj.Set("isLooping", Napi::Boolean::New(env, info.is_looping));
     obj.Set("sampleRate", Napi::Number::New(env, info.sample_rate));
     obj.Set("channels", Napi::Number::New(env, info.channels));
+    obj.Set("trimGain", Napi::Number::New(env, info.trim_gain));
+    obj.Set("peakLeft", Napi::Number::New(env, info.peak_left));
+    obj.Set("peakRight", Napi::Number::New(env, info.peak_right));
     return obj;
 }
 
 // Initialize the audio core
-Napi::Value Initialize(const Napi::CallbackInfo& info) {
+Napi::Value Initialize(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (g_audio_core) {
+    if (engine.core) {
         Napi::TypeError::New(env, "Audio core already initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -96,41 +201,63 @@ Napi::Value Initialize(const Napi::CallbackInfo& info) {
         if (settingsObj.Has("targetLatencyMs")) {
             settings.target_latency_ms = settingsObj.Get("targetLatencyMs").As<Napi::Number>().DoubleValue();
         }
+        if (settingsObj.Has("deviceName")) {
+            settings.device_name = settingsObj.Get("deviceName").As<Napi::String>().Utf8Value();
+        }
     }
 
-    g_audio_core = create_audio_core();
+    engine.core = create_audio_core();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Failed to create audio core").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    bool success = g_audio_core->initialize(settings);
+    bool success = engine.core->initialize(settings);
     return Napi::Boolean::New(env, success);
 }
 
-// Shutdown the audio core
-Napi::Value Shutdown(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+static void ShutdownEngine(EngineContext& engine) {
+    engine.osc_server.reset(); // Joins the listener before the core goes away
+    engine.midi_input.reset();
 
-    if (g_audio_core) {
-        g_audio_core->shutdown();
-        g_audio_core.reset();
+    if (engine.core) {
+        for (auto& [id, entry] : engine.spectrum_analyzers) {
+            DetachSpectrumAnalyzer(engine, entry);
+        }
+        engine.spectrum_analyzers.clear();
+
+        engine.core->detach_command_ring();
+        engine.command_ring_view.Reset();
+
+        engine.core->shutdown();
+        engine.core.reset();
     }
+}
 
+// Engines that JS never shut down (garbage collected AudioEngine objects,
+// worker or environment teardown) still stop their device
+EngineContext::~EngineContext() {
+    ShutdownEngine(*this);
+}
+
+// Shutdown the audio core
+Napi::Value Shutdown(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ShutdownEngine(engine);
     return env.Undefined();
 }
 
 // Detect professional hardware
-Napi::Value DetectHardware(const Napi::CallbackInfo& info) {
+Napi::Value DetectHardware(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto hardware_types = g_audio_core->detect_professional_hardware();
+    auto hardware_types = engine.core->detect_professional_hardware();
 
     Napi::Array array = Napi::Array::New(env, hardware_types.size());
     for (size_t i = 0; i < hardware_types.size(); ++i) {
@@ -141,15 +268,15 @@ Napi::Value DetectHardware(const Napi::CallbackInfo& info) {
 }
 
 // Get available devices
-Napi::Value GetAvailableDevices(const Napi::CallbackInfo& info) {
+Napi::Value GetAvailableDevices(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto devices = g_audio_core->get_available_devices();
+    auto devices = engine.core->get_available_devices();
 
     Napi::Array array = Napi::Array::New(env, devices.size());
     for (size_t i = 0; i < devices.size(); ++i) {
@@ -160,49 +287,163 @@ Napi::Value GetAvailableDevices(const Napi::CallbackInfo& info) {
 }
 
 // Start audio
-Napi::Value StartAudio(const Napi::CallbackInfo& info) {
+Napi::Value StartAudio(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    g_audio_core->start_audio();
-    return Napi::Boolean::New(env, g_audio_core->is_audio_running());
+    engine.core->start_audio();
+    return Napi::Boolean::New(env, engine.core->is_audio_running());
 }
 
 // Stop audio
-Napi::Value StopAudio(const Napi::CallbackInfo& info) {
+Napi::Value StopAudio(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    g_audio_core->stop_audio();
+    engine.core->stop_audio();
     return env.Undefined();
 }
 
 // Get performance metrics
-Napi::Value GetPerformanceMetrics(const Napi::CallbackInfo& info) {
+Napi::Value GetPerformanceMetrics(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto metrics = g_audio_core->get_performance_metrics();
+    auto metrics = engine.core->get_performance_metrics();
     return PerformanceMetricsToJS(env, metrics);
 }
 
+// Get per-stage callback timing
+Napi::Value GetStageProfile(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto profile = engine.core->get_stage_profile();
+    Napi::Array array = Napi::Array::New(env, profile.size());
+    for (size_t i = 0; i < profile.size(); ++i) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("name", Napi::String::New(env, profile[i].name));
+        obj.Set("averageUs", Napi::Number::New(env, profile[i].average_us));
+        obj.Set("maxUs", Napi::Number::New(env, profile[i].max_us));
+        obj.Set("blocks", Napi::Number::New(env, static_cast<double>(profile[i].blocks)));
+        array[i] = obj;
+    }
+
+    return array;
+}
+
+// Attach a command ring created by lib/command_ring.js. Takes any typed
+// array over the whole SharedArrayBuffer (ring.view).
+Napi::Value AttachCommandRing(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsTypedArray()) {
+        Napi::TypeError::New(env, "Expected (view: TypedArray over a SharedArrayBuffer)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // The C call resolves the data pointer for shared backing stores too,
+    // where Napi::ArrayBuffer would reject the SharedArrayBuffer
+    Napi::TypedArray view = info[0].As<Napi::TypedArray>();
+    void* data = nullptr;
+    if (napi_get_typedarray_info(env, view, nullptr, nullptr, &data, nullptr, nullptr) != napi_ok || !data) {
+        Napi::TypeError::New(env, "Cannot access the command ring memory").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    engine.core->detach_command_ring();
+    engine.command_ring_view.Reset();
+
+    bool success = engine.core->attach_command_ring(data, view.ByteLength());
+    if (success) {
+        engine.command_ring_view = Napi::Persistent(view);
+    }
+    return Napi::Boolean::New(env, success);
+}
+
+// Stop draining the command ring
+Napi::Value DetachCommandRing(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->detach_command_ring();
+    engine.command_ring_view.Reset();
+    return env.Undefined();
+}
+
+// Start recording the command stream for offline replay
+Napi::Value StartCommandCapture(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (path: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool success = engine.core->start_command_capture(info[0].As<Napi::String>().Utf8Value());
+    return Napi::Boolean::New(env, success);
+}
+
+// Stop recording the command stream
+Napi::Value StopCommandCapture(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->stop_command_capture();
+    return env.Undefined();
+}
+
+// OSC addresses follow the loaded cues
+static void RefreshOscAddresses(EngineContext& engine) {
+    if (!engine.osc_server) {
+        return;
+    }
+
+    std::vector<std::string> cue_ids;
+    for (const auto& [cue_id, file_path] : engine.core->get_cue_manager()->get_loaded_assets()) {
+        cue_ids.push_back(cue_id);
+    }
+    engine.osc_server->set_cues(cue_ids);
+}
+
 // Load audio cue
-Napi::Value LoadAudioCue(const Napi::CallbackInfo& info) {
+Napi::Value LoadAudioCue(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -215,17 +456,47 @@ Napi::Value LoadAudioCue(const Napi::CallbackInfo& info) {
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
     std::string file_path = info[1].As<Napi::String>().Utf8Value();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
+    auto* cue_manager = engine.core->get_cue_manager();
     bool success = cue_manager->load_audio_cue(cue_id, file_path);
+    if (success) {
+        RefreshOscAddresses(engine);
+    }
 
     return Napi::Boolean::New(env, success);
 }
 
+// Transport and fader changes from the UI go through the engine's command
+// queue, so a GO takes the critical lane and a fader drag coalesces. With
+// the device stopped nothing drains the queue: apply directly instead.
+static bool SendCueCommand(EngineContext& engine, AudioThreadMessage::Type type, const std::string& cue_id, float value) {
+    auto* cue_manager = engine.core->get_cue_manager();
+    if (!cue_manager->is_cue_loaded(cue_id)) {
+        return false;
+    }
+
+    AudioThreadMessage msg;
+    if (!engine.core->is_audio_running() || cue_id.size() >= sizeof(msg.cue_id)) {
+        switch (type) {
+        case AudioThreadMessage::START_CUE:
+            return cue_manager->start_cue(cue_id);
+        case AudioThreadMessage::STOP_CUE:
+            return cue_manager->stop_cue(cue_id);
+        default:
+            return cue_manager->set_cue_volume(cue_id, value);
+        }
+    }
+
+    msg.type = type;
+    std::memcpy(msg.cue_id, cue_id.c_str(), cue_id.size() + 1);
+    msg.param1.float_value = value;
+    return engine.core->send_command(msg);
+}
+
 // Start cue
-Napi::Value StartCue(const Napi::CallbackInfo& info) {
+Napi::Value StartCue(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -237,17 +508,16 @@ Napi::Value StartCue(const Napi::CallbackInfo& info) {
 
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
-    bool success = cue_manager->start_cue(cue_id);
+    bool success = SendCueCommand(engine, AudioThreadMessage::START_CUE, cue_id, 0.0f);
 
     return Napi::Boolean::New(env, success);
 }
 
 // Stop cue
-Napi::Value StopCue(const Napi::CallbackInfo& info) {
+Napi::Value StopCue(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -259,17 +529,16 @@ Napi::Value StopCue(const Napi::CallbackInfo& info) {
 
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
-    bool success = cue_manager->stop_cue(cue_id);
+    bool success = SendCueCommand(engine, AudioThreadMessage::STOP_CUE, cue_id, 0.0f);
 
     return Napi::Boolean::New(env, success);
 }
 
 // Set cue volume
-Napi::Value SetCueVolume(const Napi::CallbackInfo& info) {
+Napi::Value SetCueVolume(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -282,17 +551,16 @@ Napi::Value SetCueVolume(const Napi::CallbackInfo& info) {
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
     float volume = info[1].As<Napi::Number>().FloatValue();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
-    bool success = cue_manager->set_cue_volume(cue_id, volume);
+    bool success = SendCueCommand(engine, AudioThreadMessage::SET_VOLUME, cue_id, volume);
 
     return Napi::Boolean::New(env, success);
 }
 
 // Fade in cue
-Napi::Value FadeInCue(const Napi::CallbackInfo& info) {
+Napi::Value FadeInCue(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -305,17 +573,17 @@ Napi::Value FadeInCue(const Napi::CallbackInfo& info) {
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
     double duration = info[1].As<Napi::Number>().DoubleValue();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
+    auto* cue_manager = engine.core->get_cue_manager();
     bool success = cue_manager->fade_in_cue(cue_id, duration);
 
     return Napi::Boolean::New(env, success);
 }
 
 // Fade out cue
-Napi::Value FadeOutCue(const Napi::CallbackInfo& info) {
+Napi::Value FadeOutCue(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -328,22 +596,69 @@ Napi::Value FadeOutCue(const Napi::CallbackInfo& info) {
     std::string cue_id = info[0].As<Napi::String>().Utf8Value();
     double duration = info[1].As<Napi::Number>().DoubleValue();
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
+    auto* cue_manager = engine.core->get_cue_manager();
     bool success = cue_manager->fade_out_cue(cue_id, duration);
 
     return Napi::Boolean::New(env, success);
 }
 
+// Set cue looping
+Napi::Value SetCueLoop(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, loop: boolean)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+    bool loop = info[1].As<Napi::Boolean>().Value();
+    return Napi::Boolean::New(env, engine.core->get_cue_manager()->set_cue_loop(cue_id, loop));
+}
+
+// Loop region with a precomputed crossfade seam: setCueLoopRegion(cueId, start, end, crossfade?)
+// (end 0: end of the file; null start clears the region)
+Napi::Value SetCueLoopRegion(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() >= 2 && info[0].IsString() && info[1].IsNull()) {
+        std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+        return Napi::Boolean::New(env, engine.core->get_cue_manager()->clear_cue_loop_region(cue_id));
+    }
+
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()
+        || (info.Length() >= 4 && !info[3].IsNumber())) {
+        Napi::TypeError::New(env, "Expected (cueId: string, startSeconds: number, endSeconds: number, crossfadeSeconds?: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+    double start = info[1].As<Napi::Number>().DoubleValue();
+    double end = info[2].As<Napi::Number>().DoubleValue();
+    double crossfade = info.Length() >= 4 ? info[3].As<Napi::Number>().DoubleValue() : 0.0;
+    return Napi::Boolean::New(env, engine.core->get_cue_manager()->set_cue_loop_region(cue_id, start, end, crossfade));
+}
+
 // Get active cues
-Napi::Value GetActiveCues(const Napi::CallbackInfo& info) {
+Napi::Value GetActiveCues(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto* cue_manager = g_audio_core->get_cue_manager();
+    auto* cue_manager = engine.core->get_cue_manager();
     auto active_cues = cue_manager->get_active_cues();
 
     Napi::Array array = Napi::Array::New(env, active_cues.size());
@@ -355,10 +670,10 @@ Napi::Value GetActiveCues(const Napi::CallbackInfo& info) {
 }
 
 // Start crossfade
-Napi::Value StartCrossfade(const Napi::CallbackInfo& info) {
+Napi::Value StartCrossfade(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -372,79 +687,1784 @@ Napi::Value StartCrossfade(const Napi::CallbackInfo& info) {
     std::string to_cue_id = info[1].As<Napi::String>().Utf8Value();
     double duration = info[2].As<Napi::Number>().DoubleValue();
 
-    auto* crossfade_engine = g_audio_core->get_crossfade_engine();
+    auto* crossfade_engine = engine.core->get_crossfade_engine();
     bool success = crossfade_engine->start_crossfade(from_cue_id, to_cue_id, duration);
 
     return Napi::Boolean::New(env, success);
 }
 
 // Get crossfade progress
-Napi::Value GetCrossfadeProgress(const Napi::CallbackInfo& info) {
+Napi::Value GetCrossfadeProgress(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto* crossfade_engine = g_audio_core->get_crossfade_engine();
+    auto* crossfade_engine = engine.core->get_crossfade_engine();
     double progress = crossfade_engine->get_crossfade_progress();
 
     return Napi::Number::New(env, progress);
 }
 
 // Is crossfading
-Napi::Value IsCrossfading(const Napi::CallbackInfo& info) {
+Napi::Value IsCrossfading(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
+    if (!engine.core) {
         Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    auto* crossfade_engine = g_audio_core->get_crossfade_engine();
+    auto* crossfade_engine = engine.core->get_crossfade_engine();
     bool is_crossfading = crossfade_engine->is_crossfading();
 
     return Napi::Boolean::New(env, is_crossfading);
 }
 
-// Get last error
-Napi::Value GetLastError(const Napi::CallbackInfo& info) {
+// Add mix bus
+Napi::Value AddBus(EngineContext& engine, const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (!g_audio_core) {
-        return Napi::String::New(env, "Audio core not initialized");
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
 
-    std::string error = g_audio_core->get_last_error();
-    return Napi::String::New(env, error);
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (name: string, numChannels: number, firstOutputChannel: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    int num_channels = info[1].As<Napi::Number>().Int32Value();
+    int first_output = info[2].As<Napi::Number>().Int32Value();
+
+    int bus_index = engine.core->get_mix_graph()->add_bus(name, num_channels, first_output);
+    return Napi::Number::New(env, bus_index);
 }
 
-// Module initialization
-Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    // Core functions
-    exports.Set("initialize", Napi::Function::New(env, Initialize));
-    exports.Set("shutdown", Napi::Function::New(env, Shutdown));
-    exports.Set("detectHardware", Napi::Function::New(env, DetectHardware));
-    exports.Set("getAvailableDevices", Napi::Function::New(env, GetAvailableDevices));
-    exports.Set("startAudio", Napi::Function::New(env, StartAudio));
-    exports.Set("stopAudio", Napi::Function::New(env, StopAudio));
-    exports.Set("getPerformanceMetrics", Napi::Function::New(env, GetPerformanceMetrics));
-    exports.Set("getLastError", Napi::Function::New(env, GetLastError));
+// Load plugin into a bus or output insert slot (instantiated on the loader thread)
+Napi::Value LoadInsertPlugin(EngineContext& engine, const Napi::CallbackInfo& info, bool output_insert) {
+    Napi::Env env = info.Env();
 
-    // Cue management functions
-    exports.Set("loadAudioCue", Napi::Function::New(env, LoadAudioCue));
-    exports.Set("startCue", Napi::Function::New(env, StartCue));
-    exports.Set("stopCue", Napi::Function::New(env, StopCue));
-    exports.Set("setCueVolume", Napi::Function::New(env, SetCueVolume));
-    exports.Set("fadeInCue", Napi::Function::New(env, FadeInCue));
-    exports.Set("fadeOutCue", Napi::Function::New(env, FadeOutCue));
-    exports.Set("getActiveCues", Napi::Function::New(env, GetActiveCues));
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
 
-    // Crossfade functions
-    exports.Set("startCrossfade", Napi::Function::New(env, StartCrossfade));
-    exports.Set("getCrossfadeProgress", Napi::Function::New(env, GetCrossfadeProgress));
-    exports.Set("isCrossfading", Napi::Function::New(env, IsCrossfading));
+    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsString()) {
+        Napi::TypeError::New(env, "Expected (index: number, slot: number, pluginPath: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    int index = info[0].As<Napi::Number>().Int32Value();
+    int slot_index = info[1].As<Napi::Number>().Int32Value();
+    std::string plugin_path = info[2].As<Napi::String>().Utf8Value();
+
+    auto* mix_graph = engine.core->get_mix_graph();
+    auto* slot = output_insert ? mix_graph->get_output_insert(index, slot_index)
+                               : mix_graph->get_bus_insert(index, slot_index);
+    if (!slot) {
+        Napi::RangeError::New(env, "Invalid insert slot").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool queued = engine.core->get_plugin_host()->load_plugin_async(slot, plugin_path);
+    return Napi::Boolean::New(env, queued);
+}
+
+Napi::Value LoadBusInsert(EngineContext& engine, const Napi::CallbackInfo& info) {
+    return LoadInsertPlugin(engine, info, false);
+}
+
+Napi::Value LoadOutputInsert(EngineContext& engine, const Napi::CallbackInfo& info) {
+    return LoadInsertPlugin(engine, info, true);
+}
+
+// Get bus info (including loaded inserts and their latency)
+Napi::Value GetBusInfo(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (busIndex: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    int bus_index = info[0].As<Napi::Number>().Int32Value();
+    auto* mix_graph = engine.core->get_mix_graph();
+    MixBusInfo bus = mix_graph->get_bus_info(bus_index);
+    if (bus.bus_index < 0) {
+        return env.Null();
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("busIndex", Napi::Number::New(env, bus.bus_index));
+    obj.Set("name", Napi::String::New(env, bus.name));
+    obj.Set("numChannels", Napi::Number::New(env, bus.num_channels));
+    obj.Set("firstOutputChannel", Napi::Number::New(env, bus.first_output_channel));
+    obj.Set("gain", Napi::Number::New(env, bus.gain));
+    obj.Set("isMuted", Napi::Boolean::New(env, bus.is_muted));
+    obj.Set("insertLatencySamples", Napi::Number::New(env, bus.insert_latency_samples));
+    obj.Set("compensationDelaySamples", Napi::Number::New(env, bus.compensation_delay_samples));
+    obj.Set("isSilent", Napi::Boolean::New(env, bus.is_silent));
+
+    Napi::Array inserts = Napi::Array::New(env);
+    for (int i = 0; i < MixGraph::kMaxInsertsPerStrip; ++i) {
+        auto* slot = mix_graph->get_bus_insert(bus_index, i);
+        inserts[i] = slot->is_loaded() ? Napi::Value(Napi::String::New(env, slot->get_plugin_name())) : env.Null();
+    }
+    obj.Set("inserts", inserts);
+    return obj;
+}
+
+// Read a meter bank and run ballistics on whatever arrived since the last poll
+static void PollMeters(MeterBank* bank, MeterPollState& state) {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - state.last_poll).count();
+    state.last_poll = now;
+
+    if (!bank->read(state.values)) {
+        // Lost the race with a publish - keep showing the previous values
+        state.values.resize(bank->get_num_channels(), MeterValues{ 0.0f, 0.0f, 0.0f });
+    }
+    state.ballistics.process(state.values, elapsed, state.readings);
+}
+
+Napi::Object MeterReadingToJS(Napi::Env env, const MeterReading& reading) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("peakDb", Napi::Number::New(env, reading.peak_db));
+    obj.Set("rmsDb", Napi::Number::New(env, reading.rms_db));
+    obj.Set("truePeakDb", Napi::Number::New(env, reading.true_peak_db));
+    obj.Set("peakHoldDb", Napi::Number::New(env, reading.peak_hold_db));
+    obj.Set("clipped", Napi::Boolean::New(env, reading.clipped));
+    return obj;
+}
+
+// Get output meters (one entry per device output channel)
+Napi::Value GetOutputMeters(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    PollMeters(engine.core->get_mix_graph()->get_output_meters(), engine.output_meter_state);
+
+    const auto& readings = engine.output_meter_state.readings;
+    Napi::Array array = Napi::Array::New(env, readings.size());
+    for (size_t i = 0; i < readings.size(); ++i) {
+        array[i] = MeterReadingToJS(env, readings[i]);
+    }
+    return array;
+}
+
+// Get bus meters (one array of channel readings per bus)
+Napi::Value GetBusMeters(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto* mix_graph = engine.core->get_mix_graph();
+    PollMeters(mix_graph->get_bus_meters(), engine.bus_meter_state);
+
+    const auto& readings = engine.bus_meter_state.readings;
+    int num_buses = mix_graph->get_num_buses();
+    Napi::Array array = Napi::Array::New(env, num_buses);
+    for (int bus = 0; bus < num_buses; ++bus) {
+        MixBusInfo bus_info = mix_graph->get_bus_info(bus);
+        Napi::Array channels = Napi::Array::New(env, std::max(0, bus_info.num_channels));
+        for (int ch = 0; ch < bus_info.num_channels; ++ch) {
+            size_t index = static_cast<size_t>(bus * MixGraph::kMaxBusChannels + ch);
+            if (index < readings.size()) {
+                channels[ch] = MeterReadingToJS(env, readings[index]);
+            }
+        }
+        array[bus] = channels;
+    }
+    return array;
+}
+
+// Get cue meters (left/right of each requested cue, keyed by cue id)
+Napi::Value GetCueMeters(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (cueIds: string[])").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto* cue_manager = engine.core->get_cue_manager();
+    PollMeters(cue_manager->get_voice_meters(), engine.voice_meter_state);
+
+    const auto& readings = engine.voice_meter_state.readings;
+    Napi::Array cue_ids = info[0].As<Napi::Array>();
+    Napi::Object result = Napi::Object::New(env);
+    for (uint32_t i = 0; i < cue_ids.Length(); ++i) {
+        Napi::Value id_value = cue_ids[i];
+        if (!id_value.IsString()) {
+            continue;
+        }
+
+        std::string cue_id = id_value.As<Napi::String>().Utf8Value();
+        int meter_index = cue_manager->get_cue_meter_index(cue_id);
+        size_t left = static_cast<size_t>(meter_index) * 2;
+        if (meter_index < 0 || left + 1 >= readings.size()) {
+            result.Set(cue_id, env.Null());
+            continue;
+        }
+
+        Napi::Array channels = Napi::Array::New(env, 2);
+        channels[0u] = MeterReadingToJS(env, readings[left]);
+        channels[1u] = MeterReadingToJS(env, readings[left + 1]);
+        result.Set(cue_id, channels);
+    }
+    return result;
+}
+
+// Get input meters (one entry per device input channel, post gain)
+Napi::Value GetInputMeters(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    PollMeters(engine.core->get_input_router()->get_input_meters(), engine.input_meter_state);
+
+    const auto& readings = engine.input_meter_state.readings;
+    Napi::Array array = Napi::Array::New(env, readings.size());
+    for (size_t i = 0; i < readings.size(); ++i) {
+        array[i] = MeterReadingToJS(env, readings[i]);
+    }
+    return array;
+}
+
+// Clear clip indicators on every meter
+Napi::Value ResetMeterClips(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    engine.output_meter_state.ballistics.reset_clip_indicators();
+    engine.bus_meter_state.ballistics.reset_clip_indicators();
+    engine.voice_meter_state.ballistics.reset_clip_indicators();
+    engine.input_meter_state.ballistics.reset_clip_indicators();
+    return env.Undefined();
+}
+
+// Get cue loudness (measured when the file was decoded)
+Napi::Value GetCueLoudness(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (cueId: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+    LoudnessInfo loudness = engine.core->get_cue_manager()->get_cue_loudness(cue_id);
+    if (!loudness.is_valid) {
+        return env.Null();
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("integratedLufs", Napi::Number::New(env, loudness.integrated_lufs));
+    obj.Set("maxMomentaryLufs", Napi::Number::New(env, loudness.max_momentary_lufs));
+    obj.Set("maxShortTermLufs", Napi::Number::New(env, loudness.max_short_term_lufs));
+    obj.Set("loudnessRangeLu", Napi::Number::New(env, loudness.loudness_range_lu));
+    return obj;
+}
+
+// Normalize a cue to a target loudness (per-cue trim)
+Napi::Value NormalizeCueLoudness(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, targetLufs?: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+    double target_lufs = (info.Length() > 1 && info[1].IsNumber()) ? info[1].As<Napi::Number>().DoubleValue() : -23.0;
+    bool success = engine.core->get_cue_manager()->normalize_cue_loudness(cue_id, target_lufs);
+    return Napi::Boolean::New(env, success);
+}
+
+// Set cue trim in dB
+Napi::Value SetCueTrim(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, trimDb: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string cue_id = info[0].As<Napi::String>().Utf8Value();
+    float trim_db = info[1].As<Napi::Number>().FloatValue();
+    bool success = engine.core->get_cue_manager()->set_cue_trim(cue_id, trim_db);
+    return Napi::Boolean::New(env, success);
+}
+
+// Get live output loudness
+Napi::Value GetOutputLoudness(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    LiveLoudness loudness = engine.core->get_loudness_monitor()->get_loudness();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("isValid", Napi::Boolean::New(env, loudness.is_valid));
+    obj.Set("momentaryLufs", Napi::Number::New(env, loudness.momentary_lufs));
+    obj.Set("shortTermLufs", Napi::Number::New(env, loudness.short_term_lufs));
+    obj.Set("integratedLufs", Napi::Number::New(env, loudness.integrated_lufs));
+    obj.Set("maxMomentaryLufs", Napi::Number::New(env, loudness.max_momentary_lufs));
+    obj.Set("measuredSeconds", Napi::Number::New(env, loudness.measured_seconds));
+    return obj;
+}
+
+// Restart the integrated output loudness measurement
+Napi::Value ResetOutputLoudness(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->get_loudness_monitor()->reset();
+    return env.Undefined();
+}
+
+// Get the waveform pyramid layout of a cue's asset
+Napi::Value GetCueWaveformInfo(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (cueId: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto asset = engine.core->get_cue_manager()->get_cue_asset(info[0].As<Napi::String>().Utf8Value());
+    if (!asset || !asset->waveform.is_built()) {
+        return env.Null();
+    }
+
+    const auto& waveform = asset->waveform;
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("numChannels", Napi::Number::New(env, waveform.get_num_channels()));
+    obj.Set("numFrames", Napi::Number::New(env, static_cast<double>(asset->metadata.num_frames)));
+    obj.Set("sampleRate", Napi::Number::New(env, asset->metadata.sample_rate));
+    obj.Set("storageFormat", Napi::String::New(env, sample_format_name(asset->metadata.storage_format)));
+    obj.Set("memoryBytes", Napi::Number::New(env, static_cast<double>(asset->metadata.memory_bytes)));
+
+    Napi::Array levels = Napi::Array::New(env, waveform.get_num_levels());
+    for (int level = 0; level < waveform.get_num_levels(); ++level) {
+        Napi::Object level_info = Napi::Object::New(env);
+        level_info.Set("samplesPerPoint", Napi::Number::New(env, static_cast<double>(waveform.get_samples_per_point(level))));
+        level_info.Set("numPoints", Napi::Number::New(env, static_cast<double>(waveform.get_level(0, level)->size())));
+        levels[level] = level_info;
+    }
+    obj.Set("levels", levels);
+    return obj;
+}
+
+// Get one pyramid level as a Float32Array of (min, max, rms) triples.
+// Always a copy: the pyramid is shared by every cue on the same file and
+// a typed array cannot be made read-only from JS.
+Napi::Value GetCueWaveformLevel(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, channel: number, level: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto asset = engine.core->get_cue_manager()->get_cue_asset(info[0].As<Napi::String>().Utf8Value());
+    int channel = info[1].As<Napi::Number>().Int32Value();
+    int level = info[2].As<Napi::Number>().Int32Value();
+    const auto* points = asset ? asset->waveform.get_level(channel, level) : nullptr;
+    if (points == nullptr) {
+        return env.Null();
+    }
+
+    const size_t num_floats = points->size() * 3;
+    Napi::Float32Array array = Napi::Float32Array::New(env, num_floats);
+    std::memcpy(array.Data(), points->data(), num_floats * sizeof(float));
+    return array;
+}
+
+// Render a cue's waveform for a view: (min, max, rms) per pixel
+Napi::Value RenderCueWaveform(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 5 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsNumber()
+        || !info[3].IsNumber() || !info[4].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, channel: number, startSeconds: number, endSeconds: number, numPixels: number)")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto asset = engine.core->get_cue_manager()->get_cue_asset(info[0].As<Napi::String>().Utf8Value());
+    if (!asset || !asset->waveform.is_built()) {
+        return env.Null();
+    }
+
+    int channel = info[1].As<Napi::Number>().Int32Value();
+    double sample_rate = asset->metadata.sample_rate;
+    double start_sample = info[2].As<Napi::Number>().DoubleValue() * sample_rate;
+    double end_sample = info[3].As<Napi::Number>().DoubleValue() * sample_rate;
+    int num_pixels = std::max(0, std::min(info[4].As<Napi::Number>().Int32Value(), 16384));
+
+    const SampleChannel* samples = nullptr;
+    if (channel >= 0 && channel < static_cast<int>(asset->channels.size())) {
+        samples = &asset->channels[channel];
+    }
+
+    std::vector<WaveformPoint> points;
+    {
+        SampleArena::ReadGuard guard(*engine.core->get_cue_manager()->get_asset_cache()->get_arena());
+        asset->waveform.render(channel, start_sample, end_sample, num_pixels, points, samples);
+    }
+
+    Napi::Float32Array array = Napi::Float32Array::New(env, points.size() * 3);
+    std::memcpy(array.Data(), points.data(), points.size() * sizeof(WaveformPoint));
+    return array;
+}
+
+// Choose how newly decoded assets are stored: 'float32', 'lossless', 'half' or 'compressed'
+Napi::Value SetSampleStoragePolicy(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (policy: 'float32' | 'lossless' | 'half' | 'compressed')").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string policy = info[0].As<Napi::String>().Utf8Value();
+    SampleStoragePolicy value;
+    if (policy == "float32") {
+        value = SampleStoragePolicy::FLOAT32;
+    }
+    else if (policy == "lossless") {
+        value = SampleStoragePolicy::LOSSLESS;
+    }
+    else if (policy == "half") {
+        value = SampleStoragePolicy::HALF_FLOAT;
+    }
+    else if (policy == "compressed") {
+        value = SampleStoragePolicy::COMPRESSED;
+    }
+    else {
+        Napi::TypeError::New(env, "Unknown storage policy: " + policy).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->get_cue_manager()->get_asset_cache()->set_storage_policy(value);
+    return Napi::Boolean::New(env, true);
+}
+
+// Decoded sample memory, in total and per storage format
+Napi::Value GetAssetMemory(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    AudioAssetCache* cache = engine.core->get_cue_manager()->get_asset_cache();
+    std::vector<size_t> by_format = cache->get_memory_bytes_by_format();
+
+    Napi::Object formats = Napi::Object::New(env);
+    for (size_t i = 0; i < by_format.size(); ++i) {
+        formats.Set(sample_format_name(static_cast<SampleFormat>(i)), Napi::Number::New(env, static_cast<double>(by_format[i])));
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("numAssets", Napi::Number::New(env, cache->get_num_assets()));
+    obj.Set("totalBytes", Napi::Number::New(env, static_cast<double>(cache->get_memory_bytes())));
+    obj.Set("bytesByFormat", formats);
+
+    SampleArenaStats arena_stats = cache->get_arena()->get_stats();
+    Napi::Object arena = Napi::Object::New(env);
+    arena.Set("slabBytes", Napi::Number::New(env, static_cast<double>(arena_stats.slab_bytes)));
+    arena.Set("usedBytes", Napi::Number::New(env, static_cast<double>(arena_stats.used_bytes)));
+    arena.Set("numSlabs", Napi::Number::New(env, arena_stats.num_slabs));
+    arena.Set("hugePageSlabs", Napi::Number::New(env, arena_stats.num_huge_page_slabs));
+    arena.Set("fragmentation", Napi::Number::New(env, arena_stats.get_fragmentation()));
+    arena.Set("compactions", Napi::Number::New(env, arena_stats.compactions));
+    arena.Set("bytesMoved", Napi::Number::New(env, static_cast<double>(arena_stats.bytes_moved)));
+    obj.Set("arena", arena);
+    return obj;
+}
+
+// Create a spectrum analyzer on the outputs or on a bus, returns its id
+Napi::Value CreateSpectrumAnalyzer(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected ({ source: 'output' | 'bus', busIndex?, firstChannel?, numChannels?, fftSize?, overlap?, smoothing? })")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    auto number_option = [&](const char* key, double fallback) {
+        return options.Has(key) && options.Get(key).IsNumber() ? options.Get(key).As<Napi::Number>().DoubleValue() : fallback;
+    };
+
+    bool is_bus = options.Has("source") && options.Get("source").IsString()
+        && options.Get("source").As<Napi::String>().Utf8Value() == "bus";
+    int bus_index = is_bus ? static_cast<int>(number_option("busIndex", 0)) : -1;
+    int first_channel = static_cast<int>(number_option("firstChannel", 0));
+    int num_channels = static_cast<int>(number_option("numChannels", 2));
+
+    SpectrumSettings settings;
+    settings.fft_order = static_cast<int>(std::lround(std::log2(std::max(256.0, number_option("fftSize", 4096)))));
+    settings.overlap = static_cast<float>(number_option("overlap", settings.overlap));
+    settings.smoothing = static_cast<float>(number_option("smoothing", settings.smoothing));
+
+    auto* mix_graph = engine.core->get_mix_graph();
+    auto analyzer = std::make_shared<SpectrumAnalyzer>();
+    if (!analyzer->start(mix_graph->get_sample_rate(), first_channel, num_channels, settings)) {
+        return env.Null();
+    }
+
+    bool attached = is_bus ? mix_graph->add_bus_tap(bus_index, analyzer->get_tap())
+        : mix_graph->add_output_tap(analyzer->get_tap());
+    if (!attached) {
+        analyzer->stop();
+        return env.Null();
+    }
+
+    int id = engine.next_spectrum_id++;
+    engine.spectrum_analyzers[id] = SpectrumTapEntry{ analyzer, bus_index };
+    return Napi::Number::New(env, id);
+}
+
+// Stop and remove a spectrum analyzer
+Napi::Value DestroySpectrumAnalyzer(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (analyzerId: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto it = engine.spectrum_analyzers.find(info[0].As<Napi::Number>().Int32Value());
+    if (it == engine.spectrum_analyzers.end()) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    DetachSpectrumAnalyzer(engine, it->second);
+    engine.spectrum_analyzers.erase(it);
+    return Napi::Boolean::New(env, true);
+}
+
+// Shared frame memory of an analyzer: Int32 view [0] is the sequence,
+// [1] the bin count, Float32 view [2] the sample rate, [3] the FFT size,
+// followed by the bins in dBFS. Read the sequence with Atomics.load before
+// and after copying the bins; retry if it was odd or changed.
+Napi::Value GetSpectrumBuffer(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (analyzerId: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto it = engine.spectrum_analyzers.find(info[0].As<Napi::Number>().Int32Value());
+    if (it == engine.spectrum_analyzers.end()) {
+        return env.Null();
+    }
+
+#ifdef NODE_API_NO_EXTERNAL_BUFFERS_ALLOWED
+    // No external memory on this runtime - use getSpectrumFrame instead
+    return env.Null();
+#else
+    const auto& analyzer = it->second.analyzer;
+    auto* keep_alive = new std::shared_ptr<SpectrumAnalyzer>(analyzer);
+    return Napi::ArrayBuffer::New(env, const_cast<void*>(analyzer->get_shared_frame()),
+        analyzer->get_shared_frame_bytes(),
+        [](Napi::Env, void*, std::shared_ptr<SpectrumAnalyzer>* hint) { delete hint; },
+        keep_alive);
+#endif
+}
+
+// Copy of the latest spectrum frame (dBFS per bin)
+Napi::Value GetSpectrumFrame(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (analyzerId: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto it = engine.spectrum_analyzers.find(info[0].As<Napi::Number>().Int32Value());
+    if (it == engine.spectrum_analyzers.end()) {
+        return env.Null();
+    }
+
+    std::vector<float> bins;
+    if (!it->second.analyzer->read_frame(bins)) {
+        return env.Null();
+    }
+
+    Napi::Float32Array array = Napi::Float32Array::New(env, bins.size());
+    std::memcpy(array.Data(), bins.data(), bins.size() * sizeof(float));
+    return array;
+}
+
+// Route a device input: setInputRoute(input, { bus?, directOutput?, gain?, pan?, muted? })
+Napi::Value SetInputRoute(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected (inputChannel: number, route: { bus?, directOutput?, gain?, pan?, muted? })")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto* router = engine.core->get_input_router();
+    int input_channel = info[0].As<Napi::Number>().Int32Value();
+    Napi::Object route = info[1].As<Napi::Object>();
+    bool success = input_channel >= 0 && input_channel < router->get_num_inputs();
+
+    if (success && route.Has("bus")) {
+        success &= router->set_input_bus(input_channel,
+            route.Get("bus").IsNumber() ? route.Get("bus").As<Napi::Number>().Int32Value() : -1);
+    }
+    if (success && route.Has("directOutput")) {
+        success &= router->set_input_direct_output(input_channel,
+            route.Get("directOutput").IsNumber() ? route.Get("directOutput").As<Napi::Number>().Int32Value() : -1);
+    }
+    if (success && route.Has("gain") && route.Get("gain").IsNumber()) {
+        success &= router->set_input_gain(input_channel, route.Get("gain").As<Napi::Number>().FloatValue());
+    }
+    if (success && route.Has("pan") && route.Get("pan").IsNumber()) {
+        success &= router->set_input_pan(input_channel, route.Get("pan").As<Napi::Number>().FloatValue());
+    }
+    if (success && route.Has("muted") && route.Get("muted").IsBoolean()) {
+        success &= router->set_input_mute(input_channel, route.Get("muted").As<Napi::Boolean>().Value());
+    }
+
+    return Napi::Boolean::New(env, success);
+}
+
+// Get the routing of a device input
+Napi::Value GetInputRoute(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (inputChannel: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    InputChannelInfo input = engine.core->get_input_router()->get_input_info(info[0].As<Napi::Number>().Int32Value());
+    if (input.input_channel < 0) {
+        return env.Null();
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("inputChannel", Napi::Number::New(env, input.input_channel));
+    obj.Set("bus", input.bus_index >= 0 ? Napi::Value(Napi::Number::New(env, input.bus_index)) : env.Null());
+    obj.Set("directOutput", input.direct_output >= 0 ? Napi::Value(Napi::Number::New(env, input.direct_output)) : env.Null());
+    obj.Set("gain", Napi::Number::New(env, input.gain));
+    obj.Set("pan", Napi::Number::New(env, input.pan));
+    obj.Set("muted", Napi::Boolean::New(env, input.is_muted));
+    obj.Set("source", Napi::String::New(env,
+        engine.core->get_player()->is_input_playback(input.input_channel) ? "playback" : "live"));
+    return obj;
+}
+
+// Start a multitrack recording:
+// startRecording({ directory?, takeName?, format?: 'wav'|'w64'|'caf', sampleFormat?: 'float32'|'int24', inputs?, outputs?, ringSeconds? })
+Napi::Value StartRecording(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() > 0 && !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected (options?: object)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    RecordingSettings settings;
+    if (info.Length() > 0) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("directory") && options.Get("directory").IsString()) {
+            settings.directory = options.Get("directory").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("takeName") && options.Get("takeName").IsString()) {
+            settings.take_name = options.Get("takeName").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("format") && options.Get("format").IsString()) {
+            std::string format = options.Get("format").As<Napi::String>().Utf8Value();
+            if (format == "wav") settings.file_format = RecordingFileFormat::WAV;
+            else if (format == "w64") settings.file_format = RecordingFileFormat::W64;
+            else if (format == "caf") settings.file_format = RecordingFileFormat::CAF;
+            else {
+                Napi::TypeError::New(env, "format must be 'wav', 'w64' or 'caf'").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+        if (options.Has("sampleFormat") && options.Get("sampleFormat").IsString()) {
+            std::string sample_format = options.Get("sampleFormat").As<Napi::String>().Utf8Value();
+            settings.sample_format = sample_format == "int24" ? RecordingSampleFormat::INT24 : RecordingSampleFormat::FLOAT32;
+        }
+        if (options.Has("inputs") && options.Get("inputs").IsBoolean()) {
+            settings.record_inputs = options.Get("inputs").As<Napi::Boolean>().Value();
+        }
+        if (options.Has("outputs") && options.Get("outputs").IsBoolean()) {
+            settings.record_outputs = options.Get("outputs").As<Napi::Boolean>().Value();
+        }
+        if (options.Has("ringSeconds") && options.Get("ringSeconds").IsNumber()) {
+            settings.ring_seconds = std::max(1.0, options.Get("ringSeconds").As<Napi::Number>().DoubleValue());
+        }
+    }
+
+    return Napi::Boolean::New(env, engine.core->get_recorder()->start_recording(settings));
+}
+
+// Stop the current recording and finalize its files
+Napi::Value StopRecording(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->get_recorder()->stop_recording();
+    return env.Undefined();
+}
+
+// Recording progress and disk health (ring high-water marks, dropped frames, slowest write)
+Napi::Value GetRecordingStatus(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    RecordingStatus status = engine.core->get_recorder()->get_status();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("isRecording", Napi::Boolean::New(env, status.is_recording));
+    obj.Set("elapsedSeconds", Napi::Number::New(env, status.elapsed_seconds));
+    obj.Set("bytesWritten", Napi::Number::New(env, static_cast<double>(status.bytes_written)));
+    obj.Set("maxWriteMs", Napi::Number::New(env, status.max_write_ms));
+
+    Napi::Array streams = Napi::Array::New(env, status.streams.size());
+    for (size_t i = 0; i < status.streams.size(); ++i) {
+        const auto& stream = status.streams[i];
+        Napi::Object s = Napi::Object::New(env);
+        s.Set("filePath", Napi::String::New(env, stream.file_path));
+        s.Set("numChannels", Napi::Number::New(env, stream.num_channels));
+        s.Set("framesWritten", Napi::Number::New(env, static_cast<double>(stream.frames_written)));
+        s.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(stream.dropped_frames)));
+        Napi::Array dropouts = Napi::Array::New(env, stream.dropouts.size());
+        for (size_t d = 0; d < stream.dropouts.size(); ++d) {
+            Napi::Object dropout = Napi::Object::New(env);
+            dropout.Set("frame", Napi::Number::New(env, static_cast<double>(stream.dropouts[d].frame)));
+            dropout.Set("frames", Napi::Number::New(env, static_cast<double>(stream.dropouts[d].frames)));
+            dropouts[static_cast<uint32_t>(d)] = dropout;
+        }
+        s.Set("dropouts", dropouts);
+        s.Set("ringCapacityFrames", Napi::Number::New(env, stream.ring_capacity_frames));
+        s.Set("ringHighWaterFrames", Napi::Number::New(env, stream.ring_high_water_frames));
+        s.Set("ringHighWaterPercent", Napi::Number::New(env, stream.ring_high_water_percent));
+        streams[i] = s;
+    }
+    obj.Set("streams", streams);
+    return obj;
+}
+
+// Load recorded tracks for virtual soundcheck:
+// loadSoundcheck(files: Array<string | { path, firstInput? }>, options?: { readAheadSeconds?, directIo? })
+Napi::Value LoadSoundcheck(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (files: Array<string | { path, firstInput? }>, options?: object)")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Array files = info[0].As<Napi::Array>();
+    std::vector<PlaybackSource> sources;
+    for (uint32_t i = 0; i < files.Length(); ++i) {
+        Napi::Value entry = files.Get(i);
+        PlaybackSource source; // Without firstInput, tracks follow the previous file's
+
+        if (entry.IsString()) {
+            source.file_path = entry.As<Napi::String>().Utf8Value();
+        }
+        else if (entry.IsObject() && entry.As<Napi::Object>().Get("path").IsString()) {
+            Napi::Object file = entry.As<Napi::Object>();
+            source.file_path = file.Get("path").As<Napi::String>().Utf8Value();
+            if (file.Has("firstInput") && file.Get("firstInput").IsNumber()) {
+                source.first_input = file.Get("firstInput").As<Napi::Number>().Int32Value();
+            }
+        }
+        else {
+            Napi::TypeError::New(env, "Each file must be a path or { path, firstInput? }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        sources.push_back(source);
+    }
+
+    double read_ahead_seconds = 4.0;
+    bool direct_io = false;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("readAheadSeconds") && options.Get("readAheadSeconds").IsNumber()) {
+            read_ahead_seconds = std::max(0.5, options.Get("readAheadSeconds").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Has("directIo") && options.Get("directIo").IsBoolean()) {
+            direct_io = options.Get("directIo").As<Napi::Boolean>().Value();
+        }
+    }
+
+    return Napi::Boolean::New(env, engine.core->get_player()->load(sources, read_ahead_seconds, direct_io));
+}
+
+// Soundcheck transport: playSoundcheck(), pauseSoundcheck(), seekSoundcheck(seconds)
+Napi::Value PlaySoundcheck(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->get_player()->play();
+    return env.Undefined();
+}
+
+Napi::Value PauseSoundcheck(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.core->get_player()->pause();
+    return env.Undefined();
+}
+
+Napi::Value SeekSoundcheck(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (seconds: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    return Napi::Boolean::New(env, engine.core->get_player()->seek(info[0].As<Napi::Number>().DoubleValue()));
+}
+
+// Loop part of the soundcheck: setSoundcheckLoop(start, end, crossfade?) or setSoundcheckLoop(null)
+Napi::Value SetSoundcheckLoop(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() >= 1 && info[0].IsNull()) {
+        engine.core->get_player()->clear_loop();
+        return Napi::Boolean::New(env, true);
+    }
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()
+        || (info.Length() >= 3 && !info[2].IsNumber())) {
+        Napi::TypeError::New(env, "Expected (startSeconds: number, endSeconds: number, crossfadeSeconds?: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    double start = info[0].As<Napi::Number>().DoubleValue();
+    double end = info[1].As<Napi::Number>().DoubleValue();
+    double crossfade = info.Length() >= 3 ? info[2].As<Napi::Number>().DoubleValue() : 0.0;
+    return Napi::Boolean::New(env, engine.core->get_player()->set_loop(start, end, crossfade));
+}
+
+// Switch inputs between live and recorded: setInputSource(input | 'all', 'live' | 'playback')
+Napi::Value SetInputSource(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !(info[0].IsNumber() || info[0].IsString()) || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected (inputChannel: number | 'all', source: 'live' | 'playback')")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string source = info[1].As<Napi::String>().Utf8Value();
+    if (source != "live" && source != "playback") {
+        Napi::TypeError::New(env, "source must be 'live' or 'playback'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto* player = engine.core->get_player();
+    if (info[0].IsString()) {
+        player->set_all_inputs_source(source == "playback");
+        return Napi::Boolean::New(env, true);
+    }
+    return Napi::Boolean::New(env, player->set_input_source(info[0].As<Napi::Number>().Int32Value(), source == "playback"));
+}
+
+// Soundcheck position and read-ahead health
+Napi::Value GetSoundcheckStatus(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    PlaybackStatus status = engine.core->get_player()->get_status();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("isLoaded", Napi::Boolean::New(env, status.is_loaded));
+    obj.Set("isPlaying", Napi::Boolean::New(env, status.is_playing));
+    obj.Set("reachedEnd", Napi::Boolean::New(env, status.reached_end));
+    obj.Set("isLooping", Napi::Boolean::New(env, status.is_looping));
+    obj.Set("numTracks", Napi::Number::New(env, status.num_tracks));
+    obj.Set("positionSeconds", Napi::Number::New(env, status.position_seconds));
+    obj.Set("durationSeconds", Napi::Number::New(env, status.duration_seconds));
+    obj.Set("bufferedSeconds", Napi::Number::New(env, status.buffered_seconds));
+    obj.Set("underrunBlocks", Napi::Number::New(env, static_cast<double>(status.underrun_blocks)));
+    obj.Set("bytesRead", Napi::Number::New(env, static_cast<double>(status.bytes_read)));
+    obj.Set("readRequests", Napi::Number::New(env, static_cast<double>(status.read_requests)));
+    obj.Set("maxReadMs", Napi::Number::New(env, status.max_read_ms));
+
+    auto* scheduler = engine.core->get_read_scheduler();
+    ReadSchedulerStats io = scheduler->get_stats();
+    obj.Set("ioBackend", Napi::String::New(env, scheduler->get_backend_name()));
+    obj.Set("ioMissedDeadlines", Napi::Number::New(env, static_cast<double>(io.missed_deadlines)));
+    obj.Set("ioMaxInFlight", Napi::Number::New(env, io.max_in_flight));
+    return obj;
+}
+
+// Capture every voice, bus, input and output level under a name
+Napi::Value CaptureScene(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (name: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    return Napi::Boolean::New(env, engine.core->get_scene_manager()->capture_scene(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// Recall a stored scene at the next block boundary: recallScene(name, rampSeconds?)
+Napi::Value RecallScene(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString() || (info.Length() >= 2 && !info[1].IsNumber())) {
+        Napi::TypeError::New(env, "Expected (name: string, rampSeconds?: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    double ramp_seconds = info.Length() >= 2 ? info[1].As<Napi::Number>().DoubleValue() : 0.0;
+    return Napi::Boolean::New(env, engine.core->get_scene_manager()->recall_scene(name, ramp_seconds));
+}
+
+// Delete a stored scene
+Napi::Value DeleteScene(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (name: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    return Napi::Boolean::New(env, engine.core->get_scene_manager()->remove_scene(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// List stored scenes
+Napi::Value GetScenes(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::vector<SceneInfo> scenes = engine.core->get_scene_manager()->get_scenes();
+    Napi::Array array = Napi::Array::New(env, scenes.size());
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("name", Napi::String::New(env, scenes[i].name));
+        obj.Set("numParameters", Napi::Number::New(env, static_cast<double>(scenes[i].num_parameters)));
+        array[i] = obj;
+    }
+    return array;
+}
+
+// Start the native OSC listener (see show_control/osc_server.h for the address space)
+Napi::Value StartOscServer(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected (options: { port: number, bindAddress?: string })").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("port").IsNumber()) {
+        Napi::TypeError::New(env, "Expected (options: { port: number, bindAddress?: string })").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const int port = options.Get("port").As<Napi::Number>().Int32Value();
+    std::string bind_address = "0.0.0.0";
+    if (options.Has("bindAddress")) {
+        bind_address = options.Get("bindAddress").As<Napi::String>().Utf8Value();
+    }
+
+    if (engine.osc_server && engine.osc_server->is_running()) {
+        Napi::Error::New(env, "OSC server already running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    engine.osc_server = std::make_unique<OscServer>(engine.core.get());
+    RefreshOscAddresses(engine);
+    if (!engine.osc_server->start(port, bind_address)) {
+        Napi::Error::New(env, engine.osc_server->get_last_error()).ThrowAsJavaScriptException();
+        engine.osc_server.reset();
+        return env.Undefined();
+    }
+
+    return Napi::Number::New(env, engine.osc_server->get_port());
+}
+
+Napi::Value StopOscServer(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    engine.osc_server.reset();
+    return env.Undefined();
+}
+
+Napi::Value GetOscStatus(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object obj = Napi::Object::New(env);
+    const bool running = engine.osc_server && engine.osc_server->is_running();
+    obj.Set("running", Napi::Boolean::New(env, running));
+    if (!running) {
+        return obj;
+    }
+
+    const OscServerStats stats = engine.osc_server->get_stats();
+    obj.Set("port", Napi::Number::New(env, engine.osc_server->get_port()));
+    obj.Set("packetsReceived", Napi::Number::New(env, static_cast<double>(stats.packets_received)));
+    obj.Set("messagesDispatched", Napi::Number::New(env, static_cast<double>(stats.messages_dispatched)));
+    obj.Set("messagesUnmatched", Napi::Number::New(env, static_cast<double>(stats.messages_unmatched)));
+    obj.Set("packetsMalformed", Napi::Number::New(env, static_cast<double>(stats.packets_malformed)));
+    obj.Set("commandsDropped", Napi::Number::New(env, static_cast<double>(stats.commands_dropped)));
+    obj.Set("bundlesScheduled", Napi::Number::New(env, static_cast<double>(stats.bundles_scheduled)));
+    return obj;
+}
+
+// MIDI inputs available for triggers
+Napi::Value GetMidiInputs(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::vector<std::string> devices = MidiTriggerInput::get_available_devices();
+    Napi::Array array = Napi::Array::New(env, devices.size());
+    for (size_t i = 0; i < devices.size(); ++i) {
+        array[i] = Napi::String::New(env, devices[i]);
+    }
+    return array;
+}
+
+static MidiTriggerInput* GetMidiInput(EngineContext& engine) {
+    if (!engine.midi_input) {
+        engine.midi_input = std::make_unique<MidiTriggerInput>(engine.core.get());
+    }
+    return engine.midi_input.get();
+}
+
+// Open a MIDI input for triggers (see show_control/midi_trigger_input.h)
+Napi::Value OpenMidiInput(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected (options: { device?: string, virtualPort?: string, latencyMs?: number })").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    MidiTriggerInput* input = GetMidiInput(engine);
+    if (options.Has("latencyMs")) {
+        input->set_latency_ms(options.Get("latencyMs").As<Napi::Number>().DoubleValue());
+    }
+
+    bool success = false;
+    if (options.Has("virtualPort")) {
+        success = input->open_virtual(options.Get("virtualPort").As<Napi::String>().Utf8Value());
+    } else if (options.Has("device")) {
+        success = input->open(options.Get("device").As<Napi::String>().Utf8Value());
+    } else {
+        Napi::TypeError::New(env, "Expected device or virtualPort").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (!success) {
+        Napi::Error::New(env, input->get_last_error()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::String::New(env, input->get_device_name());
+}
+
+Napi::Value CloseMidiInput(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (engine.midi_input) {
+        engine.midi_input->close();
+    }
+    return env.Undefined();
+}
+
+// Replace the trigger tables:
+// { notes: [{ channel, note, cueId, stop? }], msc: [{ cue, cueId }], mscDeviceId?, mscCommandFormat? }
+Napi::Value SetMidiTriggers(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        Napi::Error::New(env, "Audio core not initialized").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected (triggers: { notes?: [], msc?: [], mscDeviceId?: number, mscCommandFormat?: number })").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object triggers = info[0].As<Napi::Object>();
+    MidiTriggerMap map;
+    if (triggers.Has("mscDeviceId")) {
+        map.msc_device_id = triggers.Get("mscDeviceId").As<Napi::Number>().Int32Value();
+    }
+    if (triggers.Has("mscCommandFormat")) {
+        map.msc_command_format = triggers.Get("mscCommandFormat").As<Napi::Number>().Int32Value();
+    }
+
+    if (triggers.Get("notes").IsArray()) {
+        Napi::Array notes = triggers.Get("notes").As<Napi::Array>();
+        for (uint32_t i = 0; i < notes.Length(); ++i) {
+            Napi::Value value = notes[i];
+            if (!value.IsObject()) {
+                continue;
+            }
+            Napi::Object note = value.As<Napi::Object>();
+            MidiNoteTrigger trigger;
+            if (note.Has("channel")) {
+                trigger.channel = note.Get("channel").As<Napi::Number>().Int32Value();
+            }
+            trigger.note = note.Get("note").As<Napi::Number>().Int32Value();
+            trigger.cue_id = note.Get("cueId").As<Napi::String>().Utf8Value();
+            trigger.stop = note.Has("stop") && note.Get("stop").ToBoolean().Value();
+            map.notes.push_back(trigger);
+        }
+    }
+
+    if (triggers.Get("msc").IsArray()) {
+        Napi::Array cues = triggers.Get("msc").As<Napi::Array>();
+        for (uint32_t i = 0; i < cues.Length(); ++i) {
+            Napi::Value value = cues[i];
+            if (!value.IsObject()) {
+                continue;
+            }
+            Napi::Object cue = value.As<Napi::Object>();
+            map.msc_cues.push_back({ cue.Get("cue").ToString().Utf8Value(), cue.Get("cueId").As<Napi::String>().Utf8Value() });
+        }
+    }
+
+    GetMidiInput(engine)->set_mappings(map);
+    return env.Undefined();
+}
+
+Napi::Value GetMidiStatus(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object obj = Napi::Object::New(env);
+    const bool open = engine.midi_input && engine.midi_input->is_open();
+    obj.Set("open", Napi::Boolean::New(env, open));
+    if (!engine.midi_input) {
+        return obj;
+    }
+
+    const MidiTriggerStats stats = engine.midi_input->get_stats();
+    if (open) {
+        obj.Set("device", Napi::String::New(env, engine.midi_input->get_device_name()));
+    }
+    obj.Set("messagesReceived", Napi::Number::New(env, static_cast<double>(stats.messages_received)));
+    obj.Set("commandsDispatched", Napi::Number::New(env, static_cast<double>(stats.commands_dispatched)));
+    obj.Set("messagesUnmatched", Napi::Number::New(env, static_cast<double>(stats.messages_unmatched)));
+    obj.Set("commandsDropped", Napi::Number::New(env, static_cast<double>(stats.commands_dropped)));
+    return obj;
+}
+
+#ifndef _WIN32
+static EngineHostClient* RequireEngineHost(Napi::Env env) {
+    EngineHostClient* host = GetAddonData(env)->engine_host.get();
+    if (!host || !host->is_connected()) {
+        Napi::Error::New(env, "Engine host not connected").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return host;
+}
+
+// Launch the engine host, or reattach to one that outlived an earlier UI
+Napi::Value ConnectEngineHost(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected (options: { hostPath, segmentName?, sampleRate?, bufferSize?, "
+            "inputChannels?, outputChannels?, deviceName? })").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Napi::Object config = info[0].As<Napi::Object>();
+    EngineHostOptions options;
+    if (config.Has("hostPath")) {
+        options.host_executable = config.Get("hostPath").As<Napi::String>().Utf8Value();
+    }
+    if (config.Has("segmentName")) {
+        options.segment_name = config.Get("segmentName").As<Napi::String>().Utf8Value();
+    }
+    if (config.Has("deviceName")) {
+        options.settings.device_name = config.Get("deviceName").As<Napi::String>().Utf8Value();
+    }
+    if (config.Has("sampleRate")) {
+        options.settings.sample_rate = config.Get("sampleRate").As<Napi::Number>().Int32Value();
+    }
+    if (config.Has("bufferSize")) {
+        options.settings.buffer_size = config.Get("bufferSize").As<Napi::Number>().Int32Value();
+    }
+    if (config.Has("inputChannels")) {
+        options.settings.input_channels = config.Get("inputChannels").As<Napi::Number>().Int32Value();
+    }
+    if (config.Has("outputChannels")) {
+        options.settings.output_channels = config.Get("outputChannels").As<Napi::Number>().Int32Value();
+    }
+
+    AddonData* data = GetAddonData(env);
+    if (!data->engine_host) {
+        data->engine_host = std::make_unique<EngineHostClient>();
+    }
+    EngineHostClient* host = data->engine_host.get();
+
+    Napi::Object result = Napi::Object::New(env);
+    const bool success = host->connect(options);
+    result.Set("connected", Napi::Boolean::New(env, success));
+    result.Set("reattached", Napi::Boolean::New(env, success && host->was_reattached()));
+    if (!success) {
+        result.Set("error", Napi::String::New(env, host->get_last_error()));
+    }
+    return result;
+}
+
+// Unmap the host; audio keeps running
+Napi::Value DisconnectEngineHost(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = GetAddonData(env)->engine_host.get();
+    if (host) {
+        host->disconnect();
+    }
+    return env.Undefined();
+}
+
+// Stop the host process and its audio
+Napi::Value ShutdownEngineHost(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+    bool success = host->shutdown_host();
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value IsEngineHostAlive(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    EngineHostClient* host = GetAddonData(env)->engine_host.get();
+    return Napi::Boolean::New(env, host && host->is_host_alive());
+}
+
+// Load a cue in the host (waits for the decode)
+Napi::Value HostLoadAudioCue(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, filePath: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool success = host->load_audio_cue(info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::String>().Utf8Value());
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value HostUnloadAudioCue(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (cueId: string)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool success = host->unload_audio_cue(info[0].As<Napi::String>().Utf8Value());
+    return Napi::Boolean::New(env, success);
+}
+
+Napi::Value HostSetCueLoop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected (cueId: string, loop: boolean)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    bool success = host->set_cue_loop(info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::Boolean>().Value());
+    return Napi::Boolean::New(env, success);
+}
+
+// Hot path: (type, cueId, value?) straight into the host's command ring,
+// types as in lib/command_ring.js CommandType
+Napi::Value HostSendCommand(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected (type: number, cueId: string, value?: number)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    AudioThreadMessage msg;
+    msg.type = static_cast<AudioThreadMessage::Type>(info[0].As<Napi::Number>().Int32Value());
+    std::string cue_id = info[1].As<Napi::String>().Utf8Value();
+    strncpy(msg.cue_id, cue_id.c_str(), sizeof(msg.cue_id) - 1);
+    const double value = info.Length() > 2 && info[2].IsNumber() ? info[2].As<Napi::Number>().DoubleValue() : 0.0;
+    if (msg.type == AudioThreadMessage::SEEK) {
+        msg.param1.double_value = value;
+    }
+    else {
+        msg.param1.float_value = static_cast<float>(value);
+    }
+
+    return Napi::Boolean::New(env, host->send_command(msg));
+}
+
+// The host's command ring for lib/command_ring.js (new CommandRing(buffer)),
+// so commands skip N-API entirely. Null where external buffers are not allowed.
+Napi::Value GetEngineHostCommandBuffer(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    EngineHostClient* host = RequireEngineHost(env);
+    if (!host) {
+        return env.Undefined();
+    }
+
+#ifdef NODE_API_NO_EXTERNAL_BUFFERS_ALLOWED
+    return env.Null();
+#else
+    void* ring = host->get_command_ring();
+    if (ring == nullptr) {
+        Napi::Error::New(env, host->get_last_error()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // The buffer holds the mapping, and with it this client's claim on the
+    // ring: disconnect or shutdown leave it mapped until it is collected
+    auto* keep_alive = new std::shared_ptr<void>(host->retain_mapping());
+    return Napi::ArrayBuffer::New(env, ring, host->get_command_ring_bytes(),
+        [](Napi::Env, void*, std::shared_ptr<void>* hint) { delete hint; },
+        keep_alive);
+#endif
+}
+
+// Latest status and output meters published by the host
+Napi::Value GetEngineHostStatus(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!RequireEngineHost(env)) {
+        return env.Undefined();
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("alive", Napi::Boolean::New(env, host->is_host_alive()));
+
+    static HostStatusFrame status; // Large, and only touched from the JS thread
+    if (host->read_status(status)) {
+        obj.Set("metrics", PerformanceMetricsToJS(env, status.metrics));
+        Napi::Array array = Napi::Array::New(env, status.num_cues);
+        for (int i = 0; i < status.num_cues; ++i) {
+            const HostCueStatus& cue = status.cues[i];
+            AudioCueInfo cue_info{};
+            cue_info.cue_id = cue.cue_id;
+            cue_info.state = static_cast<CueState>(cue.state);
+            cue_info.is_looping = cue.is_looping != 0;
+            cue_info.is_loaded = true;
+            cue_info.current_position_seconds = cue.position_seconds;
+            cue_info.duration_seconds = cue.duration_seconds;
+            cue_info.volume = cue.volume;
+            cue_info.pan = cue.pan;
+            cue_info.peak_left = cue.peak_left;
+            cue_info.peak_right = cue.peak_right;
+            array[i] = AudioCueInfoToJS(env, cue_info);
+        }
+        obj.Set("activeCues", array);
+    }
+
+    static HostMeterFrame meters;
+    if (host->read_meters(meters)) {
+        Napi::Array array = Napi::Array::New(env, meters.num_outputs);
+        for (int i = 0; i < meters.num_outputs; ++i) {
+            Napi::Object meter = Napi::Object::New(env);
+            meter.Set("peak", Napi::Number::New(env, meters.outputs[i].peak));
+            meter.Set("rms", Napi::Number::New(env, meters.outputs[i].rms));
+            meter.Set("truePeak", Napi::Number::New(env, meters.outputs[i].true_peak));
+            array[i] = meter;
+        }
+        obj.Set("outputMeters", array);
+    }
+
+    return obj;
+}
+#endif
+
+// Get last error
+Napi::Value GetLastError(EngineContext& engine, const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!engine.core) {
+        return Napi::String::New(env, "Audio core not initialized");
+    }
+
+    std::string error = engine.core->get_last_error();
+    return Napi::String::New(env, error);
+}
+
+// Engine functions, exported at module level (default engine of the
+// environment) and as AudioEngine methods (that object's engine)
+using EngineFunction = Napi::Value (*)(EngineContext&, const Napi::CallbackInfo&);
+
+struct EngineFunctionEntry {
+    const char* name;
+    EngineFunction function;
+};
+
+static const EngineFunctionEntry kEngineFunctions[] = {
+    // Core functions
+    { "initialize", Initialize },
+    { "shutdown", Shutdown },
+    { "detectHardware", DetectHardware },
+    { "getAvailableDevices", GetAvailableDevices },
+    { "startAudio", StartAudio },
+    { "stopAudio", StopAudio },
+    { "getPerformanceMetrics", GetPerformanceMetrics },
+    { "getLastError", GetLastError },
+    { "getStageProfile", GetStageProfile },
+    { "startCommandCapture", StartCommandCapture },
+    { "attachCommandRing", AttachCommandRing },
+    { "detachCommandRing", DetachCommandRing },
+    { "stopCommandCapture", StopCommandCapture },
+
+    // Cue management functions
+    { "loadAudioCue", LoadAudioCue },
+    { "startCue", StartCue },
+    { "stopCue", StopCue },
+    { "setCueVolume", SetCueVolume },
+    { "fadeInCue", FadeInCue },
+    { "fadeOutCue", FadeOutCue },
+    { "setCueLoop", SetCueLoop },
+    { "setCueLoopRegion", SetCueLoopRegion },
+    { "getActiveCues", GetActiveCues },
+
+    // Scene functions
+    { "captureScene", CaptureScene },
+    { "recallScene", RecallScene },
+    { "deleteScene", DeleteScene },
+    { "getScenes", GetScenes },
+
+    // Crossfade functions
+    { "startCrossfade", StartCrossfade },
+    { "getCrossfadeProgress", GetCrossfadeProgress },
+    { "isCrossfading", IsCrossfading },
+
+    // Mix bus and plugin insert functions
+    { "addBus", AddBus },
+    { "loadBusInsert", LoadBusInsert },
+    { "loadOutputInsert", LoadOutputInsert },
+    { "getBusInfo", GetBusInfo },
+
+    // Metering functions
+    { "getOutputMeters", GetOutputMeters },
+    { "getBusMeters", GetBusMeters },
+    { "getCueMeters", GetCueMeters },
+    { "getInputMeters", GetInputMeters },
+    { "resetMeterClips", ResetMeterClips },
+
+    // Loudness functions
+    { "getCueLoudness", GetCueLoudness },
+    { "normalizeCueLoudness", NormalizeCueLoudness },
+    { "setCueTrim", SetCueTrim },
+    { "getOutputLoudness", GetOutputLoudness },
+    { "resetOutputLoudness", ResetOutputLoudness },
+
+    // Waveform overview functions
+    { "getCueWaveformInfo", GetCueWaveformInfo },
+    { "getCueWaveformLevel", GetCueWaveformLevel },
+    { "renderCueWaveform", RenderCueWaveform },
+
+    // Asset storage functions
+    { "setSampleStoragePolicy", SetSampleStoragePolicy },
+    { "getAssetMemory", GetAssetMemory },
+
+    // Live input functions
+    { "setInputRoute", SetInputRoute },
+    { "getInputRoute", GetInputRoute },
+
+    // Recording functions
+    { "startRecording", StartRecording },
+    { "stopRecording", StopRecording },
+    { "getRecordingStatus", GetRecordingStatus },
+
+    // Virtual soundcheck functions
+    { "loadSoundcheck", LoadSoundcheck },
+    { "playSoundcheck", PlaySoundcheck },
+    { "pauseSoundcheck", PauseSoundcheck },
+    { "seekSoundcheck", SeekSoundcheck },
+    { "setSoundcheckLoop", SetSoundcheckLoop },
+    { "setInputSource", SetInputSource },
+    { "getSoundcheckStatus", GetSoundcheckStatus },
+
+    // Spectrum analyzer functions
+    { "createSpectrumAnalyzer", CreateSpectrumAnalyzer },
+    { "destroySpectrumAnalyzer", DestroySpectrumAnalyzer },
+    { "getSpectrumBuffer", GetSpectrumBuffer },
+    { "getSpectrumFrame", GetSpectrumFrame },
+
+    // OSC control functions
+    { "startOscServer", StartOscServer },
+    { "stopOscServer", StopOscServer },
+    { "getOscStatus", GetOscStatus },
+
+    // MIDI trigger functions
+    { "getMidiInputs", GetMidiInputs },
+    { "openMidiInput", OpenMidiInput },
+    { "closeMidiInput", CloseMidiInput },
+    { "setMidiTriggers", SetMidiTriggers },
+    { "getMidiStatus", GetMidiStatus },
+};
+
+static Napi::Value DispatchDefaultEngine(const Napi::CallbackInfo& info) {
+    auto function = reinterpret_cast<EngineFunction>(info.Data());
+    return function(GetAddonData(info.Env())->default_engine, info);
+}
+
+// An engine of its own, e.g. a headphone preview engine next to the main PA:
+//
+//   const preview = new audio.AudioEngine();
+//   preview.initialize({ deviceName: 'Headphones', outputChannels: 2 });
+//
+// The device is released by shutdown(), or when the object is collected.
+class AudioEngine : public Napi::ObjectWrap<AudioEngine> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        std::vector<Napi::ClassPropertyDescriptor<AudioEngine>> methods;
+        for (const auto& entry : kEngineFunctions) {
+            methods.push_back(InstanceMethod(entry.name, &AudioEngine::Dispatch, napi_default,
+                reinterpret_cast<void*>(entry.function)));
+        }
+        return DefineClass(env, "AudioEngine", methods);
+    }
+
+    explicit AudioEngine(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<AudioEngine>(info) {}
+
+private:
+    Napi::Value Dispatch(const Napi::CallbackInfo& info) {
+        auto function = reinterpret_cast<EngineFunction>(info.Data());
+        return function(engine_, info);
+    }
+
+    EngineContext engine_;
+};
+
+// Module initialization. Runs once per environment (main thread and each
+// worker), each with its own AddonData.
+Napi::Object Init(Napi::Env env, Napi::Object exports) {
+    AddonData* data = new AddonData();
+    env.SetInstanceData(data);
+
+    for (const auto& entry : kEngineFunctions) {
+        exports.Set(entry.name, Napi::Function::New(env, DispatchDefaultEngine, entry.name,
+            reinterpret_cast<void*>(entry.function)));
+    }
+
+    Napi::Function engine_class = AudioEngine::Define(env);
+    data->engine_constructor = Napi::Persistent(engine_class);
+    exports.Set("AudioEngine", engine_class);
+
+#ifndef _WIN32
+    // Engine host functions (engine in its own process)
+    exports.Set("connectEngineHost", Napi::Function::New(env, ConnectEngineHost));
+    exports.Set("disconnectEngineHost", Napi::Function::New(env, DisconnectEngineHost));
+    exports.Set("shutdownEngineHost", Napi::Function::New(env, ShutdownEngineHost));
+    exports.Set("isEngineHostAlive", Napi::Function::New(env, IsEngineHostAlive));
+    exports.Set("hostLoadAudioCue", Napi::Function::New(env, HostLoadAudioCue));
+    exports.Set("hostUnloadAudioCue", Napi::Function::New(env, HostUnloadAudioCue));
+    exports.Set("hostSetCueLoop", Napi::Function::New(env, HostSetCueLoop));
+    exports.Set("hostSendCommand", Napi::Function::New(env, HostSendCommand));
+    exports.Set("getEngineHostCommandBuffer", Napi::Function::New(env, GetEngineHostCommandBuffer));
+    exports.Set("getEngineHostStatus", Napi::Function::New(env, GetEngineHostStatus));
+#endif
 
     return exports;
 }
@@ -0,0 +1,171 @@
+﻿#include "shared_audio/shared_audio_core.h"
+#include "show_control/cue_audio_manager.h"
+#include "show_control/scene_manager.h"
+#include "processing/mix_graph.h"
+#include "core/command_capture.h"
+#include <algorithm>
+#include <memory>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace SharedAudio;
+
+// Replays a command capture (SharedAudioCore::start_command_capture) through
+// an offline engine: loads the captured asset manifest, rebuilds the bus
+// layout, restores the levels and every voice's transport state from the
+// header, then applies every command directly (never through the command
+// queue, which could reorder or coalesce them) in file order at the block
+// it was applied live. Renders the same block sizes and compares each
+// block's output checksum with the live one. Prints the per-stage timing
+// profile, so an incident becomes a repeatable benchmark.
+//
+// Record times are relative to the capture's base sample, so the replay
+// clock starts at 0. Live device inputs are not captured and are replayed
+// as silence; shows that mix live inputs will diverge from the first block
+// that used them. Fades and ramps in flight when the capture started are
+// not in the snapshot either.
+
+namespace {
+
+    struct ReplayResult {
+        uint64_t blocks = 0;
+        uint64_t commands = 0;
+        uint64_t mismatches = 0;
+        uint64_t gaps = 0;
+        uint64_t first_mismatch = 0;
+    };
+
+    bool replay(const std::string& path, ReplayResult& result) {
+        CaptureReader reader;
+        if (!reader.open(path)) {
+            std::cout << "  ❌ Cannot read capture " << path << "\n";
+            return false;
+        }
+        const CaptureHeader& header = reader.get_header();
+
+        auto core = create_audio_core();
+        AudioSettings settings;
+        settings.offline = true;
+        settings.sample_rate = header.sample_rate;
+        settings.input_channels = header.num_inputs;
+        settings.output_channels = header.num_outputs;
+        if (!core->initialize(settings)) {
+            std::cout << "  ❌ " << core->get_last_error() << "\n";
+            return false;
+        }
+
+        CueAudioManager* cue_manager = core->get_cue_manager();
+        for (const auto& asset : header.assets) {
+            if (!cue_manager->load_audio_cue(asset.cue_id, asset.file_path)) {
+                std::cout << "  ⚠️  Missing asset " << asset.cue_id << " (" << asset.file_path << ")\n";
+            }
+        }
+
+        // Bus 0 exists in every engine; the others are added in order
+        MixGraph* mix_graph = core->get_mix_graph();
+        for (size_t bus = 0; bus < header.buses.size(); ++bus) {
+            const CaptureBus& layout = header.buses[bus];
+            if (bus == 0) {
+                mix_graph->set_bus_output(0, layout.first_output_channel);
+            }
+            else if (mix_graph->add_bus(layout.name, layout.num_channels, layout.first_output_channel)
+                != static_cast<int>(bus)) {
+                std::cout << "  ⚠️  Cannot rebuild bus " << bus << " (" << layout.name << ")\n";
+            }
+        }
+        core->get_scene_manager()->recall(std::make_shared<SceneSnapshot>(header.levels), 0.0);
+
+        for (const auto& voice : header.voices) {
+            if (!cue_manager->restore_playback_state(voice)) {
+                std::cout << "  ⚠️  Cannot restore voice " << voice.cue_id << "\n";
+            }
+        }
+
+        AudioBuffer inputs(header.num_inputs);
+        AudioBuffer outputs;
+        uint64_t rendered = 0;
+        int last_block = 256;
+        CaptureRecord record;
+
+        auto render = [&](int num_samples) {
+            for (auto& channel : inputs) {
+                channel.assign(num_samples, 0.0f);
+            }
+            core->render_offline(inputs, outputs, num_samples);
+            rendered += static_cast<uint64_t>(num_samples);
+        };
+
+        // Records dropped live: keep the sample clock aligned
+        auto render_up_to = [&](uint64_t sample_time) {
+            while (rendered < sample_time) {
+                render(static_cast<int>(std::min<uint64_t>(last_block, sample_time - rendered)));
+                ++result.gaps;
+            }
+        };
+
+        while (reader.next(record)) {
+            if (record.kind == CaptureRecord::COMMAND) {
+                // Lands at the top of the block starting at record.sample_time
+                render_up_to(record.sample_time);
+                core->apply_command_offline(record.message);
+                ++result.commands;
+                continue;
+            }
+
+            render_up_to(record.sample_time);
+
+            render(record.num_samples);
+            last_block = record.num_samples;
+            ++result.blocks;
+            if (checksum_block(outputs, record.num_samples) != record.checksum) {
+                if (result.mismatches++ == 0) {
+                    result.first_mismatch = record.sample_time;
+                }
+            }
+        }
+
+        std::cout << "\nStage profile (" << header.sample_rate << " Hz, "
+            << header.num_inputs << " in, " << header.num_outputs << " out):\n";
+        for (const auto& stage : core->get_stage_profile()) {
+            std::cout << "  " << std::left << std::setw(14) << stage.name << std::right
+                << std::fixed << std::setprecision(2)
+                << std::setw(10) << stage.average_us << " us avg"
+                << std::setw(10) << stage.max_us << " us max\n";
+        }
+
+        core->shutdown();
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: command_replay <capture file>\n";
+        return 1;
+    }
+
+    std::cout << "==========================================\n";
+    std::cout << "  Command Capture Replay\n";
+    std::cout << "==========================================\n";
+    std::cout << "Capture: " << argv[1] << "\n";
+
+    ReplayResult result;
+    if (!replay(argv[1], result)) {
+        return 1;
+    }
+
+    std::cout << "\nBlocks: " << result.blocks << ", commands: " << result.commands << "\n";
+    if (result.gaps > 0) {
+        std::cout << "  ⚠️  " << result.gaps << " blocks missing from the capture (records dropped live)\n";
+    }
+    if (result.mismatches == 0) {
+        std::cout << "  ✅ Output identical to the live run\n";
+        return 0;
+    }
+
+    std::cout << "  ❌ " << result.mismatches << " blocks differ, first at sample " << result.first_mismatch << "\n";
+    return 2;
+}
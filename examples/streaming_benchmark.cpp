@@ -0,0 +1,232 @@
+﻿#include "io/read_scheduler.h"
+#include "io/recording_file.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SharedAudio;
+
+// Streams sustained per disk: N simulated voices each play a stereo float
+// file in real time out of a 1 s read-ahead buffer, refilled in 256 KiB
+// reads through the ReadScheduler. The stream count doubles until a run
+// underruns. Pass --direct to bypass the page cache, otherwise the test
+// files are served from memory after the first pass.
+
+namespace {
+
+    constexpr int kSampleRate = 48000;
+    constexpr int kChannels = 2;
+    constexpr int kFrameBytes = kChannels * 4;
+    constexpr int kNumFiles = 8;
+    constexpr int kFileSeconds = 20;
+    constexpr size_t kChunkBytes = 256 * 1024;
+    constexpr int kChunkFrames = static_cast<int>(kChunkBytes / kFrameBytes);
+    constexpr int kBufferFrames = kSampleRate; // 1 s read-ahead per stream
+
+    struct Stream {
+        RecordingFile file;
+        RecordingFileInfo info;
+        AlignedBuffer buffer;
+        uint64_t next_frame = 0;
+        std::atomic<int64_t> buffered_frames{ 0 };
+        std::atomic<bool> read_in_flight{ false };
+        uint64_t underruns = 0;
+    };
+
+    struct RunResult {
+        uint64_t underruns = 0;
+        double megabytes_per_second = 0.0;
+        ReadSchedulerStats stats;
+    };
+
+    bool create_test_files(const std::string& directory, std::vector<std::string>& paths) {
+        const uint64_t frames = static_cast<uint64_t>(kSampleRate) * kFileSeconds;
+        std::vector<float> block(static_cast<size_t>(kChunkFrames) * kChannels);
+        std::vector<uint8_t> header(kRecordingHeaderBytes);
+
+        for (int f = 0; f < kNumFiles; ++f) {
+            std::string path = directory + "/stream_bench_" + std::to_string(f) + ".w64";
+            RecordingFile file;
+            if (!file.open_for_write(path)) {
+                std::cout << "  ❌ Cannot create " << path << "\n";
+                return false;
+            }
+
+            for (size_t i = 0; i < block.size(); ++i) {
+                block[i] = static_cast<float>((i + f) % 200) / 100.0f - 1.0f;
+            }
+            uint64_t written = 0;
+            while (written < frames) {
+                const uint64_t count = std::min<uint64_t>(kChunkFrames, frames - written);
+                file.write_at(kRecordingHeaderBytes + written * kFrameBytes, block.data(), count * kFrameBytes);
+                written += count;
+            }
+            build_recording_header(header.data(), RecordingFileFormat::W64, kChannels, kSampleRate, 4, true,
+                frames * kFrameBytes, true);
+            file.write_at(0, header.data(), header.size());
+            paths.push_back(path);
+        }
+        return true;
+    }
+
+    void request_refill(ReadScheduler& scheduler, Stream& stream) {
+        const int64_t buffered = stream.buffered_frames.load();
+        if (stream.read_in_flight.load() || buffered + kChunkFrames > kBufferFrames) {
+            return;
+        }
+
+        if (stream.next_frame + kChunkFrames > stream.info.num_frames) {
+            stream.next_frame = 0; // Loop the file
+        }
+
+        ReadRequest request;
+        request.file = &stream.file;
+        request.offset = stream.info.data_offset + stream.next_frame * kFrameBytes;
+        request.buffer = stream.buffer.data();
+        request.bytes = kChunkBytes;
+        request.deadline = std::chrono::steady_clock::now()
+            + std::chrono::microseconds(buffered * 1000000 / kSampleRate);
+        request.on_complete = [&stream](int64_t result) {
+            if (result > 0) {
+                stream.buffered_frames.fetch_add(result / kFrameBytes);
+            }
+            stream.read_in_flight.store(false);
+        };
+
+        stream.next_frame += kChunkFrames;
+        stream.read_in_flight.store(true);
+        scheduler.submit(std::move(request));
+    }
+
+    RunResult run_streams(ReadScheduler& scheduler, const std::vector<std::string>& paths,
+        int num_streams, bool direct_io, double seconds) {
+        std::vector<std::unique_ptr<Stream>> streams;
+        for (int s = 0; s < num_streams; ++s) {
+            auto stream = std::make_unique<Stream>();
+            std::string error;
+            stream->file.open_for_read(paths[s % paths.size()]);
+            parse_recording_header(stream->file, stream->info, error);
+            if (direct_io) {
+                stream->file.open_for_read(paths[s % paths.size()], true);
+            }
+            stream->buffer.allocate(kChunkBytes);
+            // Spread the voices over the file so they do not read in step
+            stream->next_frame = (static_cast<uint64_t>(s) * 7919 * kChunkFrames) % (stream->info.num_frames - kChunkFrames);
+            streams.push_back(std::move(stream));
+        }
+
+        // Pre-roll: every stream starts full, as a cue would after loading
+        scheduler.reset_stats();
+        for (int fill = 0; fill < kBufferFrames / kChunkFrames; ++fill) {
+            for (auto& stream : streams) {
+                while (stream->read_in_flight.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                request_refill(scheduler, *stream);
+            }
+        }
+        for (auto& stream : streams) {
+            while (stream->read_in_flight.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        scheduler.reset_stats();
+
+        // Real-time playback: consume by wall clock, refill below the high-water mark
+        const auto start = std::chrono::steady_clock::now();
+        auto last = start;
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            const auto now = std::chrono::steady_clock::now();
+            const int64_t consumed = std::chrono::duration_cast<std::chrono::microseconds>(now - last).count() * kSampleRate / 1000000;
+            last = now;
+
+            for (auto& stream : streams) {
+                if (stream->buffered_frames.fetch_sub(consumed) < consumed) {
+                    stream->underruns++;
+                    stream->buffered_frames.store(0);
+                }
+                request_refill(scheduler, *stream);
+            }
+        }
+
+        for (auto& stream : streams) {
+            while (stream->read_in_flight.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        RunResult result;
+        for (auto& stream : streams) {
+            result.underruns += stream->underruns;
+        }
+        result.stats = scheduler.get_stats();
+        result.megabytes_per_second = result.stats.bytes_read / (1024.0 * 1024.0) / seconds;
+        return result;
+    }
+
+    void benchmark_backend(bool prefer_io_uring, const std::vector<std::string>& paths,
+        bool direct_io, double seconds, int max_streams) {
+        ReadScheduler scheduler;
+        ReadSchedulerSettings settings;
+        settings.prefer_io_uring = prefer_io_uring;
+        scheduler.start(settings);
+
+        if (prefer_io_uring && scheduler.get_backend() != ReadBackend::IO_URING) {
+            std::cout << "\n  (io_uring not available, skipping)\n";
+            return;
+        }
+
+        std::cout << "\n🔧 Backend: " << scheduler.get_backend_name() << (direct_io ? " (direct I/O)" : " (page cache)") << "\n";
+        int sustained = 0;
+        for (int streams = 8; streams <= max_streams; streams *= 2) {
+            RunResult result = run_streams(scheduler, paths, streams, direct_io, seconds);
+            std::cout << "  " << std::setw(5) << streams << " streams: "
+                << std::fixed << std::setprecision(1) << std::setw(8) << result.megabytes_per_second << " MB/s, "
+                << "max latency " << std::setw(6) << result.stats.max_latency_ms << " ms, "
+                << "missed deadlines " << result.stats.missed_deadlines << ", "
+                << "underruns " << result.underruns
+                << (result.underruns == 0 ? "  ✅" : "  ❌") << "\n";
+            if (result.underruns != 0) {
+                break;
+            }
+            sustained = streams;
+        }
+        std::cout << "  📊 Sustained: " << sustained << " stereo float streams\n";
+        scheduler.stop();
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory = ".";
+    bool direct_io = false;
+    double seconds = 5.0;
+    int max_streams = 1024;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--direct") direct_io = true;
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::stod(argv[++i]);
+        else if (arg == "--max-streams" && i + 1 < argc) max_streams = std::stoi(argv[++i]);
+        else directory = arg;
+    }
+
+    std::cout << "==========================================\n";
+    std::cout << "  Streaming Read Benchmark\n";
+    std::cout << "==========================================\n";
+    std::cout << "Directory: " << directory << "\n";
+
+    std::vector<std::string> paths;
+    if (!create_test_files(directory, paths)) {
+        return 1;
+    }
+
+    benchmark_backend(true, paths, direct_io, seconds, max_streams);
+    benchmark_backend(false, paths, direct_io, seconds, max_streams);
+
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+    return 0;
+}
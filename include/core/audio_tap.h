@@ -0,0 +1,50 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Single-producer/single-consumer ring that copies a range of channels
+    // out of the audio thread for non-realtime analysis. The audio thread
+    // never waits: if the reader falls behind, the whole block is dropped
+    // and counted instead of tearing channels apart.
+    class AudioTap {
+    public:
+        AudioTap() = default;
+
+        // Non-realtime thread, before the tap is attached
+        void prepare(int first_channel, int num_channels, int capacity_frames);
+        int get_first_channel() const { return first_channel_; }
+        int get_num_channels() const { return num_channels_; }
+
+        // Called from audio thread. False if the block was dropped.
+        bool write(const AudioBuffer& buffer, int num_samples);
+        // Audio thread: frames a write can take now (only grows until the next write)
+        int get_free_frames() const;
+
+        // Reader thread - copies up to max_frames per channel into dest
+        int read(float* const* dest, int max_frames);
+        int get_num_available() const;
+        uint64_t get_dropped_frames() const { return dropped_frames_.load(std::memory_order_relaxed); }
+        int get_capacity() const { return static_cast<int>(mask_ + 1); }
+
+        // Highest fill level the producer has seen, for sizing rings
+        int get_high_water_frames() const { return high_water_frames_.load(std::memory_order_relaxed); }
+        void reset_high_water() { high_water_frames_.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::vector<std::vector<float>> channels_;
+        int first_channel_ = 0;
+        int num_channels_ = 0;
+        uint64_t mask_ = 0;
+
+        alignas(64) std::atomic<uint64_t> write_pos_{ 0 };
+        alignas(64) std::atomic<uint64_t> read_pos_{ 0 };
+        std::atomic<uint64_t> dropped_frames_{ 0 };
+        std::atomic<int> high_water_frames_{ 0 };
+    };
+
+} // namespace SharedAudio
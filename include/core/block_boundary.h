@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Lets a control thread find out when the audio thread has left the
+    // block it may have been in when something was detached. The audio
+    // thread brackets every process call with enter()/leave(); all accesses
+    // are sequentially consistent, so once no block is in flight, the next
+    // one is guaranteed to see whatever was cleared before the check.
+    //
+    // If the audio thread stalls inside a block, wait() gives up and the
+    // caller hands what it was about to free to retire() instead. Retired
+    // objects are released by a later control call once that block is over.
+    class BlockBoundary {
+    public:
+        BlockBoundary() = default;
+        BlockBoundary(const BlockBoundary&) = delete;
+        BlockBoundary& operator=(const BlockBoundary&) = delete;
+
+        // REAL-TIME THREAD
+        void enter() { in_process_.store(true); }
+        void leave() {
+            blocks_processed_.fetch_add(1);
+            in_process_.store(false);
+        }
+
+        // Non-realtime thread. False if a block that started before the call
+        // was still running when the timeout ran out.
+        bool wait(std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+
+        // Frees garbage once the block in flight now (if any) has finished
+        void retire(std::shared_ptr<void> garbage);
+        // Frees retired objects whose block is over; wait() and retire() call it too
+        void collect();
+        size_t get_num_retired() const;
+
+    private:
+        bool has_passed(uint64_t block) const {
+            return !in_process_.load() || blocks_processed_.load() != block;
+        }
+
+        std::atomic<bool> in_process_{ false };
+        std::atomic<uint64_t> blocks_processed_{ 0 };
+
+        mutable std::mutex retired_mutex_;
+        std::vector<std::pair<uint64_t, std::shared_ptr<void>>> retired_; // Block in flight at retire, object
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "core/lock_free_fifo.h"
+#include "show_control/cue_audio_manager.h"
+#include "show_control/scene_manager.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Asset a captured show had loaded when the capture started
+    struct CaptureAsset {
+        std::string cue_id;
+        std::string file_path;
+    };
+
+    // Bus layout, so replay can rebuild the graph (bus 0 is the main bus)
+    struct CaptureBus {
+        std::string name;
+        int num_channels = 2;
+        int first_output_channel = 0;
+    };
+
+    // Everything replay needs to start from the same state as the live
+    // engine. The control thread fills in the assets, the bus layout and
+    // the levels when the capture starts; the audio thread adds the base
+    // sample and the voices at the first captured block.
+    struct CaptureHeader {
+        int sample_rate = 0;
+        int num_inputs = 0;
+        int num_outputs = 0;
+        uint64_t base_sample = 0; // Engine sample of the first captured block; records are relative to it
+        std::vector<CaptureAsset> assets;
+        std::vector<CaptureBus> buses;
+        SceneSnapshot levels;     // Bus, input and output levels (voices are in voices)
+        std::vector<VoicePlaybackState> voices;
+    };
+
+    // One entry of the stream: a command as the audio thread applied it, or
+    // the end of a block with a checksum of everything it rendered
+    struct CaptureRecord {
+        enum Kind : uint8_t {
+            COMMAND = 1,
+            BLOCK = 2
+        };
+
+        Kind kind = COMMAND;
+        uint64_t sample_time = 0; // Start of the block; relative to the base sample once written
+        int num_samples = 0;      // BLOCK only
+        uint64_t checksum = 0;    // BLOCK only
+        AudioThreadMessage message; // COMMAND only, timestamp rebased like sample_time
+    };
+
+    // FNV-1a over the float bits of every output channel
+    uint64_t checksum_block(const AudioBuffer& outputs, int num_samples);
+
+    // Opt-in recorder of the command stream. The audio thread appends fixed
+    // size records to a lock-free ring and never touches the file; a writer
+    // thread drains it into a compact binary file. If the writer falls
+    // behind, records are dropped and counted, and replay reports the gap.
+    //
+    // start() arms the capture; the audio thread snapshots the voices into
+    // preallocated storage at the top of its next block and recording
+    // begins with that block. The writer puts the header down once the
+    // snapshot is in, then the records, rebased to the snapshot's sample.
+    class CommandCapture {
+    public:
+        static constexpr size_t kRingSize = 4096;
+        static constexpr size_t kMaxSnapshotVoices = 1024;
+
+        CommandCapture() = default;
+        ~CommandCapture();
+
+        // Non-realtime thread
+        bool start(const std::string& path, const CaptureHeader& header);
+        void stop();
+        bool is_capturing() const { return capturing_.load(std::memory_order_acquire); }
+        uint64_t get_dropped_records() const { return dropped_records_.load(std::memory_order_relaxed); }
+
+        // Called from audio thread, at the top of a block: storage for the
+        // voice snapshot while one is wanted, nullptr otherwise. Fill it,
+        // then commit_snapshot() with the block's first sample.
+        std::vector<VoicePlaybackState>* pending_snapshot();
+        void commit_snapshot(uint64_t base_sample);
+
+        // Called from audio thread
+        void record_command(uint64_t sample_time, const AudioThreadMessage& msg);
+        void record_block(uint64_t sample_time, int num_samples, const AudioBuffer& outputs);
+
+    private:
+        bool is_recording() const { return is_capturing() && snapshot_ready_.load(std::memory_order_relaxed); }
+        void push(const CaptureRecord& record);
+        void writer_loop();
+
+        LockFreeFIFO<CaptureRecord, kRingSize> ring_;
+        std::atomic<bool> capturing_{ false };
+        std::atomic<bool> snapshot_ready_{ false }; // Published by the audio thread with the header below
+        std::atomic<uint64_t> dropped_records_{ 0 };
+
+        CaptureHeader header_; // Writer thread once snapshot_ready_, audio thread fills voices before
+
+        std::ofstream file_;
+        std::thread writer_;
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        bool stop_requested_ = false;
+    };
+
+    // Reads a capture back, for replay
+    class CaptureReader {
+    public:
+        bool open(const std::string& path);
+        const CaptureHeader& get_header() const { return header_; }
+        bool next(CaptureRecord& record); // sample_time and timestamps relative to the base sample
+
+    private:
+        std::ifstream file_;
+        CaptureHeader header_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/lock_free_fifo.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace SharedAudio {
+
+    struct CommandQueueStats {
+        uint64_t pushed = 0;
+        uint64_t coalesced = 0;        // Superseded before the audio thread saw them
+        uint64_t dropped = 0;          // Normal lane full
+        uint64_t critical_dropped = 0; // Critical lane full (audio thread stalled)
+        int high_water = 0;
+        int critical_high_water = 0;
+    };
+
+    // Commands from control threads to the audio thread, in two lanes.
+    //
+    // Transport commands (START_CUE, STOP_CUE, SEEK, CROSSFADE, LOAD_BUFFER)
+    // go through a reserved critical lane that parameter traffic can never
+    // fill, so a GO is not lost behind a fader drag. Parameter commands
+    // (SET_VOLUME, SET_PAN) are coalesced on the producer side: each
+    // (type, cue) pair owns a slot holding its latest value, and only one
+    // message per slot is ever in flight. A newer value rewrites the slot
+    // instead of queueing another message.
+    //
+    // Both lanes carry a push sequence number and pop() merges them by it,
+    // so commands for one cue come out in the order they were pushed. A
+    // parameter change pushed after a transport command for the same cue
+    // never folds into a message queued before it.
+    //
+    // Any number of producer threads (serialised internally), one consumer.
+    class AudioCommandQueue {
+    public:
+        static constexpr size_t kNormalLaneSize = 256;
+        static constexpr size_t kCriticalLaneSize = 64;
+        static constexpr int kNumCoalesceSlots = 256;
+
+        AudioCommandQueue();
+
+        // Producer side. Returns false only if the command was dropped.
+        bool push(const AudioThreadMessage& msg);
+
+        // Called from audio thread - both lanes, in push order
+        bool pop(AudioThreadMessage& msg);
+
+        CommandQueueStats get_stats() const;
+        void reset_high_water();
+
+        static bool is_critical(AudioThreadMessage::Type type);
+        static bool is_coalescable(AudioThreadMessage::Type type);
+
+    private:
+        // Latest value bits in the low word, in-flight flag above them, so the
+        // audio thread takes the value and frees the slot in one exchange
+        static constexpr uint64_t kQueuedFlag = uint64_t(1) << 32;
+
+        struct QueuedCommand {
+            AudioThreadMessage msg;
+            uint64_t sequence = 0;
+        };
+
+        // Producer side: which (type, cue) a coalescing slot belongs to
+        struct SlotKey {
+            bool used = false;
+            AudioThreadMessage::Type type = AudioThreadMessage::NONE;
+            uint64_t cue_hash = 0;
+            char cue_id[sizeof(AudioThreadMessage::cue_id)] = { 0 };
+            uint64_t queued_sequence = 0;  // Of the message in flight for this slot
+            uint64_t barrier_sequence = 0; // Last transport command for the cue
+        };
+
+        bool push_normal(const AudioThreadMessage& msg);
+        bool push_coalesced(const AudioThreadMessage& msg);
+        int find_slot(const AudioThreadMessage& msg, uint64_t cue_hash);
+        void note_transport(const AudioThreadMessage& msg, uint64_t cue_hash);
+        static uint64_t hash_cue_id(const char* cue_id);
+        static bool same_cue(const SlotKey& key, const AudioThreadMessage& msg, uint64_t cue_hash);
+        void note_fill(std::atomic<int>& high_water, size_t fill);
+
+        LockFreeFIFO<QueuedCommand, kCriticalLaneSize> critical_;
+        LockFreeFIFO<QueuedCommand, kNormalLaneSize> normal_;
+
+        std::array<std::atomic<uint64_t>, kNumCoalesceSlots> slots_{};
+
+        // Audio thread only: lane heads popped but not yet handed out
+        QueuedCommand critical_head_;
+        QueuedCommand normal_head_;
+        bool has_critical_head_ = false;
+        bool has_normal_head_ = false;
+
+        // Producer side only
+        std::mutex producer_mutex_;
+        uint64_t next_sequence_ = 1;
+        std::array<SlotKey, kNumCoalesceSlots> slot_keys_;
+
+        std::atomic<uint64_t> pushed_{ 0 };
+        std::atomic<uint64_t> coalesced_{ 0 };
+        std::atomic<uint64_t> dropped_{ 0 };
+        std::atomic<uint64_t> critical_dropped_{ 0 };
+        std::atomic<int> high_water_{ 0 };
+        std::atomic<int> critical_high_water_{ 0 };
+    };
+
+} // namespace SharedAudio
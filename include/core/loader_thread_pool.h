@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SharedAudio {
+
+    // General purpose pool for non-realtime work (decoding, analysis).
+    // Normal priority threads - never use this from the audio thread.
+    class LoaderThreadPool {
+    public:
+        using Task = std::function<void()>;
+
+        LoaderThreadPool();
+        ~LoaderThreadPool();
+
+        bool start(int num_threads);
+        void stop();
+        int get_num_threads() const { return static_cast<int>(threads_.size()); }
+
+        // Queue a task, runs on any pool thread
+        void submit(Task task);
+
+        // Runs fn(0..count-1) across the pool and returns when all are done.
+        // The calling thread works through indices too, so this is safe to
+        // call from inside a pool task without starving the pool.
+        void parallel_for(int count, const std::function<void(int)>& fn);
+
+    private:
+        void thread_loop();
+
+        std::vector<std::thread> threads_;
+        std::deque<Task> tasks_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool running_ = false;
+    };
+
+} // namespace SharedAudio
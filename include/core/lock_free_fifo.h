@@ -3,6 +3,7 @@
 #include <atomic>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace SharedAudio {
@@ -43,6 +44,12 @@ namespace SharedAudio {
             return true;
         }
 
+        // Producer side: true while a push would fail
+        bool is_full() const {
+            const size_t next_write = (write_pos_.load(std::memory_order_relaxed) + 1) & (Size - 1);
+            return next_write == read_pos_.load(std::memory_order_acquire);
+        }
+
         // Non-blocking check if data available
         bool available() const {
             return read_pos_.load(std::memory_order_relaxed) !=
@@ -91,6 +98,8 @@ namespace SharedAudio {
             float float_value;
             int int_value;
         } param2 = { 0 };
+        int coalesce_slot = -1; // Parameter value lives in AudioCommandQueue's coalescing table
+        int64_t timestamp_samples = -1; // Engine sample to act at (see SharedAudioCore::get_sample_time), -1 = next block
     };
 
     using AudioMessageQueue = LockFreeFIFO<AudioThreadMessage, 256>;
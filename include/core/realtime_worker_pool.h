@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Pool of real-time priority worker threads that help the audio thread
+    // through a batch of independent jobs (e.g. slow plugin insert chains).
+    // The audio thread always takes part in the batch itself, so a worker that
+    // wakes up late only costs parallelism, never a missed deadline.
+    //
+    // start()/stop() may run while audio is running: the audio thread only
+    // sees the published worker count, never the thread list, and a batch in
+    // flight is finished by the audio thread if its workers leave. Workers run
+    // one priority step below the audio thread that dispatches to them.
+    class RealtimeWorkerPool {
+    public:
+        using JobFunction = void (*)(void* context, int job_index);
+
+        RealtimeWorkerPool();
+        ~RealtimeWorkerPool();
+
+        // Non-realtime thread
+        bool start(int num_workers);
+        void stop();
+        int get_num_workers() const { return num_active_workers_.load(std::memory_order_acquire); }
+
+        // Called from audio thread - runs job_fn(context, 0..num_jobs-1) and
+        // returns once every job has finished. No locks, no allocation.
+        void run_jobs(JobFunction job_fn, void* context, int num_jobs);
+
+        // Split form of run_jobs: the audio thread can do its own work between
+        // dispatch and wait, then helps with whatever jobs are still unclaimed
+        void dispatch_jobs(JobFunction job_fn, void* context, int num_jobs);
+        void wait_for_jobs();
+
+    private:
+        void worker_loop();
+        bool run_next_job();
+        void note_audio_thread_priority();
+        void follow_audio_thread_priority(int& applied_generation);
+
+        std::mutex control_mutex_;           // serialises start/stop
+        std::vector<std::thread> workers_;   // control thread only
+        std::atomic<bool> running_{ false };
+        std::atomic<int> num_active_workers_{ 0 }; // what the audio thread dispatches to
+
+        // Scheduling of the dispatching audio thread, read once per start
+        // (workers start at normal priority and follow it)
+        bool audio_priority_noted_ = false; // audio thread only
+        std::atomic<int> audio_policy_{ 0 };
+        std::atomic<int> audio_priority_{ 0 };
+        std::atomic<int> audio_priority_generation_{ 0 };
+
+        // Current batch, published by the release store to ticket_
+        std::atomic<JobFunction> job_fn_{ nullptr };
+        std::atomic<void*> job_context_{ nullptr };
+        std::atomic<int> num_jobs_{ 0 };
+        int dispatched_jobs_ = 0; // audio thread only
+
+        // High 32 bits: batch generation, low 32 bits: next job index.
+        // Claiming through one CAS keeps a late worker from running a job
+        // of the previous batch with the new batch's function.
+        alignas(64) std::atomic<uint64_t> ticket_{ 0 };
+        alignas(64) std::atomic<int> jobs_done_{ 0 };
+        alignas(64) std::atomic<int> parked_workers_{ 0 };
+
+        // Idle workers park here; the audio thread never takes this mutex
+        std::mutex park_mutex_;
+        std::condition_variable park_cv_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace SharedAudio {
+
+    struct SampleArenaStats {
+        size_t slab_bytes = 0;          // Mapped from the OS
+        size_t used_bytes = 0;          // Held by live allocations (after alignment)
+        size_t largest_free_bytes = 0;  // Biggest single free range
+        int num_slabs = 0;
+        int num_huge_page_slabs = 0;
+        int num_allocations = 0;
+        int compactions = 0;
+        uint64_t bytes_moved = 0;
+
+        double get_fragmentation() const {
+            const size_t free_bytes = slab_bytes - used_bytes;
+            return free_bytes > 0 ? 1.0 - static_cast<double>(largest_free_bytes) / free_bytes : 0.0;
+        }
+    };
+
+    // Slab allocator for decoded sample data. Slabs are large, huge-page
+    // backed where the OS allows it, and every allocation is 64-byte aligned
+    // so SIMD loads never split a cache line at the start of a channel.
+    //
+    // Allocations are reached through handles rather than raw pointers so
+    // compact() can move them: it copies live data towards the front of the
+    // arena, publishes the new address, waits for every reader that might
+    // still hold the old one to leave its ReadGuard, then frees the old range
+    // and returns emptied slabs to the OS. Guards count against the reader
+    // epoch they entered in and compact() starts a new one, so it only waits
+    // for guards taken before the move, however many arrive meanwhile. That keeps fragmentation bounded
+    // across long sessions of loading and purging cues.
+    class SampleArena {
+    public:
+        static constexpr size_t kAlignment = 64;
+        static constexpr size_t kHugePageBytes = size_t(2) << 20;
+        static constexpr size_t kDefaultSlabBytes = size_t(64) << 20;
+
+        struct Block; // One allocation
+        using Handle = Block*;
+
+        // Held while sample pointers from resolve() are in use. Cheap enough
+        // for the audio thread to take once per block.
+        class ReadGuard {
+        public:
+            explicit ReadGuard(const SampleArena& arena) : arena_(arena) { slot_ = arena_.enter_reader(); }
+            ~ReadGuard() { arena_.readers_[slot_].fetch_sub(1); }
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+        private:
+            const SampleArena& arena_;
+            unsigned slot_ = 0;
+        };
+
+        explicit SampleArena(size_t slab_bytes = kDefaultSlabBytes);
+        ~SampleArena();
+
+        SampleArena(const SampleArena&) = delete;
+        SampleArena& operator=(const SampleArena&) = delete;
+
+        // Non-realtime thread. Copies the data in, so a block is never moved
+        // while it is still being written. Returns nullptr if the OS is out of memory.
+        Handle store(const void* data, size_t bytes);
+        void free(Handle handle);
+
+        // Any thread, inside a ReadGuard
+        static const uint8_t* resolve(Handle handle);
+
+        // Moves at most max_bytes of live data, returns the bytes moved.
+        // Blocks while waiting for readers - run it on a background thread.
+        size_t compact(size_t max_bytes = static_cast<size_t>(-1));
+        bool should_compact() const;
+
+        SampleArenaStats get_stats() const;
+
+    private:
+        struct Slab {
+            uint8_t* base = nullptr;
+            size_t size = 0;
+            size_t used = 0;
+            bool huge_pages = false;
+            std::map<size_t, size_t> free_ranges; // offset -> size, coalesced
+        };
+
+        bool take_range(size_t bytes, size_t limit_slab, size_t limit_offset, size_t& slab, size_t& offset);
+        void release_range(size_t slab, size_t offset, size_t bytes);
+        size_t add_slab(size_t min_bytes);
+        void release_empty_slabs();
+        unsigned enter_reader() const;
+        void wait_for_readers();
+
+        const size_t slab_bytes_;
+        mutable std::mutex mutex_;
+        std::mutex compact_mutex_;
+        std::vector<std::unique_ptr<Slab>> slabs_; // nullptr once returned to the OS
+        std::vector<std::unique_ptr<Block>> blocks_;
+        // Guards per epoch parity; only compact() (under compact_mutex_) advances reader_epoch_
+        mutable std::atomic<uint64_t> reader_epoch_{ 0 };
+        mutable std::atomic<int> readers_[2] = {};
+        int compactions_ = 0;
+        uint64_t bytes_moved_ = 0;
+    };
+
+    struct SampleArena::Block {
+        std::atomic<uint8_t*> data{ nullptr };
+        size_t bytes = 0;    // Rounded to kAlignment
+        size_t slab = 0;
+        size_t offset = 0;
+        size_t index = 0;    // Position in blocks_
+    };
+
+    // Counts the guard against the current epoch. If compact() moved to a
+    // new one in between, the count may have been missed, so retry there.
+    inline unsigned SampleArena::enter_reader() const {
+        while (true) {
+            const uint64_t epoch = reader_epoch_.load();
+            const unsigned slot = static_cast<unsigned>(epoch & 1);
+            readers_[slot].fetch_add(1);
+            if (reader_epoch_.load() == epoch) {
+                return slot;
+            }
+            readers_[slot].fetch_sub(1);
+        }
+    }
+
+    // Sequentially consistent so the load cannot be ordered ahead of the
+    // ReadGuard's increment that compact() waits on (a plain load on x86)
+    inline const uint8_t* SampleArena::resolve(Handle handle) {
+        return handle != nullptr ? handle->data.load() : nullptr;
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "core/lock_free_fifo.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace SharedAudio {
+
+    // Binary layout of the command ring shared with JavaScript (must match
+    // bindings/electron/lib/command_ring.js). Little-endian, byte offsets.
+    namespace CommandRingLayout {
+        constexpr uint32_t kMagic = 0x52434153; // "SACR"
+        constexpr uint32_t kVersion = 1;
+
+        // Header - producer and consumer indices on separate cache lines
+        constexpr size_t kWriteIndexOffset = 0;   // u32, records written (JS, Atomics.store)
+        constexpr size_t kReadIndexOffset = 64;   // u32, records consumed (engine)
+        constexpr size_t kCapacityOffset = 128;   // u32, records, power of two
+        constexpr size_t kRecordBytesOffset = 132;
+        constexpr size_t kMagicOffset = 136;
+        constexpr size_t kVersionOffset = 140;
+        constexpr size_t kDroppedOffset = 144;    // u32, pushes JS found the ring full for
+        constexpr size_t kHeaderBytes = 256;
+
+        // Record
+        constexpr size_t kRecordBytes = 96;
+        constexpr size_t kTypeOffset = 0;         // u32, AudioThreadMessage::Type
+        constexpr size_t kIdLengthOffset = 4;     // u32, UTF-8 bytes of the cue id
+        constexpr size_t kParam1Offset = 8;       // f64
+        constexpr size_t kParam2Offset = 16;      // f32
+        constexpr size_t kIdOffset = 24;          // cue id bytes
+        constexpr size_t kMaxIdBytes = 63;
+    }
+
+    // Single-producer/single-consumer ring in memory shared with another
+    // thread or process - a JavaScript SharedArrayBuffer or the engine host's
+    // shared memory segment. The producer encodes fixed-size records and
+    // publishes them with a release store (Atomics.store in JS) on the write
+    // index; the audio callback drains them directly, so commands never
+    // cross N-API or touch a lock. The memory is owned by whoever created
+    // it; whoever attaches keeps it alive.
+    class SharedCommandRing {
+    public:
+        SharedCommandRing() = default;
+
+        // Writes an empty ring header (capacity: power of two). Returns the
+        // bytes used, 0 if the memory is too small.
+        static size_t format(void* memory, size_t bytes, uint32_t capacity);
+        static size_t get_bytes_for(uint32_t capacity) { return kHeaderBytes + static_cast<size_t>(capacity) * kRecordBytes; }
+
+        // Non-realtime thread. Validates the header the producer wrote.
+        bool attach(void* memory, size_t bytes);
+        bool is_attached() const { return base_ != nullptr; }
+        uint32_t get_capacity() const { return mask_ + 1; }
+        uint32_t get_dropped() const;
+
+        // Called from audio thread. Records with an unsupported type are
+        // consumed and skipped.
+        bool pop(AudioThreadMessage& msg);
+
+        // Producer side (one producer at a time). Counts a drop when full.
+        bool push(const AudioThreadMessage& msg);
+
+        static bool is_supported(uint32_t type);
+
+    private:
+        std::atomic<uint32_t>& index_at(size_t offset) const {
+            return *reinterpret_cast<std::atomic<uint32_t>*>(base_ + offset);
+        }
+
+        static constexpr size_t kHeaderBytes = CommandRingLayout::kHeaderBytes;
+        static constexpr size_t kRecordBytes = CommandRingLayout::kRecordBytes;
+
+        uint8_t* base_ = nullptr;
+        uint32_t mask_ = 0;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace SharedAudio {
+
+    // Latest-value handoff from one writer to one reader. The writer fills
+    // its own buffer and publishes it by swapping it with the middle one;
+    // the reader swaps the middle one out when a newer value is there.
+    // Neither side ever waits and neither ever sees a half-written value.
+    // Values the reader never picked up are simply overwritten.
+    template<typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Writer thread
+        T& write_buffer() { return buffers_[back_]; }
+        void publish() {
+            back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+        }
+
+        // Reader thread: picks up the newest published value, false if there
+        // was nothing new (read_buffer() then still holds the previous one)
+        bool update() {
+            if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+                return false;
+            }
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+            return true;
+        }
+        const T& read_buffer() const { return buffers_[front_]; }
+
+    private:
+        static constexpr uint32_t kIndexMask = 3;
+        static constexpr uint32_t kFresh = 4;
+
+        std::array<T, 3> buffers_{};
+        alignas(64) uint32_t back_ = 0;           // writer only
+        alignas(64) std::atomic<uint32_t> middle_{ 1 };
+        alignas(64) uint32_t front_ = 2;          // reader only
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "core/shared_command_ring.h"
+#include "core/triple_buffer.h"
+#include "processing/level_meter.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace SharedAudio {
+
+    // The engine can run in its own process (shared_audio_engine_host) so a
+    // UI crash or GC pause never touches the audio thread. Host and client
+    // share one POSIX shared memory segment laid out as EngineHostSegment:
+    //
+    //   command ring   client -> audio callback, no syscalls (see shared_command_ring.h);
+    //                  single producer, claimed through ring_producer
+    //   status/meters  host publisher -> client, triple buffers
+    //   control slot   client -> host control thread, for loads and other slow calls;
+    //                  one request at a time, claimed through control.owner
+    //   heartbeat      bumped by the host main loop, never blocked by a control call
+    //
+    // The host holds an fcntl write lock on get_engine_host_lock_path() for
+    // its lifetime. The lock, not the segment, says whether a host owns the
+    // name: the kernel drops it when the host dies, only the holder removes
+    // a stale segment, and a second host started for the same name exits.
+    //
+    // Claims name their owner as client pid << 32 | claim number. Every
+    // client process write-locks the byte at its pid in
+    // get_engine_host_clients_lock_path() while it lives, so a claim is
+    // stale once that lock is gone, even if the pid has been reused.
+    //
+    // Both sides must be built from the same headers; the version field
+    // guards against a stale host.
+    namespace EngineHostLayout {
+        constexpr uint32_t kMagic = 0x48414153; // "SAAH"
+        constexpr uint32_t kVersion = 4;
+        constexpr uint32_t kCommandRingCapacity = 1024;
+        constexpr int kMaxCues = 256;
+        constexpr int kMaxMeters = 64;
+        constexpr size_t kMaxIdBytes = 64;
+        constexpr size_t kMaxPathBytes = 1024;
+        constexpr size_t kMaxErrorBytes = 256;
+    }
+
+    enum class EngineHostState : uint32_t {
+        STARTING = 0,
+        RUNNING,
+        FAILED,  // error holds the reason, the host has exited
+        STOPPED
+    };
+
+    struct HostCueStatus {
+        char cue_id[EngineHostLayout::kMaxIdBytes];
+        uint32_t state;        // CueState
+        uint32_t is_looping;
+        double position_seconds;
+        double duration_seconds;
+        float volume;
+        float pan;
+        float peak_left;
+        float peak_right;
+    };
+
+    struct HostStatusFrame {
+        uint64_t sequence;
+        int64_t time_ns;       // steady_clock in the host
+        PerformanceMetrics metrics;
+        int num_cues;          // active cues
+        HostCueStatus cues[EngineHostLayout::kMaxCues];
+    };
+
+    struct HostMeterFrame {
+        uint64_t sequence;
+        int num_outputs;
+        MeterValues outputs[EngineHostLayout::kMaxMeters]; // linear, since the previous frame
+    };
+
+    // One request at a time, across all clients
+    struct HostControlSlot {
+        enum Op : uint32_t {
+            NONE = 0,
+            LOAD_CUE,
+            UNLOAD_CUE,
+            SET_CUE_LOOP,
+            SHUTDOWN
+        };
+
+        alignas(64) std::atomic<uint64_t> owner; // Claim of the client filling the slot, 0 = free
+        alignas(64) std::atomic<uint32_t> request_sequence;
+        alignas(64) std::atomic<uint32_t> response_sequence;
+        uint32_t op;
+        int32_t result;        // 1 success, 0 failure
+        double value;
+        char cue_id[EngineHostLayout::kMaxIdBytes];
+        char path[EngineHostLayout::kMaxPathBytes];
+        char error[EngineHostLayout::kMaxErrorBytes];
+    };
+
+    struct EngineHostSegment {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t segment_bytes;
+        int32_t host_pid;
+        int32_t sample_rate;
+        int32_t num_inputs;
+        int32_t num_outputs;
+        alignas(64) std::atomic<uint64_t> heartbeat; // bumped by the host main loop
+        std::atomic<uint32_t> state;                 // EngineHostState
+        char error[EngineHostLayout::kMaxErrorBytes];
+
+        // Mapping allowed to push into command_ring, 0 = free. Claimed on
+        // first use, released with the mapping; a stale claim is taken over.
+        alignas(64) std::atomic<uint64_t> ring_producer;
+
+        HostControlSlot control;
+        TripleBuffer<HostStatusFrame> status;
+        TripleBuffer<HostMeterFrame> meters;
+
+        alignas(64) uint8_t command_ring[CommandRingLayout::kHeaderBytes
+            + EngineHostLayout::kCommandRingCapacity * CommandRingLayout::kRecordBytes];
+    };
+
+    struct EngineHostOptions {
+        std::string segment_name = "/shared_audio_engine";
+        std::string host_executable = "shared_audio_engine_host";
+        AudioSettings settings;
+        int connect_timeout_ms = 10000;
+    };
+
+    // Lock file next to the segment name ("/shared_audio_engine" ->
+    // "/tmp/shared_audio_engine.lock")
+    std::string get_engine_host_lock_path(const std::string& segment_name);
+    // "/tmp/shared_audio_engine.clients.lock", locked per client pid
+    std::string get_engine_host_clients_lock_path(const std::string& segment_name);
+
+    struct EngineHostMapping;
+
+    // Client side, used by the Electron binding. connect() reattaches to the
+    // host holding the lock, otherwise launches one in its own session so it
+    // outlives the calling process. disconnect() leaves the host (and the
+    // audio) running.
+    class EngineHostClient {
+    public:
+        EngineHostClient() = default;
+        ~EngineHostClient();
+
+        EngineHostClient(const EngineHostClient&) = delete;
+        EngineHostClient& operator=(const EngineHostClient&) = delete;
+
+        bool connect(const EngineHostOptions& options);
+        void disconnect();
+        bool shutdown_host(); // stops audio and removes the segment
+        bool is_connected() const { return segment_ != nullptr; }
+        // Running, holding the lock and with a heartbeat that moved within
+        // the last half second. Also reaps hosts this client launched.
+        bool is_host_alive();
+        bool was_reattached() const { return reattached_; }
+
+        // Hot path: written straight into the shared ring. The ring has one
+        // producer: both fail while another mapping (another process, worker
+        // or a buffer from an earlier connect still alive) holds the claim.
+        bool send_command(const AudioThreadMessage& msg);
+        void* get_command_ring();
+        size_t get_command_ring_bytes() const;
+        // Keeps the current mapping alive past disconnect() for as long as
+        // the returned owner lives (a JS buffer over get_command_ring())
+        std::shared_ptr<void> retain_mapping() const;
+
+        // Control path: waits for the host main loop
+        bool load_audio_cue(const std::string& cue_id, const std::string& file_path);
+        bool unload_audio_cue(const std::string& cue_id);
+        bool set_cue_loop(const std::string& cue_id, bool loop);
+
+        // Latest published frames (single reader). False before the first one.
+        bool read_status(HostStatusFrame& frame);
+        bool read_meters(HostMeterFrame& frame);
+
+        std::string get_last_error() const { return last_error_; }
+
+    private:
+        bool map_segment(const std::string& name, pid_t host_pid);
+        pid_t find_host() const; // Pid holding the lock, 0 = none
+        void reap_children();
+        bool launch_host(const EngineHostOptions& options);
+        bool wait_for_running(int timeout_ms);
+        bool claim_ring_producer();
+        bool request(HostControlSlot::Op op, const std::string& cue_id, const std::string& path,
+            double value, int timeout_ms);
+        void unmap();
+
+        EngineHostSegment* segment_ = nullptr; // mapping_->segment
+        std::shared_ptr<EngineHostMapping> mapping_;
+        std::string segment_name_;
+        int lock_fd_ = -1;     // Open on the lock file, to query the holder
+        int clients_fd_ = -1;  // Process-wide, holds our clients lock until exit
+        pid_t launched_pid_ = 0;
+        std::vector<pid_t> children_; // Launched hosts not reaped yet
+        uint64_t last_heartbeat_ = 0;
+        std::chrono::steady_clock::time_point last_heartbeat_change_;
+        std::mutex liveness_mutex_;
+        SharedCommandRing ring_;
+        std::mutex control_mutex_;
+        bool reattached_ = false;
+        std::string last_error_;
+    };
+
+} // namespace SharedAudio
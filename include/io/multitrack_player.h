@@ -0,0 +1,76 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    class ReadScheduler;
+
+    // One recorded file and the first input slot its channels replace
+    struct PlaybackSource {
+        std::string file_path;
+        int first_input = -1; // -1: right after the previous file's tracks
+    };
+
+    struct PlaybackStatus {
+        bool is_loaded = false;
+        bool is_playing = false;
+        bool reached_end = false;
+        bool is_looping = false;
+        int num_tracks = 0;
+        double position_seconds = 0.0;
+        double duration_seconds = 0.0;
+        double buffered_seconds = 0.0;  // Read-ahead currently in the ring
+        uint64_t underrun_blocks = 0;   // Blocks the disk could not deliver in time
+        uint64_t bytes_read = 0;
+        uint64_t read_requests = 0;
+        double max_read_ms = 0.0;
+    };
+
+    // Virtual soundcheck: plays recorded multitrack files back in place of
+    // the device inputs they were captured from, ahead of input routing, so
+    // they reach the same buses, direct outputs and meters. Each input can
+    // be switched between live and playback at a block boundary.
+    //
+    // All tracks stream in lockstep through one ring fed by a single
+    // read-ahead thread. Interleaved files are read in large sequential
+    // requests that serve every track of the file at once, and all files are
+    // advanced by the same frame count per pass. Passes go through the shared
+    // ReadScheduler, so the reads of one pass are in flight together and are
+    // ordered against other streams by time-to-underrun.
+    class MultitrackPlayer {
+    public:
+        MultitrackPlayer();
+        ~MultitrackPlayer();
+
+        // Non-realtime thread
+        bool initialize(int sample_rate, int num_inputs, int max_block_size, ReadScheduler* scheduler = nullptr);
+        bool load(const std::vector<PlaybackSource>& sources, double read_ahead_seconds = 4.0, bool direct_io = false);
+        void unload();
+        void play();
+        void pause();
+        bool seek(double seconds);
+        // Loops [start, end) (end 0: end of the files) with a seam crossfaded
+        // over crossfade_seconds, read and mixed once here. Restarts the
+        // read-ahead like a seek.
+        bool set_loop(double start_seconds, double end_seconds, double crossfade_seconds = 0.0);
+        void clear_loop();
+        bool set_input_source(int input_channel, bool use_playback);
+        void set_all_inputs_source(bool use_playback); // Only inputs covered by a loaded track
+        bool is_input_playback(int input_channel) const;
+        PlaybackStatus get_status() const;
+        std::string get_last_error() const;
+
+        // Called from audio thread, before input routing
+        void process(AudioBuffer& inputs, int num_samples);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "io/recording_file.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    enum class RecordingSampleFormat {
+        FLOAT32,
+        INT24
+    };
+
+    struct RecordingSettings {
+        std::string directory = ".";
+        std::string take_name = "take";
+        RecordingFileFormat file_format = RecordingFileFormat::W64;
+        RecordingSampleFormat sample_format = RecordingSampleFormat::FLOAT32;
+        bool record_inputs = true;
+        bool record_outputs = true;
+        double ring_seconds = 10.0;        // How long the disk may stall before blocks are dropped
+        double preallocate_minutes = 30.0; // File space reserved up front (extended as needed)
+    };
+
+    // Frames the ring could not take, written to the file as silence
+    struct RecordingDropout {
+        uint64_t frame = 0;  // Position in the file
+        uint64_t frames = 0;
+    };
+
+    // One multichannel file (all inputs, or all outputs)
+    struct RecordingStreamStatus {
+        std::string file_path;
+        int num_channels = 0;
+        uint64_t frames_written = 0; // Including dropout silence
+        uint64_t dropped_frames = 0;
+        std::vector<RecordingDropout> dropouts;
+        int ring_capacity_frames = 0;
+        int ring_high_water_frames = 0;
+        double ring_high_water_percent = 0.0;
+    };
+
+    struct RecordingStatus {
+        bool is_recording = false;
+        double elapsed_seconds = 0.0;
+        uint64_t bytes_written = 0;
+        double max_write_ms = 0.0;
+        std::vector<RecordingStreamStatus> streams;
+    };
+
+    // Captures device inputs and final outputs to disk. The audio thread only
+    // copies each block into per-track lock-free rings and never waits; a
+    // writer thread interleaves the rings into 1 MiB writes at 4 KiB aligned
+    // offsets of preallocated files. If the disk stalls longer than the ring
+    // lasts, whole blocks are dropped and counted instead of blocking; the
+    // writer puts the same number of silent frames in their place so the
+    // take stays in time with the other files and the show clock.
+    class MultitrackRecorder {
+    public:
+        MultitrackRecorder();
+        ~MultitrackRecorder();
+
+        // Non-realtime thread
+        bool initialize(int sample_rate, int num_inputs, int num_outputs);
+        bool start_recording(const RecordingSettings& settings);
+        void stop_recording();
+        bool is_recording() const;
+        RecordingStatus get_status() const;
+        std::string get_last_error() const;
+
+        // Called from audio thread with the final output signal
+        void process(const AudioBuffer& inputs, const AudioBuffer& outputs, int num_samples);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
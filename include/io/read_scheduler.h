@@ -0,0 +1,76 @@
+#pragma once
+
+#include "io/recording_file.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SHARED_AUDIO_HAS_IO_URING 1
+#endif
+#endif
+
+namespace SharedAudio {
+
+    enum class ReadBackend {
+        IO_URING,    // Linux: one ring, many reads in flight from one thread
+        THREAD_POOL  // Portable: blocking positional reads on worker threads
+    };
+
+    struct ReadSchedulerSettings {
+        bool prefer_io_uring = true;
+        int queue_depth = 64;     // Reads in flight at once (io_uring)
+        int worker_threads = 4;   // Reads in flight at once (thread pool)
+    };
+
+    // Result is the number of bytes read, or a negative value on error
+    using ReadCompletion = std::function<void(int64_t result)>;
+
+    struct ReadRequest {
+        RecordingFile* file = nullptr;
+        uint64_t offset = 0;
+        void* buffer = nullptr;
+        size_t bytes = 0;
+        // When the requesting stream runs dry without this data
+        std::chrono::steady_clock::time_point deadline;
+        ReadCompletion on_complete; // Runs on a scheduler thread
+    };
+
+    struct ReadSchedulerStats {
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+        uint64_t bytes_read = 0;
+        uint64_t missed_deadlines = 0; // Completed after their deadline
+        int max_in_flight = 0;
+        double max_latency_ms = 0.0;   // Submit to completion
+    };
+
+    // Shared disk read queue for every streaming consumer. Pending reads are
+    // issued earliest-deadline-first, so the stream closest to running dry
+    // always gets the disk next, and up to queue_depth reads are kept in
+    // flight so the device sees parallel, large requests. Uses io_uring on
+    // Linux when the kernel allows it and falls back to a thread pool.
+    class ReadScheduler {
+    public:
+        ReadScheduler();
+        ~ReadScheduler();
+
+        // Non-realtime threads only
+        bool start(const ReadSchedulerSettings& settings = ReadSchedulerSettings());
+        void stop();
+        bool is_running() const;
+        ReadBackend get_backend() const;
+        const char* get_backend_name() const;
+
+        void submit(ReadRequest request);
+        ReadSchedulerStats get_stats() const;
+        void reset_stats();
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
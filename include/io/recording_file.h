@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace SharedAudio {
+
+    enum class RecordingFileFormat {
+        WAV,  // Promoted to RF64 once it grows past 4 GB
+        W64,
+        CAF
+    };
+
+    // Everything before the sample data fits in this many bytes, so the data
+    // offset never moves while a recording grows
+    constexpr size_t kRecordingHeaderBytes = 4096;
+
+    // Layout of an interleaved PCM file
+    struct RecordingFileInfo {
+        RecordingFileFormat format = RecordingFileFormat::WAV;
+        int sample_rate = 0;
+        int num_channels = 0;
+        int bytes_per_sample = 0;
+        bool is_float = false;
+        uint64_t data_offset = 0;
+        uint64_t data_bytes = 0;
+        uint64_t num_frames = 0;
+    };
+
+    // Offset, size and address alignment for direct (unbuffered) reads
+    constexpr size_t kDirectIoAlignment = 4096;
+
+    // Heap block aligned for direct I/O
+    class AlignedBuffer {
+    public:
+        AlignedBuffer() = default;
+        ~AlignedBuffer();
+
+        AlignedBuffer(AlignedBuffer&& other) noexcept;
+        AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        bool allocate(size_t bytes, size_t alignment = kDirectIoAlignment);
+        void release();
+        uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Positional-read/write file handle. Writes never move a shared file
+    // pointer, so header rewrites and data writes can be issued in any order.
+    class RecordingFile {
+    public:
+        RecordingFile() = default;
+        ~RecordingFile();
+
+        RecordingFile(const RecordingFile&) = delete;
+        RecordingFile& operator=(const RecordingFile&) = delete;
+
+        bool open_for_write(const std::string& path);
+        // direct_io bypasses the page cache (O_DIRECT / FILE_FLAG_NO_BUFFERING);
+        // reads must then be kDirectIoAlignment aligned in offset, size and
+        // buffer. Falls back to buffered reads where unsupported (e.g. tmpfs).
+        bool open_for_read(const std::string& path, bool direct_io = false);
+        bool is_open() const;
+        bool is_direct_io() const { return direct_io_; }
+        void close();
+
+        bool preallocate(uint64_t bytes);
+        bool truncate(uint64_t bytes);
+        bool write_at(uint64_t offset, const void* data, size_t bytes);
+        int64_t read_at(uint64_t offset, void* data, size_t bytes); // bytes read, -1 on error
+        uint64_t get_size() const;
+
+#ifdef _WIN32
+        void* get_native_handle() const { return handle_; }
+#else
+        int get_native_handle() const { return fd_; }
+#endif
+
+    private:
+        bool direct_io_ = false;
+#ifdef _WIN32
+        void* handle_ = reinterpret_cast<void*>(static_cast<intptr_t>(-1));
+#else
+        int fd_ = -1;
+#endif
+    };
+
+    // Builds the kRecordingHeaderBytes header for the given data size.
+    // A CAF written with finished = false carries the "still recording"
+    // size marker so it stays readable after a crash.
+    void build_recording_header(uint8_t* header, RecordingFileFormat format, int num_channels,
+        int sample_rate, int bytes_per_sample, bool is_float, uint64_t data_bytes, bool finished);
+
+    // Reads the layout of a WAV/RF64, W64 or CAF file with 16/24-bit integer
+    // or 32-bit float samples (everything the recorder writes)
+    bool parse_recording_header(RecordingFile& file, RecordingFileInfo& info, std::string& error);
+
+} // namespace SharedAudio
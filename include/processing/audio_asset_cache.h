@@ -0,0 +1,77 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "processing/loudness_analyzer.h"
+#include "processing/sample_storage.h"
+#include "processing/waveform_pyramid.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace SharedAudio {
+
+    class LoaderThreadPool;
+
+    // Everything learned about an asset while it was decoded
+    struct AudioAssetMetadata {
+        std::string file_path;
+        int sample_rate = 0;
+        int num_channels = 0;
+        size_t num_frames = 0;
+        double duration_seconds = 0.0;
+        LoudnessInfo loudness;
+        SampleFormat storage_format = SampleFormat::FLOAT32;
+        size_t memory_bytes = 0; // Sample storage only
+    };
+
+    // Decoded, immutable audio. Shared by every cue that plays the file.
+    struct AudioAsset {
+        AudioAssetMetadata metadata;
+        std::vector<SampleChannel> channels;
+        WaveformPyramid waveform;
+        ActivityMap activity;
+    };
+
+    // Decode cache keyed by file path. Each file is decoded and analysed
+    // once; concurrent requests for the same file wait for the first one.
+    // Analysis runs on the loader thread pool, never on the audio thread.
+    class AudioAssetCache {
+    public:
+        using LoadCallback = std::function<void(std::shared_ptr<const AudioAsset> asset)>;
+
+        AudioAssetCache();
+        ~AudioAssetCache();
+
+        bool initialize(int sample_rate, int num_loader_threads = 0);
+        void shutdown();
+
+        // Applies to assets decoded after the call (default LOSSLESS)
+        void set_storage_policy(SampleStoragePolicy policy);
+        SampleStoragePolicy get_storage_policy() const;
+
+        // Blocking load (decodes on the calling thread, analysis fans out to the pool)
+        std::shared_ptr<const AudioAsset> load(const std::string& file_path);
+        // Decode on the loader pool, callback runs on a loader thread
+        void load_async(const std::string& file_path, LoadCallback callback);
+
+        std::shared_ptr<const AudioAsset> find(const std::string& file_path) const;
+        bool get_metadata(const std::string& file_path, AudioAssetMetadata& metadata) const;
+
+        // Drop assets that no cue references any more
+        int purge_unused();
+        int get_num_assets() const;
+        size_t get_memory_bytes() const;
+        // Sample bytes held per storage format, indexed by SampleFormat
+        std::vector<size_t> get_memory_bytes_by_format() const;
+
+        LoaderThreadPool* get_loader_pool();
+        // Holds every asset's samples; readers take a SampleArena::ReadGuard on it
+        SampleArena* get_arena();
+        std::string get_last_error() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Single-channel compensation delay.
+    // The ring is written every block even at zero delay, so a delay change
+    // always has real history to read from and can crossfade from the old
+    // read position to the new one within one block instead of clicking.
+    class DelayLine {
+    public:
+        DelayLine() = default;
+
+        // Non-realtime thread
+        void prepare(int max_delay_samples, int max_block_size);
+        int get_max_delay() const { return max_delay_; }
+
+        // Called from audio thread
+        void reset();
+        void set_delay(int delay_samples);
+        int get_delay() const { return target_delay_; }
+        void process(float* data, int num_samples);
+
+    private:
+        std::vector<float> buffer_;
+        int mask_ = 0;
+        int write_pos_ = 0;
+        int max_delay_ = 0;
+        int current_delay_ = 0;
+        int target_delay_ = 0;
+    };
+
+    // Fixed set of delay lines allocated up front, handed out to mix graph
+    // paths when they are created so the audio thread never allocates.
+    class DelayLinePool {
+    public:
+        DelayLinePool() = default;
+
+        // Non-realtime thread
+        void prepare(int num_lines, int max_delay_samples, int max_block_size);
+        DelayLine* acquire();
+        void release(DelayLine* line);
+        int get_num_free() const;
+        int get_max_delay() const { return max_delay_; }
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<DelayLine>> lines_;
+        std::vector<DelayLine*> free_lines_;
+        int max_delay_ = 0;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <memory>
+
+namespace SharedAudio {
+
+    class MixGraph;
+    class MeterBank;
+
+    // Routing of one device input (non-realtime snapshot)
+    struct InputChannelInfo {
+        int input_channel;
+        float gain;
+        float pan;          // -1 (left) .. +1 (right), balance law like the cues
+        bool is_muted;
+        int bus_index;      // -1 = not routed to a bus
+        int direct_output;  // -1 = no direct monitor output
+    };
+
+    // Device inputs as first-class sources. Each input can feed a mix bus
+    // (through the bus inserts, delay compensation and metering) and/or a
+    // direct output. The direct path is summed after the graph's delay
+    // compensation (and before the output trim and meters), so live
+    // monitoring gets no added latency, and both paths share the playback
+    // clock because they run inside the same device callback.
+    class InputRouter {
+    public:
+        static constexpr int kMaxInputs = 128;
+
+        InputRouter();
+        ~InputRouter();
+
+        // Non-realtime thread
+        bool initialize(int num_inputs, MixGraph* mix_graph);
+        int get_num_inputs() const;
+        bool set_input_gain(int input_channel, float gain);
+        bool set_input_pan(int input_channel, float pan);
+        bool set_input_mute(int input_channel, bool muted);
+        bool set_input_bus(int input_channel, int bus_index);
+        bool set_input_direct_output(int input_channel, int output_channel);
+        InputChannelInfo get_input_info(int input_channel) const;
+
+        // Post-gain input meters, one per input channel (single reader)
+        MeterBank* get_input_meters();
+
+        // Called from audio thread: buses before MixGraph::process, direct
+        // outputs as its direct feed
+        void process_to_buses(const AudioBuffer& inputs, int num_samples);
+        void process_direct(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
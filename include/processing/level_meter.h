@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Running level of one channel, folded block by block on the audio thread
+    struct MeterAccumulator {
+        float peak = 0.0f;
+        float true_peak = 0.0f;
+        double sum_squares = 0.0;
+        int num_samples = 0;
+
+        void reset() {
+            peak = 0.0f;
+            true_peak = 0.0f;
+            sum_squares = 0.0;
+            num_samples = 0;
+        }
+    };
+
+    // Linear levels since the previous read
+    struct MeterValues {
+        float peak;
+        float rms;
+        float true_peak;
+    };
+
+    // Display values after ballistics (dBFS)
+    struct MeterReading {
+        float peak_db;
+        float rms_db;
+        float true_peak_db;
+        float peak_hold_db;
+        bool clipped;
+    };
+
+    // SIMD kernels - fused into the mix loops so levels come for free while
+    // the samples are already in registers
+    void measure_block(const float* data, int num_samples, MeterAccumulator& meter);
+    void mix_and_measure(const float* src, float* dst, float gain_start, float gain_end,
+        int num_samples, MeterAccumulator& meter); // dst may be nullptr (meter only)
+
+    // 4x oversampled true-peak (ITU-R BS.1770-4 Annex 2 polyphase FIR).
+    // Keeps 11 samples of history, so no per-channel block buffer is needed.
+    class TruePeakDetector {
+    public:
+        void reset() { history_.fill(0.0f); }
+        float process(const float* data, int num_samples);
+
+    private:
+        std::array<float, 11> history_{};
+    };
+
+    // Fixed set of channel meters written by the audio thread and read by
+    // one UI thread. The audio thread publishes one snapshot under a
+    // sequence counter and never waits; the reader retries if a publish
+    // landed during its copy. Accumulators keep growing until the reader has
+    // consumed them, so peaks between two UI polls are never lost.
+    class MeterBank {
+    public:
+        MeterBank() = default;
+
+        // Non-realtime thread
+        void prepare(int num_channels, bool enable_true_peak);
+        int get_num_channels() const { return static_cast<int>(accumulators_.size()); }
+
+        // Called from audio thread
+        void begin_block();
+        MeterAccumulator& accumulator(int channel) { return accumulators_[channel]; }
+        void measure(int channel, const float* data, int num_samples);
+        void measure_true_peak(int channel, const float* data, int num_samples, float gain);
+        void publish();
+
+        // Reader thread (single consumer)
+        bool read(std::vector<MeterValues>& values);
+
+    private:
+        std::vector<MeterAccumulator> accumulators_;
+        std::vector<TruePeakDetector> true_peak_detectors_;
+        bool true_peak_enabled_ = true;
+        int unread_blocks_ = 0; // audio thread only
+
+        std::vector<MeterAccumulator> published_;
+        alignas(64) std::atomic<uint32_t> sequence_{ 0 };
+        alignas(64) std::atomic<uint32_t> consumed_{ 0 };
+    };
+
+    // Peak hold, decay and clip latch, applied on the UI side
+    class MeterBallistics {
+    public:
+        MeterBallistics(double hold_seconds = 1.5, double decay_db_per_second = 20.0);
+
+        void process(const std::vector<MeterValues>& values, double elapsed_seconds,
+            std::vector<MeterReading>& readings);
+        void reset_clip_indicators();
+
+    private:
+        struct ChannelState {
+            float display_peak_db = -120.0f;
+            float display_rms_db = -120.0f;
+            float hold_db = -120.0f;
+            double hold_remaining = 0.0;
+            bool clipped = false;
+        };
+
+        double hold_seconds_;
+        double decay_db_per_second_;
+        std::vector<ChannelState> states_;
+    };
+
+    float linear_to_db(float linear);
+
+} // namespace SharedAudio
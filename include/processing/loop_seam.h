@@ -0,0 +1,58 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <cstddef>
+
+namespace SharedAudio {
+
+    // Frames of a file that repeat while a cue or playback stream loops
+    struct LoopRegion {
+        size_t start_frame = 0;
+        size_t end_frame = 0;          // Exclusive
+        int crossfade_frames = 0;      // 0: hard wrap (declicked, not seamless)
+    };
+
+    // Where the seam sits once the region has been clamped to the file. The
+    // last crossfade_frames before end_frame are replaced by the seam, which
+    // then continues at resume_frame. When the region starts at least one
+    // crossfade into the file the seam blends towards the material leading up
+    // to start_frame and resumes exactly there, so the loop keeps its length;
+    // otherwise it blends towards the first frames of the loop and resumes
+    // after them.
+    struct LoopSeamPlan {
+        size_t seam_start = 0;     // end_frame - crossfade_frames
+        size_t end_frame = 0;
+        size_t incoming_start = 0; // Source of the frames faded in
+        size_t resume_frame = 0;
+        int crossfade_frames = 0;
+
+        bool is_valid() const { return end_frame > resume_frame; }
+    };
+
+    // Precomputed loop crossfade. Built once on a non-realtime thread from
+    // the outgoing and incoming spans, so a looping reader only switches its
+    // source pointer to the seam and back, and never mixes two read heads.
+    class LoopSeam {
+    public:
+        static LoopSeamPlan plan(const LoopRegion& region, size_t num_frames);
+
+        // outgoing/incoming hold plan.crossfade_frames frames per channel
+        // (read at seam_start and incoming_start)
+        void build(const LoopSeamPlan& plan, const AudioBuffer& outgoing, const AudioBuffer& incoming);
+
+        const LoopSeamPlan& get_plan() const { return plan_; }
+        bool has_crossfade() const { return plan_.crossfade_frames > 0 && !seam_.empty(); }
+        int get_num_channels() const { return static_cast<int>(seam_.size()); }
+        const float* get_channel(int channel) const { return seam_[channel].data(); }
+        const AudioBuffer& get_buffer() const { return seam_; }
+
+        // Timeline position of a frame count that has been played straight
+        // through the loop (streams count frames, not positions)
+        size_t fold_position(size_t position) const;
+
+    private:
+        LoopSeamPlan plan_;
+        AudioBuffer seam_;
+    };
+
+} // namespace SharedAudio
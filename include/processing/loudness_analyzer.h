@@ -0,0 +1,81 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <memory>
+
+namespace SharedAudio {
+
+    class AudioTap;
+    class LoaderThreadPool;
+
+    constexpr double kLoudnessFloorLufs = -70.0;
+
+    // EBU R128 / ITU-R BS.1770-4 loudness of a whole asset
+    struct LoudnessInfo {
+        bool is_valid = false;
+        double integrated_lufs = kLoudnessFloorLufs;   // gated (-70 LUFS absolute, -10 LU relative)
+        double max_momentary_lufs = kLoudnessFloorLufs; // 400 ms window
+        double max_short_term_lufs = kLoudnessFloorLufs; // 3 s window
+        double loudness_range_lu = 0.0;                // EBU Tech 3342
+    };
+
+    // Running loudness of a live signal
+    struct LiveLoudness {
+        bool is_valid = false;
+        double momentary_lufs = kLoudnessFloorLufs;
+        double short_term_lufs = kLoudnessFloorLufs;
+        double integrated_lufs = kLoudnessFloorLufs;
+        double max_momentary_lufs = kLoudnessFloorLufs;
+        double measured_seconds = 0.0;
+    };
+
+    // K-weighting pre-filter (shelf + RLB high-pass) for any sample rate.
+    // Returns the sum of squares of the weighted signal, which is all the
+    // gating stage needs.
+    class KWeightingFilter {
+    public:
+        void prepare(double sample_rate);
+        void reset();
+        double process_energy(const float* data, int num_samples);
+
+    private:
+        struct Biquad {
+            double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+            double z1 = 0.0, z2 = 0.0;
+        };
+        Biquad shelf_;
+        Biquad high_pass_;
+    };
+
+    // BS.1770 channel weighting (surrounds of a 5.1 layout get +1.5 dB, LFE is ignored)
+    double loudness_channel_weight(int channel, int num_channels);
+
+    // Offline analysis of a decoded asset. Channels are filtered in parallel
+    // on the pool when one is given.
+    LoudnessInfo analyze_loudness(const AudioBuffer& channels, int sample_rate,
+        LoaderThreadPool* pool = nullptr);
+
+    // Live loudness of a range of output channels. The audio thread only
+    // copies samples into a lock-free tap; filtering and gating happen on a
+    // normal priority analysis thread.
+    class LoudnessMonitor {
+    public:
+        LoudnessMonitor();
+        ~LoudnessMonitor();
+
+        bool start(int sample_rate, int first_channel, int num_channels);
+        void stop();
+        bool is_running() const;
+
+        // Attach this to MixGraph::add_output_tap
+        AudioTap* get_tap();
+
+        LiveLoudness get_loudness() const;
+        void reset(); // Restart the integrated measurement
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
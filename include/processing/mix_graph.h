@@ -0,0 +1,118 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    class PluginHost;
+    class PluginInsertSlot;
+    class MeterBank;
+    class AudioTap;
+
+    // Bus information (non-realtime snapshot)
+    struct MixBusInfo {
+        int bus_index;
+        std::string name;
+        int num_channels;
+        int first_output_channel;
+        float gain;
+        bool is_muted;
+        int insert_latency_samples;
+        int compensation_delay_samples;
+        bool is_silent; // Nothing reached the bus in the last block
+    };
+
+    // Summing graph between the cue voices and the device outputs.
+    // Cues render into buses, each bus runs its plugin inserts and sums into a
+    // range of output channels, then output groups run their own inserts.
+    // Buses are created off the audio thread and are never freed while the
+    // graph is running, so the audio thread only ever sees stable buffers.
+    //
+    // Plugin delay compensation: every bus and every output channel owns a
+    // delay line from a preallocated pool. Each block the audio thread sums
+    // the insert latencies per path and delays the faster paths to match the
+    // slowest one, so all buses and all outputs stay time-aligned.
+    class MixGraph {
+    public:
+        static constexpr int kMaxBuses = 64;
+        static constexpr int kMaxBusChannels = 16;
+        static constexpr int kMaxInsertsPerStrip = 8;
+        static constexpr int kMaxOutputGroups = 64;
+        static constexpr int kMaxCompensationSamples = 16384;
+        static constexpr int kMaxOutputTaps = 8;
+        static constexpr int kMaxTapsPerBus = 4;
+
+        MixGraph();
+        ~MixGraph();
+
+        // Initialization
+        bool initialize(int sample_rate, int max_block_size, int num_outputs, PluginHost* plugin_host);
+        void shutdown();
+        int get_sample_rate() const;
+
+        // Bus management (non-realtime thread)
+        int add_bus(const std::string& name, int num_channels, int first_output_channel);
+        bool set_bus_output(int bus_index, int first_output_channel);
+        bool set_bus_gain(int bus_index, float gain);
+        bool set_bus_mute(int bus_index, bool muted);
+        float get_bus_gain(int bus_index) const; // Lock-free, any thread
+        int get_num_buses() const;
+        MixBusInfo get_bus_info(int bus_index) const;
+
+        // Output groups - consecutive device outputs that share an insert chain.
+        // By default the outputs are grouped in stereo pairs.
+        int get_num_output_groups() const;
+        bool set_output_groups(const std::vector<int>& group_sizes);
+
+        // Per-output trim after the output inserts (any thread, lock-free)
+        int get_num_outputs() const;
+        bool set_output_gain(int output_channel, float gain);
+        float get_output_gain(int output_channel) const;
+
+        // Insert slots (load plugins into these through PluginHost)
+        PluginInsertSlot* get_bus_insert(int bus_index, int slot_index);
+        PluginInsertSlot* get_output_insert(int group_index, int slot_index);
+
+        // Realtime worker threads for offloaded insert chains
+        bool set_num_worker_threads(int num_workers);
+
+        // Latency of the slowest bus path plus the slowest output group, in samples
+        int get_total_latency_samples() const;
+
+        // Post-fader bus meters (index bus * kMaxBusChannels + channel) and
+        // final output meters. Each bank supports a single reader thread.
+        MeterBank* get_bus_meters();
+        MeterBank* get_output_meters();
+
+        // Copies of the final outputs or of a bus (post-insert, pre-fader)
+        // for non-realtime analysis such as loudness or spectrum. Removing a
+        // tap waits for the block in flight, after which it may be destroyed.
+        // If that block stalls, owner (whatever keeps the tap alive) is held
+        // until it ends; with no owner the tap must outlive the graph.
+        bool add_output_tap(AudioTap* tap);
+        void remove_output_tap(AudioTap* tap, std::shared_ptr<void> owner = nullptr);
+        bool add_bus_tap(int bus_index, AudioTap* tap);
+        void remove_bus_tap(int bus_index, AudioTap* tap, std::shared_ptr<void> owner = nullptr);
+
+        // Called from audio thread. Asking for a bus buffer marks the bus as
+        // written for this block; buses nobody asked for (and with no insert
+        // or delay tail still ringing) skip processing and summing entirely.
+        AudioBuffer* get_bus_buffer(int bus_index);
+        void begin_block(int num_samples);
+
+        // Zero-latency sources (direct input monitoring) mixed into the
+        // outputs after delay compensation, so they skip the graph latency
+        // but still go through the output trim and meters
+        using DirectFeedFunction = void (*)(void* context, AudioBuffer& outputs, int num_samples);
+        void process(AudioBuffer& outputs, int num_samples,
+            DirectFeedFunction direct_feed = nullptr, void* direct_context = nullptr);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
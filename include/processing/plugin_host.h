@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core/lock_free_fifo.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Opaque wrapper around a prepared juce::AudioPluginInstance
+    struct LoadedPlugin;
+
+    // Description of a plugin found by a scan
+    struct PluginInfo {
+        std::string name;
+        std::string manufacturer;
+        std::string format_name;      // "VST3", "LV2", ...
+        std::string file_or_identifier;
+        int num_input_channels;
+        int num_output_channels;
+    };
+
+    // One insert position on a bus or output group.
+    // The loader thread publishes a fully prepared plugin into the slot; the
+    // audio thread picks it up at the next block boundary with a single
+    // pointer exchange and hands the previous instance back for deletion.
+    class PluginInsertSlot {
+    public:
+        PluginInsertSlot();
+        ~PluginInsertSlot();
+
+        PluginInsertSlot(const PluginInsertSlot&) = delete;
+        PluginInsertSlot& operator=(const PluginInsertSlot&) = delete;
+
+        // Non-realtime thread
+        bool is_loaded() const { return has_plugin_.load(std::memory_order_acquire); }
+        std::string get_plugin_name() const;
+        int get_latency_samples() const { return latency_samples_.load(std::memory_order_acquire); }
+        int get_num_channels() const { return num_channels_.load(std::memory_order_acquire); }
+
+        void set_bypassed(bool bypassed) { bypassed_.store(bypassed, std::memory_order_release); }
+        bool is_bypassed() const { return bypassed_.load(std::memory_order_acquire); }
+
+        // Slow plugins can be moved off the audio thread onto a realtime worker
+        void set_offload_to_worker(bool offload) { offload_.store(offload, std::memory_order_release); }
+        bool is_offloaded_to_worker() const { return offload_.load(std::memory_order_acquire); }
+
+        // Called from audio thread
+        void update_active_plugin();
+        bool is_active() const { return active_ != nullptr; }
+        int get_active_latency_samples() const;
+        void process(float* const* channels, int num_channels, int num_samples);
+
+    private:
+        friend class PluginHost;
+        friend class MixGraph;
+
+        void publish(LoadedPlugin* plugin, int latency_samples); // nullptr unloads
+
+        std::atomic<LoadedPlugin*> pending_{ nullptr };
+        LoadedPlugin* active_ = nullptr;    // audio thread only
+        LoadedPlugin* published_ = nullptr; // loader thread only
+        LockFreeFIFO<LoadedPlugin*, 64>* retire_queue_ = nullptr;
+
+        std::atomic<int> num_channels_{ 2 };
+        mutable std::mutex name_mutex_;
+        std::string plugin_name_;
+        std::atomic<bool> has_plugin_{ false };
+        std::atomic<int> latency_samples_{ 0 };
+        std::atomic<bool> bypassed_{ false };
+        std::atomic<bool> offload_{ false };
+    };
+
+    // Hosts VST3/LV2 plugins via juce::AudioPluginFormatManager.
+    // Scanning, instantiation, state restore and destruction all run on a
+    // background loader thread so the audio thread only ever swaps pointers.
+    // JUCE wants plugins created and destroyed on its message thread, and
+    // nothing else here runs a message loop, so the loader thread is the
+    // message thread from initialize() until shutdown().
+    class PluginHost {
+    public:
+        using LoadCallback = std::function<void(bool success, const std::string& error)>;
+
+        PluginHost();
+        ~PluginHost();
+
+        // Initialization
+        bool initialize(double sample_rate, int max_block_size);
+        void shutdown();
+
+        // Plugin discovery (blocks the caller - run from a non-realtime thread)
+        std::vector<PluginInfo> scan_plugin_file(const std::string& file_or_identifier);
+
+        // Asynchronous loading into an insert slot
+        bool load_plugin_async(PluginInsertSlot* slot, const std::string& file_or_identifier,
+            const std::vector<uint8_t>& state = {}, LoadCallback callback = nullptr);
+        bool unload_plugin_async(PluginInsertSlot* slot, LoadCallback callback = nullptr);
+
+        // State (queried on the loader thread, result delivered through callback)
+        bool get_plugin_state_async(PluginInsertSlot* slot,
+            std::function<void(std::vector<uint8_t> state)> callback);
+
+        // Slots must be attached before plugins can be loaded into them
+        void attach_slot(PluginInsertSlot* slot, int num_channels);
+
+        // Error handling
+        std::string get_last_error() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "core/sample_arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SharedAudio {
+
+    // In-memory sample encodings for decoded assets
+    enum class SampleFormat {
+        FLOAT32,
+        INT16,    // value / 32768
+        INT24,    // Packed 3 bytes, value / 8388608
+        FLOAT16,  // IEEE 754 half
+        COMPRESSED // Lossless: fixed linear prediction + bit-packed residuals of the int16/int24 grid
+    };
+
+    constexpr size_t kNumSampleFormats = 5;
+
+    // COMPRESSED channels are coded in independent blocks (random access for
+    // seeks and loops), each split into sub-blocks with their own residual width
+    constexpr int kCompressedBlockFrames = 4096;
+    constexpr int kCompressedSubBlockFrames = 32;
+    constexpr int kCompressedSubBlocksPerBlock = kCompressedBlockFrames / kCompressedSubBlockFrames;
+    constexpr int kCompressedMaxPredictorOrder = 3;
+
+    // Where a partial decode of one COMPRESSED block stopped
+    struct CompressedBlockCursor {
+        size_t block = static_cast<size_t>(-1);
+        int next_sub_block = 0;
+        size_t byte_offset = 0;
+        uint32_t carries[kCompressedMaxPredictorOrder] = {};
+    };
+
+    // How the asset cache picks a format for each asset
+    enum class SampleStoragePolicy {
+        FLOAT32,    // Always 32-bit float
+        LOSSLESS,   // Smallest of int16 / int24 / float32 that holds every sample exactly
+        HALF_FLOAT, // As LOSSLESS, but anything that is not exact int16 becomes half float
+        COMPRESSED  // Int16/int24 grids compressed losslessly, anything else float32
+    };
+
+    size_t sample_format_bytes(SampleFormat format); // 0 for COMPRESSED (variable)
+    const char* sample_format_name(SampleFormat format);
+
+    // Most compact format for these channels under the policy (one format per asset)
+    SampleFormat choose_sample_format(const AudioBuffer& channels, SampleStoragePolicy policy);
+
+    // Arena used when encode() is not given one
+    std::shared_ptr<SampleArena> get_default_sample_arena();
+
+    // Level of what a mix kernel added (peak and sum of squares of x * gain * pan_gain)
+    struct MixSpanLevels {
+        float peak = 0.0f;
+        float sum_sq = 0.0f;
+    };
+
+    // Vectorised dest[i] += src[i] * gain * pan_gain, rounding exactly like
+    // the scalar (x * gain) * pan_gain
+    void mix_samples(const float* src, int count, float gain, float pan_gain, float* dest, MixSpanLevels& levels);
+
+    // One channel of samples in a compact format. Immutable once encoded;
+    // read() expands any span back to float with SIMD (F16C for half floats
+    // when the CPU has it), so the mix loop converts small chunks that stay
+    // in L1 instead of the asset keeping a float copy.
+    //
+    // The samples live in a SampleArena, which may move them while
+    // compacting: anything that reads them (read, view, float_data,
+    // decode_block) must hold a SampleArena::ReadGuard on get_arena().
+    class SampleChannel {
+    public:
+        SampleChannel() = default;
+        ~SampleChannel();
+        SampleChannel(SampleChannel&& other) noexcept;
+        SampleChannel& operator=(SampleChannel&& other) noexcept;
+        SampleChannel(const SampleChannel&) = delete;
+        SampleChannel& operator=(const SampleChannel&) = delete;
+
+        // Throws std::bad_alloc if the arena cannot grow, like the vectors it replaces
+        void encode(const float* samples, size_t num_samples, SampleFormat format,
+            std::shared_ptr<SampleArena> arena = nullptr);
+        SampleArena* get_arena() const { return arena_.get(); }
+
+        SampleFormat get_format() const { return format_; }
+        size_t size() const { return num_samples_; }
+        size_t get_memory_bytes() const;
+
+        // Direct access when stored as float (no conversion needed), else nullptr
+        const float* float_data() const;
+
+        // Expands [start, start + count) to float. Callers keep the span in range.
+        // COMPRESSED decodes sub-block by sub-block on the stack here (no
+        // allocation); the audio thread reads those through a SampleReader.
+        void read(size_t start, int count, float* dest) const;
+
+        // mix_samples() straight from the stored format: int16, int24 and half
+        // are expanded in registers in the same pass, bit-identical to read()
+        // followed by mix_samples(). expanded (nullptr to skip) also receives
+        // the float samples, for metering.
+        void mix(size_t start, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) const;
+
+        // COMPRESSED only: decodes block index into dest (kCompressedBlockFrames
+        // floats, samples past the end repeat the last one)
+        size_t get_num_blocks() const { return block_offsets_.size(); }
+        void decode_block(size_t block, float* dest) const;
+        int get_block_order(size_t block) const; // Predictor order the encoder picked (0-3)
+
+        // COMPRESSED only: the same decode a few sub-blocks at a time. dest is
+        // the whole block; returns true once every sub-block is in it.
+        void begin_block(size_t block, CompressedBlockCursor& cursor) const;
+        bool decode_sub_blocks(CompressedBlockCursor& cursor, int max_sub_blocks, float* dest) const;
+
+        // Float view of a span: float_data() + start when possible, else
+        // decoded into scratch (which must hold count floats)
+        const float* view(size_t start, int count, float* scratch) const {
+            const float* data = float_data();
+            if (data != nullptr) {
+                return data + start;
+            }
+            read(start, count, scratch);
+            return scratch;
+        }
+
+    private:
+        const uint8_t* data() const { return SampleArena::resolve(storage_); }
+        void store(const void* data, size_t bytes);
+        void release();
+        void encode_compressed(const float* samples, size_t num_samples);
+        void decode_next_sub_block(CompressedBlockCursor& cursor, float* out) const;
+
+        SampleFormat format_ = SampleFormat::FLOAT32;
+        size_t num_samples_ = 0;
+
+        // Float, int16, packed little-endian int24, half or compressed
+        // blocks ([order][sub-block widths][packed residuals]) per format_
+        std::shared_ptr<SampleArena> arena_;
+        SampleArena::Handle storage_ = nullptr;
+        size_t storage_bytes_ = 0;
+        std::vector<uint32_t> block_offsets_; // COMPRESSED only
+        int compressed_bits_ = 16;
+    };
+
+    // Peak level per fixed block of frames across all channels of an asset,
+    // computed at load time so voices can skip blocks nobody would hear
+    class ActivityMap {
+    public:
+        static constexpr int kBlockFrames = 256;
+
+        void build(const AudioBuffer& channels);
+        bool is_built() const { return !peaks_.empty(); }
+
+        // Largest |sample| over [start, start + count), rounded out to whole
+        // blocks. 1.0 when no map was built so callers never skip by mistake.
+        float get_peak(size_t start, size_t count) const;
+
+    private:
+        std::vector<float> peaks_;
+    };
+
+    // Per-voice read cursor. Compressed channels are decoded a whole block at
+    // a time into a cache the reader owns, and spans inside the block are
+    // returned in place. The block after the play head is decoded ahead, a
+    // share per view() matching the frames read (count / 32 + 2 sub-blocks),
+    // so a callback costs about count / 4096 of a block decode instead of a
+    // whole block at every crossing. Seeks and loop jumps land on a block
+    // that was not decoded ahead and pay for it in full, as before. Other
+    // formats pass straight through to SampleChannel::view.
+    class SampleReader {
+    public:
+        SampleReader() = default;
+
+        // Non-realtime thread (allocates the block cache for COMPRESSED channels)
+        void attach(const SampleChannel* channel);
+        const SampleChannel* get_channel() const { return channel_; }
+
+        // Called from audio thread. count <= kCompressedBlockFrames; scratch is
+        // only written when the span straddles two blocks or needs expanding.
+        const float* view(size_t start, int count, float* scratch);
+
+    private:
+        float* cache_slot(int slot) { return cache_.data() + slot * kCompressedBlockFrames; }
+        const float* cached_block(size_t block);
+        void decode_ahead(int count);
+
+        const SampleChannel* channel_ = nullptr;
+        std::vector<float> cache_; // Two blocks: the current one and the one after it
+        int current_slot_ = 0;
+        size_t cached_block_ = static_cast<size_t>(-1);
+        CompressedBlockCursor ahead_;
+    };
+
+} // namespace SharedAudio
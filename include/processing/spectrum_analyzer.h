@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SharedAudio {
+
+    class AudioTap;
+
+    struct SpectrumSettings {
+        int fft_order = 12;          // FFT size 2^order (8..15)
+        float overlap = 0.75f;       // 0 .. 0.9375
+        float smoothing = 0.7f;      // per-frame exponential smoothing of the power spectrum (0 = none)
+        float floor_db = -120.0f;
+    };
+
+    // Layout of the shared frame block handed to the UI. The analysis thread
+    // bumps `sequence` to odd before writing and to even afterwards, so a
+    // reader (JS through Atomics.load on an Int32Array view, or C++) copies
+    // the bins and retries if the sequence moved or was odd.
+    struct SpectrumFrameHeader {
+        std::atomic<uint32_t> sequence;
+        uint32_t num_bins;
+        float sample_rate;
+        uint32_t fft_size;
+        // float bins_db[num_bins] follows
+    };
+    static_assert(sizeof(SpectrumFrameHeader) == 16, "Shared spectrum header layout is part of the JS API");
+
+    // Windowed-FFT spectrum of a tap. The audio thread only copies samples
+    // into the tap; FFTs, smoothing and dB conversion run on a normal
+    // priority analysis thread.
+    class SpectrumAnalyzer {
+    public:
+        SpectrumAnalyzer();
+        ~SpectrumAnalyzer();
+
+        bool start(int sample_rate, int first_channel, int num_channels,
+            const SpectrumSettings& settings = SpectrumSettings{});
+        void stop();
+        bool is_running() const;
+
+        // Attach to MixGraph::add_output_tap or MixGraph::add_bus_tap
+        AudioTap* get_tap();
+
+        int get_num_bins() const;
+        uint64_t get_frames_analyzed() const;
+
+        // Copy of the latest smoothed frame in dBFS
+        bool read_frame(std::vector<float>& bins_db) const;
+
+        // Shared frame block (header followed by the bins), valid until stop()
+        const void* get_shared_frame() const;
+        size_t get_shared_frame_bytes() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <vector>
+
+namespace SharedAudio {
+
+    class LoaderThreadPool;
+    class SampleChannel;
+
+    // One overview point. Interleaved floats so a level can be handed to JS
+    // as a Float32Array (min, max, rms, min, max, rms, ...) without copying.
+    struct WaveformPoint {
+        float min;
+        float max;
+        float rms;
+    };
+    static_assert(sizeof(WaveformPoint) == 3 * sizeof(float), "WaveformPoint must stay tightly packed");
+
+    // Multi-resolution min/max/RMS overview of an asset. Level 0 summarises
+    // kBaseSamplesPerPoint samples per point and every further level is 4x
+    // coarser, so the whole pyramid costs about 1/64 of the sample data.
+    // Rendering picks the level with 1-4 points per pixel, so drawing any
+    // zoom is O(pixels) no matter how long the file is.
+    class WaveformPyramid {
+    public:
+        static constexpr int kBaseSamplesPerPoint = 256;
+        static constexpr int kLevelFactor = 4;
+
+        // Built once by the loader, read-only afterwards
+        void build(const AudioBuffer& channels, LoaderThreadPool* pool = nullptr);
+        bool is_built() const { return !levels_.empty(); }
+
+        int get_num_channels() const { return static_cast<int>(levels_.size()); }
+        int get_num_levels() const { return levels_.empty() ? 0 : static_cast<int>(levels_[0].size()); }
+        size_t get_samples_per_point(int level) const;
+        const std::vector<WaveformPoint>* get_level(int channel, int level) const;
+
+        // Coarsest level that still has at least one point per pixel
+        int select_level(double samples_per_pixel) const;
+
+        // num_pixels points covering [start_sample, end_sample). When zoomed in
+        // past level 0 the raw samples are used if given (at most 256 per pixel).
+        void render(int channel, double start_sample, double end_sample, int num_pixels,
+            std::vector<WaveformPoint>& points, const SampleChannel* samples = nullptr) const;
+
+    private:
+        std::vector<std::vector<std::vector<WaveformPoint>>> levels_; // [channel][level][point]
+        size_t num_frames_ = 0;
+    };
+
+} // namespace SharedAudio
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -10,6 +12,15 @@ namespace SharedAudio {
     // Forward declarations
     class CueAudioManager;
     class CrossfadeEngine;
+    class MixGraph;
+    class PluginHost;
+    class LoudnessMonitor;
+    class InputRouter;
+    class MultitrackRecorder;
+    class MultitrackPlayer;
+    class ReadScheduler;
+    class SceneManager;
+    struct AudioThreadMessage;
 
     // Audio sample type
     using AudioSample = float;
@@ -60,6 +71,7 @@ namespace SharedAudio {
         int output_channels = 2;
         bool enable_asio = true;
         double target_latency_ms = 5.0;
+        bool offline = false; // No device: render_offline() drives the engine
     };
 
     // Performance metrics
@@ -69,6 +81,29 @@ namespace SharedAudio {
         int buffer_underruns;
         int buffer_overruns;
         bool is_stable;
+
+        // Plugin delay compensation
+        int graph_latency_samples = 0;     // slowest bus path + slowest output group
+        double total_output_latency_ms = 0.0; // device latency + graph latency
+
+        // Control -> audio thread commands
+        uint64_t commands_pushed = 0;           // send_command calls
+        uint64_t commands_coalesced = 0;        // superseded parameter changes folded away
+        uint64_t commands_dropped = 0;          // parameter lane full
+        uint64_t critical_commands_dropped = 0; // transport lane full (audio thread stalled)
+        int command_queue_high_water = 0;
+        int critical_queue_high_water = 0;
+        uint64_t shared_ring_dropped = 0;       // JS commands that found the shared ring full
+        uint64_t scheduled_commands_late = 0;     // timestamp already passed on arrival, applied at once
+        uint64_t scheduled_commands_overflow = 0; // schedule full, applied ahead of their timestamp
+    };
+
+    // Time spent in one stage of the audio callback
+    struct StageTiming {
+        std::string name;
+        double average_us = 0.0;
+        double max_us = 0.0;
+        uint64_t blocks = 0;
     };
 
     // Forward declaration of HardwareCapabilities (defined in hardware_detector.h)
@@ -98,11 +133,64 @@ namespace SharedAudio {
 
         // Performance monitoring
         PerformanceMetrics get_performance_metrics() const;
+        std::vector<StageTiming> get_stage_profile() const;
+        void reset_stage_profile();
+
+        // Commands to the audio thread (any thread)
+        bool send_command(const AudioThreadMessage& msg);
+
+        // Engine sample clock. A command whose timestamp_samples lies ahead
+        // is held and takes effect on that sample, inside the block
+        // containing it. -1 until the first block has run.
+        int64_t get_sample_time(std::chrono::steady_clock::time_point when) const;
+
+        // Command ring in memory shared with a JS producer (see
+        // core/shared_command_ring.h). The caller keeps the memory alive
+        // until detach_command_ring() returns. One ring at a time.
+        bool attach_command_ring(void* memory, size_t bytes);
+        void detach_command_ring();
+
+        // Offline rendering for replay and tests (settings.offline only).
+        // Runs exactly the path the device callback runs.
+        bool render_offline(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples);
+        // Offline only, on the thread calling render_offline: the command is
+        // dispatched at the top of the next block, ahead of the queues and
+        // in call order, exactly as the audio thread would apply it (replay)
+        bool apply_command_offline(const AudioThreadMessage& msg);
+
+        // Capture of every applied command, the loaded asset manifest, the
+        // bus layout, levels and voice state at the first captured block, and
+        // a checksum per block, for replay with examples/command_replay
+        bool start_command_capture(const std::string& path);
+        void stop_command_capture();
+        bool is_capturing_commands() const;
 
         // Show control features (for CueForge)
         CueAudioManager* get_cue_manager();
         CrossfadeEngine* get_crossfade_engine();
 
+        // Mixing and plugin hosting
+        MixGraph* get_mix_graph();
+        PluginHost* get_plugin_host();
+
+        // Live EBU R128 loudness of the main output pair
+        LoudnessMonitor* get_loudness_monitor();
+
+        // Live device inputs (routing to buses and direct outputs)
+        InputRouter* get_input_router();
+
+        // Multitrack recording of device inputs and final outputs
+        MultitrackRecorder* get_recorder();
+
+        // Virtual soundcheck: recorded tracks played back in place of live inputs
+        MultitrackPlayer* get_player();
+
+        // Shared deadline-ordered disk reads for all streaming playback
+        ReadScheduler* get_read_scheduler();
+
+        // Scene snapshots of every voice, bus, input and output level
+        SceneManager* get_scene_manager();
+
         // Hardware detection (from Syntri)
         std::vector<HardwareType> detect_professional_hardware() const;
         bool is_professional_hardware_available() const;
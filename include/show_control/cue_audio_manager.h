@@ -1,12 +1,22 @@
 #pragma once
 
 #include "shared_audio/shared_audio_core.h"
+#include "processing/loudness_analyzer.h"
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace SharedAudio {
 
+    class MixGraph;
+    class MeterBank;
+    class AudioAssetCache;
+    struct AudioAsset;
+    struct SceneSnapshot;
+    struct VoiceSnapshot;
+
     // Cue state enum
     enum class CueState {
         STOPPED,
@@ -16,7 +26,7 @@ namespace SharedAudio {
         FADING_OUT
     };
 
-    // Audio cue information
+    // Audio cue information (as of the last audio block, position extrapolated to now)
     struct AudioCueInfo {
         std::string cue_id;
         std::string file_path;
@@ -25,10 +35,30 @@ namespace SharedAudio {
         double current_position_seconds;
         float volume;
         float pan;
+        float trim_gain;
+        float peak_left;  // Output peak of the last block
+        float peak_right;
+        int sample_rate;
+        int channels;
         bool is_looping;
         bool is_loaded;
     };
 
+    // Transport state of one voice at a block boundary, for command capture
+    // and replay. Fixed size so the audio thread can fill it in place.
+    // Fades, scene ramps and declick tails in flight are not part of it; a
+    // fading voice is restored as playing at its current level.
+    struct VoicePlaybackState {
+        char cue_id[64] = { 0 };
+        CueState state = CueState::STOPPED;
+        bool is_looping = false;
+        int bus_index = 0;
+        uint64_t position_frames = 0;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        float trim_gain = 1.0f;
+    };
+
     // Cue audio manager class
     class CueAudioManager {
     public:
@@ -55,6 +85,39 @@ namespace SharedAudio {
         bool set_cue_loop(const std::string& cue_id, bool loop);
         bool seek_cue(const std::string& cue_id, double position_seconds);
 
+        // Loop region used while the cue loops (end 0: end of the file). The
+        // crossfaded seam is precomputed here, on the calling thread.
+        bool set_cue_loop_region(const std::string& cue_id, double start_seconds, double end_seconds,
+            double crossfade_seconds = 0.0);
+        bool clear_cue_loop_region(const std::string& cue_id);
+
+        // Routing - cues render into a MixGraph bus (bus 0 is the main bus)
+        void set_mix_graph(MixGraph* mix_graph);
+        bool set_cue_bus(const std::string& cue_id, int bus_index);
+
+        // Voices skip blocks the asset's activity map marks silent (on by
+        // default). Off renders every block, for A/B checks.
+        void set_silence_skipping(bool enabled);
+
+        // Voice metering - channels meter_index * 2 and meter_index * 2 + 1
+        MeterBank* get_voice_meters();
+        int get_cue_meter_index(const std::string& cue_id) const;
+
+        // Loudness (EBU R128, measured when the asset is decoded)
+        bool set_cue_trim(const std::string& cue_id, float trim_db);
+        bool normalize_cue_loudness(const std::string& cue_id, double target_lufs = -23.0);
+        LoudnessInfo get_cue_loudness(const std::string& cue_id) const;
+
+        // Decode cache shared by all cues
+        AudioAssetCache* get_asset_cache();
+        std::shared_ptr<const AudioAsset> get_cue_asset(const std::string& cue_id) const;
+
+        // Scene snapshots (driven by SceneManager)
+        // Returns the voice layout the captured indices belong to
+        uint64_t capture_voices(std::vector<VoiceSnapshot>& voices) const;
+        // Audio thread: the scene must stay alive until the next process_audio returns
+        void apply_scene_realtime(const SceneSnapshot* scene, int default_ramp_samples);
+
         // Fading
         bool fade_in_cue(const std::string& cue_id, double fade_time_seconds);
         bool fade_out_cue(const std::string& cue_id, double fade_time_seconds);
@@ -65,12 +128,31 @@ namespace SharedAudio {
         void pause_all_cues();
         void resume_all_cues();
 
-        // Information
+        // Information - wait-free reads of the status the audio thread
+        // publishes each block, never blocked by the callback
         std::vector<AudioCueInfo> get_active_cues() const;
         AudioCueInfo get_cue_info(const std::string& cue_id) const;
         bool is_cue_loaded(const std::string& cue_id) const;
+        std::vector<std::pair<std::string, std::string>> get_loaded_assets() const; // cue id, file path
         bool is_cue_playing(const std::string& cue_id) const;
 
+        // Audio thread: commands drained from the engine's queues. They are
+        // held in a preallocated list and applied by the next process_audio,
+        // in the same block, sample_offset frames into it; the cue id is
+        // resolved there through a hashed id -> voice table. False when the
+        // list is full.
+        bool start_cue_realtime(const char* cue_id, int sample_offset = 0);
+        bool stop_cue_realtime(const char* cue_id, int sample_offset = 0);
+        bool set_cue_volume_realtime(const char* cue_id, float volume, int sample_offset = 0);
+        bool set_cue_pan_realtime(const char* cue_id, float pan, int sample_offset = 0);
+        bool seek_cue_realtime(const char* cue_id, double position_seconds, int sample_offset = 0);
+
+        // Audio thread, between blocks: one entry per loaded cue, up to
+        // states.capacity() (never allocates)
+        void capture_playback_state_realtime(std::vector<VoicePlaybackState>& states) const;
+        // Non-realtime: puts a loaded cue back exactly where a capture found it
+        bool restore_playback_state(const VoicePlaybackState& state);
+
         // Audio processing (called from audio callback)
         void process_audio(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples);
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    // Note-on from a desk (any velocity above 0) starts or stops a cue
+    struct MidiNoteTrigger {
+        int channel = 1;    // 1-16, 0 = any channel
+        int note = 60;      // 0-127
+        std::string cue_id;
+        bool stop = false;  // Note stops the cue instead of starting it
+    };
+
+    // MIDI Show Control GO / STOP for one cue number ("12", "12.5")
+    struct MscCueTrigger {
+        std::string cue_number;
+        std::string cue_id;
+    };
+
+    struct MidiTriggerMap {
+        std::vector<MidiNoteTrigger> notes;
+        std::vector<MscCueTrigger> msc_cues;
+        int msc_device_id = 0x7F; // 0-126, 127 = respond to every device id
+        int msc_command_format = 0; // 0 = any sound format (0x10-0x1F), else only this one; all-types (0x7F) always
+    };
+
+    struct MidiTriggerStats {
+        uint64_t messages_received = 0;
+        uint64_t commands_dispatched = 0;
+        uint64_t messages_unmatched = 0; // Note or cue number with no mapping
+        uint64_t commands_dropped = 0;   // Command queue full
+    };
+
+    // MIDI input for show triggers. GO/STOP from MIDI Show Control
+    // (F0 7F <device> 02 <format> <command> <cue> ... F7) and note-on
+    // messages are looked up in tables compiled by set_mappings(): a
+    // 16 x 128 grid for notes, a sorted cue number list for MSC.
+    //
+    // Events keep their driver timestamps. Each command is stamped with the
+    // engine sample at event time + latency (never less than
+    // kMinSchedulingLatencyMs, the MIDI thread's delivery slack) and takes
+    // effect on that sample, so the spacing between events survives MIDI
+    // thread and buffer jitter.
+    class MidiTriggerInput {
+    public:
+        static constexpr double kMinSchedulingLatencyMs = 2.0;
+
+        explicit MidiTriggerInput(SharedAudioCore* core);
+        ~MidiTriggerInput();
+
+        MidiTriggerInput(const MidiTriggerInput&) = delete;
+        MidiTriggerInput& operator=(const MidiTriggerInput&) = delete;
+
+        static std::vector<std::string> get_available_devices();
+
+        // First device whose name contains device_name
+        bool open(const std::string& device_name);
+        // Virtual input other applications can send to (ALSA seq, CoreMIDI).
+        // Not available on Windows.
+        bool open_virtual(const std::string& port_name);
+        void close();
+        bool is_open() const;
+        std::string get_device_name() const;
+
+        void set_mappings(const MidiTriggerMap& mappings); // Any thread
+        void set_latency_ms(double latency_ms);
+
+        // Entry point for the driver callback, also usable for scripted input
+        void handle_message(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point event_time);
+
+        MidiTriggerStats get_stats() const;
+        std::string get_last_error() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include "core/lock_free_fifo.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SharedAudio {
+
+    struct OscServerStats {
+        uint64_t packets_received = 0;
+        uint64_t messages_dispatched = 0;
+        uint64_t messages_unmatched = 0;  // No cue at that address
+        uint64_t packets_malformed = 0;   // Includes bundles beyond the schedule horizon
+        uint64_t commands_dropped = 0;    // Command queue full
+        uint64_t bundles_scheduled = 0;   // Bundles with a future timetag
+    };
+
+    // OSC over UDP straight into the engine's command queue, so console and
+    // Stream Deck traffic never goes through Node. Address space, with the
+    // engine's cue ids as handles:
+    //
+    //   /cue/<id>/start   [value]   a value of 0 is ignored (button release)
+    //   /cue/<id>/stop    [value]
+    //   /cue/<id>/volume  f         linear gain
+    //   /cue/<id>/pan     f         -1 (left) .. 1 (right)
+    //   /cue/<id>/seek    f         seconds
+    //
+    // Numeric arguments may be sent as f, d, i, h, T or F. Addresses are
+    // compiled into a hashed table by set_cues(); the listener parses each
+    // packet in place and allocates nothing. Messages in a bundle whose
+    // timetag lies ahead are stamped with the engine sample it maps to and
+    // take effect on that sample, inside the block containing it. Bundles
+    // timed further ahead than the schedule horizon are dropped, so a bad
+    // clock can't fill the engine's scheduled command slots.
+    class OscServer {
+    public:
+        static constexpr size_t kMaxPacketBytes = 65536;
+        static constexpr int kMaxBundleDepth = 8;
+        static constexpr double kDefaultScheduleHorizonSeconds = 4.0;
+
+        explicit OscServer(SharedAudioCore* core);
+        ~OscServer();
+
+        OscServer(const OscServer&) = delete;
+        OscServer& operator=(const OscServer&) = delete;
+
+        // Port 0 picks a free port, see get_port()
+        bool start(int port, const std::string& bind_address = "0.0.0.0");
+        void stop();
+        bool is_running() const { return running_.load(std::memory_order_acquire); }
+        int get_port() const { return port_; }
+
+        // Rebuilds the address table (any thread; swapped in between packets)
+        void set_cues(const std::vector<std::string>& cue_ids);
+
+        // Furthest ahead a bundle timetag may lie (any thread)
+        void set_schedule_horizon(double seconds);
+        double get_schedule_horizon() const { return schedule_horizon_seconds_.load(std::memory_order_relaxed); }
+
+        OscServerStats get_stats() const;
+        std::string get_last_error() const { return last_error_; }
+
+    private:
+        struct DispatchEntry {
+            uint64_t hash = 0;
+            std::string address;       // Empty: free slot
+            AudioThreadMessage::Type type = AudioThreadMessage::NONE;
+            std::string cue_id;
+        };
+
+        void listen_loop();
+        void handle_packet(const char* data, size_t size, int64_t timestamp_samples, int depth);
+        void handle_message(const char* data, size_t size, int64_t timestamp_samples);
+        bool timetag_to_sample(uint64_t timetag, int64_t& sample) const;
+        const DispatchEntry* find_entry(const char* address, size_t length) const;
+        void close_socket();
+
+        SharedAudioCore* core_;
+
+        // Listener thread only
+        std::array<char, kMaxPacketBytes> packet_{};
+
+        std::vector<DispatchEntry> table_; // Power-of-two size, open addressing
+        mutable std::mutex table_mutex_;
+
+        intptr_t socket_ = -1;
+        int port_ = 0;
+        std::thread listener_;
+        std::atomic<bool> running_{ false };
+        std::string last_error_;
+        std::atomic<double> schedule_horizon_seconds_{ kDefaultScheduleHorizonSeconds };
+
+        std::atomic<uint64_t> packets_received_{ 0 };
+        std::atomic<uint64_t> messages_dispatched_{ 0 };
+        std::atomic<uint64_t> messages_unmatched_{ 0 };
+        std::atomic<uint64_t> packets_malformed_{ 0 };
+        std::atomic<uint64_t> commands_dropped_{ 0 };
+        std::atomic<uint64_t> bundles_scheduled_{ 0 };
+    };
+
+} // namespace SharedAudio
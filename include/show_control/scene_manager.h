@@ -0,0 +1,101 @@
+#pragma once
+
+#include "shared_audio/shared_audio_core.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SharedAudio {
+
+    class CueAudioManager;
+    class MixGraph;
+    class InputRouter;
+
+    // Ramp times are in seconds; a negative ramp uses the time given to recall()
+
+    struct VoiceSnapshot {
+        std::string cue_id;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        float trim_gain = 1.0f;
+        float ramp_seconds = -1.0f;
+        int voice_index = -1; // Set by capture, used while SceneSnapshot::voice_layout is current
+    };
+
+    struct BusSnapshot {
+        float gain = 1.0f;
+        bool muted = false;
+        float ramp_seconds = -1.0f;
+    };
+
+    struct InputSnapshot {
+        float gain = 1.0f;
+        float pan = 0.0f;
+        bool muted = false;
+        float ramp_seconds = -1.0f;
+    };
+
+    struct OutputSnapshot {
+        float gain = 1.0f;
+        float ramp_seconds = -1.0f;
+    };
+
+    // Levels of every voice, bus, input and output at one moment. Treated as
+    // immutable once handed to recall(); edit a copy instead.
+    struct SceneSnapshot {
+        std::string name;
+        std::vector<VoiceSnapshot> voices;
+        std::vector<BusSnapshot> buses;     // Indexed by bus
+        std::vector<InputSnapshot> inputs;  // Indexed by input channel
+        std::vector<OutputSnapshot> outputs; // Indexed by output channel
+        uint64_t voice_layout = 0;          // Cue set the voice indices refer to, 0: none
+
+        size_t get_num_parameters() const {
+            return voices.size() * 3 + buses.size() * 2 + inputs.size() * 3 + outputs.size();
+        }
+    };
+
+    struct SceneInfo {
+        std::string name;
+        size_t num_parameters;
+    };
+
+    // Scene store and recall. recall() publishes the whole snapshot with one
+    // pointer exchange, whatever its size; the audio thread picks it up at
+    // the start of the next block and sets every parameter in that block, so
+    // a scene never lands across several callbacks. Parameters with a ramp
+    // move there linearly, advanced once per block and de-zippered inside
+    // the block by the strips themselves (voices ramp per sample). Voices are
+    // found by the index capture() recorded, or by id if the cue set has
+    // changed since.
+    class SceneManager {
+    public:
+        SceneManager();
+        ~SceneManager();
+
+        // Non-realtime thread
+        bool initialize(int sample_rate, CueAudioManager* cue_manager, MixGraph* mix_graph, InputRouter* input_router);
+
+        std::shared_ptr<SceneSnapshot> capture() const;
+        bool capture_scene(const std::string& name);
+        bool store_scene(const std::string& name, std::shared_ptr<const SceneSnapshot> scene);
+        bool remove_scene(const std::string& name);
+        std::shared_ptr<const SceneSnapshot> get_scene(const std::string& name) const;
+        std::vector<SceneInfo> get_scenes() const;
+
+        bool recall(std::shared_ptr<const SceneSnapshot> scene, double ramp_seconds = 0.0);
+        bool recall_scene(const std::string& name, double ramp_seconds = 0.0);
+        uint64_t get_recall_count() const;   // Recalls the audio thread has applied
+        uint64_t get_retire_overflow_count() const; // Recalls leaked because the retire queue was full
+        bool is_ramping() const;
+
+        // Called from audio thread, before anything reads the parameters this block
+        void process(int num_samples);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+} // namespace SharedAudio
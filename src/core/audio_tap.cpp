@@ -0,0 +1,97 @@
+﻿#include "core/audio_tap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SharedAudio {
+
+    void AudioTap::prepare(int first_channel, int num_channels, int capacity_frames) {
+        uint64_t size = 1;
+        while (size < static_cast<uint64_t>(std::max(capacity_frames, 1))) {
+            size <<= 1;
+        }
+
+        first_channel_ = std::max(0, first_channel);
+        num_channels_ = std::max(0, num_channels);
+        mask_ = size - 1;
+        channels_.assign(num_channels_, std::vector<float>(size, 0.0f));
+        write_pos_.store(0, std::memory_order_relaxed);
+        read_pos_.store(0, std::memory_order_relaxed);
+        dropped_frames_.store(0, std::memory_order_relaxed);
+        high_water_frames_.store(0, std::memory_order_relaxed);
+    }
+
+    bool AudioTap::write(const AudioBuffer& buffer, int num_samples) {
+        if (channels_.empty() || num_samples <= 0) {
+            return true;
+        }
+
+        const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+        const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+        const uint64_t capacity = mask_ + 1;
+        const uint64_t fill = write_pos - read_pos + static_cast<uint64_t>(num_samples);
+        if (fill > capacity) {
+            dropped_frames_.fetch_add(static_cast<uint64_t>(num_samples), std::memory_order_relaxed);
+            high_water_frames_.store(static_cast<int>(capacity), std::memory_order_relaxed);
+            return false;
+        }
+        if (static_cast<int>(fill) > high_water_frames_.load(std::memory_order_relaxed)) {
+            high_water_frames_.store(static_cast<int>(fill), std::memory_order_relaxed); // single producer
+        }
+
+        const uint64_t start = write_pos & mask_;
+        const int first_part = static_cast<int>(std::min<uint64_t>(num_samples, capacity - start));
+        for (int ch = 0; ch < num_channels_; ++ch) {
+            float* ring = channels_[ch].data();
+            const int source_channel = first_channel_ + ch;
+            if (source_channel >= static_cast<int>(buffer.size())) {
+                // Missing device channel - keep the frame count aligned with silence
+                std::fill(ring + start, ring + start + first_part, 0.0f);
+                std::fill(ring, ring + (num_samples - first_part), 0.0f);
+                continue;
+            }
+
+            const float* src = buffer[source_channel].data();
+            std::memcpy(ring + start, src, first_part * sizeof(float));
+            if (first_part < num_samples) {
+                std::memcpy(ring, src + first_part, (num_samples - first_part) * sizeof(float));
+            }
+        }
+
+        write_pos_.store(write_pos + num_samples, std::memory_order_release);
+        return true;
+    }
+
+    int AudioTap::get_free_frames() const {
+        const uint64_t used = write_pos_.load(std::memory_order_relaxed) - read_pos_.load(std::memory_order_acquire);
+        return static_cast<int>((mask_ + 1) - used);
+    }
+
+    int AudioTap::read(float* const* dest, int max_frames) {
+        const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+        const uint64_t write_pos = write_pos_.load(std::memory_order_acquire);
+        const int frames = static_cast<int>(std::min<uint64_t>(write_pos - read_pos, std::max(max_frames, 0)));
+        if (frames == 0) {
+            return 0;
+        }
+
+        const uint64_t capacity = mask_ + 1;
+        const uint64_t start = read_pos & mask_;
+        const int first_part = static_cast<int>(std::min<uint64_t>(frames, capacity - start));
+        for (int ch = 0; ch < num_channels_; ++ch) {
+            const float* ring = channels_[ch].data();
+            std::memcpy(dest[ch], ring + start, first_part * sizeof(float));
+            if (first_part < frames) {
+                std::memcpy(dest[ch] + first_part, ring, (frames - first_part) * sizeof(float));
+            }
+        }
+
+        read_pos_.store(read_pos + frames, std::memory_order_release);
+        return frames;
+    }
+
+    int AudioTap::get_num_available() const {
+        return static_cast<int>(write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_relaxed));
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,53 @@
+﻿#include "core/block_boundary.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+namespace SharedAudio {
+
+    bool BlockBoundary::wait(std::chrono::milliseconds timeout) {
+        collect();
+
+        const uint64_t block = blocks_processed_.load();
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!has_passed(block)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                std::cout << "[AUDIO] Audio thread still inside block " << block
+                    << " after " << timeout.count() << " ms" << std::endl;
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void BlockBoundary::retire(std::shared_ptr<void> garbage) {
+        if (garbage) {
+            const uint64_t block = blocks_processed_.load();
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            retired_.emplace_back(block, std::move(garbage));
+        }
+        collect();
+    }
+
+    void BlockBoundary::collect() {
+        std::vector<std::shared_ptr<void>> released;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            auto done = std::stable_partition(retired_.begin(), retired_.end(),
+                [this](const auto& entry) { return !has_passed(entry.first); });
+            for (auto it = done; it != retired_.end(); ++it) {
+                released.push_back(std::move(it->second));
+            }
+            retired_.erase(done, retired_.end());
+        }
+        // Destructors run outside the lock
+    }
+
+    size_t BlockBoundary::get_num_retired() const {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        return retired_.size();
+    }
+
+} // namespace SharedAudio
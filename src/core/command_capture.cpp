@@ -0,0 +1,406 @@
+﻿#include "core/command_capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace SharedAudio {
+
+    namespace {
+
+        // File layout (little-endian, strings u16-length-prefixed):
+        //   "SACMDCAP" u32 version, u32 sample rate, u32 inputs, u32 outputs,
+        //   u64 base sample,
+        //   u32 asset count, per asset: cue id, file path
+        //   u32 bus count, per bus: name, u32 channels, i32 first output,
+        //     f32 gain, u8 muted
+        //   u32 input count, per input: f32 gain, f32 pan, u8 muted
+        //   u32 output count, per output: f32 gain
+        //   u32 voice count, per voice: cue id, u8 state, u8 looping,
+        //     i32 bus, u64 position, f32 volume, f32 pan, f32 trim
+        //   then records, times relative to the base sample:
+        //     u8 kind, u64 sample time and
+        //     BLOCK:   u32 num samples, u64 checksum
+        //     COMMAND: u8 type, u8 id length, id bytes, u64 param1, u32 param2,
+        //              i64 timestamp (-1: none)
+        constexpr char kMagic[8] = { 'S', 'A', 'C', 'M', 'D', 'C', 'A', 'P' };
+        constexpr uint32_t kVersion = 2;
+
+        template<typename T>
+        void write_value(std::ofstream& file, T value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        template<typename T>
+        bool read_value(std::ifstream& file, T& value) {
+            return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+        }
+
+        void write_string(std::ofstream& file, const std::string& text) {
+            const uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), 0xFFFF));
+            write_value(file, length);
+            file.write(text.data(), length);
+        }
+
+        bool read_string(std::ifstream& file, std::string& text) {
+            uint16_t length = 0;
+            if (!read_value(file, length)) {
+                return false;
+            }
+            text.resize(length);
+            return length == 0 || static_cast<bool>(file.read(&text[0], length));
+        }
+
+        void write_record(std::ofstream& file, const CaptureRecord& record) {
+            write_value(file, static_cast<uint8_t>(record.kind));
+            write_value(file, record.sample_time);
+            if (record.kind == CaptureRecord::BLOCK) {
+                write_value(file, static_cast<uint32_t>(record.num_samples));
+                write_value(file, record.checksum);
+                return;
+            }
+
+            const AudioThreadMessage& msg = record.message;
+            const uint8_t id_length = static_cast<uint8_t>(strnlen(msg.cue_id, sizeof(msg.cue_id) - 1));
+            uint64_t param1 = 0;
+            uint32_t param2 = 0;
+            std::memcpy(&param1, &msg.param1, std::min(sizeof(param1), sizeof(msg.param1)));
+            std::memcpy(&param2, &msg.param2, std::min(sizeof(param2), sizeof(msg.param2)));
+            write_value(file, static_cast<uint8_t>(msg.type));
+            write_value(file, id_length);
+            file.write(msg.cue_id, id_length);
+            write_value(file, param1);
+            write_value(file, param2);
+            write_value(file, static_cast<int64_t>(msg.timestamp_samples));
+        }
+
+        void write_header(std::ofstream& file, const CaptureHeader& header) {
+            file.write(kMagic, sizeof(kMagic));
+            write_value(file, kVersion);
+            write_value(file, static_cast<uint32_t>(header.sample_rate));
+            write_value(file, static_cast<uint32_t>(header.num_inputs));
+            write_value(file, static_cast<uint32_t>(header.num_outputs));
+            write_value(file, header.base_sample);
+
+            write_value(file, static_cast<uint32_t>(header.assets.size()));
+            for (const auto& asset : header.assets) {
+                write_string(file, asset.cue_id);
+                write_string(file, asset.file_path);
+            }
+
+            write_value(file, static_cast<uint32_t>(header.buses.size()));
+            for (size_t i = 0; i < header.buses.size(); ++i) {
+                const CaptureBus& bus = header.buses[i];
+                const BusSnapshot level = i < header.levels.buses.size() ? header.levels.buses[i] : BusSnapshot();
+                write_string(file, bus.name);
+                write_value(file, static_cast<uint32_t>(bus.num_channels));
+                write_value(file, static_cast<int32_t>(bus.first_output_channel));
+                write_value(file, level.gain);
+                write_value(file, static_cast<uint8_t>(level.muted));
+            }
+
+            write_value(file, static_cast<uint32_t>(header.levels.inputs.size()));
+            for (const auto& input : header.levels.inputs) {
+                write_value(file, input.gain);
+                write_value(file, input.pan);
+                write_value(file, static_cast<uint8_t>(input.muted));
+            }
+
+            write_value(file, static_cast<uint32_t>(header.levels.outputs.size()));
+            for (const auto& output : header.levels.outputs) {
+                write_value(file, output.gain);
+            }
+
+            write_value(file, static_cast<uint32_t>(header.voices.size()));
+            for (const auto& voice : header.voices) {
+                write_string(file, std::string(voice.cue_id, strnlen(voice.cue_id, sizeof(voice.cue_id))));
+                write_value(file, static_cast<uint8_t>(voice.state));
+                write_value(file, static_cast<uint8_t>(voice.is_looping));
+                write_value(file, static_cast<int32_t>(voice.bus_index));
+                write_value(file, voice.position_frames);
+                write_value(file, voice.volume);
+                write_value(file, voice.pan);
+                write_value(file, voice.trim_gain);
+            }
+        }
+
+        bool read_header(std::ifstream& file, CaptureHeader& header) {
+            char magic[sizeof(kMagic)];
+            uint32_t version = 0;
+            uint32_t sample_rate = 0;
+            uint32_t num_inputs = 0;
+            uint32_t num_outputs = 0;
+            if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0
+                || !read_value(file, version) || version != kVersion
+                || !read_value(file, sample_rate) || !read_value(file, num_inputs)
+                || !read_value(file, num_outputs) || !read_value(file, header.base_sample)) {
+                return false;
+            }
+            header.sample_rate = static_cast<int>(sample_rate);
+            header.num_inputs = static_cast<int>(num_inputs);
+            header.num_outputs = static_cast<int>(num_outputs);
+
+            uint32_t count = 0;
+            if (!read_value(file, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                CaptureAsset asset;
+                if (!read_string(file, asset.cue_id) || !read_string(file, asset.file_path)) return false;
+                header.assets.push_back(std::move(asset));
+            }
+
+            if (!read_value(file, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                CaptureBus bus;
+                BusSnapshot level;
+                uint32_t num_channels = 0;
+                int32_t first_output = 0;
+                uint8_t muted = 0;
+                if (!read_string(file, bus.name) || !read_value(file, num_channels) || !read_value(file, first_output)
+                    || !read_value(file, level.gain) || !read_value(file, muted)) return false;
+                bus.num_channels = static_cast<int>(num_channels);
+                bus.first_output_channel = first_output;
+                level.muted = muted != 0;
+                level.ramp_seconds = 0.0f;
+                header.buses.push_back(std::move(bus));
+                header.levels.buses.push_back(level);
+            }
+
+            if (!read_value(file, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                InputSnapshot input;
+                uint8_t muted = 0;
+                if (!read_value(file, input.gain) || !read_value(file, input.pan) || !read_value(file, muted)) return false;
+                input.muted = muted != 0;
+                input.ramp_seconds = 0.0f;
+                header.levels.inputs.push_back(input);
+            }
+
+            if (!read_value(file, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                OutputSnapshot output;
+                if (!read_value(file, output.gain)) return false;
+                output.ramp_seconds = 0.0f;
+                header.levels.outputs.push_back(output);
+            }
+
+            if (!read_value(file, count)) return false;
+            for (uint32_t i = 0; i < count; ++i) {
+                VoicePlaybackState voice;
+                std::string cue_id;
+                uint8_t state = 0;
+                uint8_t looping = 0;
+                int32_t bus = 0;
+                if (!read_string(file, cue_id) || !read_value(file, state) || !read_value(file, looping)
+                    || !read_value(file, bus) || !read_value(file, voice.position_frames)
+                    || !read_value(file, voice.volume) || !read_value(file, voice.pan)
+                    || !read_value(file, voice.trim_gain)) return false;
+                std::strncpy(voice.cue_id, cue_id.c_str(), sizeof(voice.cue_id) - 1);
+                voice.state = static_cast<CueState>(state);
+                voice.is_looping = looping != 0;
+                voice.bus_index = bus;
+                header.voices.push_back(voice);
+            }
+            return true;
+        }
+
+    } // namespace
+
+    uint64_t checksum_block(const AudioBuffer& outputs, int num_samples) {
+        uint64_t hash = 1469598103934665603ull;
+        for (const auto& channel : outputs) {
+            const int count = std::min(num_samples, static_cast<int>(channel.size()));
+            for (int i = 0; i < count; ++i) {
+                uint32_t bits;
+                std::memcpy(&bits, &channel[i], sizeof(bits));
+                hash = (hash ^ bits) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    // CommandCapture implementation
+    CommandCapture::~CommandCapture() {
+        stop();
+    }
+
+    bool CommandCapture::start(const std::string& path, const CaptureHeader& header) {
+        if (is_capturing()) {
+            return false;
+        }
+
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            std::cout << "[CAPTURE] Cannot create " << path << std::endl;
+            return false;
+        }
+
+        // Anything left over from an earlier capture that stopped mid-block
+        CaptureRecord stale;
+        while (ring_.pop(stale)) {
+        }
+
+        header_ = header;
+        header_.base_sample = 0;
+        header_.voices.clear();
+        header_.voices.reserve(kMaxSnapshotVoices); // The audio thread fills it without allocating
+
+        dropped_records_.store(0, std::memory_order_relaxed);
+        snapshot_ready_.store(false, std::memory_order_relaxed);
+        stop_requested_ = false;
+        writer_ = std::thread([this] { writer_loop(); });
+        capturing_.store(true, std::memory_order_release);
+
+        std::cout << "[CAPTURE] Recording commands to " << path << std::endl;
+        return true;
+    }
+
+    void CommandCapture::stop() {
+        if (!writer_.joinable()) {
+            return;
+        }
+
+        capturing_.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stop_requested_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+        file_.close();
+
+        const uint64_t dropped = get_dropped_records();
+        if (dropped > 0) {
+            std::cout << "[CAPTURE] " << dropped << " records dropped, replay will not be exact" << std::endl;
+        }
+    }
+
+    std::vector<VoicePlaybackState>* CommandCapture::pending_snapshot() {
+        if (!capturing_.load(std::memory_order_acquire) || snapshot_ready_.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return &header_.voices;
+    }
+
+    void CommandCapture::commit_snapshot(uint64_t base_sample) {
+        header_.base_sample = base_sample;
+        snapshot_ready_.store(true, std::memory_order_release);
+    }
+
+    void CommandCapture::record_command(uint64_t sample_time, const AudioThreadMessage& msg) {
+        if (!is_recording()) {
+            return;
+        }
+
+        CaptureRecord record;
+        record.kind = CaptureRecord::COMMAND;
+        record.sample_time = sample_time;
+        record.message = msg;
+        push(record);
+    }
+
+    void CommandCapture::record_block(uint64_t sample_time, int num_samples, const AudioBuffer& outputs) {
+        if (!is_recording()) {
+            return;
+        }
+
+        CaptureRecord record;
+        record.kind = CaptureRecord::BLOCK;
+        record.sample_time = sample_time;
+        record.num_samples = num_samples;
+        record.checksum = checksum_block(outputs, num_samples);
+        push(record);
+    }
+
+    void CommandCapture::push(const CaptureRecord& record) {
+        if (!ring_.push(record)) {
+            dropped_records_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The audio thread never signals; the writer polls at a rate that keeps
+    // the ring well below capacity at any block size
+    void CommandCapture::writer_loop() {
+        bool header_written = false;
+        CaptureRecord record;
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_.wait_for(lock, std::chrono::milliseconds(20), [this] { return stop_requested_; });
+                stopping = stop_requested_;
+            }
+
+            // Stopped before the audio thread ran a block: an empty capture
+            const bool ready = snapshot_ready_.load(std::memory_order_acquire);
+            if (!header_written && (ready || stopping)) {
+                write_header(file_, header_);
+                header_written = true;
+            }
+
+            if (header_written) {
+                while (ring_.pop(record)) {
+                    record.sample_time -= header_.base_sample;
+                    if (record.kind == CaptureRecord::COMMAND && record.message.timestamp_samples >= 0) {
+                        record.message.timestamp_samples -= static_cast<int64_t>(header_.base_sample);
+                    }
+                    write_record(file_, record);
+                }
+                file_.flush();
+            }
+
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    // CaptureReader implementation
+    bool CaptureReader::open(const std::string& path) {
+        file_.open(path, std::ios::binary);
+        if (!file_) {
+            return false;
+        }
+        header_ = CaptureHeader{};
+        return read_header(file_, header_);
+    }
+
+    bool CaptureReader::next(CaptureRecord& record) {
+        uint8_t kind = 0;
+        if (!read_value(file_, kind) || !read_value(file_, record.sample_time)) {
+            return false;
+        }
+
+        if (kind == CaptureRecord::BLOCK) {
+            uint32_t num_samples = 0;
+            record.kind = CaptureRecord::BLOCK;
+            if (!read_value(file_, num_samples) || !read_value(file_, record.checksum)) {
+                return false;
+            }
+            record.num_samples = static_cast<int>(num_samples);
+            return true;
+        }
+        if (kind != CaptureRecord::COMMAND) {
+            return false;
+        }
+
+        uint8_t type = 0;
+        uint8_t id_length = 0;
+        uint64_t param1 = 0;
+        uint32_t param2 = 0;
+        record.kind = CaptureRecord::COMMAND;
+        record.message = AudioThreadMessage{};
+        if (!read_value(file_, type) || !read_value(file_, id_length)
+            || id_length >= sizeof(record.message.cue_id)
+            || !file_.read(record.message.cue_id, id_length)
+            || !read_value(file_, param1) || !read_value(file_, param2)
+            || !read_value(file_, record.message.timestamp_samples)) {
+            return false;
+        }
+        record.message.type = static_cast<AudioThreadMessage::Type>(type);
+        std::memcpy(&record.message.param1, &param1, std::min(sizeof(param1), sizeof(record.message.param1)));
+        std::memcpy(&record.message.param2, &param2, std::min(sizeof(param2), sizeof(record.message.param2)));
+        return true;
+    }
+
+} // namespace SharedAudio
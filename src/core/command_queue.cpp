@@ -0,0 +1,204 @@
+﻿#include "core/command_queue.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace SharedAudio {
+
+    AudioCommandQueue::AudioCommandQueue() = default;
+
+    bool AudioCommandQueue::is_critical(AudioThreadMessage::Type type) {
+        switch (type) {
+        case AudioThreadMessage::START_CUE:
+        case AudioThreadMessage::STOP_CUE:
+        case AudioThreadMessage::CROSSFADE:
+        case AudioThreadMessage::LOAD_BUFFER:
+        case AudioThreadMessage::SEEK:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool AudioCommandQueue::is_coalescable(AudioThreadMessage::Type type) {
+        return type == AudioThreadMessage::SET_VOLUME || type == AudioThreadMessage::SET_PAN;
+    }
+
+    bool AudioCommandQueue::push(const AudioThreadMessage& msg) {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+
+        if (is_critical(msg.type)) {
+            QueuedCommand command{ msg, next_sequence_++ };
+            if (!critical_.push(command)) {
+                critical_dropped_.fetch_add(1, std::memory_order_relaxed);
+                std::cout << "[AUDIO] Critical command lane full, command for '" << msg.cue_id
+                    << "' dropped" << std::endl;
+                return false;
+            }
+            note_transport(msg, hash_cue_id(msg.cue_id));
+            note_fill(critical_high_water_, critical_.size());
+            return true;
+        }
+
+        // A slot holds one value, it cannot keep several timestamps apart
+        if (is_coalescable(msg.type) && msg.timestamp_samples < 0) {
+            return push_coalesced(msg);
+        }
+        return push_normal(msg);
+    }
+
+    bool AudioCommandQueue::push_normal(const AudioThreadMessage& msg) {
+        QueuedCommand command{ msg, next_sequence_++ };
+        if (!normal_.push(command)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        note_fill(high_water_, normal_.size());
+        return true;
+    }
+
+    bool AudioCommandQueue::push_coalesced(const AudioThreadMessage& msg) {
+        const uint64_t cue_hash = hash_cue_id(msg.cue_id);
+        const int index = find_slot(msg, cue_hash);
+        if (index < 0) {
+            return push_normal(msg); // Every slot is in flight: fall back to an uncoalesced message
+        }
+
+        SlotKey& key = slot_keys_[index];
+        const bool in_flight = (slots_[index].load() & kQueuedFlag) != 0;
+        if (in_flight && key.queued_sequence < key.barrier_sequence) {
+            // The queued message sits ahead of a later transport command for
+            // this cue; folding this value into it would reorder the two
+            return push_normal(msg);
+        }
+
+        uint32_t bits;
+        std::memcpy(&bits, &msg.param1.float_value, sizeof(bits));
+        if (slots_[index].exchange(kQueuedFlag | bits) & kQueuedFlag) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed); // In-flight message picks this up
+            return true;
+        }
+
+        QueuedCommand command{ msg, next_sequence_++ };
+        command.msg.coalesce_slot = index;
+        if (!normal_.push(command)) {
+            slots_[index].store(bits); // Nothing in flight, release the slot
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        key.queued_sequence = command.sequence;
+        note_fill(high_water_, normal_.size());
+        return true;
+    }
+
+    // Producer side, under producer_mutex_. Slots are matched on the id hash
+    // first and confirmed with memcmp, nothing is allocated.
+    int AudioCommandQueue::find_slot(const AudioThreadMessage& msg, uint64_t cue_hash) {
+        int free_index = -1;
+        for (int i = 0; i < kNumCoalesceSlots; ++i) {
+            const SlotKey& key = slot_keys_[i];
+            if (key.used && key.type == msg.type && same_cue(key, msg, cue_hash)) {
+                return i;
+            }
+            if (free_index < 0 && (!key.used || !(slots_[i].load() & kQueuedFlag))) {
+                free_index = i;
+            }
+        }
+        if (free_index < 0) {
+            return -1;
+        }
+
+        // Take an unused slot, or recycle one with nothing in flight
+        SlotKey& key = slot_keys_[free_index];
+        key.used = true;
+        key.type = msg.type;
+        key.cue_hash = cue_hash;
+        std::memcpy(key.cue_id, msg.cue_id, sizeof(key.cue_id));
+        key.queued_sequence = 0;
+        key.barrier_sequence = 0;
+        return free_index;
+    }
+
+    // Producer side: parameter messages already queued for this cue must not
+    // take values pushed from now on
+    void AudioCommandQueue::note_transport(const AudioThreadMessage& msg, uint64_t cue_hash) {
+        for (SlotKey& key : slot_keys_) {
+            if (key.used && same_cue(key, msg, cue_hash)) {
+                key.barrier_sequence = next_sequence_;
+            }
+        }
+    }
+
+    uint64_t AudioCommandQueue::hash_cue_id(const char* cue_id) {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (size_t i = 0; i < sizeof(AudioThreadMessage::cue_id) && cue_id[i] != '\0'; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(cue_id[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool AudioCommandQueue::same_cue(const SlotKey& key, const AudioThreadMessage& msg, uint64_t cue_hash) {
+        return key.cue_hash == cue_hash
+            && std::memcmp(key.cue_id, msg.cue_id, sizeof(key.cue_id)) == 0;
+    }
+
+    bool AudioCommandQueue::pop(AudioThreadMessage& msg) {
+        // Normal lane first: pushes are serialised, so once a normal command
+        // is visible every critical command sequenced before it is too. The
+        // other order could miss a critical push that lands in between and
+        // let the normal command overtake it.
+        if (!has_normal_head_) {
+            has_normal_head_ = normal_.pop(normal_head_);
+        }
+        if (!has_critical_head_) {
+            has_critical_head_ = critical_.pop(critical_head_);
+        }
+        if (!has_critical_head_ && !has_normal_head_) {
+            return false;
+        }
+
+        // Oldest push first; sequences are unique across both lanes
+        const bool take_critical = has_critical_head_
+            && (!has_normal_head_ || critical_head_.sequence < normal_head_.sequence);
+        if (take_critical) {
+            msg = critical_head_.msg;
+            has_critical_head_ = false;
+        }
+        else {
+            msg = normal_head_.msg;
+            has_normal_head_ = false;
+        }
+
+        if (msg.coalesce_slot >= 0 && msg.coalesce_slot < kNumCoalesceSlots) {
+            const uint32_t bits = static_cast<uint32_t>(slots_[msg.coalesce_slot].exchange(0));
+            std::memcpy(&msg.param1.float_value, &bits, sizeof(bits));
+            msg.coalesce_slot = -1;
+        }
+        return true;
+    }
+
+    void AudioCommandQueue::note_fill(std::atomic<int>& high_water, size_t fill) {
+        const int level = static_cast<int>(fill);
+        if (level > high_water.load(std::memory_order_relaxed)) {
+            high_water.store(level, std::memory_order_relaxed); // producers are serialised
+        }
+    }
+
+    CommandQueueStats AudioCommandQueue::get_stats() const {
+        CommandQueueStats stats;
+        stats.pushed = pushed_.load(std::memory_order_relaxed);
+        stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.critical_dropped = critical_dropped_.load(std::memory_order_relaxed);
+        stats.high_water = high_water_.load(std::memory_order_relaxed);
+        stats.critical_high_water = critical_high_water_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void AudioCommandQueue::reset_high_water() {
+        high_water_.store(0, std::memory_order_relaxed);
+        critical_high_water_.store(0, std::memory_order_relaxed);
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,121 @@
+﻿#include "core/loader_thread_pool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace SharedAudio {
+
+    LoaderThreadPool::LoaderThreadPool() = default;
+
+    LoaderThreadPool::~LoaderThreadPool() {
+        stop();
+    }
+
+    bool LoaderThreadPool::start(int num_threads) {
+        stop();
+
+        if (num_threads <= 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = true;
+        }
+
+        for (int i = 0; i < num_threads; ++i) {
+            threads_.emplace_back(&LoaderThreadPool::thread_loop, this);
+        }
+
+        std::cout << "[LOADER] Started " << num_threads << " loader threads" << std::endl;
+        return true;
+    }
+
+    void LoaderThreadPool::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_ && threads_.empty()) {
+                return;
+            }
+            running_ = false;
+        }
+        cv_.notify_all();
+
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        threads_.clear();
+
+        // Tasks queued after stop() are dropped
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.clear();
+    }
+
+    void LoaderThreadPool::submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    void LoaderThreadPool::parallel_for(int count, const std::function<void(int)>& fn) {
+        if (count <= 0) {
+            return;
+        }
+
+        struct Batch {
+            std::atomic<int> next{ 0 };
+            std::atomic<int> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+        auto batch = std::make_shared<Batch>();
+        const int count_copy = count;
+
+        // Helpers and the caller pull indices from the same counter. A helper
+        // that starts after everything is claimed simply returns.
+        auto run = [batch, count_copy, &fn]() {
+            int index;
+            while ((index = batch->next.fetch_add(1)) < count_copy) {
+                fn(index);
+                if (batch->done.fetch_add(1) + 1 == count_copy) {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    batch->cv.notify_all();
+                }
+            }
+        };
+
+        const int helpers = std::min(count - 1, get_num_threads());
+        for (int i = 0; i < helpers; ++i) {
+            submit(run);
+        }
+        run();
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->cv.wait(lock, [&]() { return batch->done.load() == count_copy; });
+    }
+
+    void LoaderThreadPool::thread_loop() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return !running_ || !tasks_.empty(); });
+                if (!running_) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+} // namespace SharedAudio
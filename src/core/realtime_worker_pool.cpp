@@ -0,0 +1,213 @@
+﻿#include "core/realtime_worker_pool.h"
+
+#include <chrono>
+#include <iostream>
+
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+        // Idle workers spin this long after a batch before parking: long
+        // enough to catch the next block's jobs on a busy graph, short enough
+        // not to hog a core on a small machine
+        constexpr auto kSpinBeforePark = std::chrono::microseconds(200);
+    }
+
+    RealtimeWorkerPool::RealtimeWorkerPool() = default;
+
+    RealtimeWorkerPool::~RealtimeWorkerPool() {
+        stop();
+    }
+
+    bool RealtimeWorkerPool::start(int num_workers) {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        if (running_ || num_workers <= 0) {
+            return false;
+        }
+
+        running_ = true;
+        workers_.reserve(num_workers);
+        for (int i = 0; i < num_workers; ++i) {
+            workers_.emplace_back(&RealtimeWorkerPool::worker_loop, this);
+        }
+        num_active_workers_.store(num_workers, std::memory_order_release);
+
+        std::cout << "[WORKER] Started " << num_workers << " realtime worker thread(s)" << std::endl;
+        return true;
+    }
+
+    void RealtimeWorkerPool::stop() {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        if (!running_) {
+            return;
+        }
+
+        // Later batches run inline; one already dispatched is finished by
+        // the audio thread, whatever the workers leave unclaimed
+        num_active_workers_.store(0, std::memory_order_release);
+        running_ = false;
+        park_cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers_.clear();
+    }
+
+    void RealtimeWorkerPool::run_jobs(JobFunction job_fn, void* context, int num_jobs) {
+        dispatch_jobs(job_fn, context, num_jobs);
+        wait_for_jobs();
+    }
+
+    void RealtimeWorkerPool::dispatch_jobs(JobFunction job_fn, void* context, int num_jobs) {
+        dispatched_jobs_ = 0;
+        if (num_jobs <= 0) {
+            return;
+        }
+
+        if (num_active_workers_.load(std::memory_order_acquire) == 0) {
+            audio_priority_noted_ = false; // Looked up again for the next set of workers
+            for (int i = 0; i < num_jobs; ++i) {
+                job_fn(context, i);
+            }
+            return;
+        }
+        if (!audio_priority_noted_) {
+            note_audio_thread_priority();
+        }
+
+        jobs_done_.store(0, std::memory_order_relaxed);
+        job_fn_.store(job_fn, std::memory_order_relaxed);
+        job_context_.store(context, std::memory_order_relaxed);
+        num_jobs_.store(num_jobs, std::memory_order_relaxed);
+
+        const uint64_t generation = (ticket_.load(std::memory_order_relaxed) >> 32) + 1;
+        ticket_.store(generation << 32, std::memory_order_release);
+        dispatched_jobs_ = num_jobs;
+
+        // Only pay for the wake-up syscall when someone is actually parked
+        if (parked_workers_.load(std::memory_order_acquire) > 0) {
+            park_cv_.notify_all();
+        }
+    }
+
+    void RealtimeWorkerPool::wait_for_jobs() {
+        if (dispatched_jobs_ == 0) {
+            return;
+        }
+
+        while (run_next_job()) {
+        }
+
+        while (jobs_done_.load(std::memory_order_acquire) < dispatched_jobs_) {
+            std::this_thread::yield();
+        }
+        dispatched_jobs_ = 0;
+    }
+
+    bool RealtimeWorkerPool::run_next_job() {
+        uint64_t ticket = ticket_.load(std::memory_order_acquire);
+        for (;;) {
+            const int index = static_cast<int>(ticket & 0xffffffffu);
+            const JobFunction job_fn = job_fn_.load(std::memory_order_relaxed);
+            void* context = job_context_.load(std::memory_order_relaxed);
+
+            if (index >= num_jobs_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+
+            if (ticket_.compare_exchange_weak(ticket, ticket + 1,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+                job_fn(context, index);
+                jobs_done_.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    // Audio thread, once per worker set: a single non-blocking lookup of
+    // its own scheduling, which the workers then copy one step lower
+    void RealtimeWorkerPool::note_audio_thread_priority() {
+        audio_priority_noted_ = true;
+#ifdef PLATFORM_WINDOWS
+        audio_priority_.store(GetThreadPriority(GetCurrentThread()), std::memory_order_relaxed);
+#else
+        int policy = SCHED_OTHER;
+        sched_param param{};
+        if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) {
+            return;
+        }
+        audio_policy_.store(policy, std::memory_order_relaxed);
+        audio_priority_.store(param.sched_priority, std::memory_order_relaxed);
+#endif
+        audio_priority_generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Worker thread: strictly below the audio thread, never above it
+    void RealtimeWorkerPool::follow_audio_thread_priority(int& applied_generation) {
+        const int generation = audio_priority_generation_.load(std::memory_order_acquire);
+        if (generation == applied_generation) {
+            return;
+        }
+        applied_generation = generation;
+
+#ifdef PLATFORM_WINDOWS
+        const int audio_priority = audio_priority_.load(std::memory_order_relaxed);
+        int priority = THREAD_PRIORITY_NORMAL;
+        if (audio_priority == THREAD_PRIORITY_TIME_CRITICAL) {
+            priority = THREAD_PRIORITY_HIGHEST;
+        } else if (audio_priority > THREAD_PRIORITY_NORMAL) {
+            priority = audio_priority - 1;
+        }
+        SetThreadPriority(GetCurrentThread(), priority);
+#else
+        const int policy = audio_policy_.load(std::memory_order_relaxed);
+        const int audio_priority = audio_priority_.load(std::memory_order_relaxed);
+        if ((policy != SCHED_FIFO && policy != SCHED_RR) || audio_priority <= sched_get_priority_min(policy)) {
+            return; // Callback is not realtime (or already at the floor): workers stay normal
+        }
+        sched_param param{};
+        param.sched_priority = audio_priority - 1;
+        if (pthread_setschedparam(pthread_self(), policy, &param) != 0) {
+            // No rtprio limit for this user - workers still help, just without RT guarantees
+            std::cout << "[WORKER] Could not set realtime priority for worker thread" << std::endl;
+        }
+#endif
+    }
+
+    void RealtimeWorkerPool::worker_loop() {
+        int applied_generation = 0;
+        auto idle_since = std::chrono::steady_clock::now();
+
+        while (running_.load(std::memory_order_relaxed)) {
+            follow_audio_thread_priority(applied_generation);
+
+            if (run_next_job()) {
+                idle_since = std::chrono::steady_clock::now();
+                continue;
+            }
+
+            if (std::chrono::steady_clock::now() - idle_since < kSpinBeforePark) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Bounded wait: a missed notify only delays this worker by 1 ms,
+            // the audio thread finishes the batch on its own meanwhile
+            parked_workers_.fetch_add(1, std::memory_order_acq_rel);
+            {
+                std::unique_lock<std::mutex> lock(park_mutex_);
+                park_cv_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            parked_workers_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+} // namespace SharedAudio
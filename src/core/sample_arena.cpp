@@ -0,0 +1,317 @@
+﻿#include "core/sample_arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <tuple>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        size_t round_up(size_t value, size_t multiple) {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        // Maps a slab, preferring explicit huge pages, then transparent huge
+        // pages (Linux), then normal pages
+        uint8_t* map_slab(size_t& size, bool& huge_pages) {
+            huge_pages = false;
+#ifdef _WIN32
+            // Needs SeLockMemoryPrivilege, which most machines do not grant
+            const SIZE_T large_page = GetLargePageMinimum();
+            if (large_page > 0) {
+                const size_t large_size = round_up(size, large_page);
+                void* p = VirtualAlloc(nullptr, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                if (p != nullptr) {
+                    size = large_size;
+                    huge_pages = true;
+                    return static_cast<uint8_t*>(p);
+                }
+            }
+            return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+#if defined(__linux__) && defined(MAP_HUGETLB)
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                huge_pages = true;
+                return static_cast<uint8_t*>(p);
+            }
+#endif
+            // Over-map so the slab can start on a huge page boundary, which
+            // transparent huge pages need
+            const size_t mapped = size + SampleArena::kHugePageBytes;
+            void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) {
+                return nullptr;
+            }
+
+            uint8_t* start = static_cast<uint8_t*>(raw);
+            uint8_t* aligned = reinterpret_cast<uint8_t*>(round_up(reinterpret_cast<uintptr_t>(start), SampleArena::kHugePageBytes));
+            if (aligned > start) {
+                munmap(start, aligned - start);
+            }
+            const size_t tail = (start + mapped) - (aligned + size);
+            if (tail > 0) {
+                munmap(aligned + size, tail);
+            }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            huge_pages = madvise(aligned, size, MADV_HUGEPAGE) == 0;
+#endif
+            return aligned;
+#endif
+        }
+
+        void unmap_slab(uint8_t* base, size_t size) {
+#ifdef _WIN32
+            (void)size;
+            VirtualFree(base, 0, MEM_RELEASE);
+#else
+            munmap(base, size);
+#endif
+        }
+
+    } // namespace
+
+    SampleArena::SampleArena(size_t slab_bytes)
+        : slab_bytes_(round_up(std::max(slab_bytes, kHugePageBytes), kHugePageBytes)) {
+    }
+
+    SampleArena::~SampleArena() {
+        for (auto& slab : slabs_) {
+            if (slab) {
+                unmap_slab(slab->base, slab->size);
+            }
+        }
+    }
+
+    SampleArena::Handle SampleArena::store(const void* data, size_t bytes) {
+        const size_t rounded = round_up(std::max<size_t>(bytes, 1), kAlignment);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t slab = 0, offset = 0;
+        if (!take_range(rounded, slabs_.size(), 0, slab, offset)) {
+            slab = add_slab(rounded);
+            if (slab == slabs_.size() || !take_range(rounded, slabs_.size(), 0, slab, offset)) {
+                return nullptr;
+            }
+        }
+
+        uint8_t* dest = slabs_[slab]->base + offset;
+        if (bytes > 0) {
+            std::memcpy(dest, data, bytes);
+        }
+
+        auto block = std::make_unique<Block>();
+        block->data.store(dest);
+        block->bytes = rounded;
+        block->slab = slab;
+        block->offset = offset;
+        block->index = blocks_.size();
+        blocks_.push_back(std::move(block));
+        return blocks_.back().get();
+    }
+
+    void SampleArena::free(Handle handle) {
+        if (handle == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        release_range(handle->slab, handle->offset, handle->bytes);
+
+        const size_t index = handle->index;
+        std::swap(blocks_[index], blocks_.back());
+        blocks_[index]->index = index;
+        blocks_.pop_back();
+
+        release_empty_slabs();
+    }
+
+    bool SampleArena::take_range(size_t bytes, size_t limit_slab, size_t limit_offset, size_t& slab, size_t& offset) {
+        // First fit, lowest address first, strictly before (limit_slab, limit_offset)
+        const size_t num_slabs = std::min(slabs_.size(), limit_slab + 1);
+        for (size_t s = 0; s < num_slabs; ++s) {
+            if (!slabs_[s] || slabs_[s]->size - slabs_[s]->used < bytes) {
+                continue;
+            }
+            auto& ranges = slabs_[s]->free_ranges;
+            for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+                if (s == limit_slab && it->first + bytes > limit_offset) {
+                    break;
+                }
+                if (it->second < bytes) {
+                    continue;
+                }
+
+                slab = s;
+                offset = it->first;
+                const size_t remaining = it->second - bytes;
+                ranges.erase(it);
+                if (remaining > 0) {
+                    ranges.emplace(offset + bytes, remaining);
+                }
+                slabs_[s]->used += bytes;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void SampleArena::release_range(size_t slab, size_t offset, size_t bytes) {
+        Slab& target = *slabs_[slab];
+        target.used -= bytes;
+
+        auto it = target.free_ranges.emplace(offset, bytes).first;
+        auto next = std::next(it);
+        if (next != target.free_ranges.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            target.free_ranges.erase(next);
+        }
+        if (it != target.free_ranges.begin()) {
+            auto previous = std::prev(it);
+            if (previous->first + previous->second == it->first) {
+                previous->second += it->second;
+                target.free_ranges.erase(it);
+            }
+        }
+    }
+
+    size_t SampleArena::add_slab(size_t min_bytes) {
+        auto slab = std::make_unique<Slab>();
+        slab->size = std::max(slab_bytes_, round_up(min_bytes, kHugePageBytes));
+        slab->base = map_slab(slab->size, slab->huge_pages);
+        if (slab->base == nullptr) {
+            std::cout << "[CACHE] Sample arena could not map " << (slab->size >> 20) << " MiB" << std::endl;
+            return slabs_.size();
+        }
+        slab->free_ranges.emplace(0, slab->size);
+
+        // Reuse the slot of a slab that went back to the OS
+        auto empty = std::find(slabs_.begin(), slabs_.end(), nullptr);
+        if (empty != slabs_.end()) {
+            *empty = std::move(slab);
+            return static_cast<size_t>(empty - slabs_.begin());
+        }
+        slabs_.push_back(std::move(slab));
+        return slabs_.size() - 1;
+    }
+
+    void SampleArena::release_empty_slabs() {
+        for (auto& slab : slabs_) {
+            if (slab && slab->used == 0) {
+                unmap_slab(slab->base, slab->size);
+                slab.reset();
+            }
+        }
+        while (!slabs_.empty() && !slabs_.back()) {
+            slabs_.pop_back();
+        }
+    }
+
+    // Called after the new addresses are published. Guards entered from here
+    // on count in the new epoch and resolve the new addresses; the old
+    // epoch's count only drains, so this returns once those guards are gone.
+    void SampleArena::wait_for_readers() {
+        const uint64_t previous = reader_epoch_.fetch_add(1);
+        const std::atomic<int>& old_readers = readers_[previous & 1];
+        while (old_readers.load() != 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    size_t SampleArena::compact(size_t max_bytes) {
+        std::lock_guard<std::mutex> compact_lock(compact_mutex_);
+
+        // Old ranges stay reserved until no reader can still be using them
+        std::vector<std::tuple<size_t, size_t, size_t>> old_ranges;
+        size_t moved = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            std::vector<Block*> order;
+            order.reserve(blocks_.size());
+            for (auto& block : blocks_) {
+                order.push_back(block.get());
+            }
+            std::sort(order.begin(), order.end(), [](const Block* a, const Block* b) {
+                return a->slab != b->slab ? a->slab < b->slab : a->offset < b->offset;
+            });
+
+            for (Block* block : order) {
+                if (moved >= max_bytes) {
+                    break;
+                }
+
+                size_t slab = 0, offset = 0;
+                if (!take_range(block->bytes, block->slab, block->offset, slab, offset)) {
+                    continue;
+                }
+
+                uint8_t* dest = slabs_[slab]->base + offset;
+                std::memcpy(dest, block->data.load(), block->bytes);
+                block->data.store(dest);
+
+                old_ranges.emplace_back(block->slab, block->offset, block->bytes);
+                block->slab = slab;
+                block->offset = offset;
+                moved += block->bytes;
+            }
+        }
+
+        if (old_ranges.empty()) {
+            return 0;
+        }
+
+        wait_for_readers();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [slab, offset, bytes] : old_ranges) {
+            release_range(slab, offset, bytes);
+        }
+        release_empty_slabs();
+
+        ++compactions_;
+        bytes_moved_ += moved;
+        return moved;
+    }
+
+    bool SampleArena::should_compact() const {
+        // Worth it once a slab's worth could go back to the OS
+        const SampleArenaStats stats = get_stats();
+        return stats.num_slabs > 1 && stats.slab_bytes - stats.used_bytes >= slab_bytes_;
+    }
+
+    SampleArenaStats SampleArena::get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        SampleArenaStats stats;
+        for (const auto& slab : slabs_) {
+            if (!slab) {
+                continue;
+            }
+            stats.slab_bytes += slab->size;
+            stats.used_bytes += slab->used;
+            ++stats.num_slabs;
+            if (slab->huge_pages) {
+                ++stats.num_huge_page_slabs;
+            }
+            for (const auto& [offset, size] : slab->free_ranges) {
+                stats.largest_free_bytes = std::max(stats.largest_free_bytes, size);
+            }
+        }
+        stats.num_allocations = static_cast<int>(blocks_.size());
+        stats.compactions = compactions_;
+        stats.bytes_moved = bytes_moved_;
+        return stats;
+    }
+
+} // namespace SharedAudio
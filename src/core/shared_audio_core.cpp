@@ -3,11 +3,24 @@
 #include "processing/audio_processor.h"
 #include "show_control/cue_audio_manager.h"
 #include "show_control/crossfade_engine.h"
-#include "core/lock_free_fifo.h"
+#include "show_control/scene_manager.h"
+#include "processing/mix_graph.h"
+#include "processing/plugin_host.h"
+#include "processing/loudness_analyzer.h"
+#include "processing/input_router.h"
+#include "io/multitrack_recorder.h"
+#include "io/multitrack_player.h"
+#include "io/read_scheduler.h"
+#include "core/command_queue.h"
+#include "core/command_capture.h"
+#include "core/shared_command_ring.h"
 
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -25,6 +38,14 @@ namespace SharedAudio {
             , device_manager_(std::make_unique<juce::AudioDeviceManager>())
             , cue_manager_(std::make_unique<CueAudioManager>())
             , crossfade_engine_(std::make_unique<CrossfadeEngine>())
+            , plugin_host_(std::make_unique<PluginHost>())
+            , mix_graph_(std::make_unique<MixGraph>())
+            , loudness_monitor_(std::make_unique<LoudnessMonitor>())
+            , input_router_(std::make_unique<InputRouter>())
+            , recorder_(std::make_unique<MultitrackRecorder>())
+            , player_(std::make_unique<MultitrackPlayer>())
+            , read_scheduler_(std::make_unique<ReadScheduler>())
+            , scene_manager_(std::make_unique<SceneManager>())
         {
             // Set thread priority for audio callback
 #ifdef PLATFORM_WINDOWS
@@ -42,6 +63,9 @@ namespace SharedAudio {
             }
 
             settings_ = settings;
+            if (settings.offline) {
+                return initialize_offline(settings);
+            }
 
             // Initialize JUCE audio device manager
             auto result = device_manager_->initialiseWithDefaultDevices(
@@ -66,6 +90,13 @@ namespace SharedAudio {
             setup.sampleRate = settings.sample_rate;
             setup.bufferSize = settings.buffer_size;
 
+            // ASIO picks its named device in setup_asio_device; other driver
+            // types take it here, so engines in one process can each open
+            // their own interface (e.g. main PA and headphone preview)
+            if (!settings.device_name.empty() && device_manager_->getCurrentAudioDeviceType() != "ASIO") {
+                select_named_device(setup, settings.device_name, settings.input_channels > 0);
+            }
+
             result = device_manager_->setAudioDeviceSetup(setup, true);
             if (!result.isEmpty()) {
                 last_error_ = "Failed to configure audio device: " + result.toStdString();
@@ -77,10 +108,13 @@ namespace SharedAudio {
             current_sample_rate_ = setup.sampleRate;
             current_buffer_size_ = setup.bufferSize;
 
-            // Initialize components with actual sample rate
-            cue_manager_->initialize(static_cast<int>(current_sample_rate_),
-                current_buffer_size_);
-            crossfade_engine_->initialize(static_cast<int>(current_sample_rate_));
+            int num_outputs = settings.output_channels;
+            int num_inputs = settings.input_channels;
+            if (auto* device = device_manager_->getCurrentAudioDevice()) {
+                num_outputs = device->getActiveOutputChannels().countNumberOfSetBits();
+                num_inputs = device->getActiveInputChannels().countNumberOfSetBits();
+            }
+            initialize_components(num_inputs, num_outputs);
 
             // Set this as the audio callback
             device_manager_->addAudioCallback(this);
@@ -96,15 +130,67 @@ namespace SharedAudio {
             return true;
         }
 
+        // Virtual device: same components, no JUCE device and no callback
+        bool initialize_offline(const AudioSettings& settings) {
+            current_sample_rate_ = settings.sample_rate;
+            current_buffer_size_ = settings.buffer_size;
+            initialize_components(settings.input_channels, settings.output_channels);
+
+            initialized_ = true;
+            std::cout << "SharedAudioCore initialized offline: " << current_sample_rate_ << " Hz, "
+                << settings.input_channels << " in, " << settings.output_channels << " out" << std::endl;
+            return true;
+        }
+
+        void initialize_components(int num_inputs, int num_outputs) {
+            num_inputs_ = num_inputs;
+            num_outputs_ = num_outputs;
+
+            // Initialize components with actual sample rate
+            cue_manager_->initialize(static_cast<int>(current_sample_rate_),
+                current_buffer_size_);
+            crossfade_engine_->initialize(static_cast<int>(current_sample_rate_));
+
+            // Hosts may deliver blocks larger than the nominal buffer size
+            const int max_block_size = std::max(current_buffer_size_, kMinMaxBlockSize);
+            plugin_host_->initialize(current_sample_rate_, max_block_size);
+            mix_graph_->initialize(static_cast<int>(current_sample_rate_), max_block_size,
+                num_outputs, plugin_host_.get());
+            cue_manager_->set_mix_graph(mix_graph_.get());
+            input_router_->initialize(num_inputs, mix_graph_.get());
+            scene_manager_->initialize(static_cast<int>(current_sample_rate_), cue_manager_.get(),
+                mix_graph_.get(), input_router_.get());
+            recorder_->initialize(static_cast<int>(current_sample_rate_), num_inputs, num_outputs);
+            read_scheduler_->start();
+            player_->initialize(static_cast<int>(current_sample_rate_), num_inputs, max_block_size, read_scheduler_.get());
+
+            // Programme loudness of the first output pair
+            if (loudness_monitor_->start(static_cast<int>(current_sample_rate_), 0, std::min(num_outputs, 2))) {
+                mix_graph_->add_output_tap(loudness_monitor_->get_tap());
+            }
+        }
+
         void shutdown() {
             if (!initialized_) {
                 return;
             }
 
             stop_audio();
+            detach_command_ring();
+            command_capture_.stop();
+            recorder_->stop_recording();
+            player_->unload();
+            read_scheduler_->stop();
+
+            if (!settings_.offline) {
+                device_manager_->removeAudioCallback(this);
+                device_manager_->closeAudioDevice();
+            }
 
-            device_manager_->removeAudioCallback(this);
-            device_manager_->closeAudioDevice();
+            mix_graph_->remove_output_tap(loudness_monitor_->get_tap());
+            loudness_monitor_->stop();
+            plugin_host_->shutdown();
+            mix_graph_->shutdown();
 
             initialized_ = false;
 
@@ -149,6 +235,36 @@ namespace SharedAudio {
             return false;
         }
 
+        void select_named_device(juce::AudioDeviceManager::AudioDeviceSetup& setup,
+                                 const std::string& preferred_device, bool with_inputs) {
+            auto* device_type = device_manager_->getCurrentDeviceTypeObject();
+            if (device_type == nullptr) {
+                return;
+            }
+
+            bool found = false;
+            for (const auto& name : device_type->getDeviceNames(false)) {
+                if (name.toStdString().find(preferred_device) != std::string::npos) {
+                    setup.outputDeviceName = name;
+                    found = true;
+                    break;
+                }
+            }
+            if (with_inputs) {
+                for (const auto& name : device_type->getDeviceNames(true)) {
+                    if (name.toStdString().find(preferred_device) != std::string::npos) {
+                        setup.inputDeviceName = name;
+                        break;
+                    }
+                }
+            }
+
+            if (!found) {
+                std::cout << "[AUDIO] Device '" << preferred_device
+                          << "' not found, using default audio device" << std::endl;
+            }
+        }
+
         void start_audio() {
             if (!initialized_ || audio_running_) {
                 return;
@@ -174,11 +290,44 @@ namespace SharedAudio {
             float** outputChannelData,
             int numOutputChannels,
             int numSamples) override {
+            process_block(inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples);
+        }
+
+        // REAL-TIME THREAD - shared by the device callback and render_offline
+        void process_block(const float** inputChannelData,
+            int numInputChannels,
+            float** outputChannelData,
+            int numOutputChannels,
+            int numSamples) {
+            StageClock clock(stage_stats_);
+            const uint64_t block_start = static_cast<uint64_t>(samples_processed_total_.load(std::memory_order_relaxed));
+            const int64_t block_end = static_cast<int64_t>(block_start) + numSamples;
+            publish_clock_anchor(block_start);
+
+            // A capture that was just armed starts here, from this state
+            if (std::vector<VoicePlaybackState>* voices = command_capture_.pending_snapshot()) {
+                cue_manager_->capture_playback_state_realtime(*voices);
+                command_capture_.commit_snapshot(block_start);
+            }
+
+            // Replayed commands first, in file order (offline engines only)
+            for (const AudioThreadMessage& replayed : offline_commands_) {
+                dispatch_command(replayed, block_start, block_end);
+            }
+            offline_commands_.clear();
+
             // Process messages from non-realtime thread
             AudioThreadMessage msg;
             while (message_queue_.pop(msg)) {
-                processAudioThreadMessage(msg);
+                dispatch_command(msg, block_start, block_end);
             }
+            if (SharedCommandRing* ring = command_ring_.load(std::memory_order_acquire)) {
+                while (ring->pop(msg)) {
+                    dispatch_command(msg, block_start, block_end);
+                }
+            }
+            run_scheduled_commands(block_start, block_end);
+            clock.lap(STAGE_COMMANDS);
 
             // Convert to our buffer format
             AudioBuffer input_channels(numInputChannels);
@@ -198,14 +347,29 @@ namespace SharedAudio {
                 std::fill(output_channels[ch].begin(), output_channels[ch].end(), 0.0f);
             }
 
+            scene_manager_->process(numSamples); // scene recalls land before any strip reads its levels
+            mix_graph_->begin_block(numSamples);
+            player_->process(input_channels, numSamples); // virtual soundcheck replaces live inputs
+            input_router_->process_to_buses(input_channels, numSamples);
+            clock.lap(STAGE_INPUTS);
+
             // Call user callback if set (NO LOCKS!)
             if (user_callback_) {
                 user_callback_(input_channels, output_channels, numSamples, current_sample_rate_);
             }
+            clock.lap(STAGE_USER_CALLBACK);
 
             // Process through show control systems (lock-free)
             cue_manager_->process_audio(input_channels, output_channels, numSamples);
+            clock.lap(STAGE_CUES);
+            direct_inputs_ = &input_channels;
+            mix_graph_->process(output_channels, numSamples, &Impl::mix_direct_monitoring, this); // zero-latency monitoring joins before the output trim and meters
+            clock.lap(STAGE_MIX);
             crossfade_engine_->process_audio(output_channels, numSamples);
+            clock.lap(STAGE_OUTPUTS);
+            recorder_->process(input_channels, output_channels, numSamples); // what the audience heard
+            command_capture_.record_block(block_start, numSamples, output_channels);
+            clock.lap(STAGE_RECORDING);
 
             // Copy back to output
             for (int ch = 0; ch < numOutputChannels; ++ch) {
@@ -220,6 +384,12 @@ namespace SharedAudio {
             updatePerformanceMetrics(numSamples);
         }
 
+        // MixGraph direct feed: live inputs to their direct monitor outputs
+        static void mix_direct_monitoring(void* context, AudioBuffer& outputs, int num_samples) {
+            auto* self = static_cast<Impl*>(context);
+            self->input_router_->process_direct(*self->direct_inputs_, outputs, num_samples);
+        }
+
         void audioDeviceAboutToStart(juce::AudioIODevice* device) override {
             // Called before audio starts
             current_sample_rate_ = device->getCurrentSampleRate();
@@ -230,17 +400,24 @@ namespace SharedAudio {
             // Called when audio stops
         }
 
-        // Process messages in audio thread (lock-free)
-        void processAudioThreadMessage(const AudioThreadMessage& msg) {
+        // Process messages in audio thread (lock-free). sample_offset is the
+        // frame within the current block the command takes effect at.
+        void processAudioThreadMessage(const AudioThreadMessage& msg, int sample_offset = 0) {
             switch (msg.type) {
             case AudioThreadMessage::START_CUE:
-                cue_manager_->start_cue_realtime(msg.cue_id);
+                cue_manager_->start_cue_realtime(msg.cue_id, sample_offset);
                 break;
             case AudioThreadMessage::STOP_CUE:
-                cue_manager_->stop_cue_realtime(msg.cue_id);
+                cue_manager_->stop_cue_realtime(msg.cue_id, sample_offset);
                 break;
             case AudioThreadMessage::SET_VOLUME:
-                cue_manager_->set_cue_volume_realtime(msg.cue_id, msg.param1.float_value);
+                cue_manager_->set_cue_volume_realtime(msg.cue_id, msg.param1.float_value, sample_offset);
+                break;
+            case AudioThreadMessage::SET_PAN:
+                cue_manager_->set_cue_pan_realtime(msg.cue_id, msg.param1.float_value, sample_offset);
+                break;
+            case AudioThreadMessage::SEEK:
+                cue_manager_->seek_cue_realtime(msg.cue_id, msg.param1.double_value, sample_offset);
                 break;
             case AudioThreadMessage::CROSSFADE:
                 crossfade_engine_->start_crossfade_realtime(
@@ -254,14 +431,221 @@ namespace SharedAudio {
             }
         }
 
+        // REAL-TIME THREAD - applies a command now, or holds it for the
+        // block that contains its timestamp
+        void dispatch_command(const AudioThreadMessage& msg, uint64_t block_start, int64_t block_end) {
+            if (msg.timestamp_samples >= block_end && schedule_command(msg)) {
+                return;
+            }
+            if (msg.timestamp_samples >= 0 && msg.timestamp_samples < static_cast<int64_t>(block_start)) {
+                scheduled_late_.fetch_add(1, std::memory_order_relaxed);
+            }
+            command_capture_.record_command(block_start, msg); // replay applies it in this block
+            processAudioThreadMessage(msg, block_offset(msg, block_start, block_end));
+        }
+
+        // Frame a due command lands on; untimed and late commands start the block
+        static int block_offset(const AudioThreadMessage& msg, uint64_t block_start, int64_t block_end) {
+            if (msg.timestamp_samples < static_cast<int64_t>(block_start) || msg.timestamp_samples >= block_end) {
+                return 0;
+            }
+            return static_cast<int>(msg.timestamp_samples - static_cast<int64_t>(block_start));
+        }
+
+        // Keeps the schedule ordered by timestamp, arrival order among equals
+        bool schedule_command(const AudioThreadMessage& msg) {
+            if (num_scheduled_ >= kMaxScheduledCommands) {
+                scheduled_overflow_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            int index = num_scheduled_;
+            while (index > 0 && scheduled_[index - 1].timestamp_samples > msg.timestamp_samples) {
+                scheduled_[index] = scheduled_[index - 1];
+                --index;
+            }
+            scheduled_[index] = msg;
+            ++num_scheduled_;
+            return true;
+        }
+
+        void run_scheduled_commands(uint64_t block_start, int64_t block_end) {
+            int due = 0;
+            while (due < num_scheduled_ && scheduled_[due].timestamp_samples < block_end) {
+                command_capture_.record_command(block_start, scheduled_[due]);
+                processAudioThreadMessage(scheduled_[due], block_offset(scheduled_[due], block_start, block_end));
+                ++due;
+            }
+            if (due > 0) {
+                std::copy(scheduled_.begin() + due, scheduled_.begin() + num_scheduled_, scheduled_.begin());
+                num_scheduled_ -= due;
+            }
+        }
+
+        // Seqlock: the steady clock time at which a block started processing
+        void publish_clock_anchor(uint64_t block_start) {
+            const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            const uint32_t sequence = clock_sequence_.load(std::memory_order_relaxed);
+            clock_sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            clock_anchor_ns_.store(now_ns, std::memory_order_relaxed);
+            clock_anchor_sample_.store(static_cast<int64_t>(block_start), std::memory_order_relaxed);
+            clock_sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        int64_t get_sample_time(std::chrono::steady_clock::time_point when) const {
+            int64_t anchor_ns = 0;
+            int64_t anchor_sample = -1;
+            for (;;) {
+                const uint32_t before = clock_sequence_.load(std::memory_order_acquire);
+                anchor_ns = clock_anchor_ns_.load(std::memory_order_relaxed);
+                anchor_sample = clock_anchor_sample_.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((before & 1) == 0 && clock_sequence_.load(std::memory_order_relaxed) == before) {
+                    break;
+                }
+            }
+            if (anchor_sample < 0) {
+                return -1;
+            }
+
+            const int64_t when_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                when.time_since_epoch()).count();
+            return anchor_sample + static_cast<int64_t>(std::llround((when_ns - anchor_ns) * 1.0e-9 * current_sample_rate_));
+        }
+
         // Send message to audio thread (lock-free)
         bool sendAudioThreadMessage(const AudioThreadMessage& msg) {
             return message_queue_.push(msg);
         }
 
+        bool attach_command_ring(void* memory, size_t bytes) {
+            if (attached_ring_) {
+                last_error_ = "A command ring is already attached";
+                return false;
+            }
+
+            auto ring = std::make_unique<SharedCommandRing>();
+            if (!ring->attach(memory, bytes)) {
+                last_error_ = "Invalid command ring buffer";
+                return false;
+            }
+
+            attached_ring_ = std::move(ring);
+            command_ring_.store(attached_ring_.get(), std::memory_order_release);
+            std::cout << "[AUDIO] Command ring attached (" << attached_ring_->get_capacity() << " records)" << std::endl;
+            return true;
+        }
+
+        // Waits for a callback that may still be draining the old ring
+        void detach_command_ring() {
+            if (!attached_ring_) {
+                return;
+            }
+
+            command_ring_.store(nullptr, std::memory_order_release);
+            if (!settings_.offline) {
+                const int64_t seen = samples_processed_total_.load(std::memory_order_acquire);
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+                while (samples_processed_total_.load(std::memory_order_acquire) == seen
+                    && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            attached_ring_.reset();
+        }
+
+        bool render_offline(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
+            if (!initialized_ || !settings_.offline || num_samples <= 0) {
+                return false;
+            }
+
+            std::vector<const float*> input_pointers(num_inputs_, nullptr);
+            for (int ch = 0; ch < num_inputs_ && ch < static_cast<int>(inputs.size()); ++ch) {
+                if (static_cast<int>(inputs[ch].size()) >= num_samples) {
+                    input_pointers[ch] = inputs[ch].data();
+                }
+            }
+
+            outputs.resize(num_outputs_);
+            std::vector<float*> output_pointers(num_outputs_);
+            for (int ch = 0; ch < num_outputs_; ++ch) {
+                outputs[ch].resize(num_samples);
+                output_pointers[ch] = outputs[ch].data();
+            }
+
+            process_block(input_pointers.data(), num_inputs_, output_pointers.data(), num_outputs_, num_samples);
+            return true;
+        }
+
+        bool apply_command_offline(const AudioThreadMessage& msg) {
+            if (!initialized_ || !settings_.offline) {
+                last_error_ = "apply_command_offline needs an offline engine";
+                return false;
+            }
+            offline_commands_.push_back(msg);
+            return true;
+        }
+
+        bool start_command_capture(const std::string& path) {
+            if (!initialized_) {
+                last_error_ = "Audio core not initialized";
+                return false;
+            }
+
+            CaptureHeader header;
+            header.sample_rate = static_cast<int>(current_sample_rate_);
+            header.num_inputs = num_inputs_;
+            header.num_outputs = num_outputs_;
+            for (const auto& [cue_id, file_path] : cue_manager_->get_loaded_assets()) {
+                header.assets.push_back({ cue_id, file_path });
+            }
+            for (int bus = 0; bus < mix_graph_->get_num_buses(); ++bus) {
+                const MixBusInfo info = mix_graph_->get_bus_info(bus);
+                header.buses.push_back({ info.name, info.num_channels, info.first_output_channel });
+            }
+            header.levels = *scene_manager_->capture();
+            header.levels.voices.clear(); // Voice levels travel with the voice snapshot
+
+            if (!command_capture_.start(path, header)) {
+                last_error_ = "Failed to start command capture: " + path;
+                return false;
+            }
+            return true;
+        }
+
+        std::vector<StageTiming> get_stage_profile() const {
+            static const char* const kStageNames[kNumStages] = {
+                "commands", "inputs", "user_callback", "cues", "mix", "outputs", "recording"
+            };
+
+            std::vector<StageTiming> profile;
+            for (int stage = 0; stage < kNumStages; ++stage) {
+                const StageStats& stats = stage_stats_[stage];
+                StageTiming timing;
+                timing.name = kStageNames[stage];
+                timing.blocks = stats.blocks.load(std::memory_order_relaxed);
+                if (timing.blocks > 0) {
+                    timing.average_us = stats.total_ns.load(std::memory_order_relaxed) * 1.0e-3 / timing.blocks;
+                }
+                timing.max_us = stats.max_ns.load(std::memory_order_relaxed) * 1.0e-3;
+                profile.push_back(timing);
+            }
+            return profile;
+        }
+
+        void reset_stage_profile() {
+            for (auto& stats : stage_stats_) {
+                stats.total_ns.store(0, std::memory_order_relaxed);
+                stats.max_ns.store(0, std::memory_order_relaxed);
+                stats.blocks.store(0, std::memory_order_relaxed);
+            }
+        }
+
         void updatePerformanceMetrics(int samples_processed) {
             // Update metrics without locks
-            samples_processed_total_.fetch_add(samples_processed, std::memory_order_relaxed);
+            samples_processed_total_.fetch_add(samples_processed, std::memory_order_release); // detach_command_ring waits on this
 
             // Calculate CPU usage periodically
             auto now = std::chrono::steady_clock::now();
@@ -269,8 +653,24 @@ namespace SharedAudio {
                 // Update metrics (this is approximate, no locks needed)
                 double latency = getLatencyMs();
                 current_metrics_.current_latency_ms = latency;
+                current_metrics_.graph_latency_samples = mix_graph_->get_total_latency_samples();
+                current_metrics_.total_output_latency_ms = latency +
+                    (current_metrics_.graph_latency_samples * 1000.0) / current_sample_rate_;
                 current_metrics_.is_stable = true;
 
+                const CommandQueueStats commands = message_queue_.get_stats();
+                current_metrics_.commands_pushed = commands.pushed;
+                current_metrics_.commands_coalesced = commands.coalesced;
+                current_metrics_.commands_dropped = commands.dropped;
+                current_metrics_.critical_commands_dropped = commands.critical_dropped;
+                current_metrics_.command_queue_high_water = commands.high_water;
+                current_metrics_.critical_queue_high_water = commands.critical_high_water;
+                if (SharedCommandRing* ring = command_ring_.load(std::memory_order_acquire)) {
+                    current_metrics_.shared_ring_dropped = ring->get_dropped();
+                }
+                current_metrics_.scheduled_commands_late = scheduled_late_.load(std::memory_order_relaxed);
+                current_metrics_.scheduled_commands_overflow = scheduled_overflow_.load(std::memory_order_relaxed);
+
                 last_metrics_update_ = now;
             }
         }
@@ -294,6 +694,49 @@ namespace SharedAudio {
             return "No Device";
         }
 
+        static constexpr int kMinMaxBlockSize = 4096;
+
+        // Per-stage callback timing, written by the audio thread only
+        enum Stage {
+            STAGE_COMMANDS,
+            STAGE_INPUTS,
+            STAGE_USER_CALLBACK,
+            STAGE_CUES,
+            STAGE_MIX,
+            STAGE_OUTPUTS,
+            STAGE_RECORDING,
+            kNumStages
+        };
+
+        struct StageStats {
+            std::atomic<uint64_t> total_ns{ 0 };
+            std::atomic<uint64_t> max_ns{ 0 };
+            std::atomic<uint64_t> blocks{ 0 };
+        };
+
+        class StageClock {
+        public:
+            explicit StageClock(std::array<StageStats, kNumStages>& stats)
+                : stats_(stats), last_(std::chrono::steady_clock::now()) {}
+
+            void lap(Stage stage) {
+                const auto now = std::chrono::steady_clock::now();
+                const uint64_t ns = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+                StageStats& stats = stats_[stage];
+                stats.total_ns.store(stats.total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+                stats.blocks.store(stats.blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                if (ns > stats.max_ns.load(std::memory_order_relaxed)) {
+                    stats.max_ns.store(ns, std::memory_order_relaxed);
+                }
+                last_ = now;
+            }
+
+        private:
+            std::array<StageStats, kNumStages>& stats_;
+            std::chrono::steady_clock::time_point last_;
+        };
+
         // Member variables
         bool initialized_;
         bool audio_running_;
@@ -307,13 +750,41 @@ namespace SharedAudio {
         // Audio parameters
         double current_sample_rate_;
         int current_buffer_size_;
+        int num_inputs_ = 0;
+        int num_outputs_ = 0;
 
         // Components
         std::unique_ptr<CueAudioManager> cue_manager_;
         std::unique_ptr<CrossfadeEngine> crossfade_engine_;
-
-        // Lock-free message queue for real-time thread communication
-        AudioMessageQueue message_queue_;
+        std::unique_ptr<PluginHost> plugin_host_;
+        std::unique_ptr<MixGraph> mix_graph_;
+        std::unique_ptr<LoudnessMonitor> loudness_monitor_;
+        std::unique_ptr<InputRouter> input_router_;
+        const AudioBuffer* direct_inputs_ = nullptr; // audio thread, current block's inputs
+        std::unique_ptr<MultitrackRecorder> recorder_;
+        std::unique_ptr<MultitrackPlayer> player_;
+        std::unique_ptr<ReadScheduler> read_scheduler_;
+        std::unique_ptr<SceneManager> scene_manager_;
+
+        // Lock-free command lanes for real-time thread communication
+        AudioCommandQueue message_queue_;
+        CommandCapture command_capture_;
+        std::vector<AudioThreadMessage> offline_commands_; // render_offline's thread only
+        std::atomic<SharedCommandRing*> command_ring_{ nullptr };
+        std::unique_ptr<SharedCommandRing> attached_ring_; // control thread only
+        std::array<StageStats, kNumStages> stage_stats_;
+
+        // Timestamped commands waiting for their block (audio thread only)
+        static constexpr int kMaxScheduledCommands = 256;
+        std::array<AudioThreadMessage, kMaxScheduledCommands> scheduled_{};
+        int num_scheduled_ = 0;
+        std::atomic<uint64_t> scheduled_late_{ 0 };
+        std::atomic<uint64_t> scheduled_overflow_{ 0 };
+
+        // Block start time <-> engine sample, for get_sample_time
+        std::atomic<uint32_t> clock_sequence_{ 0 };
+        std::atomic<int64_t> clock_anchor_ns_{ 0 };
+        std::atomic<int64_t> clock_anchor_sample_{ -1 };
 
         // Performance tracking (lock-free)
         std::atomic<int64_t> samples_processed_total_{ 0 };
@@ -365,10 +836,86 @@ namespace SharedAudio {
         return impl_->crossfade_engine_.get();
     }
 
+    MixGraph* SharedAudioCore::get_mix_graph() {
+        return impl_->mix_graph_.get();
+    }
+
+    PluginHost* SharedAudioCore::get_plugin_host() {
+        return impl_->plugin_host_.get();
+    }
+
+    LoudnessMonitor* SharedAudioCore::get_loudness_monitor() {
+        return impl_->loudness_monitor_.get();
+    }
+
+    InputRouter* SharedAudioCore::get_input_router() {
+        return impl_->input_router_.get();
+    }
+
+    MultitrackRecorder* SharedAudioCore::get_recorder() {
+        return impl_->recorder_.get();
+    }
+
+    MultitrackPlayer* SharedAudioCore::get_player() {
+        return impl_->player_.get();
+    }
+
+    SceneManager* SharedAudioCore::get_scene_manager() {
+        return impl_->scene_manager_.get();
+    }
+
+    ReadScheduler* SharedAudioCore::get_read_scheduler() {
+        return impl_->read_scheduler_.get();
+    }
+
     PerformanceMetrics SharedAudioCore::get_performance_metrics() const {
         return impl_->current_metrics_;
     }
 
+    std::vector<StageTiming> SharedAudioCore::get_stage_profile() const {
+        return impl_->get_stage_profile();
+    }
+
+    void SharedAudioCore::reset_stage_profile() {
+        impl_->reset_stage_profile();
+    }
+
+    bool SharedAudioCore::send_command(const AudioThreadMessage& msg) {
+        return impl_->sendAudioThreadMessage(msg);
+    }
+
+    int64_t SharedAudioCore::get_sample_time(std::chrono::steady_clock::time_point when) const {
+        return impl_->get_sample_time(when);
+    }
+
+    bool SharedAudioCore::attach_command_ring(void* memory, size_t bytes) {
+        return impl_->attach_command_ring(memory, bytes);
+    }
+
+    void SharedAudioCore::detach_command_ring() {
+        impl_->detach_command_ring();
+    }
+
+    bool SharedAudioCore::render_offline(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
+        return impl_->render_offline(inputs, outputs, num_samples);
+    }
+
+    bool SharedAudioCore::apply_command_offline(const AudioThreadMessage& msg) {
+        return impl_->apply_command_offline(msg);
+    }
+
+    bool SharedAudioCore::start_command_capture(const std::string& path) {
+        return impl_->start_command_capture(path);
+    }
+
+    void SharedAudioCore::stop_command_capture() {
+        impl_->command_capture_.stop();
+    }
+
+    bool SharedAudioCore::is_capturing_commands() const {
+        return impl_->command_capture_.is_capturing();
+    }
+
     std::string SharedAudioCore::get_last_error() const {
         return impl_->last_error_;
     }
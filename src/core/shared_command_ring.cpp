@@ -0,0 +1,147 @@
+﻿#include "core/shared_command_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace SharedAudio {
+
+    using namespace CommandRingLayout;
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+        "ring indices are shared with JS Atomics and must be plain lock-free words");
+
+    namespace {
+
+        template<typename T>
+        T load_field(const uint8_t* data) {
+            T value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+    } // namespace
+
+    size_t SharedCommandRing::format(void* memory, size_t bytes, uint32_t capacity) {
+        const size_t needed = get_bytes_for(capacity);
+        if (memory == nullptr || capacity == 0 || (capacity & (capacity - 1)) != 0 || needed > bytes) {
+            return 0;
+        }
+
+        auto* base = static_cast<uint8_t*>(memory);
+        std::memset(base, 0, needed);
+        const uint32_t header[] = { capacity, static_cast<uint32_t>(kRecordBytes), kMagic, kVersion };
+        std::memcpy(base + kCapacityOffset, header, sizeof(header));
+        return needed;
+    }
+
+    bool SharedCommandRing::attach(void* memory, size_t bytes) {
+        auto* base = static_cast<uint8_t*>(memory);
+        if (base == nullptr || bytes < kHeaderBytes || reinterpret_cast<uintptr_t>(base) % 8 != 0) {
+            return false;
+        }
+
+        const uint32_t capacity = load_field<uint32_t>(base + kCapacityOffset);
+        if (load_field<uint32_t>(base + kMagicOffset) != kMagic
+            || load_field<uint32_t>(base + kVersionOffset) != kVersion
+            || load_field<uint32_t>(base + kRecordBytesOffset) != kRecordBytes) {
+            std::cout << "[AUDIO] Command ring header does not match this engine" << std::endl;
+            return false;
+        }
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0
+            || kHeaderBytes + static_cast<size_t>(capacity) * kRecordBytes > bytes) {
+            std::cout << "[AUDIO] Command ring capacity " << capacity << " is invalid for "
+                << bytes << " bytes" << std::endl;
+            return false;
+        }
+
+        base_ = base;
+        mask_ = capacity - 1;
+        return true;
+    }
+
+    uint32_t SharedCommandRing::get_dropped() const {
+        return base_ != nullptr ? index_at(kDroppedOffset).load(std::memory_order_relaxed) : 0;
+    }
+
+    bool SharedCommandRing::is_supported(uint32_t type) {
+        switch (type) {
+        case AudioThreadMessage::START_CUE:
+        case AudioThreadMessage::STOP_CUE:
+        case AudioThreadMessage::SET_VOLUME:
+        case AudioThreadMessage::SET_PAN:
+        case AudioThreadMessage::SEEK:
+            return true;
+        default:
+            return false; // CROSSFADE needs two ids, LOAD_BUFFER is not a JS command
+        }
+    }
+
+    bool SharedCommandRing::push(const AudioThreadMessage& msg) {
+        if (base_ == nullptr || !is_supported(msg.type)) {
+            return false;
+        }
+
+        std::atomic<uint32_t>& write_index = index_at(kWriteIndexOffset);
+        const uint32_t write = write_index.load(std::memory_order_relaxed);
+        if (write - index_at(kReadIndexOffset).load(std::memory_order_acquire) > mask_) {
+            index_at(kDroppedOffset).fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint8_t* record = base_ + kHeaderBytes + static_cast<size_t>(write & mask_) * kRecordBytes;
+        const uint32_t type = static_cast<uint32_t>(msg.type);
+        const uint32_t id_length = static_cast<uint32_t>(strnlen(msg.cue_id, kMaxIdBytes));
+        const double param1 = msg.type == AudioThreadMessage::SEEK
+            ? msg.param1.double_value : static_cast<double>(msg.param1.float_value);
+        std::memcpy(record + kTypeOffset, &type, sizeof(type));
+        std::memcpy(record + kIdLengthOffset, &id_length, sizeof(id_length));
+        std::memcpy(record + kParam1Offset, &param1, sizeof(param1));
+        std::memcpy(record + kParam2Offset, &msg.param2.float_value, sizeof(float));
+        std::memcpy(record + kIdOffset, msg.cue_id, id_length);
+
+        write_index.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool SharedCommandRing::pop(AudioThreadMessage& msg) {
+        if (base_ == nullptr) {
+            return false;
+        }
+
+        std::atomic<uint32_t>& read_index = index_at(kReadIndexOffset);
+        const uint32_t write = index_at(kWriteIndexOffset).load(std::memory_order_acquire);
+        uint32_t read = read_index.load(std::memory_order_relaxed);
+
+        while (read != write) {
+            const uint8_t* record = base_ + kHeaderBytes + static_cast<size_t>(read & mask_) * kRecordBytes;
+            const uint32_t type = load_field<uint32_t>(record + kTypeOffset);
+            ++read;
+            if (!is_supported(type)) {
+                continue;
+            }
+
+            msg = AudioThreadMessage{};
+            msg.type = static_cast<AudioThreadMessage::Type>(type);
+            const uint32_t id_length = std::min<uint32_t>(load_field<uint32_t>(record + kIdLengthOffset),
+                static_cast<uint32_t>(kMaxIdBytes));
+            std::memcpy(msg.cue_id, record + kIdOffset, id_length);
+
+            const double param1 = load_field<double>(record + kParam1Offset);
+            if (msg.type == AudioThreadMessage::SEEK) {
+                msg.param1.double_value = param1;
+            }
+            else {
+                msg.param1.float_value = static_cast<float>(param1);
+            }
+            msg.param2.float_value = load_field<float>(record + kParam2Offset);
+
+            read_index.store(read, std::memory_order_release);
+            return true;
+        }
+
+        read_index.store(read, std::memory_order_release);
+        return false;
+    }
+
+} // namespace SharedAudio
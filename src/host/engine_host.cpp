@@ -0,0 +1,516 @@
+﻿#include "host/engine_host.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr int kControlTimeoutMs = 30000; // Loads decode the whole file
+        constexpr int kHeartbeatWindowMs = 500;
+
+        void copy_string(char* dest, size_t size, const std::string& text) {
+            const size_t count = std::min(text.size(), size - 1);
+            std::memcpy(dest, text.data(), count);
+            dest[count] = '\0';
+        }
+
+        // Claims this process holds, and its clients lock per path. The lock
+        // fd stays open until exit: closing any fd on the file drops it.
+        struct ClientClaims {
+            std::mutex mutex;
+            std::map<std::string, std::pair<pid_t, int>> lock_fds; // Path -> (pid that locked, fd)
+            std::vector<uint64_t> live;
+        };
+
+        ClientClaims& client_claims() {
+            static ClientClaims claims;
+            return claims;
+        }
+
+        int hold_clients_lock(const std::string& path) {
+            ClientClaims& claims = client_claims();
+            std::lock_guard<std::mutex> lock(claims.mutex);
+            const pid_t pid = getpid();
+            auto it = claims.lock_fds.find(path);
+            if (it != claims.lock_fds.end() && it->second.first == pid) {
+                return it->second.second;
+            }
+
+            // A forked child inherits the fd but not the lock
+            const int fd = it != claims.lock_fds.end() ? it->second.second
+                : open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+            if (fd < 0) {
+                return -1;
+            }
+            struct flock region {};
+            region.l_type = F_WRLCK;
+            region.l_whence = SEEK_SET;
+            region.l_start = pid;
+            region.l_len = 1;
+            if (fcntl(fd, F_SETLK, &region) != 0) {
+                return -1;
+            }
+            claims.lock_fds[path] = { pid, fd };
+            return fd;
+        }
+
+        // Random start: a reused pid must not reissue a dead owner's claim
+        uint64_t next_claim_token() {
+            static std::atomic<uint32_t> claims{ std::random_device{}() };
+            return (static_cast<uint64_t>(static_cast<uint32_t>(getpid())) << 32)
+                | claims.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool is_claim_stale(int clients_fd, uint64_t token) {
+            const pid_t pid = static_cast<pid_t>(token >> 32);
+            if (pid == getpid()) {
+                // Ours, unless a dead owner's pid came back as this process
+                ClientClaims& claims = client_claims();
+                std::lock_guard<std::mutex> lock(claims.mutex);
+                return std::find(claims.live.begin(), claims.live.end(), token) == claims.live.end();
+            }
+
+            struct flock query {};
+            query.l_type = F_WRLCK;
+            query.l_whence = SEEK_SET;
+            query.l_start = pid;
+            query.l_len = 1;
+            return fcntl(clients_fd, F_GETLK, &query) == 0 && query.l_type == F_UNLCK;
+        }
+
+        // One attempt: false while a live owner holds the claim
+        bool take_claim(std::atomic<uint64_t>& owner, int clients_fd, uint64_t token) {
+            ClientClaims& claims = client_claims();
+            {
+                // Listed before it is visible, so our other threads never see it as stale
+                std::lock_guard<std::mutex> lock(claims.mutex);
+                claims.live.push_back(token);
+            }
+
+            uint64_t current = owner.load(std::memory_order_acquire);
+            for (;;) {
+                if (current != 0 && !is_claim_stale(clients_fd, current)) {
+                    std::lock_guard<std::mutex> lock(claims.mutex);
+                    claims.live.erase(std::find(claims.live.begin(), claims.live.end(), token));
+                    return false;
+                }
+                if (owner.compare_exchange_weak(current, token, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+        }
+
+        void release_claim(std::atomic<uint64_t>& owner, uint64_t token) {
+            uint64_t expected = token;
+            owner.compare_exchange_strong(expected, 0, std::memory_order_release);
+            ClientClaims& claims = client_claims();
+            std::lock_guard<std::mutex> lock(claims.mutex);
+            claims.live.erase(std::find(claims.live.begin(), claims.live.end(), token));
+        }
+
+    } // namespace
+
+    // One mmap of the segment, unmapped with its last owner
+    struct EngineHostMapping {
+        EngineHostSegment* segment = nullptr;
+        size_t bytes = 0;
+        uint64_t producer_token = 0; // Our claim on the command ring, 0 = none
+
+        ~EngineHostMapping() {
+            if (producer_token != 0) {
+                release_claim(segment->ring_producer, producer_token);
+            }
+            munmap(segment, bytes);
+        }
+    };
+
+    std::string get_engine_host_lock_path(const std::string& segment_name) {
+        const size_t start = segment_name.find_first_not_of('/');
+        return "/tmp/" + (start == std::string::npos ? std::string() : segment_name.substr(start)) + ".lock";
+    }
+
+    std::string get_engine_host_clients_lock_path(const std::string& segment_name) {
+        const std::string path = get_engine_host_lock_path(segment_name);
+        return path.substr(0, path.size() - 5) + ".clients.lock";
+    }
+
+    EngineHostClient::~EngineHostClient() {
+        disconnect();
+    }
+
+    bool EngineHostClient::connect(const EngineHostOptions& options) {
+        disconnect();
+        reap_children();
+        segment_name_ = options.segment_name;
+        const std::string lock_path = get_engine_host_lock_path(options.segment_name);
+        lock_fd_ = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (lock_fd_ < 0) {
+            last_error_ = "Cannot open " + lock_path + ": " + std::strerror(errno);
+            return false;
+        }
+        const std::string clients_path = get_engine_host_clients_lock_path(options.segment_name);
+        clients_fd_ = hold_clients_lock(clients_path);
+        if (clients_fd_ < 0) {
+            last_error_ = "Cannot lock " + clients_path + ": " + std::strerror(errno);
+            disconnect();
+            return false;
+        }
+
+        // A host from an earlier UI session holds the lock: map it again.
+        // Otherwise launch one; the host clears any stale segment itself.
+        const bool reattach = find_host() != 0;
+        if (!reattach && !launch_host(options)) {
+            disconnect();
+            return false;
+        }
+
+        // The segment of a host that has not started yet, or that lost the
+        // lock to a concurrent launch, is not the one to map
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.connect_timeout_ms);
+        for (;;) {
+            const pid_t owner = find_host();
+            const pid_t host_pid = owner != 0 ? owner : launched_pid_; // A failed launch leaves its error
+            if (host_pid != 0 && map_segment(options.segment_name, host_pid)) {
+                break;
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                last_error_ = reattach ? "Engine host is not answering" : "Engine host did not create " + options.segment_name;
+                disconnect();
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (!wait_for_running(static_cast<int>(std::max<int64_t>(remaining, 0)))) {
+            disconnect();
+            return false;
+        }
+
+        reattached_ = reattach;
+        if (reattach) {
+            std::cout << "[HOST] Reattached to engine host (pid " << segment_->host_pid << ")" << std::endl;
+        }
+        else {
+            std::cout << "[HOST] Engine host started (pid " << segment_->host_pid << ")" << std::endl;
+        }
+        return true;
+    }
+
+    void EngineHostClient::disconnect() {
+        unmap();
+        if (lock_fd_ >= 0) {
+            close(lock_fd_); // Holds no lock of ours, so closing releases nothing
+            lock_fd_ = -1;
+        }
+        reattached_ = false;
+    }
+
+    bool EngineHostClient::shutdown_host() {
+        if (!segment_) {
+            return false;
+        }
+
+        const bool success = request(HostControlSlot::SHUTDOWN, std::string(), std::string(), 0.0, 5000);
+        unmap();
+        return success;
+    }
+
+    bool EngineHostClient::is_host_alive() {
+        reap_children();
+        if (!segment_ || segment_->state.load(std::memory_order_acquire) != static_cast<uint32_t>(EngineHostState::RUNNING)
+            || find_host() != segment_->host_pid) {
+            return false;
+        }
+
+        // The lock outlives a hung host; a stalled heartbeat does not
+        const uint64_t beat = segment_->heartbeat.load(std::memory_order_acquire);
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(liveness_mutex_);
+        if (beat != last_heartbeat_) {
+            last_heartbeat_ = beat;
+            last_heartbeat_change_ = now;
+        }
+        return now - last_heartbeat_change_ < std::chrono::milliseconds(kHeartbeatWindowMs);
+    }
+
+    bool EngineHostClient::send_command(const AudioThreadMessage& msg) {
+        return segment_ != nullptr && claim_ring_producer() && ring_.push(msg);
+    }
+
+    void* EngineHostClient::get_command_ring() {
+        return segment_ != nullptr && claim_ring_producer() ? segment_->command_ring : nullptr;
+    }
+
+    size_t EngineHostClient::get_command_ring_bytes() const {
+        return segment_ ? sizeof(segment_->command_ring) : 0;
+    }
+
+    std::shared_ptr<void> EngineHostClient::retain_mapping() const {
+        return mapping_;
+    }
+
+    bool EngineHostClient::load_audio_cue(const std::string& cue_id, const std::string& file_path) {
+        return request(HostControlSlot::LOAD_CUE, cue_id, file_path, 0.0, kControlTimeoutMs);
+    }
+
+    bool EngineHostClient::unload_audio_cue(const std::string& cue_id) {
+        return request(HostControlSlot::UNLOAD_CUE, cue_id, std::string(), 0.0, kControlTimeoutMs);
+    }
+
+    bool EngineHostClient::set_cue_loop(const std::string& cue_id, bool loop) {
+        return request(HostControlSlot::SET_CUE_LOOP, cue_id, std::string(), loop ? 1.0 : 0.0, kControlTimeoutMs);
+    }
+
+    bool EngineHostClient::read_status(HostStatusFrame& frame) {
+        if (!segment_) {
+            return false;
+        }
+        segment_->status.update();
+        frame = segment_->status.read_buffer();
+        return frame.sequence != 0;
+    }
+
+    bool EngineHostClient::read_meters(HostMeterFrame& frame) {
+        if (!segment_) {
+            return false;
+        }
+        segment_->meters.update();
+        frame = segment_->meters.read_buffer();
+        return frame.sequence != 0;
+    }
+
+    pid_t EngineHostClient::find_host() const {
+        struct flock query {};
+        query.l_type = F_WRLCK;
+        query.l_whence = SEEK_SET; // Whole file
+        if (lock_fd_ < 0 || fcntl(lock_fd_, F_GETLK, &query) != 0 || query.l_type == F_UNLCK) {
+            return 0;
+        }
+        return query.l_pid;
+    }
+
+    // posix_spawn children stay zombies until waited for, and a zombie
+    // still answers kill(pid, 0)
+    void EngineHostClient::reap_children() {
+        std::lock_guard<std::mutex> lock(liveness_mutex_);
+        children_.erase(std::remove_if(children_.begin(), children_.end(),
+            [](pid_t pid) { return waitpid(pid, nullptr, WNOHANG) != 0; }), children_.end());
+    }
+
+    bool EngineHostClient::map_segment(const std::string& name, pid_t host_pid) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(EngineHostSegment)) {
+            close(fd); // Host has not sized it yet
+            return false;
+        }
+
+        void* memory = mmap(nullptr, sizeof(EngineHostSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            return false;
+        }
+
+        // The host writes the magic last, once the segment is fully set up
+        auto* segment = static_cast<EngineHostSegment*>(memory);
+        const uint32_t magic = segment->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (magic != EngineHostLayout::kMagic || segment->version != EngineHostLayout::kVersion
+            || segment->host_pid != static_cast<int32_t>(host_pid)) {
+            if (magic == EngineHostLayout::kMagic && segment->version != EngineHostLayout::kVersion) {
+                last_error_ = "Engine host version mismatch";
+            }
+            munmap(memory, sizeof(EngineHostSegment)); // Or a dead host's segment
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(liveness_mutex_);
+            last_heartbeat_ = segment->heartbeat.load(std::memory_order_acquire);
+            last_heartbeat_change_ = std::chrono::steady_clock::now();
+        }
+
+        mapping_ = std::make_shared<EngineHostMapping>();
+        mapping_->segment = segment;
+        mapping_->bytes = sizeof(EngineHostSegment);
+        segment_ = segment;
+        if (!ring_.attach(segment_->command_ring, sizeof(segment_->command_ring))) {
+            unmap();
+            last_error_ = "Engine host command ring is invalid";
+            return false;
+        }
+        return true;
+    }
+
+    bool EngineHostClient::launch_host(const EngineHostOptions& options) {
+        const AudioSettings& settings = options.settings;
+        std::vector<std::string> args = {
+            options.host_executable,
+            "--segment", options.segment_name,
+            "--sample-rate", std::to_string(settings.sample_rate),
+            "--buffer-size", std::to_string(settings.buffer_size),
+            "--inputs", std::to_string(settings.input_channels),
+            "--outputs", std::to_string(settings.output_channels)
+        };
+        if (!settings.device_name.empty()) {
+            args.push_back("--device");
+            args.push_back(settings.device_name);
+        }
+
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+
+        // New session: the host must survive the UI process and its signals
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+#ifdef POSIX_SPAWN_SETSID
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#endif
+
+        pid_t pid = 0;
+        const int result = posix_spawnp(&pid, options.host_executable.c_str(), nullptr, &attr, argv.data(), environ);
+        posix_spawnattr_destroy(&attr);
+        if (result != 0) {
+            last_error_ = "Cannot launch engine host " + options.host_executable + ": " + std::strerror(result);
+            return false;
+        }
+        launched_pid_ = pid;
+        std::lock_guard<std::mutex> lock(liveness_mutex_);
+        children_.push_back(pid);
+        return true;
+    }
+
+    bool EngineHostClient::wait_for_running(int timeout_ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        for (;;) {
+            const auto state = static_cast<EngineHostState>(segment_->state.load(std::memory_order_acquire));
+            if (state == EngineHostState::RUNNING) {
+                return true;
+            }
+            if (state == EngineHostState::FAILED || state == EngineHostState::STOPPED) {
+                last_error_ = std::string("Engine host failed: ") + segment_->error;
+                return false; // The next host removes the segment
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                last_error_ = "Engine host did not start in time";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // The ring is single producer: one mapping at a time may push into it
+    bool EngineHostClient::claim_ring_producer() {
+        if (mapping_->producer_token != 0) {
+            return true;
+        }
+
+        const uint64_t token = next_claim_token();
+        if (!take_claim(segment_->ring_producer, clients_fd_, token)) {
+            last_error_ = "Another client owns the engine host command ring";
+            return false;
+        }
+        mapping_->producer_token = token;
+        return true;
+    }
+
+    // Polls for the answer: control calls are rare and may take seconds.
+    // The slot is shared with every other client process, so it is claimed
+    // like the command ring; control_mutex_ only orders our own threads.
+    bool EngineHostClient::request(HostControlSlot::Op op, const std::string& cue_id, const std::string& path,
+        double value, int timeout_ms) {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        if (!segment_) {
+            last_error_ = "Not connected to the engine host";
+            return false;
+        }
+
+        HostControlSlot& control = segment_->control;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        const uint64_t token = next_claim_token();
+        while (!take_claim(control.owner, clients_fd_, token)) {
+            if (std::chrono::steady_clock::now() > deadline || !is_host_alive()) {
+                last_error_ = "Another client is holding the engine host control slot";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        struct ClaimRelease {
+            std::atomic<uint64_t>& owner;
+            uint64_t token;
+            ~ClaimRelease() { release_claim(owner, token); }
+        } release{ control.owner, token };
+
+        // A request left behind by a crashed UI must finish first
+        while (control.response_sequence.load(std::memory_order_acquire)
+            != control.request_sequence.load(std::memory_order_relaxed)) {
+            if (std::chrono::steady_clock::now() > deadline || !is_host_alive()) {
+                last_error_ = "Engine host is not answering";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        control.op = op;
+        control.value = value;
+        control.result = 0;
+        control.error[0] = '\0';
+        copy_string(control.cue_id, sizeof(control.cue_id), cue_id);
+        copy_string(control.path, sizeof(control.path), path);
+
+        const uint32_t sequence = control.request_sequence.load(std::memory_order_relaxed) + 1;
+        control.request_sequence.store(sequence, std::memory_order_release);
+
+        while (control.response_sequence.load(std::memory_order_acquire) != sequence) {
+            if (std::chrono::steady_clock::now() > deadline || (op != HostControlSlot::SHUTDOWN && !is_host_alive())) {
+                last_error_ = "Engine host did not answer";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (control.result == 0) {
+            last_error_ = control.error;
+            return false;
+        }
+        return true;
+    }
+
+    // The memory stays mapped while a JS buffer still holds the mapping
+    void EngineHostClient::unmap() {
+        if (segment_) {
+            segment_ = nullptr;
+            mapping_.reset();
+            ring_ = SharedCommandRing();
+        }
+    }
+
+} // namespace SharedAudio
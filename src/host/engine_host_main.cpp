@@ -0,0 +1,284 @@
+﻿#include "host/engine_host.h"
+#include "show_control/cue_audio_manager.h"
+#include "processing/mix_graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace SharedAudio;
+
+// Standalone engine process. Launched by EngineHostClient::connect() with
+// the segment name and audio settings; runs the audio device until a client
+// sends SHUTDOWN or the process gets SIGTERM. UI processes may come and go
+// in between - they only map the segment. Control requests run on their own
+// thread, so a long decode never stalls the heartbeat or the status frames.
+
+namespace {
+
+    constexpr int kLoopMs = 5;               // Control latency and heartbeat rate
+    constexpr int kPublishEveryLoops = 4;    // Status and meters at ~50 Hz
+
+    std::atomic<bool> g_stop_requested{ false };
+
+    void on_stop_signal(int) {
+        g_stop_requested.store(true);
+    }
+
+    struct HostArgs {
+        std::string segment_name;
+        AudioSettings settings;
+    };
+
+    bool parse_args(int argc, char* argv[], HostArgs& args) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            const std::string key = argv[i];
+            const std::string value = argv[i + 1];
+            if (key == "--segment") args.segment_name = value;
+            else if (key == "--sample-rate") args.settings.sample_rate = std::stoi(value);
+            else if (key == "--buffer-size") args.settings.buffer_size = std::stoi(value);
+            else if (key == "--inputs") args.settings.input_channels = std::stoi(value);
+            else if (key == "--outputs") args.settings.output_channels = std::stoi(value);
+            else if (key == "--device") args.settings.device_name = value;
+            else return false;
+        }
+        return !args.segment_name.empty();
+    }
+
+    void copy_string(char* dest, size_t size, const std::string& text) {
+        const size_t count = std::min(text.size(), size - 1);
+        std::memcpy(dest, text.data(), count);
+        dest[count] = '\0';
+    }
+
+    // Held until the process exits; -1 if another host owns the name
+    int lock_segment_name(const std::string& name) {
+        const std::string path = get_engine_host_lock_path(name);
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            std::cout << "[HOST] Cannot open " << path << ": " << std::strerror(errno) << std::endl;
+            return -1;
+        }
+
+        struct flock lock {};
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET; // Whole file
+        if (fcntl(fd, F_SETLK, &lock) != 0) {
+            std::cout << "[HOST] Another engine host owns " << name << std::endl;
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Only the lock holder gets here, so an existing segment is a dead host's
+    EngineHostSegment* create_segment(const std::string& name, const AudioSettings& settings) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+        if (fd < 0) {
+            std::cout << "[HOST] Cannot create segment " << name << ": " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        const size_t bytes = sizeof(EngineHostSegment);
+        void* memory = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (memory == MAP_FAILED) {
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        auto* segment = new (memory) EngineHostSegment();
+        segment->version = EngineHostLayout::kVersion;
+        segment->segment_bytes = bytes;
+        segment->host_pid = static_cast<int32_t>(getpid());
+        segment->sample_rate = settings.sample_rate;
+        segment->num_inputs = settings.input_channels;
+        segment->num_outputs = settings.output_channels;
+        segment->state.store(static_cast<uint32_t>(EngineHostState::STARTING));
+        SharedCommandRing::format(segment->command_ring, sizeof(segment->command_ring),
+            EngineHostLayout::kCommandRingCapacity);
+
+        // Clients only look at a segment once the magic is there
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = EngineHostLayout::kMagic;
+        return segment;
+    }
+
+    void fail(EngineHostSegment* segment, const std::string& error) {
+        std::cout << "[HOST] " << error << std::endl;
+        copy_string(segment->error, sizeof(segment->error), error);
+        segment->state.store(static_cast<uint32_t>(EngineHostState::FAILED), std::memory_order_release);
+    }
+
+    // Returns false once a client asked the host to exit
+    bool handle_control(EngineHostSegment* segment, SharedAudioCore& core) {
+        HostControlSlot& control = segment->control;
+        const uint32_t sequence = control.request_sequence.load(std::memory_order_acquire);
+        if (sequence == control.response_sequence.load(std::memory_order_relaxed)) {
+            return true;
+        }
+
+        CueAudioManager* cues = core.get_cue_manager();
+        bool keep_running = true;
+        bool success = false;
+        switch (control.op) {
+        case HostControlSlot::LOAD_CUE:
+            success = cues->load_audio_cue(control.cue_id, control.path);
+            break;
+        case HostControlSlot::UNLOAD_CUE:
+            success = cues->unload_audio_cue(control.cue_id);
+            break;
+        case HostControlSlot::SET_CUE_LOOP:
+            success = cues->set_cue_loop(control.cue_id, control.value != 0.0);
+            break;
+        case HostControlSlot::SHUTDOWN:
+            success = true;
+            keep_running = false;
+            break;
+        default:
+            copy_string(control.error, sizeof(control.error), "Unknown control request");
+            break;
+        }
+
+        if (!success && control.error[0] == '\0') {
+            copy_string(control.error, sizeof(control.error), core.get_last_error());
+        }
+        control.result = success ? 1 : 0;
+        control.response_sequence.store(sequence, std::memory_order_release);
+        return keep_running;
+    }
+
+    void publish_status(EngineHostSegment* segment, SharedAudioCore& core, uint64_t sequence) {
+        HostStatusFrame& frame = segment->status.write_buffer();
+        const auto cues = core.get_cue_manager()->get_active_cues();
+
+        frame.sequence = sequence;
+        frame.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        frame.metrics = core.get_performance_metrics();
+        frame.num_cues = static_cast<int>(std::min<size_t>(cues.size(), EngineHostLayout::kMaxCues));
+        for (int i = 0; i < frame.num_cues; ++i) {
+            const AudioCueInfo& info = cues[i];
+            HostCueStatus& status = frame.cues[i];
+            copy_string(status.cue_id, sizeof(status.cue_id), info.cue_id);
+            status.state = static_cast<uint32_t>(info.state);
+            status.is_looping = info.is_looping ? 1 : 0;
+            status.position_seconds = info.current_position_seconds;
+            status.duration_seconds = info.duration_seconds;
+            status.volume = info.volume;
+            status.pan = info.pan;
+            status.peak_left = info.peak_left;
+            status.peak_right = info.peak_right;
+        }
+        segment->status.publish();
+    }
+
+    void publish_meters(EngineHostSegment* segment, SharedAudioCore& core, std::vector<MeterValues>& values,
+        uint64_t sequence) {
+        MeterBank* meters = core.get_mix_graph()->get_output_meters();
+        if (meters == nullptr || !meters->read(values)) {
+            return;
+        }
+
+        HostMeterFrame& frame = segment->meters.write_buffer();
+        frame.sequence = sequence;
+        frame.num_outputs = static_cast<int>(std::min<size_t>(values.size(), EngineHostLayout::kMaxMeters));
+        std::copy(values.begin(), values.begin() + frame.num_outputs, frame.outputs);
+        segment->meters.publish();
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    HostArgs args;
+    if (!parse_args(argc, argv, args)) {
+        std::cout << "Usage: shared_audio_engine_host --segment <name> [--sample-rate n] [--buffer-size n]"
+            " [--inputs n] [--outputs n] [--device name]" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGTERM, on_stop_signal);
+    std::signal(SIGINT, on_stop_signal);
+    std::signal(SIGHUP, SIG_IGN);  // The launching UI going away is expected
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int lock_fd = lock_segment_name(args.segment_name);
+    if (lock_fd < 0) {
+        return 1;
+    }
+
+    EngineHostSegment* segment = create_segment(args.segment_name, args.settings);
+    if (segment == nullptr) {
+        return 1;
+    }
+
+    auto core = create_audio_core();
+    if (!core->initialize(args.settings)) {
+        fail(segment, core->get_last_error());
+        munmap(segment, sizeof(EngineHostSegment)); // The client reads the error, the next host removes the segment
+        return 1;
+    }
+    if (!core->attach_command_ring(segment->command_ring, sizeof(segment->command_ring))) {
+        fail(segment, core->get_last_error());
+        core->shutdown();
+        munmap(segment, sizeof(EngineHostSegment));
+        return 1;
+    }
+
+    core->start_audio();
+    segment->state.store(static_cast<uint32_t>(EngineHostState::RUNNING), std::memory_order_release);
+    std::cout << "[HOST] Engine running on " << args.segment_name << std::endl;
+
+    // Loads can take seconds; SHUTDOWN ends the main loop from here
+    std::thread control_thread([segment, &core] {
+        while (!g_stop_requested.load()) {
+            if (!handle_control(segment, *core)) {
+                g_stop_requested.store(true);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kLoopMs));
+        }
+    });
+
+    std::vector<MeterValues> meter_values;
+    uint64_t loops = 0;
+    uint64_t publish_sequence = 0;
+    while (!g_stop_requested.load()) {
+        if (loops++ % kPublishEveryLoops == 0) {
+            ++publish_sequence;
+            publish_status(segment, *core, publish_sequence);
+            publish_meters(segment, *core, meter_values, publish_sequence);
+        }
+        segment->heartbeat.fetch_add(1, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kLoopMs));
+    }
+    control_thread.join(); // Lets a request in progress finish
+
+    segment->state.store(static_cast<uint32_t>(EngineHostState::STOPPED), std::memory_order_release);
+    core->shutdown();
+    shm_unlink(args.segment_name.c_str());
+    munmap(segment, sizeof(EngineHostSegment));
+    close(lock_fd); // Only now may another host take the name
+
+    std::cout << "[HOST] Engine host stopped" << std::endl;
+    return 0;
+}
@@ -0,0 +1,834 @@
+﻿#include "io/multitrack_player.h"
+#include "io/recording_file.h"
+#include "io/read_scheduler.h"
+#include "core/audio_tap.h"
+#include "core/block_boundary.h"
+#include "processing/loop_seam.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr int kMaxInputs = 128;
+        constexpr size_t kTargetReadBytes = 1 << 20; // Per file and per pass
+        constexpr int kMinReadFrames = 4096;
+        constexpr int kMaxReadFrames = 65536;
+        constexpr int kPassesInFlight = 2; // Next pass is on the disk while the last one is unpacked
+
+        struct SourceFile {
+            std::string file_path;
+            RecordingFile file;
+            RecordingFileInfo info;
+            int first_input = 0;
+            int first_track = 0;
+        };
+
+        // One frame span read from every file
+        struct ReadPass {
+            uint64_t start_frame = 0;
+            int frames = 0;
+            std::vector<AlignedBuffer> buffers;  // Per file
+            std::vector<size_t> skip_bytes;      // Alignment padding before the wanted bytes
+            std::vector<int64_t> results;
+            std::atomic<int> pending{ 0 };
+            int seam_offset = -1; // Loop seam frames skipped before appending the seam, -1: no seam
+        };
+
+        // Interleaved file samples -> per-track float
+        void deinterleave(const uint8_t* src, const RecordingFileInfo& info, int frames,
+            AudioBuffer& tracks, int first_track) {
+            const int num_channels = info.num_channels;
+
+            if (info.is_float) {
+                const float* in = reinterpret_cast<const float*>(src);
+                for (int ch = 0; ch < num_channels; ++ch) {
+                    float* out = tracks[first_track + ch].data();
+                    for (int i = 0; i < frames; ++i) {
+                        out[i] = in[i * num_channels + ch];
+                    }
+                }
+                return;
+            }
+
+            const int stride = num_channels * info.bytes_per_sample;
+            for (int ch = 0; ch < num_channels; ++ch) {
+                float* out = tracks[first_track + ch].data();
+                const uint8_t* in = src + ch * info.bytes_per_sample;
+                if (info.bytes_per_sample == 3) {
+                    for (int i = 0; i < frames; ++i, in += stride) {
+                        const int32_t value = static_cast<int32_t>((static_cast<uint32_t>(in[0]) << 8)
+                            | (static_cast<uint32_t>(in[1]) << 16) | (static_cast<uint32_t>(in[2]) << 24)) >> 8;
+                        out[i] = static_cast<float>(value) * (1.0f / 8388608.0f);
+                    }
+                }
+                else {
+                    for (int i = 0; i < frames; ++i, in += stride) {
+                        const int16_t value = static_cast<int16_t>(in[0] | (in[1] << 8));
+                        out[i] = static_cast<float>(value) * (1.0f / 32768.0f);
+                    }
+                }
+            }
+        }
+
+    } // namespace
+
+    class MultitrackPlayer::Impl {
+    public:
+        Impl() {
+            input_track_.fill(-1);
+            for (auto& flag : input_playback_) {
+                flag.store(false);
+            }
+            active_playback_.fill(false);
+        }
+
+        ~Impl() {
+            unload();
+        }
+
+        bool initialize(int sample_rate, int num_inputs, int max_block_size, ReadScheduler* scheduler) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            scheduler_ = scheduler;
+            sample_rate_ = sample_rate;
+            num_inputs_ = std::min(num_inputs, kMaxInputs);
+            max_block_size_ = std::max(max_block_size, 1);
+            return true;
+        }
+
+        bool load(const std::vector<PlaybackSource>& sources, double read_ahead_seconds, bool direct_io) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            unload_locked();
+
+            std::vector<std::unique_ptr<SourceFile>> files;
+            std::array<int, kMaxInputs> input_track;
+            input_track.fill(-1);
+            int num_tracks = 0;
+            uint64_t total_frames = 0;
+            size_t min_frame_bytes = SIZE_MAX;
+
+            int next_input = 0;
+            for (const auto& entry : sources) {
+                PlaybackSource source = entry;
+                if (source.first_input < 0) {
+                    source.first_input = next_input;
+                }
+
+                auto file = std::make_unique<SourceFile>();
+                file->file_path = source.file_path;
+                file->first_input = source.first_input;
+
+                std::string error;
+                if (!file->file.open_for_read(source.file_path)) {
+                    set_error("Failed to open playback file: " + source.file_path);
+                    return false;
+                }
+                if (!parse_recording_header(file->file, file->info, error)) {
+                    set_error(source.file_path + ": " + error);
+                    return false;
+                }
+                if (file->info.sample_rate != sample_rate_) {
+                    set_error(source.file_path + ": recorded at " + std::to_string(file->info.sample_rate)
+                        + " Hz, engine runs at " + std::to_string(sample_rate_) + " Hz");
+                    return false;
+                }
+                if (direct_io && !file->file.open_for_read(source.file_path, true)) {
+                    set_error("Failed to reopen playback file: " + source.file_path);
+                    return false;
+                }
+                if (source.first_input + file->info.num_channels > num_inputs_) {
+                    set_error(source.file_path + ": tracks do not fit the available inputs");
+                    return false;
+                }
+
+                for (int ch = 0; ch < file->info.num_channels; ++ch) {
+                    if (input_track[source.first_input + ch] >= 0) {
+                        set_error(source.file_path + ": input " + std::to_string(source.first_input + ch)
+                            + " is already fed by another file");
+                        return false;
+                    }
+                    input_track[source.first_input + ch] = num_tracks + ch;
+                }
+
+                file->first_track = num_tracks;
+                num_tracks += file->info.num_channels;
+                next_input = source.first_input + file->info.num_channels;
+                total_frames = std::max(total_frames, file->info.num_frames);
+                min_frame_bytes = std::min(min_frame_bytes,
+                    static_cast<size_t>(file->info.num_channels) * file->info.bytes_per_sample);
+                files.push_back(std::move(file));
+            }
+
+            if (files.empty()) {
+                set_error("No playback files given");
+                return false;
+            }
+
+            // One pass reads the same frame span from every file; size it so
+            // the narrowest file still gets a large sequential request
+            read_frames_ = static_cast<int>(std::max<size_t>(kMinReadFrames,
+                std::min<size_t>(kMaxReadFrames, kTargetReadBytes / min_frame_bytes)));
+            for (auto& pass : passes_) {
+                pass.buffers.clear();
+                for (auto& file : files) {
+                    pass.buffers.emplace_back();
+                    pass.buffers.back().allocate(static_cast<size_t>(read_frames_) * file->info.num_channels
+                        * file->info.bytes_per_sample + 2 * kDirectIoAlignment);
+                }
+                pass.skip_bytes.assign(files.size(), 0);
+                pass.results.assign(files.size(), 0);
+            }
+
+            // The ring and scratch are reallocated below; a block that stalled
+            // while the previous load played may still be reading them
+            if (!boundary_.wait()) {
+                set_error("Audio thread is stalled inside a block");
+                return false;
+            }
+
+            const int ring_frames = std::max(read_frames_ * 4, static_cast<int>(read_ahead_seconds * sample_rate_));
+            ring_.prepare(0, num_tracks, ring_frames);
+            reader_scratch_.assign(num_tracks, std::vector<float>(read_frames_, 0.0f));
+            play_scratch_.assign(num_tracks, std::vector<float>(max_block_size_, 0.0f));
+            play_ptrs_.resize(num_tracks);
+            for (int t = 0; t < num_tracks; ++t) {
+                play_ptrs_[t] = play_scratch_[t].data();
+            }
+
+            sources_ = std::move(files);
+            input_track_ = input_track;
+            num_tracks_ = num_tracks;
+            total_frames_ = total_frames;
+            underrun_blocks_ = 0;
+            bytes_read_ = 0;
+            read_requests_ = 0;
+            max_read_us_ = 0;
+
+            start_reader(0);
+            loaded_.store(true);
+
+            std::cout << "[PLAYBACK] Loaded " << num_tracks << " tracks from " << sources_.size() << " files ("
+                << static_cast<double>(total_frames) / sample_rate_ << " s)" << std::endl;
+            return true;
+        }
+
+        void unload() {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            unload_locked();
+        }
+
+        void play() {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (!loaded_.load()) {
+                return;
+            }
+            if (reached_end_.load()) {
+                seek_locked(0);
+            }
+            playing_.store(true);
+        }
+
+        void pause() {
+            playing_.store(false);
+        }
+
+        bool seek(double seconds) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (!loaded_.load()) {
+                return false;
+            }
+
+            const uint64_t frame = static_cast<uint64_t>(std::max(0.0, seconds) * sample_rate_);
+            seek_locked(std::min(frame, total_frames_));
+            return true;
+        }
+
+        // Restarts the read-ahead at the play position, like a seek, so the
+        // new loop applies to everything still in the ring
+        bool set_loop(double start_seconds, double end_seconds, double crossfade_seconds) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (!loaded_.load()) {
+                return false;
+            }
+
+            LoopRegion region;
+            region.start_frame = static_cast<size_t>(std::max(0.0, start_seconds) * sample_rate_);
+            region.end_frame = end_seconds > 0.0 ? static_cast<size_t>(end_seconds * sample_rate_) : 0;
+            // The seam goes into the ring in one write next to a read pass
+            region.crossfade_frames = std::min(static_cast<int>(std::max(0.0, crossfade_seconds) * sample_rate_), read_frames_);
+            const LoopSeamPlan plan = LoopSeam::plan(region, static_cast<size_t>(total_frames_));
+            if (!plan.is_valid()) {
+                set_error("Invalid loop region");
+                return false;
+            }
+
+            const bool was_playing = playing_.exchange(false);
+            boundary_.wait();
+            stop_reader();
+            const uint64_t position = get_position_locked();
+
+            // Read both sides of the seam now, so looping never costs a disk read
+            AudioBuffer outgoing(num_tracks_, std::vector<float>(plan.crossfade_frames, 0.0f));
+            AudioBuffer incoming(num_tracks_, std::vector<float>(plan.crossfade_frames, 0.0f));
+            bool ok = read_tracks(plan.seam_start, plan.crossfade_frames, outgoing)
+                && read_tracks(plan.incoming_start, plan.crossfade_frames, incoming);
+            if (ok) {
+                loop_ = std::make_unique<LoopSeam>();
+                loop_->build(plan, outgoing, incoming);
+            }
+
+            ring_.prepare(0, num_tracks_, ring_.get_capacity());
+            start_reader(position);
+            playing_.store(was_playing);
+            if (ok) {
+                std::cout << "[PLAYBACK] Looping " << static_cast<double>(plan.resume_frame) / sample_rate_ << "-"
+                    << static_cast<double>(plan.end_frame) / sample_rate_ << " s (" << plan.crossfade_frames
+                    << " frame seam)" << std::endl;
+            }
+            return ok;
+        }
+
+        void clear_loop() {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (!loaded_.load() || !loop_) {
+                return;
+            }
+
+            const bool was_playing = playing_.exchange(false);
+            boundary_.wait();
+            stop_reader();
+            const uint64_t position = get_position_locked();
+            loop_.reset();
+            ring_.prepare(0, num_tracks_, ring_.get_capacity());
+            start_reader(position);
+            playing_.store(was_playing);
+        }
+
+        bool set_input_source(int input_channel, bool use_playback) {
+            if (input_channel < 0 || input_channel >= num_inputs_) {
+                return false;
+            }
+            input_playback_[input_channel].store(use_playback);
+            return true;
+        }
+
+        void set_all_inputs_source(bool use_playback) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            for (int ch = 0; ch < num_inputs_; ++ch) {
+                if (input_track_[ch] >= 0) {
+                    input_playback_[ch].store(use_playback);
+                }
+            }
+        }
+
+        bool is_input_playback(int input_channel) const {
+            return input_channel >= 0 && input_channel < num_inputs_ && input_playback_[input_channel].load();
+        }
+
+        PlaybackStatus get_status() const {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            PlaybackStatus status;
+            status.is_loaded = loaded_.load();
+            status.is_playing = playing_.load();
+            status.reached_end = reached_end_.load();
+            status.num_tracks = num_tracks_;
+            status.is_looping = loop_ != nullptr;
+            if (status.is_loaded && sample_rate_ > 0) {
+                status.position_seconds = static_cast<double>(get_position_locked()) / sample_rate_;
+                status.duration_seconds = static_cast<double>(total_frames_) / sample_rate_;
+                status.buffered_seconds = static_cast<double>(ring_.get_num_available()) / sample_rate_;
+            }
+            status.underrun_blocks = underrun_blocks_.load();
+            status.bytes_read = bytes_read_.load();
+            status.read_requests = read_requests_.load();
+            status.max_read_ms = max_read_us_.load() / 1000.0;
+            return status;
+        }
+
+        std::string get_last_error() const {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            return last_error_;
+        }
+
+        // REAL-TIME THREAD
+        void process(AudioBuffer& inputs, int num_samples) {
+            boundary_.enter();
+
+            const bool loaded = loaded_.load();
+            const int frames = std::min(num_samples, max_block_size_);
+            if (loaded) {
+                pull_block(frames);
+            }
+
+            const int num_channels = std::min(static_cast<int>(inputs.size()), num_inputs_);
+            for (int ch = 0; ch < num_channels; ++ch) {
+                const int track = loaded ? input_track_[ch] : -1;
+                const bool want = track >= 0 && input_playback_[ch].load(std::memory_order_relaxed);
+                const bool was = active_playback_[ch];
+                if (!want && !was) {
+                    continue; // Live
+                }
+
+                float* data = inputs[ch].data();
+                const float* recorded = track >= 0 ? play_scratch_[track].data() : nullptr;
+                const int count = std::min(frames, static_cast<int>(inputs[ch].size()));
+
+                if (want && was) {
+                    std::memcpy(data, recorded, count * sizeof(float));
+                }
+                else {
+                    // Live <-> playback switch: crossfade across this block
+                    const float step = 1.0f / static_cast<float>(std::max(count, 1));
+                    for (int i = 0; i < count; ++i) {
+                        const float to_playback = want ? (i + 1) * step : 1.0f - (i + 1) * step;
+                        const float playback = recorded ? recorded[i] : 0.0f;
+                        data[i] += (playback - data[i]) * to_playback;
+                    }
+                    active_playback_[ch] = want;
+                }
+
+                // Anything past the scratch size stays silent rather than mixing sources
+                if (want && count < num_samples) {
+                    std::fill(inputs[ch].begin() + count, inputs[ch].begin() + std::min(num_samples, static_cast<int>(inputs[ch].size())), 0.0f);
+                }
+            }
+
+            boundary_.leave();
+        }
+
+    private:
+        void pull_block(int frames) {
+            int got = 0;
+            if (playing_.load()) {
+                got = ring_.read(play_ptrs_.data(), frames);
+                position_frames_.fetch_add(static_cast<uint64_t>(got), std::memory_order_relaxed);
+
+                if (got < frames) {
+                    if (reader_done_.load()) {
+                        reached_end_.store(true);
+                        playing_.store(false);
+                    }
+                    else {
+                        underrun_blocks_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Paused, starved or past the end: playback inputs are silent
+            for (int t = 0; t < num_tracks_; ++t) {
+                std::fill(play_scratch_[t].begin() + got, play_scratch_[t].begin() + frames, 0.0f);
+            }
+        }
+
+        // Streams count frames played; a loop folds them back onto the file
+        uint64_t get_position_locked() const {
+            const uint64_t position = position_frames_.load();
+            if (loop_ && stream_start_ < loop_->get_plan().end_frame) {
+                return loop_->fold_position(static_cast<size_t>(position));
+            }
+            return position;
+        }
+
+        // Synchronous read of every track (non-realtime thread, reader stopped)
+        bool read_tracks(uint64_t start_frame, int frames, AudioBuffer& tracks) {
+            for (auto& source_ptr : sources_) {
+                SourceFile& source = *source_ptr;
+                const RecordingFileInfo& info = source.info;
+                const uint64_t frame_bytes = static_cast<uint64_t>(info.num_channels) * info.bytes_per_sample;
+                const int wanted = start_frame < info.num_frames
+                    ? static_cast<int>(std::min<uint64_t>(frames, info.num_frames - start_frame)) : 0;
+
+                int got = 0;
+                if (wanted > 0) {
+                    uint64_t offset = info.data_offset + start_frame * frame_bytes;
+                    size_t bytes = static_cast<size_t>(wanted * frame_bytes);
+                    size_t skip = 0;
+                    if (source.file.is_direct_io()) {
+                        const uint64_t aligned_offset = offset / kDirectIoAlignment * kDirectIoAlignment;
+                        skip = static_cast<size_t>(offset - aligned_offset);
+                        bytes = (skip + bytes + kDirectIoAlignment - 1) / kDirectIoAlignment * kDirectIoAlignment;
+                        offset = aligned_offset;
+                    }
+
+                    AlignedBuffer buffer;
+                    if (!buffer.allocate(bytes)) {
+                        set_error("Out of memory reading loop seam");
+                        return false;
+                    }
+                    const int64_t result = source.file.read_at(offset, buffer.data(), bytes);
+                    if (result < 0) {
+                        set_error("Read failed: " + source.file_path);
+                        return false;
+                    }
+                    if (static_cast<uint64_t>(result) > skip) {
+                        got = static_cast<int>(std::min<uint64_t>((static_cast<uint64_t>(result) - skip) / frame_bytes, wanted));
+                        deinterleave(buffer.data() + skip, info, got, tracks, source.first_track);
+                    }
+                }
+
+                for (int ch = 0; ch < info.num_channels; ++ch) {
+                    auto& track = tracks[source.first_track + ch];
+                    std::fill(track.begin() + got, track.begin() + frames, 0.0f);
+                }
+            }
+            return true;
+        }
+
+        void start_reader(uint64_t frame) {
+            read_position_ = frame;
+            stream_start_ = frame;
+            position_frames_.store(frame);
+            reader_done_.store(frame >= total_frames_);
+            reached_end_.store(false);
+            reader_running_ = true;
+            reader_thread_ = std::thread(&Impl::reader_loop, this);
+
+            // Prime the first pass so play() starts without an underrun
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+            while (!reader_done_.load() && ring_.get_num_available() < read_frames_
+                && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        void stop_reader() {
+            reader_running_ = false;
+            if (reader_thread_.joinable()) {
+                reader_thread_.join();
+            }
+        }
+
+        void seek_locked(uint64_t frame) {
+            const bool was_playing = playing_.exchange(false);
+            boundary_.wait();
+            stop_reader();
+            ring_.prepare(0, num_tracks_, ring_.get_capacity());
+            start_reader(frame);
+            playing_.store(was_playing);
+        }
+
+        void unload_locked() {
+            if (!loaded_.exchange(false)) {
+                return;
+            }
+
+            playing_.store(false);
+            boundary_.wait();
+            stop_reader();
+            loop_.reset();
+            sources_.clear();
+            input_track_.fill(-1);
+            num_tracks_ = 0;
+            total_frames_ = 0;
+        }
+
+        // Read-ahead: keeps up to kPassesInFlight passes queued on the
+        // scheduler, each reading the same frame span from every file, and
+        // unpacks them into the ring in order. While looping, the pass that
+        // reaches the seam stops there; the precomputed seam is written after
+        // it and reading resumes at the loop start.
+        void reader_loop() {
+            uint64_t issue_position = read_position_;
+            int first_pass = 0;
+            int passes_in_flight = 0;
+            int frames_in_flight = 0;
+            const int seam_frames = loop_ ? loop_->get_plan().crossfade_frames : 0;
+
+            while (reader_running_) {
+                while (passes_in_flight < kPassesInFlight && issue_position < total_frames_
+                    && ring_.get_capacity() - ring_.get_num_available() - frames_in_flight >= read_frames_ + seam_frames) {
+                    ReadPass& pass = passes_[(first_pass + passes_in_flight) % kPassesInFlight];
+                    const bool looping = loop_ && issue_position < loop_->get_plan().end_frame;
+                    const uint64_t seam_start = looping ? loop_->get_plan().seam_start : total_frames_;
+                    pass.start_frame = issue_position;
+                    pass.frames = static_cast<int>(std::min<uint64_t>(read_frames_,
+                        seam_start - std::min(seam_start, issue_position)));
+                    pass.seam_offset = looping && issue_position + pass.frames >= seam_start
+                        ? static_cast<int>(issue_position > seam_start ? issue_position - seam_start : 0) : -1;
+
+                    // Time to underrun once everything queued before this pass has played
+                    const int frames_ahead = ring_.get_num_available() + frames_in_flight;
+                    const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::microseconds(static_cast<int64_t>(frames_ahead * 1.0e6 / sample_rate_));
+                    issue_pass(pass, deadline);
+
+                    issue_position = pass.seam_offset >= 0 ? loop_->get_plan().resume_frame : issue_position + pass.frames;
+                    frames_in_flight += pass_stream_frames(pass);
+                    ++passes_in_flight;
+                }
+
+                if (passes_in_flight == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    continue;
+                }
+
+                ReadPass& pass = passes_[first_pass];
+                {
+                    std::unique_lock<std::mutex> lock(pass_mutex_);
+                    pass_cv_.wait_for(lock, std::chrono::milliseconds(5), [&] { return pass.pending.load() == 0; });
+                }
+                if (pass.pending.load() != 0) {
+                    continue; // Still on the disk; check whether another pass fits meanwhile
+                }
+
+                for (size_t i = 0; i < sources_.size(); ++i) {
+                    unpack_source(*sources_[i], pass, i);
+                }
+                if (pass.frames > 0) {
+                    ring_.write(reader_scratch_, pass.frames);
+                }
+                read_position_ = pass.start_frame + pass.frames;
+                if (pass.seam_offset >= 0) {
+                    write_seam(pass.seam_offset);
+                    read_position_ = loop_->get_plan().resume_frame;
+                }
+                if (read_position_ >= total_frames_) {
+                    reader_done_.store(true);
+                }
+
+                frames_in_flight -= pass_stream_frames(pass);
+                --passes_in_flight;
+                first_pass = (first_pass + 1) % kPassesInFlight;
+            }
+
+            // Buffers must outlive every read still queued on the scheduler
+            std::unique_lock<std::mutex> lock(pass_mutex_);
+            pass_cv_.wait(lock, [&] {
+                for (auto& pass : passes_) {
+                    if (pass.pending.load() != 0) return false;
+                }
+                return true;
+            });
+        }
+
+        int pass_stream_frames(const ReadPass& pass) const {
+            return pass.frames + (pass.seam_offset >= 0 ? loop_->get_plan().crossfade_frames - pass.seam_offset : 0);
+        }
+
+        void write_seam(int offset) {
+            const AudioBuffer& seam = loop_->get_buffer();
+            const int frames = loop_->get_plan().crossfade_frames - offset;
+            if (frames <= 0) {
+                return; // Hard loop, nothing between the end and the start
+            }
+            if (offset == 0) {
+                ring_.write(seam, frames);
+                return;
+            }
+
+            // Read-ahead restarted inside the seam (seek or set_loop)
+            AudioBuffer rest(seam.size());
+            for (size_t t = 0; t < seam.size(); ++t) {
+                rest[t].assign(seam[t].begin() + offset, seam[t].end());
+            }
+            ring_.write(rest, frames);
+        }
+
+        void issue_pass(ReadPass& pass, std::chrono::steady_clock::time_point deadline) {
+            pass.pending.store(static_cast<int>(sources_.size()));
+
+            for (size_t i = 0; i < sources_.size(); ++i) {
+                SourceFile& source = *sources_[i];
+                const RecordingFileInfo& info = source.info;
+                const uint64_t frame_bytes = static_cast<uint64_t>(info.num_channels) * info.bytes_per_sample;
+                const int frames = pass.start_frame < info.num_frames
+                    ? static_cast<int>(std::min<uint64_t>(pass.frames, info.num_frames - pass.start_frame)) : 0;
+
+                pass.results[i] = 0;
+                pass.skip_bytes[i] = 0;
+                if (frames == 0) {
+                    finish_read(pass);
+                    continue;
+                }
+
+                uint64_t offset = info.data_offset + pass.start_frame * frame_bytes;
+                size_t bytes = static_cast<size_t>(frames * frame_bytes);
+                if (source.file.is_direct_io()) {
+                    // Widen to whole aligned blocks; the padding is skipped when unpacking
+                    const uint64_t aligned_offset = offset / kDirectIoAlignment * kDirectIoAlignment;
+                    pass.skip_bytes[i] = static_cast<size_t>(offset - aligned_offset);
+                    bytes = (pass.skip_bytes[i] + bytes + kDirectIoAlignment - 1) / kDirectIoAlignment * kDirectIoAlignment;
+                    offset = aligned_offset;
+                }
+
+                ReadRequest request;
+                request.file = &source.file;
+                request.offset = offset;
+                request.buffer = pass.buffers[i].data();
+                request.bytes = bytes;
+                request.deadline = deadline;
+                const auto submitted = std::chrono::steady_clock::now();
+                request.on_complete = [this, &pass, i, submitted](int64_t result) {
+                    const auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - submitted).count();
+                    if (elapsed_us > max_read_us_.load()) {
+                        max_read_us_.store(elapsed_us);
+                    }
+                    pass.results[i] = result;
+                    finish_read(pass);
+                };
+
+                read_requests_.fetch_add(1);
+                if (scheduler_ != nullptr) {
+                    scheduler_->submit(std::move(request));
+                }
+                else {
+                    request.on_complete(source.file.read_at(request.offset, request.buffer, request.bytes));
+                }
+            }
+        }
+
+        void finish_read(ReadPass& pass) {
+            if (pass.pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(pass_mutex_);
+                pass_cv_.notify_all();
+            }
+        }
+
+        void unpack_source(SourceFile& source, ReadPass& pass, size_t index) {
+            const RecordingFileInfo& info = source.info;
+            const uint64_t frame_bytes = static_cast<uint64_t>(info.num_channels) * info.bytes_per_sample;
+            const int64_t result = pass.results[index];
+            const size_t skip = pass.skip_bytes[index];
+
+            int got = 0;
+            if (result < 0) {
+                set_error("Read failed: " + source.file_path);
+            }
+            else if (static_cast<uint64_t>(result) > skip) {
+                bytes_read_.fetch_add(static_cast<uint64_t>(result));
+                got = static_cast<int>(std::min<uint64_t>((static_cast<uint64_t>(result) - skip) / frame_bytes, pass.frames));
+                deinterleave(pass.buffers[index].data() + skip, info, got, reader_scratch_, source.first_track);
+            }
+
+            // Shorter files (or a failed read) pad with silence to stay in lockstep
+            for (int ch = 0; ch < info.num_channels; ++ch) {
+                auto& track = reader_scratch_[source.first_track + ch];
+                std::fill(track.begin() + got, track.begin() + pass.frames, 0.0f);
+            }
+        }
+
+        void set_error(const std::string& error) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            last_error_ = error;
+            std::cout << "[PLAYBACK] " << error << std::endl;
+        }
+
+        int sample_rate_ = 48000;
+        int num_inputs_ = 0;
+        int max_block_size_ = 1;
+        ReadScheduler* scheduler_ = nullptr; // Synchronous reads when not set
+
+        mutable std::mutex control_mutex_;
+        std::vector<std::unique_ptr<SourceFile>> sources_;
+        int num_tracks_ = 0;
+        uint64_t total_frames_ = 0;
+        int read_frames_ = kMinReadFrames;
+
+        // Tracks in lockstep: reader thread writes, audio thread reads
+        AudioTap ring_;
+        AudioBuffer reader_scratch_;
+        AudioBuffer play_scratch_;
+        std::vector<float*> play_ptrs_;
+
+        // Input slot -> track (changed only while unloaded and between blocks)
+        std::array<int, kMaxInputs> input_track_;
+        std::array<std::atomic<bool>, kMaxInputs> input_playback_;
+        std::array<bool, kMaxInputs> active_playback_; // audio thread only
+
+        std::thread reader_thread_;
+        std::array<ReadPass, kPassesInFlight> passes_;
+        std::mutex pass_mutex_;
+        std::condition_variable pass_cv_;
+        std::atomic<bool> reader_running_{ false };
+        std::atomic<bool> reader_done_{ false };
+        uint64_t read_position_ = 0; // reader thread only while it runs
+        uint64_t stream_start_ = 0;  // Frame the read-ahead last (re)started at
+        std::unique_ptr<LoopSeam> loop_; // Changed only while the reader is stopped
+
+        std::atomic<bool> loaded_{ false };
+        std::atomic<bool> playing_{ false };
+        std::atomic<bool> reached_end_{ false };
+        std::atomic<uint64_t> position_frames_{ 0 };
+
+        std::atomic<uint64_t> underrun_blocks_{ 0 };
+        std::atomic<uint64_t> bytes_read_{ 0 };
+        std::atomic<uint64_t> read_requests_{ 0 };
+        std::atomic<int64_t> max_read_us_{ 0 };
+
+        BlockBoundary boundary_; // Audio thread handshake
+
+        mutable std::mutex error_mutex_;
+        std::string last_error_;
+    };
+
+    // MultitrackPlayer public interface
+    MultitrackPlayer::MultitrackPlayer() : impl_(std::make_unique<Impl>()) {}
+    MultitrackPlayer::~MultitrackPlayer() = default;
+
+    bool MultitrackPlayer::initialize(int sample_rate, int num_inputs, int max_block_size, ReadScheduler* scheduler) {
+        return impl_->initialize(sample_rate, num_inputs, max_block_size, scheduler);
+    }
+
+    bool MultitrackPlayer::load(const std::vector<PlaybackSource>& sources, double read_ahead_seconds, bool direct_io) {
+        return impl_->load(sources, read_ahead_seconds, direct_io);
+    }
+
+    void MultitrackPlayer::unload() {
+        impl_->unload();
+    }
+
+    void MultitrackPlayer::play() {
+        impl_->play();
+    }
+
+    void MultitrackPlayer::pause() {
+        impl_->pause();
+    }
+
+    bool MultitrackPlayer::seek(double seconds) {
+        return impl_->seek(seconds);
+    }
+
+    bool MultitrackPlayer::set_loop(double start_seconds, double end_seconds, double crossfade_seconds) {
+        return impl_->set_loop(start_seconds, end_seconds, crossfade_seconds);
+    }
+
+    void MultitrackPlayer::clear_loop() {
+        impl_->clear_loop();
+    }
+
+    bool MultitrackPlayer::set_input_source(int input_channel, bool use_playback) {
+        return impl_->set_input_source(input_channel, use_playback);
+    }
+
+    void MultitrackPlayer::set_all_inputs_source(bool use_playback) {
+        impl_->set_all_inputs_source(use_playback);
+    }
+
+    bool MultitrackPlayer::is_input_playback(int input_channel) const {
+        return impl_->is_input_playback(input_channel);
+    }
+
+    PlaybackStatus MultitrackPlayer::get_status() const {
+        return impl_->get_status();
+    }
+
+    std::string MultitrackPlayer::get_last_error() const {
+        return impl_->get_last_error();
+    }
+
+    void MultitrackPlayer::process(AudioBuffer& inputs, int num_samples) {
+        impl_->process(inputs, num_samples);
+    }
+
+} // namespace SharedAudio
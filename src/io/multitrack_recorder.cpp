@@ -0,0 +1,481 @@
+﻿#include "io/multitrack_recorder.h"
+#include "core/audio_tap.h"
+#include "core/block_boundary.h"
+#include "core/lock_free_fifo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr size_t kHeaderBytes = kRecordingHeaderBytes;
+        constexpr size_t kWriteChunkBytes = 1 << 20; // Every write except the last is this size
+        constexpr size_t kWriteAlignment = 4096;
+        constexpr int kReadChunkFrames = 8192;
+
+        const char* file_extension(RecordingFileFormat format) {
+            switch (format) {
+            case RecordingFileFormat::WAV: return ".wav";
+            case RecordingFileFormat::W64: return ".w64";
+            case RecordingFileFormat::CAF: return ".caf";
+            }
+            return ".wav";
+        }
+
+        // Blocks dropped back to back, placed by the ring frame they precede
+        struct TapGap {
+            uint64_t ring_frame = 0;
+            uint64_t frames = 0;
+        };
+
+        struct RecordingStream {
+            std::string file_path;
+            int num_channels = 0;
+            AudioTap tap;
+            RecordingFile file;
+
+            // Audio thread. A gap is queued before the next accepted block is
+            // written, so the writer always knows about it before reaching it.
+            uint64_t ring_frames = 0;
+            TapGap open_gap;
+            LockFreeFIFO<TapGap, 64> gaps; // A full queue leaves the gap for finish()
+
+            // Writer thread only
+            std::vector<std::vector<float>> scratch;
+            std::vector<float*> scratch_ptrs;
+            std::vector<uint8_t> staging_storage;
+            uint8_t* staging = nullptr; // kWriteAlignment aligned
+            size_t staging_bytes = 0;
+            uint64_t data_bytes = 0;
+            uint64_t allocated_bytes = 0;
+            bool failed = false;
+            uint64_t ring_frames_read = 0;
+            uint64_t silence_frames = 0;
+            TapGap next_gap;
+            bool has_next_gap = false;
+
+            std::atomic<uint64_t> frames_written{ 0 };
+            mutable std::mutex dropouts_mutex;
+            std::vector<RecordingDropout> dropouts;
+        };
+
+    } // namespace
+
+    class MultitrackRecorder::Impl {
+    public:
+        ~Impl() {
+            stop_recording();
+        }
+
+        bool initialize(int sample_rate, int num_inputs, int num_outputs) {
+            sample_rate_ = sample_rate;
+            num_inputs_ = num_inputs;
+            num_outputs_ = num_outputs;
+            return true;
+        }
+
+        bool start_recording(const RecordingSettings& settings) {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (recording_.load()) {
+                set_error("Already recording");
+                return false;
+            }
+
+            // The audio thread may still be inside the block that saw the
+            // previous recording stop; old streams go only after it left
+            if (!boundary_.wait()) {
+                for (auto& stream : streams_) {
+                    boundary_.retire(std::shared_ptr<RecordingStream>(std::move(stream)));
+                }
+            }
+            streams_.clear();
+
+            settings_ = settings;
+            is_float_ = settings.sample_format == RecordingSampleFormat::FLOAT32;
+            bytes_per_sample_ = is_float_ ? 4 : 3;
+
+            const int ring_frames = std::max(kReadChunkFrames * 2, static_cast<int>(settings.ring_seconds * sample_rate_));
+            auto add_stream = [&](const std::string& suffix, int num_channels) {
+                if (num_channels <= 0) return true;
+
+                auto stream = std::make_unique<RecordingStream>();
+                stream->num_channels = num_channels;
+                stream->file_path = settings.directory + "/" + settings.take_name + suffix + file_extension(settings.file_format);
+                if (!stream->file.open_for_write(stream->file_path)) {
+                    set_error("Failed to create recording file: " + stream->file_path);
+                    return false;
+                }
+
+                const uint64_t bytes_per_minute = static_cast<uint64_t>(sample_rate_) * 60 * num_channels * bytes_per_sample_;
+                stream->allocated_bytes = kHeaderBytes + static_cast<uint64_t>(settings.preallocate_minutes * bytes_per_minute);
+                stream->allocated_bytes = (stream->allocated_bytes + kWriteChunkBytes - 1) / kWriteChunkBytes * kWriteChunkBytes;
+                if (!stream->file.preallocate(stream->allocated_bytes)) {
+                    std::cout << "[RECORD] Preallocation failed, file will grow on demand: " << stream->file_path << std::endl;
+                    stream->allocated_bytes = 0;
+                }
+
+                stream->tap.prepare(0, num_channels, ring_frames);
+                stream->scratch.assign(num_channels, std::vector<float>(kReadChunkFrames, 0.0f));
+                stream->scratch_ptrs.resize(num_channels);
+                for (int ch = 0; ch < num_channels; ++ch) {
+                    stream->scratch_ptrs[ch] = stream->scratch[ch].data();
+                }
+
+                // Room for a full write chunk plus one more read chunk of leftovers
+                const size_t staging_capacity = kWriteChunkBytes
+                    + static_cast<size_t>(kReadChunkFrames) * num_channels * bytes_per_sample_;
+                stream->staging_storage.assign(staging_capacity + kWriteAlignment, 0);
+                const uintptr_t base = reinterpret_cast<uintptr_t>(stream->staging_storage.data());
+                stream->staging = stream->staging_storage.data() + ((kWriteAlignment - (base % kWriteAlignment)) % kWriteAlignment);
+
+                write_header(*stream, false);
+                streams_.push_back(std::move(stream));
+                return true;
+            };
+
+            bool ok = true;
+            input_stream_ = output_stream_ = nullptr;
+            if (settings.record_inputs) {
+                ok = add_stream("_inputs", num_inputs_);
+                if (ok && num_inputs_ > 0) input_stream_ = streams_.back().get();
+            }
+            if (ok && settings.record_outputs) {
+                ok = add_stream("_outputs", num_outputs_);
+                if (ok && num_outputs_ > 0) output_stream_ = streams_.back().get();
+            }
+            if (!ok || streams_.empty()) {
+                streams_.clear();
+                input_stream_ = output_stream_ = nullptr;
+                if (ok) set_error("Nothing to record");
+                return false;
+            }
+
+            bytes_written_ = 0;
+            max_write_us_ = 0;
+            start_time_ = std::chrono::steady_clock::now();
+            writer_running_ = true;
+            writer_thread_ = std::thread(&Impl::writer_loop, this);
+
+            recording_.store(true);
+            std::cout << "[RECORD] Recording started: " << settings.take_name << " ("
+                << streams_.size() << " files)" << std::endl;
+            return true;
+        }
+
+        void stop_recording() {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            if (!recording_.exchange(false)) {
+                return;
+            }
+
+            // Let the last block land in the rings, then drain and finalize.
+            // A block that stalls past the wait loses only its own frames;
+            // the streams stay alive until the next take retires them.
+            boundary_.wait();
+            writer_running_ = false;
+            if (writer_thread_.joinable()) {
+                writer_thread_.join();
+            }
+
+            std::cout << "[RECORD] Recording stopped (" << bytes_written_.load() / (1024 * 1024) << " MiB written)" << std::endl;
+        }
+
+        bool is_recording() const {
+            return recording_.load();
+        }
+
+        RecordingStatus get_status() const {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            RecordingStatus status;
+            status.is_recording = recording_.load();
+            status.elapsed_seconds = status.is_recording
+                ? std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count() : 0.0;
+            status.bytes_written = bytes_written_.load();
+            status.max_write_ms = max_write_us_.load() / 1000.0;
+
+            for (const auto& stream : streams_) {
+                RecordingStreamStatus s;
+                s.file_path = stream->file_path;
+                s.num_channels = stream->num_channels;
+                s.frames_written = stream->frames_written.load();
+                s.dropped_frames = stream->tap.get_dropped_frames();
+                {
+                    std::lock_guard<std::mutex> dropouts_lock(stream->dropouts_mutex);
+                    s.dropouts = stream->dropouts;
+                }
+                s.ring_capacity_frames = stream->tap.get_capacity();
+                s.ring_high_water_frames = stream->tap.get_high_water_frames();
+                s.ring_high_water_percent = s.ring_capacity_frames > 0
+                    ? 100.0 * s.ring_high_water_frames / s.ring_capacity_frames : 0.0;
+                status.streams.push_back(s);
+            }
+            return status;
+        }
+
+        std::string get_last_error() const {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            return last_error_;
+        }
+
+        // REAL-TIME THREAD
+        void process(const AudioBuffer& inputs, const AudioBuffer& outputs, int num_samples) {
+            boundary_.enter();
+            if (recording_.load()) {
+                if (input_stream_) write_tap(*input_stream_, inputs, num_samples);
+                if (output_stream_) write_tap(*output_stream_, outputs, num_samples);
+            }
+            boundary_.leave();
+        }
+
+    private:
+        // REAL-TIME THREAD
+        static void write_tap(RecordingStream& stream, const AudioBuffer& buffer, int num_samples) {
+            if (stream.open_gap.frames > 0 && stream.tap.get_free_frames() >= num_samples) {
+                stream.gaps.push(stream.open_gap); // If the queue is full, finish() pads it at the end
+                stream.open_gap = TapGap();
+            }
+            if (stream.tap.write(buffer, num_samples)) {
+                stream.ring_frames += static_cast<uint64_t>(num_samples);
+                return;
+            }
+            if (stream.open_gap.frames == 0) {
+                stream.open_gap.ring_frame = stream.ring_frames;
+            }
+            stream.open_gap.frames += static_cast<uint64_t>(num_samples);
+        }
+
+        void writer_loop() {
+            auto last_header_update = std::chrono::steady_clock::now();
+
+            while (writer_running_) {
+                for (auto& stream : streams_) {
+                    pump(*stream);
+                }
+
+                // Keep the headers current so a crash leaves playable files
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_header_update > std::chrono::seconds(5)) {
+                    for (auto& stream : streams_) {
+                        write_header(*stream, false);
+                    }
+                    last_header_update = now;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            for (auto& stream : streams_) {
+                pump(*stream);
+                // Gaps still open at stop, or that found the queue full, go at the end
+                const uint64_t unplaced = stream->tap.get_dropped_frames() - stream->silence_frames;
+                if (unplaced > 0) {
+                    write_silence(*stream, unplaced);
+                }
+                finish(*stream);
+            }
+        }
+
+        // Ring -> interleaved staging -> 1 MiB aligned writes, with silence
+        // where blocks were dropped
+        void pump(RecordingStream& stream) {
+            while (!stream.failed) {
+                // Ring first: data past a gap is only visible once the gap is queued
+                const int available = stream.tap.get_num_available();
+                if (!stream.has_next_gap) {
+                    stream.has_next_gap = stream.gaps.pop(stream.next_gap);
+                }
+
+                int limit = std::min(available, kReadChunkFrames);
+                if (stream.has_next_gap) {
+                    const uint64_t until_gap = stream.next_gap.ring_frame - stream.ring_frames_read;
+                    if (until_gap == 0) {
+                        write_silence(stream, stream.next_gap.frames);
+                        stream.has_next_gap = false;
+                        continue;
+                    }
+                    limit = static_cast<int>(std::min<uint64_t>(limit, until_gap));
+                }
+
+                const int frames = limit > 0 ? stream.tap.read(stream.scratch_ptrs.data(), limit) : 0;
+                if (frames <= 0) {
+                    break;
+                }
+                stream.ring_frames_read += static_cast<uint64_t>(frames);
+                append(stream, frames);
+            }
+        }
+
+        // Scratch -> staging, writing every full chunk
+        void append(RecordingStream& stream, int frames) {
+            const size_t frame_bytes = static_cast<size_t>(stream.num_channels) * bytes_per_sample_;
+            interleave(stream, frames);
+            stream.staging_bytes += frames * frame_bytes;
+            stream.frames_written.fetch_add(frames, std::memory_order_relaxed);
+
+            while (stream.staging_bytes >= kWriteChunkBytes) {
+                write_chunk(stream, kWriteChunkBytes);
+                std::memmove(stream.staging, stream.staging + kWriteChunkBytes, stream.staging_bytes - kWriteChunkBytes);
+                stream.staging_bytes -= kWriteChunkBytes;
+            }
+        }
+
+        void write_silence(RecordingStream& stream, uint64_t frames) {
+            {
+                std::lock_guard<std::mutex> lock(stream.dropouts_mutex);
+                stream.dropouts.push_back({ stream.frames_written.load(std::memory_order_relaxed), frames });
+            }
+            std::cout << "[RECORD] Disk fell behind, " << frames << " frames written as silence: " << stream.file_path << std::endl;
+
+            stream.silence_frames += frames;
+            for (auto& channel : stream.scratch) {
+                std::fill(channel.begin(), channel.end(), 0.0f);
+            }
+            while (frames > 0 && !stream.failed) {
+                const int count = static_cast<int>(std::min<uint64_t>(frames, kReadChunkFrames));
+                append(stream, count);
+                frames -= static_cast<uint64_t>(count);
+            }
+        }
+
+        void interleave(RecordingStream& stream, int frames) {
+            uint8_t* dst = stream.staging + stream.staging_bytes;
+            const int num_channels = stream.num_channels;
+
+            if (is_float_) {
+                float* out = reinterpret_cast<float*>(dst);
+                for (int i = 0; i < frames; ++i) {
+                    for (int ch = 0; ch < num_channels; ++ch) {
+                        *out++ = stream.scratch[ch][i];
+                    }
+                }
+                return;
+            }
+
+            for (int i = 0; i < frames; ++i) {
+                for (int ch = 0; ch < num_channels; ++ch) {
+                    const float sample = std::max(-1.0f, std::min(1.0f, stream.scratch[ch][i]));
+                    const int32_t value = static_cast<int32_t>(sample * 8388607.0f);
+                    *dst++ = static_cast<uint8_t>(value);
+                    *dst++ = static_cast<uint8_t>(value >> 8);
+                    *dst++ = static_cast<uint8_t>(value >> 16);
+                }
+            }
+        }
+
+        void write_chunk(RecordingStream& stream, size_t bytes) {
+            const uint64_t offset = kHeaderBytes + stream.data_bytes;
+
+            // Extend the reservation a chunk ahead of the data
+            if (stream.allocated_bytes != 0 && offset + bytes > stream.allocated_bytes) {
+                const uint64_t bytes_per_minute = static_cast<uint64_t>(sample_rate_) * 60
+                    * stream.num_channels * bytes_per_sample_;
+                stream.allocated_bytes += std::max<uint64_t>(bytes_per_minute * 5, kWriteChunkBytes);
+                stream.allocated_bytes = (stream.allocated_bytes + kWriteChunkBytes - 1) / kWriteChunkBytes * kWriteChunkBytes;
+                stream.file.preallocate(stream.allocated_bytes);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            if (!stream.file.write_at(offset, stream.staging, bytes)) {
+                stream.failed = true;
+                set_error("Write failed: " + stream.file_path);
+                return;
+            }
+            auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            stream.data_bytes += bytes;
+            bytes_written_.fetch_add(bytes);
+            if (elapsed_us > max_write_us_.load()) {
+                max_write_us_.store(elapsed_us);
+            }
+        }
+
+        void finish(RecordingStream& stream) {
+            if (!stream.failed && stream.staging_bytes > 0) {
+                write_chunk(stream, stream.staging_bytes);
+                stream.staging_bytes = 0;
+            }
+
+            write_header(stream, true);
+            stream.file.truncate(kHeaderBytes + stream.data_bytes);
+            stream.file.close();
+        }
+
+        void write_header(RecordingStream& stream, bool finished) {
+            alignas(16) uint8_t header[kHeaderBytes];
+            build_recording_header(header, settings_.file_format, stream.num_channels, sample_rate_,
+                bytes_per_sample_, is_float_, stream.data_bytes, finished);
+            stream.file.write_at(0, header, kHeaderBytes);
+        }
+
+        void set_error(const std::string& error) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            last_error_ = error;
+            std::cout << "[RECORD] " << error << std::endl;
+        }
+
+        int sample_rate_ = 48000;
+        int num_inputs_ = 0;
+        int num_outputs_ = 0;
+        RecordingSettings settings_;
+        bool is_float_ = true;
+        int bytes_per_sample_ = 4;
+
+        mutable std::mutex control_mutex_;
+        std::vector<std::unique_ptr<RecordingStream>> streams_;
+        RecordingStream* input_stream_ = nullptr;
+        RecordingStream* output_stream_ = nullptr;
+        std::chrono::steady_clock::time_point start_time_;
+
+        std::thread writer_thread_;
+        std::atomic<bool> writer_running_{ false };
+        std::atomic<uint64_t> bytes_written_{ 0 };
+        std::atomic<int64_t> max_write_us_{ 0 };
+
+        // Audio thread handshake (sequentially consistent, see BlockBoundary)
+        std::atomic<bool> recording_{ false };
+        BlockBoundary boundary_;
+
+        mutable std::mutex error_mutex_;
+        std::string last_error_;
+    };
+
+    // MultitrackRecorder public interface
+    MultitrackRecorder::MultitrackRecorder() : impl_(std::make_unique<Impl>()) {}
+    MultitrackRecorder::~MultitrackRecorder() = default;
+
+    bool MultitrackRecorder::initialize(int sample_rate, int num_inputs, int num_outputs) {
+        return impl_->initialize(sample_rate, num_inputs, num_outputs);
+    }
+
+    bool MultitrackRecorder::start_recording(const RecordingSettings& settings) {
+        return impl_->start_recording(settings);
+    }
+
+    void MultitrackRecorder::stop_recording() {
+        impl_->stop_recording();
+    }
+
+    bool MultitrackRecorder::is_recording() const {
+        return impl_->is_recording();
+    }
+
+    RecordingStatus MultitrackRecorder::get_status() const {
+        return impl_->get_status();
+    }
+
+    std::string MultitrackRecorder::get_last_error() const {
+        return impl_->get_last_error();
+    }
+
+    void MultitrackRecorder::process(const AudioBuffer& inputs, const AudioBuffer& outputs, int num_samples) {
+        impl_->process(inputs, outputs, num_samples);
+    }
+
+} // namespace SharedAudio
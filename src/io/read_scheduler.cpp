@@ -0,0 +1,554 @@
+﻿#include "io/read_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef SHARED_AUDIO_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        struct PendingRead {
+            ReadRequest request;
+            uint64_t sequence = 0;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        // Min-heap order: earliest deadline first, then submission order
+        struct LaterDeadline {
+            bool operator()(const PendingRead& a, const PendingRead& b) const {
+                if (a.request.deadline != b.request.deadline) {
+                    return a.request.deadline > b.request.deadline;
+                }
+                return a.sequence > b.sequence;
+            }
+        };
+
+#ifdef SHARED_AUDIO_HAS_IO_URING
+        // Minimal io_uring over the raw syscalls (no liburing dependency).
+        // One thread submits and another reaps, so the SQ and CQ each have
+        // a single owner.
+        class IoUring {
+        public:
+            ~IoUring() { close(); }
+
+            bool setup(unsigned entries, int& error) {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                if (ring_fd_ < 0) {
+                    error = errno;
+                    return false;
+                }
+
+                sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                single_mmap_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (single_mmap_) {
+                    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+                }
+
+                sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+                cq_ptr_ = single_mmap_ ? sq_ptr_
+                    : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+                sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+                void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+                if (sq_ptr_ == MAP_FAILED || cq_ptr_ == MAP_FAILED || sqes == MAP_FAILED) {
+                    error = errno;
+                    sqes_ = sqes == MAP_FAILED ? nullptr : static_cast<io_uring_sqe*>(sqes);
+                    close();
+                    return false;
+                }
+                sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+                auto* sq = static_cast<uint8_t*>(sq_ptr_);
+                sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                sq_entries_ = params.sq_entries;
+
+                auto* cq = static_cast<uint8_t*>(cq_ptr_);
+                cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                return true;
+            }
+
+            void close() {
+                if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+                if (cq_ptr_ != nullptr && cq_ptr_ != MAP_FAILED && !single_mmap_) munmap(cq_ptr_, cq_size_);
+                if (sq_ptr_ != nullptr && sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_size_);
+                if (ring_fd_ >= 0) ::close(ring_fd_);
+                sqes_ = nullptr;
+                sq_ptr_ = cq_ptr_ = nullptr;
+                ring_fd_ = -1;
+            }
+
+            // Submitting thread only. Queues one SQE; false when the SQ is
+            // full, in which case nothing was handed to the kernel. Once this
+            // returns true the kernel owns the SQE and its buffers until the
+            // matching CQE, even if flush() has not got it in yet.
+            bool queue(uint8_t opcode, int fd, const iovec* iov, uint64_t offset, uint64_t user_data) {
+                const unsigned tail = *sq_tail_;
+                if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+                    return false;
+                }
+
+                const unsigned index = tail & sq_mask_;
+                io_uring_sqe* sqe = &sqes_[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = opcode;
+                sqe->fd = fd;
+                sqe->addr = reinterpret_cast<uint64_t>(iov);
+                sqe->len = iov != nullptr ? 1 : 0;
+                sqe->off = offset;
+                sqe->user_data = user_data;
+                sq_array_[index] = index;
+                __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+                ++unsubmitted_;
+                return true;
+            }
+
+            // Submitting thread only. Tells the kernel about queued SQEs; on
+            // failure (EAGAIN/EBUSY under memory or CQ pressure) they stay in
+            // the SQ and the next flush() picks them up.
+            bool flush() {
+                while (unsubmitted_ > 0) {
+                    const int result = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_, 0, 0, nullptr, 0));
+                    if (result < 0) {
+                        if (errno == EINTR) continue;
+                        return false;
+                    }
+                    unsubmitted_ -= std::min(static_cast<unsigned>(result), unsubmitted_);
+                }
+                return true;
+            }
+
+            // Reaping thread only: waits up to timeout_ms for completions and
+            // hands each to the handler. Returns how many were reaped, -1 on
+            // error. poll() on the ring fd works on every io_uring kernel,
+            // unlike a timed io_uring_enter (5.11+).
+            template <typename Handler>
+            int wait(int timeout_ms, Handler&& handler) {
+                if (*cq_head_ == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                    pollfd ready{ ring_fd_, POLLIN, 0 };
+                    if (::poll(&ready, 1, timeout_ms) < 0 && errno != EINTR) {
+                        return -1;
+                    }
+                    // Non-blocking; moves completions parked on CQ overflow into the ring
+                    if (syscall(__NR_io_uring_enter, ring_fd_, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                        && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                        return -1;
+                    }
+                }
+
+                unsigned head = *cq_head_;
+                const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+                int reaped = 0;
+                while (head != tail) {
+                    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                    handler(cqe.user_data, cqe.res);
+                    ++head;
+                    ++reaped;
+                }
+                __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+                return reaped;
+            }
+
+        private:
+            int ring_fd_ = -1;
+            bool single_mmap_ = false;
+            void* sq_ptr_ = nullptr;
+            void* cq_ptr_ = nullptr;
+            size_t sq_size_ = 0;
+            size_t cq_size_ = 0;
+            size_t sqes_size_ = 0;
+            io_uring_sqe* sqes_ = nullptr;
+
+            unsigned unsubmitted_ = 0; // Published to the SQ, not yet entered
+
+            unsigned* sq_head_ = nullptr;
+            unsigned* sq_tail_ = nullptr;
+            unsigned* sq_array_ = nullptr;
+            unsigned sq_mask_ = 0;
+            unsigned sq_entries_ = 0;
+
+            unsigned* cq_head_ = nullptr;
+            unsigned* cq_tail_ = nullptr;
+            unsigned cq_mask_ = 0;
+            io_uring_cqe* cqes_ = nullptr;
+        };
+
+        constexpr uint64_t kStopToken = ~0ull;
+        constexpr int kReapPollMs = 50;
+        // After stop, the reaper gives up on reads that have not completed
+        // for this long and leaves them to the ring teardown
+        constexpr int kStopGraceMs = 2000;
+#endif
+
+    } // namespace
+
+    class ReadScheduler::Impl {
+    public:
+        ~Impl() {
+            stop();
+        }
+
+        bool start(const ReadSchedulerSettings& settings) {
+            std::lock_guard<std::mutex> control(control_mutex_);
+            if (running_) {
+                return true;
+            }
+
+            settings_ = settings;
+            settings_.queue_depth = std::max(1, settings_.queue_depth);
+            settings_.worker_threads = std::max(1, settings_.worker_threads);
+            running_ = true;
+
+#ifdef SHARED_AUDIO_HAS_IO_URING
+            if (settings_.prefer_io_uring) {
+                int error = 0;
+                if (ring_.setup(static_cast<unsigned>(settings_.queue_depth), error)) {
+                    backend_ = ReadBackend::IO_URING;
+                    uring_stopping_.store(false, std::memory_order_relaxed);
+                    slots_.assign(settings_.queue_depth, Slot());
+                    free_slots_.clear();
+                    for (int i = settings_.queue_depth - 1; i >= 0; --i) {
+                        free_slots_.push_back(i);
+                    }
+                    threads_.emplace_back(&Impl::uring_submit_loop, this);
+                    threads_.emplace_back(&Impl::uring_reap_loop, this);
+                    std::cout << "[IO] Read scheduler using io_uring (depth " << settings_.queue_depth << ")" << std::endl;
+                    return true;
+                }
+                std::cout << "[IO] io_uring unavailable (" << std::strerror(error) << "), using thread pool" << std::endl;
+            }
+#endif
+
+            backend_ = ReadBackend::THREAD_POOL;
+            for (int i = 0; i < settings_.worker_threads; ++i) {
+                threads_.emplace_back(&Impl::pool_loop, this);
+            }
+            std::cout << "[IO] Read scheduler using " << settings_.worker_threads << " reader threads" << std::endl;
+            return true;
+        }
+
+        void stop() {
+            std::lock_guard<std::mutex> control(control_mutex_);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_) {
+                    return;
+                }
+                running_ = false;
+            }
+            cv_.notify_all();
+
+#ifdef SHARED_AUDIO_HAS_IO_URING
+            if (backend_ == ReadBackend::IO_URING) {
+                // Submitter first, then wake the reaper once the SQ is ours.
+                // The reaper polls with a timeout, so it sees the flag even
+                // if the stop NOP never makes it in.
+                uring_stopping_.store(true, std::memory_order_release);
+                threads_[0].join();
+
+                // Enter whatever the submitter queued but could not, then the
+                // stop NOP; a full SQ has room again once the kernel took those
+                flush_uring(false);
+                for (int attempt = 0; attempt < 100 && !ring_.queue(IORING_OP_NOP, -1, nullptr, 0, kStopToken); ++attempt) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    flush_uring(false);
+                }
+                flush_uring(false);
+                threads_[1].join();
+                ring_.close();
+                threads_.clear();
+
+                // Only if the reaper gave up: the closed ring cancelled these
+                for (size_t i = 0; i < slots_.size(); ++i) {
+                    if (slots_[i].busy) finish_slot(static_cast<int>(i), -1);
+                }
+            }
+#endif
+            for (auto& thread : threads_) {
+                thread.join();
+            }
+            threads_.clear();
+
+            // Nobody will serve what is still queued; let the owners move on
+            std::vector<PendingRead> abandoned;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                abandoned.swap(pending_);
+            }
+            for (auto& read : abandoned) {
+                if (read.request.on_complete) read.request.on_complete(-1);
+            }
+        }
+
+        bool is_running() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return running_;
+        }
+
+        ReadBackend get_backend() const {
+            return backend_;
+        }
+
+        void submit(ReadRequest request) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (running_) {
+                    PendingRead read;
+                    read.request = std::move(request);
+                    read.sequence = next_sequence_++;
+                    read.submitted = std::chrono::steady_clock::now();
+                    pending_.push_back(std::move(read));
+                    std::push_heap(pending_.begin(), pending_.end(), LaterDeadline());
+                    cv_.notify_one();
+                    return;
+                }
+            }
+            if (request.on_complete) request.on_complete(-1);
+        }
+
+        ReadSchedulerStats get_stats() const {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            return stats_;
+        }
+
+        void reset_stats() {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_ = ReadSchedulerStats();
+        }
+
+    private:
+        // Caller holds mutex_
+        PendingRead pop_earliest() {
+            std::pop_heap(pending_.begin(), pending_.end(), LaterDeadline());
+            PendingRead read = std::move(pending_.back());
+            pending_.pop_back();
+            ++in_flight_;
+            std::lock_guard<std::mutex> stats(stats_mutex_);
+            stats_.max_in_flight = std::max(stats_.max_in_flight, in_flight_);
+            return read;
+        }
+
+        void complete(PendingRead& read, int64_t result) {
+            const auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                if (result >= 0) {
+                    stats_.completed++;
+                    stats_.bytes_read += static_cast<uint64_t>(result);
+                }
+                else {
+                    stats_.failed++;
+                }
+                if (now > read.request.deadline) {
+                    stats_.missed_deadlines++;
+                }
+                stats_.max_latency_ms = std::max(stats_.max_latency_ms,
+                    std::chrono::duration<double, std::milli>(now - read.submitted).count());
+            }
+
+            if (read.request.on_complete) {
+                read.request.on_complete(result);
+            }
+        }
+
+        void pool_loop() {
+            while (true) {
+                PendingRead read;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+                    if (!running_) {
+                        return;
+                    }
+                    read = pop_earliest();
+                }
+
+                const int64_t result = read.request.file->read_at(read.request.offset, read.request.buffer, read.request.bytes);
+                complete(read, result);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                --in_flight_;
+            }
+        }
+
+#ifdef SHARED_AUDIO_HAS_IO_URING
+        struct Slot {
+            PendingRead read;
+            iovec iov{};
+            bool busy = false; // Between queue() and its CQE (or teardown)
+        };
+
+        // Enter failures are transient (EAGAIN/EBUSY); back off and retry,
+        // since the queued SQEs and their slots already belong to the kernel.
+        // While running, gives up on stop and leaves the rest to stop().
+        bool flush_uring(bool while_running) {
+            while (!ring_.flush()) {
+                if (while_running && !is_running()) {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+        void uring_submit_loop() {
+            while (true) {
+                int slot_index;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this] { return !running_ || (!pending_.empty() && !free_slots_.empty()); });
+                    if (!running_) {
+                        return;
+                    }
+                    slot_index = free_slots_.back();
+                    free_slots_.pop_back();
+                    slots_[slot_index].read = pop_earliest();
+                }
+
+                Slot& slot = slots_[slot_index];
+                slot.iov.iov_base = slot.read.request.buffer;
+                slot.iov.iov_len = slot.read.request.bytes;
+                slot.busy = true;
+                if (!ring_.queue(IORING_OP_READV, slot.read.request.file->get_native_handle(), &slot.iov,
+                    slot.read.request.offset, static_cast<uint64_t>(slot_index))) {
+                    finish_slot(slot_index, -1); // Never reached the kernel
+                    continue;
+                }
+                flush_uring(true);
+            }
+        }
+
+        void uring_reap_loop() {
+            auto last_progress = std::chrono::steady_clock::now();
+            bool stopping = false;
+            while (true) {
+                const int reaped = ring_.wait(kReapPollMs, [&](uint64_t user_data, int32_t result) {
+                    if (user_data != kStopToken) {
+                        finish_slot(static_cast<int>(user_data), result);
+                    }
+                });
+                if (reaped < 0) {
+                    break;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                if (reaped > 0) {
+                    last_progress = now;
+                }
+                if (uring_stopping_.load(std::memory_order_acquire)) {
+                    if (!stopping) {
+                        stopping = true;
+                        last_progress = now; // The grace period starts at stop
+                    }
+                    if (outstanding() == 0) {
+                        break;
+                    }
+                    if (now - last_progress > std::chrono::milliseconds(kStopGraceMs)) {
+                        std::cout << "[IO] " << outstanding() << " io_uring reads still pending at stop, cancelling" << std::endl;
+                        break;
+                    }
+                }
+            }
+        }
+
+        void finish_slot(int slot_index, int64_t result) {
+            complete(slots_[slot_index].read, result);
+            slots_[slot_index].read = PendingRead();
+            slots_[slot_index].busy = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                free_slots_.push_back(slot_index);
+                --in_flight_;
+            }
+            cv_.notify_all();
+        }
+
+        int outstanding() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return in_flight_;
+        }
+
+        IoUring ring_;
+        std::atomic<bool> uring_stopping_{ false };
+        std::vector<Slot> slots_;
+        std::vector<int> free_slots_;
+#endif
+
+        ReadSchedulerSettings settings_;
+        ReadBackend backend_ = ReadBackend::THREAD_POOL;
+        std::vector<std::thread> threads_;
+        std::mutex control_mutex_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<PendingRead> pending_; // Heap ordered by LaterDeadline
+        uint64_t next_sequence_ = 0;
+        int in_flight_ = 0;
+        bool running_ = false;
+
+        mutable std::mutex stats_mutex_;
+        ReadSchedulerStats stats_;
+    };
+
+    // ReadScheduler public interface
+    ReadScheduler::ReadScheduler() : impl_(std::make_unique<Impl>()) {}
+    ReadScheduler::~ReadScheduler() = default;
+
+    bool ReadScheduler::start(const ReadSchedulerSettings& settings) {
+        return impl_->start(settings);
+    }
+
+    void ReadScheduler::stop() {
+        impl_->stop();
+    }
+
+    bool ReadScheduler::is_running() const {
+        return impl_->is_running();
+    }
+
+    ReadBackend ReadScheduler::get_backend() const {
+        return impl_->get_backend();
+    }
+
+    const char* ReadScheduler::get_backend_name() const {
+        return impl_->get_backend() == ReadBackend::IO_URING ? "io_uring" : "thread_pool";
+    }
+
+    void ReadScheduler::submit(ReadRequest request) {
+        impl_->submit(std::move(request));
+    }
+
+    ReadSchedulerStats ReadScheduler::get_stats() const {
+        return impl_->get_stats();
+    }
+
+    void ReadScheduler::reset_stats() {
+        impl_->reset_stats();
+    }
+
+} // namespace SharedAudio
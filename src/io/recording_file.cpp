@@ -0,0 +1,520 @@
+﻿#include "io/recording_file.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SharedAudio {
+
+    // AlignedBuffer implementation
+    AlignedBuffer::~AlignedBuffer() {
+        release();
+    }
+
+    AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    bool AlignedBuffer::allocate(size_t bytes, size_t alignment) {
+        release();
+        const size_t rounded = (std::max<size_t>(bytes, 1) + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+        data_ = static_cast<uint8_t*>(_aligned_malloc(rounded, alignment));
+#else
+        void* ptr = nullptr;
+        data_ = posix_memalign(&ptr, alignment, rounded) == 0 ? static_cast<uint8_t*>(ptr) : nullptr;
+#endif
+        if (data_ == nullptr) {
+            return false;
+        }
+        std::memset(data_, 0, rounded);
+        size_ = rounded;
+        return true;
+    }
+
+    void AlignedBuffer::release() {
+#ifdef _WIN32
+        _aligned_free(data_);
+#else
+        std::free(data_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // RecordingFile implementation
+    RecordingFile::~RecordingFile() {
+        close();
+    }
+
+#ifdef _WIN32
+    bool RecordingFile::open_for_write(const std::string& path) {
+        close();
+        handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return is_open();
+    }
+
+    bool RecordingFile::open_for_read(const std::string& path, bool direct_io) {
+        close();
+        const DWORD flags = FILE_ATTRIBUTE_NORMAL | (direct_io ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN);
+        handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            OPEN_EXISTING, flags, nullptr);
+        direct_io_ = direct_io && is_open();
+        return is_open();
+    }
+
+    bool RecordingFile::is_open() const {
+        return handle_ != INVALID_HANDLE_VALUE;
+    }
+
+    void RecordingFile::close() {
+        if (is_open()) {
+            CloseHandle(handle_);
+            handle_ = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    bool RecordingFile::preallocate(uint64_t bytes) {
+        return truncate(bytes);
+    }
+
+    bool RecordingFile::truncate(uint64_t bytes) {
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(bytes);
+        return SetFilePointerEx(handle_, size, nullptr, FILE_BEGIN) && SetEndOfFile(handle_);
+    }
+
+    bool RecordingFile::write_at(uint64_t offset, const void* data, size_t bytes) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xffffffffu);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        return WriteFile(handle_, data, static_cast<DWORD>(bytes), &written, &overlapped) && written == bytes;
+    }
+
+    int64_t RecordingFile::read_at(uint64_t offset, void* data, size_t bytes) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xffffffffu);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        if (!ReadFile(handle_, data, static_cast<DWORD>(bytes), &read, &overlapped)) {
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+        return static_cast<int64_t>(read);
+    }
+
+    uint64_t RecordingFile::get_size() const {
+        LARGE_INTEGER size;
+        return GetFileSizeEx(handle_, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+    }
+#else
+    bool RecordingFile::open_for_write(const std::string& path) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        return is_open();
+    }
+
+    bool RecordingFile::open_for_read(const std::string& path, bool direct_io) {
+        close();
+        direct_io_ = false;
+#ifdef __linux__
+        if (direct_io) {
+            fd_ = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+            direct_io_ = fd_ >= 0;
+        }
+        if (fd_ < 0) {
+            fd_ = ::open(path.c_str(), O_RDONLY);
+            if (fd_ >= 0) {
+                posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+#ifdef __APPLE__
+        if (fd_ >= 0 && direct_io) {
+            direct_io_ = fcntl(fd_, F_NOCACHE, 1) == 0;
+        }
+#endif
+#endif
+        return is_open();
+    }
+
+    bool RecordingFile::is_open() const {
+        return fd_ >= 0;
+    }
+
+    void RecordingFile::close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool RecordingFile::preallocate(uint64_t bytes) {
+#ifdef __linux__
+        return posix_fallocate(fd_, 0, static_cast<off_t>(bytes)) == 0;
+#else
+        return ftruncate(fd_, static_cast<off_t>(bytes)) == 0;
+#endif
+    }
+
+    bool RecordingFile::truncate(uint64_t bytes) {
+        return ftruncate(fd_, static_cast<off_t>(bytes)) == 0;
+    }
+
+    bool RecordingFile::write_at(uint64_t offset, const void* data, size_t bytes) {
+        const auto* ptr = static_cast<const uint8_t*>(data);
+        while (bytes > 0) {
+            const ssize_t written = pwrite(fd_, ptr, bytes, static_cast<off_t>(offset));
+            if (written <= 0) {
+                return false;
+            }
+            ptr += written;
+            offset += static_cast<uint64_t>(written);
+            bytes -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    int64_t RecordingFile::read_at(uint64_t offset, void* data, size_t bytes) {
+        auto* ptr = static_cast<uint8_t*>(data);
+        size_t total = 0;
+        while (total < bytes) {
+            const ssize_t count = pread(fd_, ptr + total, bytes - total, static_cast<off_t>(offset + total));
+            if (count < 0) {
+                return -1;
+            }
+            if (count == 0) {
+                break; // End of file
+            }
+            total += static_cast<size_t>(count);
+        }
+        return static_cast<int64_t>(total);
+    }
+
+    uint64_t RecordingFile::get_size() const {
+        struct stat st;
+        return fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    }
+#endif
+
+    namespace {
+
+        // Little/big-endian header writer
+        struct HeaderWriter {
+            uint8_t* data;
+            size_t pos = 0;
+
+            void bytes(const void* src, size_t n) { std::memcpy(data + pos, src, n); pos += n; }
+            void tag(const char* t) { bytes(t, 4); }
+            void le16(uint16_t v) { for (int i = 0; i < 2; ++i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void le32(uint32_t v) { for (int i = 0; i < 4; ++i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void le64(uint64_t v) { for (int i = 0; i < 8; ++i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void be16(uint16_t v) { for (int i = 1; i >= 0; --i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void be32(uint32_t v) { for (int i = 3; i >= 0; --i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void be64(uint64_t v) { for (int i = 7; i >= 0; --i) data[pos++] = static_cast<uint8_t>(v >> (8 * i)); }
+            void skip_to(size_t offset) { std::memset(data + pos, 0, offset - pos); pos = offset; }
+        };
+
+        uint16_t read_le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+        uint32_t read_le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+        uint64_t read_le64(const uint8_t* p) { return read_le32(p) | (static_cast<uint64_t>(read_le32(p + 4)) << 32); }
+        uint32_t read_be32(const uint8_t* p) { return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+        uint64_t read_be64(const uint8_t* p) { return (static_cast<uint64_t>(read_be32(p)) << 32) | read_be32(p + 4); }
+
+        const uint8_t kPcmSubFormat[16] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        const uint8_t kFloatSubFormat[16] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        const uint8_t kW64Riff[16] = { 'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+        const uint8_t kW64Wave[16] = { 'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+        const uint8_t kW64Fmt[16] = { 'f', 'm', 't', ' ', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+        const uint8_t kW64Junk[16] = { 'j', 'u', 'n', 'k', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+        const uint8_t kW64Data[16] = { 'd', 'a', 't', 'a', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+
+        // WAVE_FORMAT_EXTENSIBLE body (40 bytes), shared by WAV and W64
+        void write_wave_format(HeaderWriter& w, int num_channels, int sample_rate, int bytes_per_sample, bool is_float) {
+            const uint16_t block_align = static_cast<uint16_t>(num_channels * bytes_per_sample);
+            w.le16(0xFFFE);
+            w.le16(static_cast<uint16_t>(num_channels));
+            w.le32(static_cast<uint32_t>(sample_rate));
+            w.le32(static_cast<uint32_t>(sample_rate) * block_align);
+            w.le16(block_align);
+            w.le16(static_cast<uint16_t>(bytes_per_sample * 8));
+            w.le16(22);
+            w.le16(static_cast<uint16_t>(bytes_per_sample * 8));
+            w.le32(0); // No speaker assignment, these are tracks
+            w.bytes(is_float ? kFloatSubFormat : kPcmSubFormat, 16);
+        }
+
+        // WAVEFORMAT(EXTENSIBLE) body shared by WAV and W64
+        bool parse_wave_format(const uint8_t* fmt, size_t size, RecordingFileInfo& info) {
+            if (size < 16) {
+                return false;
+            }
+
+            uint16_t tag = read_le16(fmt);
+            info.num_channels = read_le16(fmt + 2);
+            info.sample_rate = static_cast<int>(read_le32(fmt + 4));
+            info.bytes_per_sample = read_le16(fmt + 14) / 8;
+            if (tag == 0xFFFE && size >= 40) {
+                tag = read_le16(fmt + 24);
+            }
+            info.is_float = tag == 3;
+            return tag == 1 || tag == 3;
+        }
+
+        bool parse_wav(RecordingFile& file, bool rf64, RecordingFileInfo& info) {
+            const uint64_t file_size = file.get_size();
+            uint64_t ds64_data_bytes = 0;
+            bool have_format = false;
+            uint64_t pos = 12;
+
+            while (pos + 8 <= file_size) {
+                uint8_t chunk[8];
+                if (file.read_at(pos, chunk, 8) != 8) {
+                    return false;
+                }
+                const uint32_t size = read_le32(chunk + 4);
+
+                if (std::memcmp(chunk, "ds64", 4) == 0) {
+                    uint8_t ds64[16];
+                    if (file.read_at(pos + 8, ds64, 16) != 16) return false;
+                    ds64_data_bytes = read_le64(ds64 + 8);
+                }
+                else if (std::memcmp(chunk, "fmt ", 4) == 0) {
+                    uint8_t fmt[40] = {};
+                    const size_t fmt_size = std::min<size_t>(size, sizeof(fmt));
+                    if (file.read_at(pos + 8, fmt, fmt_size) != static_cast<int64_t>(fmt_size)) return false;
+                    have_format = parse_wave_format(fmt, fmt_size, info);
+                }
+                else if (std::memcmp(chunk, "data", 4) == 0) {
+                    info.format = RecordingFileFormat::WAV;
+                    info.data_offset = pos + 8;
+                    info.data_bytes = (rf64 && size == 0xFFFFFFFFu) ? ds64_data_bytes : size;
+                    return have_format;
+                }
+
+                pos += 8 + static_cast<uint64_t>(size) + (size & 1);
+            }
+            return false;
+        }
+
+        bool parse_w64(RecordingFile& file, RecordingFileInfo& info) {
+            const uint64_t file_size = file.get_size();
+            bool have_format = false;
+            uint64_t pos = 40;
+
+            while (pos + 24 <= file_size) {
+                uint8_t chunk[24];
+                if (file.read_at(pos, chunk, 24) != 24) {
+                    return false;
+                }
+                const uint64_t size = read_le64(chunk + 16); // Includes the 24-byte header
+                if (size < 24) {
+                    return false;
+                }
+
+                if (std::memcmp(chunk, kW64Fmt, 16) == 0) {
+                    uint8_t fmt[40] = {};
+                    const size_t fmt_size = static_cast<size_t>(std::min<uint64_t>(size - 24, sizeof(fmt)));
+                    if (file.read_at(pos + 24, fmt, fmt_size) != static_cast<int64_t>(fmt_size)) return false;
+                    have_format = parse_wave_format(fmt, fmt_size, info);
+                }
+                else if (std::memcmp(chunk, kW64Data, 16) == 0) {
+                    info.format = RecordingFileFormat::W64;
+                    info.data_offset = pos + 24;
+                    info.data_bytes = size - 24;
+                    return have_format;
+                }
+
+                pos += (size + 7) & ~static_cast<uint64_t>(7);
+            }
+            return false;
+        }
+
+        bool parse_caf(RecordingFile& file, RecordingFileInfo& info, std::string& error) {
+            const uint64_t file_size = file.get_size();
+            bool have_format = false;
+            uint64_t pos = 8;
+
+            while (pos + 12 <= file_size) {
+                uint8_t chunk[12];
+                if (file.read_at(pos, chunk, 12) != 12) {
+                    return false;
+                }
+                const uint64_t size = read_be64(chunk + 4);
+
+                if (std::memcmp(chunk, "desc", 4) == 0) {
+                    uint8_t desc[32];
+                    if (file.read_at(pos + 12, desc, 32) != 32) return false;
+                    uint64_t rate_bits = read_be64(desc);
+                    double rate;
+                    std::memcpy(&rate, &rate_bits, sizeof(rate));
+                    const uint32_t flags = read_be32(desc + 12);
+                    info.sample_rate = static_cast<int>(rate + 0.5);
+                    info.num_channels = static_cast<int>(read_be32(desc + 24));
+                    info.bytes_per_sample = static_cast<int>(read_be32(desc + 28)) / 8;
+                    info.is_float = (flags & 1u) != 0;
+                    if (std::memcmp(desc + 8, "lpcm", 4) != 0 || (flags & 2u) == 0) {
+                        error = "Only little-endian linear PCM CAF files are supported";
+                        return false;
+                    }
+                    have_format = true;
+                }
+                else if (std::memcmp(chunk, "data", 4) == 0) {
+                    info.format = RecordingFileFormat::CAF;
+                    info.data_offset = pos + 16; // Skip the edit count
+                    // -1 means the writer never finished: the data runs to the end of the file
+                    info.data_bytes = size == 0xFFFFFFFFFFFFFFFFull ? file_size - info.data_offset : size - 4;
+                    return have_format;
+                }
+
+                pos += 12 + size;
+            }
+            return false;
+        }
+
+    } // namespace
+
+    void build_recording_header(uint8_t* header, RecordingFileFormat format, int num_channels,
+        int sample_rate, int bytes_per_sample, bool is_float, uint64_t data_bytes, bool finished) {
+        // Padding chunks are sized so the sample data starts exactly at kRecordingHeaderBytes
+        HeaderWriter w{ header };
+        const uint64_t file_bytes = kRecordingHeaderBytes + data_bytes;
+
+        switch (format) {
+        case RecordingFileFormat::WAV: {
+            const bool rf64 = file_bytes - 8 > 0xFFFFFFFFull;
+            w.tag(rf64 ? "RF64" : "RIFF");
+            w.le32(rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(file_bytes - 8));
+            w.tag("WAVE");
+            if (rf64) {
+                // ds64 takes the front of the reserved JUNK space
+                w.tag("ds64");
+                w.le32(28);
+                w.le64(file_bytes - 8);
+                w.le64(data_bytes);
+                w.le64(data_bytes / (static_cast<uint64_t>(num_channels) * bytes_per_sample));
+                w.le32(0);
+                w.tag("JUNK");
+                w.le32(4020 - 36);
+            }
+            else {
+                w.tag("JUNK");
+                w.le32(4020);
+            }
+            w.skip_to(12 + 8 + 4020);
+            w.tag("fmt ");
+            w.le32(40);
+            write_wave_format(w, num_channels, sample_rate, bytes_per_sample, is_float);
+            w.tag("data");
+            w.le32(rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(data_bytes));
+            break;
+        }
+
+        case RecordingFileFormat::W64:
+            w.bytes(kW64Riff, 16);
+            w.le64(file_bytes);
+            w.bytes(kW64Wave, 16);
+            w.bytes(kW64Fmt, 16);
+            w.le64(24 + 40);
+            write_wave_format(w, num_channels, sample_rate, bytes_per_sample, is_float);
+            w.bytes(kW64Junk, 16);
+            w.le64(kRecordingHeaderBytes - 24 - w.pos + 16);
+            w.skip_to(kRecordingHeaderBytes - 24);
+            w.bytes(kW64Data, 16);
+            w.le64(24 + data_bytes);
+            break;
+
+        case RecordingFileFormat::CAF: {
+            w.tag("caff");
+            w.be16(1);
+            w.be16(0);
+            w.tag("desc");
+            w.be64(32);
+            uint64_t rate_bits;
+            const double rate = static_cast<double>(sample_rate);
+            std::memcpy(&rate_bits, &rate, sizeof(rate_bits));
+            w.be64(rate_bits);
+            w.tag("lpcm");
+            w.be32((is_float ? 1u : 0u) | 2u); // IsFloat | IsLittleEndian
+            w.be32(static_cast<uint32_t>(num_channels * bytes_per_sample));
+            w.be32(1);
+            w.be32(static_cast<uint32_t>(num_channels));
+            w.be32(static_cast<uint32_t>(bytes_per_sample * 8));
+            w.tag("free");
+            w.be64(kRecordingHeaderBytes - 16 - (w.pos + 8)); // Body runs up to the data chunk
+            w.skip_to(kRecordingHeaderBytes - 16);
+            w.tag("data");
+            // -1 marks a file that is still being written (readable after a crash)
+            w.be64(finished ? data_bytes + 4 : 0xFFFFFFFFFFFFFFFFull);
+            w.be32(0); // Edit count
+            break;
+        }
+        }
+    }
+
+    bool parse_recording_header(RecordingFile& file, RecordingFileInfo& info, std::string& error) {
+        uint8_t magic[16];
+        if (file.read_at(0, magic, sizeof(magic)) != static_cast<int64_t>(sizeof(magic))) {
+            error = "File too short";
+            return false;
+        }
+
+        bool ok = false;
+        if ((std::memcmp(magic, "RIFF", 4) == 0 || std::memcmp(magic, "RF64", 4) == 0)
+            && std::memcmp(magic + 8, "WAVE", 4) == 0) {
+            ok = parse_wav(file, std::memcmp(magic, "RF64", 4) == 0, info);
+        }
+        else if (std::memcmp(magic, kW64Riff, 16) == 0) {
+            ok = parse_w64(file, info);
+        }
+        else if (std::memcmp(magic, "caff", 4) == 0) {
+            ok = parse_caf(file, info, error);
+        }
+        else {
+            error = "Unknown file format";
+            return false;
+        }
+
+        if (!ok) {
+            if (error.empty()) error = "Malformed or unsupported header";
+            return false;
+        }
+
+        const bool supported_depth = info.is_float ? info.bytes_per_sample == 4
+            : (info.bytes_per_sample == 2 || info.bytes_per_sample == 3);
+        if (info.num_channels <= 0 || info.sample_rate <= 0 || !supported_depth) {
+            error = "Unsupported sample format";
+            return false;
+        }
+
+        // Headers of an interrupted recording may lag behind (or, once
+        // preallocated, run ahead of) the data actually on disk
+        const uint64_t file_size = file.get_size();
+        info.data_bytes = std::min(info.data_bytes, file_size > info.data_offset ? file_size - info.data_offset : 0);
+        const uint64_t frame_bytes = static_cast<uint64_t>(info.num_channels) * info.bytes_per_sample;
+        info.num_frames = info.data_bytes / frame_bytes;
+        return true;
+    }
+
+} // namespace SharedAudio
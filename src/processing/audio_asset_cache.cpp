@@ -0,0 +1,368 @@
+﻿#include "processing/audio_asset_cache.h"
+#include "core/loader_thread_pool.h"
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace SharedAudio {
+
+    class AudioAssetCache::Impl {
+    public:
+        bool initialize(int sample_rate, int num_loader_threads) {
+            sample_rate_ = sample_rate;
+            format_manager_.registerBasicFormats();
+            loader_pool_.start(num_loader_threads);
+            std::cout << "[CACHE] Audio asset cache initialized" << std::endl;
+            return true;
+        }
+
+        void shutdown() {
+            loader_pool_.stop();
+            std::lock_guard<std::mutex> lock(mutex_);
+            assets_.clear();
+        }
+
+        std::shared_ptr<const AudioAsset> load(const std::string& file_path) {
+            std::promise<std::shared_ptr<const AudioAsset>> promise;
+            PendingAsset pending;
+            bool is_loader = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = assets_.find(file_path);
+                if (it != assets_.end()) {
+                    pending = it->second;
+                }
+                else {
+                    pending = promise.get_future().share();
+                    assets_[file_path] = pending;
+                    is_loader = true;
+                }
+            }
+
+            if (!is_loader) {
+                return pending.get();
+            }
+
+            auto asset = decode_and_analyze(file_path);
+            promise.set_value(asset);
+
+            if (!asset) {
+                // Failed loads are not cached, the file may appear later
+                std::lock_guard<std::mutex> lock(mutex_);
+                assets_.erase(file_path);
+            }
+            return asset;
+        }
+
+        void load_async(const std::string& file_path, LoadCallback callback) {
+            loader_pool_.submit([this, file_path, callback]() {
+                auto asset = load(file_path);
+                if (callback) {
+                    callback(asset);
+                }
+            });
+        }
+
+        std::shared_ptr<const AudioAsset> find(const std::string& file_path) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = assets_.find(file_path);
+            if (it == assets_.end() || !is_ready(it->second)) {
+                return nullptr;
+            }
+            return it->second.get();
+        }
+
+        int purge_unused() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            int purged = 0;
+            for (auto it = assets_.begin(); it != assets_.end();) {
+                // The cache's own future holds the only reference
+                if (is_ready(it->second) && it->second.get().use_count() <= 1) {
+                    it = assets_.erase(it);
+                    ++purged;
+                }
+                else {
+                    ++it;
+                }
+            }
+
+            // Purged assets leave holes in the arena - close them up off the
+            // caller's thread once a whole slab could be given back
+            if (purged > 0 && arena_->should_compact() && !compaction_queued_->exchange(true)) {
+                auto arena = arena_;
+                auto queued = compaction_queued_;
+                loader_pool_.submit([arena, queued]() {
+                    const size_t moved = arena->compact();
+                    queued->store(false);
+                    std::cout << "[CACHE] Compacted sample arena (" << (moved >> 20) << " MiB moved)" << std::endl;
+                });
+            }
+            return purged;
+        }
+
+        int get_num_assets() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return static_cast<int>(assets_.size());
+        }
+
+        size_t get_memory_bytes() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t bytes = 0;
+            for (const auto& [path, pending] : assets_) {
+                if (!is_ready(pending)) continue;
+                auto asset = pending.get();
+                if (!asset) continue;
+                bytes += asset->metadata.memory_bytes;
+            }
+            return bytes;
+        }
+
+        std::vector<size_t> get_memory_bytes_by_format() const {
+            std::vector<size_t> bytes(kNumSampleFormats, 0);
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& [path, pending] : assets_) {
+                if (!is_ready(pending)) continue;
+                auto asset = pending.get();
+                if (!asset) continue;
+                bytes[static_cast<size_t>(asset->metadata.storage_format)] += asset->metadata.memory_bytes;
+            }
+            return bytes;
+        }
+
+        void set_storage_policy(SampleStoragePolicy policy) {
+            storage_policy_.store(policy);
+        }
+
+        SampleStoragePolicy get_storage_policy() const {
+            return storage_policy_.load();
+        }
+
+        LoaderThreadPool* get_loader_pool() {
+            return &loader_pool_;
+        }
+
+        SampleArena* get_arena() {
+            return arena_.get();
+        }
+
+        std::string get_last_error() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return last_error_;
+        }
+
+    private:
+        using PendingAsset = std::shared_future<std::shared_ptr<const AudioAsset>>;
+
+        static bool is_ready(const PendingAsset& pending) {
+            return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        std::shared_ptr<const AudioAsset> decode_and_analyze(const std::string& file_path) {
+            auto asset = std::make_shared<AudioAsset>();
+            asset->metadata.file_path = file_path;
+
+            // Analysis runs on the float decode, which is then dropped for the compact copy
+            AudioBuffer decoded;
+            if (!decode_file(file_path, asset->metadata, decoded)) {
+                return nullptr;
+            }
+
+            auto& metadata = asset->metadata;
+            metadata.num_channels = static_cast<int>(decoded.size());
+            metadata.num_frames = decoded.empty() ? 0 : decoded[0].size();
+            metadata.duration_seconds = metadata.sample_rate > 0
+                ? static_cast<double>(metadata.num_frames) / metadata.sample_rate : 0.0;
+
+            metadata.loudness = analyze_loudness(decoded, metadata.sample_rate, &loader_pool_);
+            asset->waveform.build(decoded, &loader_pool_);
+            asset->activity.build(decoded);
+
+            const SampleStoragePolicy policy = storage_policy_.load();
+            encode_channels(*asset, decoded, choose_sample_format(decoded, policy));
+            if (metadata.storage_format == SampleFormat::COMPRESSED) {
+                // Noise-like material can code larger than plain PCM, keep whichever is smaller
+                const SampleFormat plain = choose_sample_format(decoded, SampleStoragePolicy::LOSSLESS);
+                if (metadata.memory_bytes >= metadata.num_frames * metadata.num_channels * sample_format_bytes(plain)) {
+                    encode_channels(*asset, decoded, plain);
+                }
+            }
+
+            std::cout << "[CACHE] Loaded " << file_path << " (" << metadata.num_channels << " ch, "
+                << metadata.duration_seconds << "s, " << metadata.loudness.integrated_lufs << " LUFS, "
+                << sample_format_name(metadata.storage_format) << ", "
+                << metadata.memory_bytes / 1024 << " KiB)" << std::endl;
+            return asset;
+        }
+
+        void encode_channels(AudioAsset& asset, const AudioBuffer& decoded, SampleFormat format) {
+            asset.metadata.storage_format = format;
+            asset.metadata.memory_bytes = 0;
+            asset.channels.clear();
+            asset.channels.resize(decoded.size());
+            for (size_t ch = 0; ch < decoded.size(); ++ch) {
+                asset.channels[ch].encode(decoded[ch].data(), decoded[ch].size(), format, arena_);
+                asset.metadata.memory_bytes += asset.channels[ch].get_memory_bytes();
+            }
+        }
+
+        bool decode_file(const std::string& file_path, AudioAssetMetadata& metadata, AudioBuffer& channels) {
+            juce::File file = juce::File::getCurrentWorkingDirectory().getChildFile(juce::String(file_path));
+            if (!file.existsAsFile()) {
+                // Show files that are not on this machine still get a placeholder
+                // tone so cue lists can be built and rehearsed
+                generate_test_tone(file_path, metadata, channels);
+                return true;
+            }
+
+            std::unique_ptr<juce::AudioFormatReader> reader(format_manager_.createReaderFor(file));
+            if (!reader) {
+                set_error("Unsupported audio file: " + file_path);
+                return false;
+            }
+
+            const int num_channels = static_cast<int>(reader->numChannels);
+            const juce::int64 num_frames = reader->lengthInSamples;
+            metadata.sample_rate = static_cast<int>(reader->sampleRate);
+            channels.assign(num_channels, std::vector<float>(static_cast<size_t>(num_frames), 0.0f));
+
+            constexpr int kChunkFrames = 65536;
+            std::vector<float*> channel_ptrs(num_channels);
+            for (juce::int64 pos = 0; pos < num_frames; pos += kChunkFrames) {
+                const int count = static_cast<int>(std::min<juce::int64>(kChunkFrames, num_frames - pos));
+                for (int ch = 0; ch < num_channels; ++ch) {
+                    channel_ptrs[ch] = channels[ch].data() + pos;
+                }
+                if (!reader->read(channel_ptrs.data(), num_channels, pos, count)) {
+                    set_error("Failed to decode audio file: " + file_path);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void generate_test_tone(const std::string& file_path, AudioAssetMetadata& metadata, AudioBuffer& channels) {
+            const size_t num_frames = static_cast<size_t>(sample_rate_) * 10; // 10 seconds
+            metadata.sample_rate = sample_rate_;
+            channels.assign(2, std::vector<float>(num_frames, 0.0f));
+
+            float frequency = 440.0f; // Default A4
+            if (file_path.find("880") != std::string::npos) frequency = 880.0f;
+            if (file_path.find("220") != std::string::npos) frequency = 220.0f;
+            if (file_path.find("background") != std::string::npos) frequency = 110.0f;
+
+            for (size_t i = 0; i < num_frames; ++i) {
+                float t = static_cast<float>(i) / sample_rate_;
+                float sample = 0.3f * std::sin(2.0f * static_cast<float>(M_PI) * frequency * t);
+
+                // Add some envelope to prevent clicks
+                if (i < 1000) sample *= static_cast<float>(i) / 1000.0f;
+                if (i > num_frames - 1000) {
+                    sample *= static_cast<float>(num_frames - i) / 1000.0f;
+                }
+
+                channels[0][i] = sample;
+                channels[1][i] = sample;
+            }
+
+            std::cout << "[LOAD] File not found, generated " << frequency << "Hz test tone: " << file_path << std::endl;
+        }
+
+        void set_error(const std::string& error) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last_error_ = error;
+            std::cout << "[CACHE] " << error << std::endl;
+        }
+
+        int sample_rate_ = 48000;
+        std::atomic<SampleStoragePolicy> storage_policy_{ SampleStoragePolicy::LOSSLESS };
+        std::shared_ptr<SampleArena> arena_ = std::make_shared<SampleArena>();
+        std::shared_ptr<std::atomic<bool>> compaction_queued_ = std::make_shared<std::atomic<bool>>(false);
+        juce::AudioFormatManager format_manager_;
+        LoaderThreadPool loader_pool_;
+
+        mutable std::mutex mutex_;
+        std::map<std::string, PendingAsset> assets_;
+        std::string last_error_;
+    };
+
+    // AudioAssetCache public interface
+    AudioAssetCache::AudioAssetCache() : impl_(std::make_unique<Impl>()) {}
+    AudioAssetCache::~AudioAssetCache() = default;
+
+    bool AudioAssetCache::initialize(int sample_rate, int num_loader_threads) {
+        return impl_->initialize(sample_rate, num_loader_threads);
+    }
+
+    void AudioAssetCache::shutdown() {
+        impl_->shutdown();
+    }
+
+    void AudioAssetCache::set_storage_policy(SampleStoragePolicy policy) {
+        impl_->set_storage_policy(policy);
+    }
+
+    SampleStoragePolicy AudioAssetCache::get_storage_policy() const {
+        return impl_->get_storage_policy();
+    }
+
+    std::shared_ptr<const AudioAsset> AudioAssetCache::load(const std::string& file_path) {
+        return impl_->load(file_path);
+    }
+
+    void AudioAssetCache::load_async(const std::string& file_path, LoadCallback callback) {
+        impl_->load_async(file_path, std::move(callback));
+    }
+
+    std::shared_ptr<const AudioAsset> AudioAssetCache::find(const std::string& file_path) const {
+        return impl_->find(file_path);
+    }
+
+    bool AudioAssetCache::get_metadata(const std::string& file_path, AudioAssetMetadata& metadata) const {
+        auto asset = impl_->find(file_path);
+        if (!asset) {
+            return false;
+        }
+        metadata = asset->metadata;
+        return true;
+    }
+
+    int AudioAssetCache::purge_unused() {
+        return impl_->purge_unused();
+    }
+
+    int AudioAssetCache::get_num_assets() const {
+        return impl_->get_num_assets();
+    }
+
+    size_t AudioAssetCache::get_memory_bytes() const {
+        return impl_->get_memory_bytes();
+    }
+
+    std::vector<size_t> AudioAssetCache::get_memory_bytes_by_format() const {
+        return impl_->get_memory_bytes_by_format();
+    }
+
+    LoaderThreadPool* AudioAssetCache::get_loader_pool() {
+        return impl_->get_loader_pool();
+    }
+
+    SampleArena* AudioAssetCache::get_arena() {
+        return impl_->get_arena();
+    }
+
+    std::string AudioAssetCache::get_last_error() const {
+        return impl_->get_last_error();
+    }
+
+} // namespace SharedAudio
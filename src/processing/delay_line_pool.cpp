@@ -0,0 +1,117 @@
+﻿#include "processing/delay_line_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SharedAudio {
+
+    // DelayLine implementation
+    void DelayLine::prepare(int max_delay_samples, int max_block_size) {
+        int size = 1;
+        while (size < max_delay_samples + max_block_size) {
+            size <<= 1;
+        }
+
+        buffer_.assign(size, 0.0f);
+        mask_ = size - 1;
+        max_delay_ = max_delay_samples;
+        reset();
+    }
+
+    void DelayLine::reset() {
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        write_pos_ = 0;
+        current_delay_ = 0;
+        target_delay_ = 0;
+    }
+
+    void DelayLine::set_delay(int delay_samples) {
+        target_delay_ = std::max(0, std::min(delay_samples, max_delay_));
+    }
+
+    void DelayLine::process(float* data, int num_samples) {
+        if (buffer_.empty() || num_samples <= 0) {
+            return;
+        }
+
+        const int size = mask_ + 1;
+        const int block_start = write_pos_;
+
+        // Write the block into the ring (at most two contiguous copies)
+        const int first_part = std::min(num_samples, size - block_start);
+        std::memcpy(&buffer_[block_start], data, first_part * sizeof(float));
+        if (first_part < num_samples) {
+            std::memcpy(&buffer_[0], data + first_part, (num_samples - first_part) * sizeof(float));
+        }
+        write_pos_ = (block_start + num_samples) & mask_;
+
+        if (current_delay_ == target_delay_) {
+            if (current_delay_ == 0) {
+                return; // Pass-through, history is still recorded above
+            }
+
+            const int read_start = (block_start - current_delay_) & mask_;
+            const int read_first = std::min(num_samples, size - read_start);
+            std::memcpy(data, &buffer_[read_start], read_first * sizeof(float));
+            if (read_first < num_samples) {
+                std::memcpy(data + read_first, &buffer_[0], (num_samples - read_first) * sizeof(float));
+            }
+            return;
+        }
+
+        // Delay changed: crossfade from the old read head to the new one over this block
+        const float step = 1.0f / static_cast<float>(num_samples);
+        for (int i = 0; i < num_samples; ++i) {
+            const int pos = block_start + i;
+            const float old_sample = buffer_[(pos - current_delay_) & mask_];
+            const float new_sample = buffer_[(pos - target_delay_) & mask_];
+            const float fade = static_cast<float>(i + 1) * step;
+            data[i] = old_sample + (new_sample - old_sample) * fade;
+        }
+        current_delay_ = target_delay_;
+    }
+
+    // DelayLinePool implementation
+    void DelayLinePool::prepare(int num_lines, int max_delay_samples, int max_block_size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        lines_.clear();
+        free_lines_.clear();
+        max_delay_ = max_delay_samples;
+
+        for (int i = 0; i < num_lines; ++i) {
+            auto line = std::make_unique<DelayLine>();
+            line->prepare(max_delay_samples, max_block_size);
+            free_lines_.push_back(line.get());
+            lines_.push_back(std::move(line));
+        }
+    }
+
+    DelayLine* DelayLinePool::acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (free_lines_.empty()) {
+            return nullptr;
+        }
+
+        DelayLine* line = free_lines_.back();
+        free_lines_.pop_back();
+        line->reset();
+        return line;
+    }
+
+    void DelayLinePool::release(DelayLine* line) {
+        if (line == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_lines_.push_back(line);
+    }
+
+    int DelayLinePool::get_num_free() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<int>(free_lines_.size());
+    }
+
+} // namespace SharedAudio
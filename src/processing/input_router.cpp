@@ -0,0 +1,225 @@
+﻿#include "processing/input_router.h"
+#include "processing/mix_graph.h"
+#include "processing/level_meter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+
+namespace SharedAudio {
+
+    namespace {
+        struct InputStrip {
+            std::atomic<float> gain{ 1.0f };
+            std::atomic<float> pan{ 0.0f };
+            std::atomic<bool> muted{ false };
+            std::atomic<int> bus_index{ -1 };
+            std::atomic<int> direct_output{ -1 };
+
+            // Audio thread only, for de-zippering
+            float applied_left = 0.0f;
+            float applied_right = 0.0f;
+            float applied_direct = 0.0f;
+            int applied_bus = -1;
+        };
+
+        void balance_gains(float gain, float pan, float& left, float& right) {
+            left = gain * (pan > 0.0f ? 1.0f - pan : 1.0f);
+            right = gain * (pan < 0.0f ? 1.0f + pan : 1.0f);
+        }
+    }
+
+    class InputRouter::Impl {
+    public:
+        bool initialize(int num_inputs, MixGraph* mix_graph) {
+            num_inputs_ = std::max(0, std::min(num_inputs, kMaxInputs));
+            mix_graph_ = mix_graph;
+            input_meters_.prepare(num_inputs_, true);
+
+            std::cout << "[INPUT] InputRouter initialized (" << num_inputs_ << " inputs)" << std::endl;
+            return true;
+        }
+
+        InputStrip* strip(int input_channel) {
+            if (input_channel < 0 || input_channel >= num_inputs_) {
+                return nullptr;
+            }
+            return &strips_[input_channel];
+        }
+
+        const InputStrip* strip(int input_channel) const {
+            return const_cast<Impl*>(this)->strip(input_channel);
+        }
+
+        InputChannelInfo get_input_info(int input_channel) const {
+            InputChannelInfo info{ -1, 0.0f, 0.0f, false, -1, -1 };
+            const InputStrip* s = strip(input_channel);
+            if (s == nullptr) {
+                return info;
+            }
+
+            info.input_channel = input_channel;
+            info.gain = s->gain.load(std::memory_order_relaxed);
+            info.pan = s->pan.load(std::memory_order_relaxed);
+            info.is_muted = s->muted.load(std::memory_order_relaxed);
+            info.bus_index = s->bus_index.load(std::memory_order_relaxed);
+            info.direct_output = s->direct_output.load(std::memory_order_relaxed);
+            return info;
+        }
+
+        // REAL-TIME THREAD
+        void process_to_buses(const AudioBuffer& inputs, int num_samples) {
+            input_meters_.begin_block();
+
+            const int num_channels = std::min(static_cast<int>(inputs.size()), num_inputs_);
+            for (int ch = 0; ch < num_channels; ++ch) {
+                InputStrip& s = strips_[ch];
+                const float* src = inputs[ch].data();
+                const float gain = s.muted.load(std::memory_order_relaxed) ? 0.0f : s.gain.load(std::memory_order_relaxed);
+
+                // Input meter, post gain and pre pan
+                mix_and_measure(src, nullptr, gain, gain, num_samples, input_meters_.accumulator(ch));
+                input_meters_.measure_true_peak(ch, src, num_samples, gain);
+
+                // A bus change fades the input out of the old bus over this
+                // block while it fades in on the new one
+                const int bus_index = s.bus_index.load(std::memory_order_relaxed);
+                if (bus_index != s.applied_bus) {
+                    AudioBuffer* old_bus = get_bus(s.applied_bus);
+                    if (old_bus != nullptr && !old_bus->empty()) {
+                        const int old_samples = std::min(num_samples, static_cast<int>((*old_bus)[0].size()));
+                        if (s.applied_left != 0.0f) {
+                            mix_and_measure(src, (*old_bus)[0].data(), s.applied_left, 0.0f, old_samples, scratch_meter_);
+                        }
+                        if (old_bus->size() >= 2 && s.applied_right != 0.0f) {
+                            mix_and_measure(src, (*old_bus)[1].data(), s.applied_right, 0.0f, old_samples, scratch_meter_);
+                        }
+                    }
+                    s.applied_left = s.applied_right = 0.0f;
+                    s.applied_bus = bus_index;
+                }
+
+                AudioBuffer* bus = get_bus(bus_index);
+                if (bus == nullptr || bus->empty()) {
+                    continue;
+                }
+                const int bus_samples = std::min(num_samples, static_cast<int>((*bus)[0].size()));
+
+                float target_left, target_right;
+                balance_gains(gain, s.pan.load(std::memory_order_relaxed), target_left, target_right);
+                if (bus->size() == 1) {
+                    target_left = gain; // Mono bus, pan does not apply
+                }
+
+                if (target_left != 0.0f || s.applied_left != 0.0f) {
+                    mix_and_measure(src, (*bus)[0].data(), s.applied_left, target_left, bus_samples, scratch_meter_);
+                }
+                if (bus->size() >= 2 && (target_right != 0.0f || s.applied_right != 0.0f)) {
+                    mix_and_measure(src, (*bus)[1].data(), s.applied_right, target_right, bus_samples, scratch_meter_);
+                }
+                s.applied_left = target_left;
+                s.applied_right = target_right;
+            }
+
+            input_meters_.publish();
+            scratch_meter_.reset();
+        }
+
+        AudioBuffer* get_bus(int bus_index) {
+            return (bus_index >= 0 && mix_graph_) ? mix_graph_->get_bus_buffer(bus_index) : nullptr;
+        }
+
+        void process_direct(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
+            const int num_channels = std::min(static_cast<int>(inputs.size()), num_inputs_);
+            const int num_outputs = static_cast<int>(outputs.size());
+
+            for (int ch = 0; ch < num_channels; ++ch) {
+                InputStrip& s = strips_[ch];
+                const int output = s.direct_output.load(std::memory_order_relaxed);
+                const float target = (output < 0 || s.muted.load(std::memory_order_relaxed))
+                    ? 0.0f : s.gain.load(std::memory_order_relaxed);
+
+                if (output >= 0 && output < num_outputs && (target != 0.0f || s.applied_direct != 0.0f)) {
+                    mix_and_measure(inputs[ch].data(), outputs[output].data(), s.applied_direct, target,
+                        num_samples, scratch_meter_);
+                }
+                s.applied_direct = target;
+            }
+            scratch_meter_.reset();
+        }
+
+        int num_inputs_ = 0;
+        MixGraph* mix_graph_ = nullptr;
+        std::array<InputStrip, kMaxInputs> strips_;
+        MeterBank input_meters_;
+        MeterAccumulator scratch_meter_; // route mixes share the fused kernel, their levels are unused
+    };
+
+    // InputRouter public interface
+    InputRouter::InputRouter() : impl_(std::make_unique<Impl>()) {}
+    InputRouter::~InputRouter() = default;
+
+    bool InputRouter::initialize(int num_inputs, MixGraph* mix_graph) {
+        return impl_->initialize(num_inputs, mix_graph);
+    }
+
+    int InputRouter::get_num_inputs() const {
+        return impl_->num_inputs_;
+    }
+
+    bool InputRouter::set_input_gain(int input_channel, float gain) {
+        auto* s = impl_->strip(input_channel);
+        if (s == nullptr) return false;
+        s->gain.store(std::max(0.0f, gain), std::memory_order_relaxed);
+        return true;
+    }
+
+    bool InputRouter::set_input_pan(int input_channel, float pan) {
+        auto* s = impl_->strip(input_channel);
+        if (s == nullptr) return false;
+        s->pan.store(std::max(-1.0f, std::min(1.0f, pan)), std::memory_order_relaxed);
+        return true;
+    }
+
+    bool InputRouter::set_input_mute(int input_channel, bool muted) {
+        auto* s = impl_->strip(input_channel);
+        if (s == nullptr) return false;
+        s->muted.store(muted, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool InputRouter::set_input_bus(int input_channel, int bus_index) {
+        auto* s = impl_->strip(input_channel);
+        if (s == nullptr) return false;
+        if (bus_index >= 0 && impl_->mix_graph_ && bus_index >= impl_->mix_graph_->get_num_buses()) {
+            return false;
+        }
+        s->bus_index.store(bus_index < 0 ? -1 : bus_index, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool InputRouter::set_input_direct_output(int input_channel, int output_channel) {
+        auto* s = impl_->strip(input_channel);
+        if (s == nullptr) return false;
+        s->direct_output.store(output_channel < 0 ? -1 : output_channel, std::memory_order_relaxed);
+        return true;
+    }
+
+    InputChannelInfo InputRouter::get_input_info(int input_channel) const {
+        return impl_->get_input_info(input_channel);
+    }
+
+    MeterBank* InputRouter::get_input_meters() {
+        return &impl_->input_meters_;
+    }
+
+    void InputRouter::process_to_buses(const AudioBuffer& inputs, int num_samples) {
+        impl_->process_to_buses(inputs, num_samples);
+    }
+
+    void InputRouter::process_direct(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
+        impl_->process_direct(inputs, outputs, num_samples);
+    }
+
+} // namespace SharedAudio
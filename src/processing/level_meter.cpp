@@ -0,0 +1,354 @@
+﻿#include "processing/level_meter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHARED_AUDIO_METER_SSE 1
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+        // ITU-R BS.1770-4 Annex 2 interpolation filter, laid out [tap][phase]
+        // so one 4-wide multiply-add produces all four oversampled points
+        alignas(16) const float kTruePeakTaps[12][4] = {
+            {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+            {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+            { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+            {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+            { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+            {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+            {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+            { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+            {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+            { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+            {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+            { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f },
+        };
+
+        constexpr int kTruePeakTapCount = 12;
+
+        // Largest oversampled magnitude for outputs [begin, end) of x,
+        // where x[n - k] must be valid for k < 12
+        float true_peak_span(const float* x, int begin, int end) {
+#ifdef SHARED_AUDIO_METER_SSE
+            const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+            __m128 max_v = _mm_setzero_ps();
+            int n = begin;
+
+            // Four outputs per step with one accumulator per phase: the tap
+            // sums no longer form a single dependent add chain per sample.
+            // Each output still adds its taps in the same order.
+#ifdef __AVX__
+            const __m256 abs_mask8 = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+            __m256 max8 = _mm256_setzero_ps();
+            for (; n + 8 <= end; n += 8) {
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                __m256 acc2 = _mm256_setzero_ps();
+                __m256 acc3 = _mm256_setzero_ps();
+                for (int k = 0; k < kTruePeakTapCount; ++k) {
+                    const __m256 samples = _mm256_loadu_ps(x + n - k);
+                    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_set1_ps(kTruePeakTaps[k][0]), samples));
+                    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_set1_ps(kTruePeakTaps[k][1]), samples));
+                    acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(_mm256_set1_ps(kTruePeakTaps[k][2]), samples));
+                    acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(_mm256_set1_ps(kTruePeakTaps[k][3]), samples));
+                }
+                max8 = _mm256_max_ps(max8, _mm256_max_ps(_mm256_and_ps(acc0, abs_mask8), _mm256_and_ps(acc1, abs_mask8)));
+                max8 = _mm256_max_ps(max8, _mm256_max_ps(_mm256_and_ps(acc2, abs_mask8), _mm256_and_ps(acc3, abs_mask8)));
+            }
+            max_v = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+#endif
+            for (; n + 4 <= end; n += 4) {
+                __m128 acc0 = _mm_setzero_ps();
+                __m128 acc1 = _mm_setzero_ps();
+                __m128 acc2 = _mm_setzero_ps();
+                __m128 acc3 = _mm_setzero_ps();
+                for (int k = 0; k < kTruePeakTapCount; ++k) {
+                    const __m128 samples = _mm_loadu_ps(x + n - k);
+                    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(kTruePeakTaps[k][0]), samples));
+                    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_set1_ps(kTruePeakTaps[k][1]), samples));
+                    acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_set1_ps(kTruePeakTaps[k][2]), samples));
+                    acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_set1_ps(kTruePeakTaps[k][3]), samples));
+                }
+                max_v = _mm_max_ps(max_v, _mm_max_ps(_mm_and_ps(acc0, abs_mask), _mm_and_ps(acc1, abs_mask)));
+                max_v = _mm_max_ps(max_v, _mm_max_ps(_mm_and_ps(acc2, abs_mask), _mm_and_ps(acc3, abs_mask)));
+            }
+
+            for (; n < end; ++n) {
+                __m128 acc = _mm_setzero_ps();
+                for (int k = 0; k < kTruePeakTapCount; ++k) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(kTruePeakTaps[k]), _mm_set1_ps(x[n - k])));
+                }
+                max_v = _mm_max_ps(max_v, _mm_and_ps(acc, abs_mask));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, max_v);
+            return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#else
+            float max_value = 0.0f;
+            for (int n = begin; n < end; ++n) {
+                float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int k = 0; k < kTruePeakTapCount; ++k) {
+                    const float sample = x[n - k];
+                    for (int p = 0; p < 4; ++p) {
+                        acc[p] += kTruePeakTaps[k][p] * sample;
+                    }
+                }
+                for (int p = 0; p < 4; ++p) {
+                    max_value = std::max(max_value, std::fabs(acc[p]));
+                }
+            }
+            return max_value;
+#endif
+        }
+    }
+
+    float linear_to_db(float linear) {
+        return linear > 1.0e-6f ? 20.0f * std::log10(linear) : -120.0f;
+    }
+
+    void measure_block(const float* data, int num_samples, MeterAccumulator& meter) {
+        float peak = meter.peak;
+        float sum_squares = 0.0f;
+        int i = 0;
+
+#ifdef SHARED_AUDIO_METER_SSE
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peak_v = _mm_setzero_ps();
+        __m128 sum_v = _mm_setzero_ps();
+        for (; i + 4 <= num_samples; i += 4) {
+            const __m128 x = _mm_loadu_ps(data + i);
+            peak_v = _mm_max_ps(peak_v, _mm_and_ps(x, abs_mask));
+            sum_v = _mm_add_ps(sum_v, _mm_mul_ps(x, x));
+        }
+        alignas(16) float peak_lanes[4];
+        alignas(16) float sum_lanes[4];
+        _mm_store_ps(peak_lanes, peak_v);
+        _mm_store_ps(sum_lanes, sum_v);
+        peak = std::max(peak, std::max(std::max(peak_lanes[0], peak_lanes[1]), std::max(peak_lanes[2], peak_lanes[3])));
+        sum_squares = (sum_lanes[0] + sum_lanes[1]) + (sum_lanes[2] + sum_lanes[3]);
+#endif
+
+        for (; i < num_samples; ++i) {
+            peak = std::max(peak, std::fabs(data[i]));
+            sum_squares += data[i] * data[i];
+        }
+
+        meter.peak = peak;
+        meter.sum_squares += sum_squares;
+        meter.num_samples += num_samples;
+    }
+
+    void mix_and_measure(const float* src, float* dst, float gain_start, float gain_end,
+        int num_samples, MeterAccumulator& meter) {
+        if (num_samples <= 0) {
+            return;
+        }
+
+        const float gain_step = (gain_end - gain_start) / static_cast<float>(num_samples);
+        float peak = meter.peak;
+        float sum_squares = 0.0f;
+        int i = 0;
+
+#ifdef SHARED_AUDIO_METER_SSE
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 step_v = _mm_set1_ps(gain_step * 4.0f);
+        __m128 gain_v = _mm_setr_ps(gain_start + gain_step, gain_start + gain_step * 2.0f,
+            gain_start + gain_step * 3.0f, gain_start + gain_step * 4.0f);
+        __m128 peak_v = _mm_setzero_ps();
+        __m128 sum_v = _mm_setzero_ps();
+        for (; i + 4 <= num_samples; i += 4) {
+            const __m128 x = _mm_mul_ps(_mm_loadu_ps(src + i), gain_v);
+            if (dst) {
+                _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), x));
+            }
+            peak_v = _mm_max_ps(peak_v, _mm_and_ps(x, abs_mask));
+            sum_v = _mm_add_ps(sum_v, _mm_mul_ps(x, x));
+            gain_v = _mm_add_ps(gain_v, step_v);
+        }
+        alignas(16) float peak_lanes[4];
+        alignas(16) float sum_lanes[4];
+        _mm_store_ps(peak_lanes, peak_v);
+        _mm_store_ps(sum_lanes, sum_v);
+        peak = std::max(peak, std::max(std::max(peak_lanes[0], peak_lanes[1]), std::max(peak_lanes[2], peak_lanes[3])));
+        sum_squares = (sum_lanes[0] + sum_lanes[1]) + (sum_lanes[2] + sum_lanes[3]);
+#endif
+
+        for (; i < num_samples; ++i) {
+            const float x = src[i] * (gain_start + gain_step * static_cast<float>(i + 1));
+            if (dst) {
+                dst[i] += x;
+            }
+            peak = std::max(peak, std::fabs(x));
+            sum_squares += x * x;
+        }
+
+        meter.peak = peak;
+        meter.sum_squares += sum_squares;
+        meter.num_samples += num_samples;
+    }
+
+    // TruePeakDetector implementation
+    float TruePeakDetector::process(const float* data, int num_samples) {
+        if (num_samples <= 0) {
+            return 0.0f;
+        }
+
+        constexpr int history_size = kTruePeakTapCount - 1;
+        const int head = std::min(num_samples, history_size);
+
+        // The first outputs reach back into the previous block
+        float joined[history_size * 2];
+        std::copy(history_.begin(), history_.end(), joined);
+        std::copy(data, data + head, joined + history_size);
+        float max_value = true_peak_span(joined, history_size, history_size + head);
+
+        if (num_samples > history_size) {
+            max_value = std::max(max_value, true_peak_span(data, history_size, num_samples));
+        }
+
+        // Keep the last 11 input samples for the next block
+        if (num_samples >= history_size) {
+            std::copy(data + num_samples - history_size, data + num_samples, history_.begin());
+        }
+        else {
+            std::copy(joined + num_samples, joined + num_samples + history_size, history_.begin());
+        }
+
+        return max_value;
+    }
+
+    // MeterBank implementation
+    void MeterBank::prepare(int num_channels, bool enable_true_peak) {
+        accumulators_.assign(num_channels, MeterAccumulator{});
+        true_peak_detectors_.assign(enable_true_peak ? num_channels : 0, TruePeakDetector{});
+        true_peak_enabled_ = enable_true_peak;
+        published_.assign(num_channels, MeterAccumulator{});
+        sequence_.store(0, std::memory_order_relaxed);
+        consumed_.store(0, std::memory_order_relaxed);
+    }
+
+    void MeterBank::begin_block() {
+        // Start a fresh window once the reader has taken the last one, or
+        // after a long time without a reader so the sample counts can't overflow
+        constexpr int max_unread_blocks = 1 << 16;
+        if (consumed_.load(std::memory_order_acquire) == sequence_.load(std::memory_order_relaxed)
+            || ++unread_blocks_ > max_unread_blocks) {
+            for (auto& meter : accumulators_) {
+                meter.reset();
+            }
+            unread_blocks_ = 0;
+        }
+    }
+
+    void MeterBank::measure(int channel, const float* data, int num_samples) {
+        measure_block(data, num_samples, accumulators_[channel]);
+        measure_true_peak(channel, data, num_samples, 1.0f);
+    }
+
+    void MeterBank::measure_true_peak(int channel, const float* data, int num_samples, float gain) {
+        if (!true_peak_enabled_) {
+            return;
+        }
+        // The block was just read by the mix loop, so this pass stays in L1
+        const float true_peak = true_peak_detectors_[channel].process(data, num_samples) * std::fabs(gain);
+        MeterAccumulator& meter = accumulators_[channel];
+        meter.true_peak = std::max(meter.true_peak, std::max(true_peak, meter.peak));
+    }
+
+    void MeterBank::publish() {
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::copy(accumulators_.begin(), accumulators_.end(), published_.begin());
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    bool MeterBank::read(std::vector<MeterValues>& values) {
+        std::vector<MeterAccumulator> snapshot(accumulators_.size());
+        uint32_t sequence = 0;
+
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            sequence = sequence_.load(std::memory_order_acquire);
+            if ((sequence & 1u) == 0) {
+                std::copy(published_.begin(), published_.end(), snapshot.begin());
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == sequence) {
+                    break;
+                }
+            }
+            if (attempt == 7) {
+                return false;
+            }
+        }
+
+        consumed_.store(sequence, std::memory_order_release);
+
+        values.resize(snapshot.size());
+        for (size_t ch = 0; ch < snapshot.size(); ++ch) {
+            const auto& meter = snapshot[ch];
+            values[ch].peak = meter.peak;
+            values[ch].true_peak = std::max(meter.true_peak, meter.peak);
+            values[ch].rms = meter.num_samples > 0
+                ? static_cast<float>(std::sqrt(meter.sum_squares / meter.num_samples)) : 0.0f;
+        }
+        return true;
+    }
+
+    // MeterBallistics implementation
+    MeterBallistics::MeterBallistics(double hold_seconds, double decay_db_per_second)
+        : hold_seconds_(hold_seconds)
+        , decay_db_per_second_(decay_db_per_second)
+    {
+    }
+
+    void MeterBallistics::process(const std::vector<MeterValues>& values, double elapsed_seconds,
+        std::vector<MeterReading>& readings) {
+        states_.resize(values.size());
+        readings.resize(values.size());
+
+        const float decay = static_cast<float>(decay_db_per_second_ * elapsed_seconds);
+
+        for (size_t ch = 0; ch < values.size(); ++ch) {
+            ChannelState& state = states_[ch];
+            const float peak_db = linear_to_db(values[ch].peak);
+            const float rms_db = linear_to_db(values[ch].rms);
+            const float true_peak_db = linear_to_db(values[ch].true_peak);
+
+            state.display_peak_db = std::max(peak_db, state.display_peak_db - decay);
+            state.display_rms_db = std::max(rms_db, state.display_rms_db - decay);
+
+            if (true_peak_db >= state.hold_db) {
+                state.hold_db = true_peak_db;
+                state.hold_remaining = hold_seconds_;
+            }
+            else if (state.hold_remaining > 0.0) {
+                state.hold_remaining -= elapsed_seconds;
+            }
+            else {
+                state.hold_db = std::max(true_peak_db, state.hold_db - decay);
+            }
+
+            state.clipped = state.clipped || values[ch].true_peak >= 1.0f;
+
+            readings[ch].peak_db = state.display_peak_db;
+            readings[ch].rms_db = state.display_rms_db;
+            readings[ch].true_peak_db = true_peak_db;
+            readings[ch].peak_hold_db = state.hold_db;
+            readings[ch].clipped = state.clipped;
+        }
+    }
+
+    void MeterBallistics::reset_clip_indicators() {
+        for (auto& state : states_) {
+            state.clipped = false;
+        }
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,59 @@
+﻿#include "processing/loop_seam.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Fix M_PI for Windows
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace SharedAudio {
+
+    LoopSeamPlan LoopSeam::plan(const LoopRegion& region, size_t num_frames) {
+        LoopSeamPlan plan;
+        plan.end_frame = std::min(region.end_frame > 0 ? region.end_frame : num_frames, num_frames);
+        const size_t start = std::min(region.start_frame, plan.end_frame);
+        const size_t length = plan.end_frame - start;
+
+        // The seam and the frames it fades towards both have to fit inside the loop
+        const size_t crossfade = std::min<size_t>(static_cast<size_t>(std::max(region.crossfade_frames, 0)), length / 2);
+        plan.crossfade_frames = static_cast<int>(crossfade);
+        plan.seam_start = plan.end_frame - crossfade;
+        if (start >= crossfade) {
+            plan.incoming_start = start - crossfade;
+            plan.resume_frame = start;
+        }
+        else {
+            plan.incoming_start = start;
+            plan.resume_frame = start + crossfade;
+        }
+        return plan;
+    }
+
+    void LoopSeam::build(const LoopSeamPlan& plan, const AudioBuffer& outgoing, const AudioBuffer& incoming) {
+        plan_ = plan;
+        const int frames = plan.crossfade_frames;
+        seam_.assign(frames > 0 ? outgoing.size() : 0, std::vector<float>(static_cast<size_t>(std::max(frames, 0)), 0.0f));
+
+        // Equal power: loop points in beds are rarely phase-aligned, so the
+        // two sides add as uncorrelated signals and the level stays flat
+        for (size_t ch = 0; ch < seam_.size(); ++ch) {
+            const float* out = outgoing[ch].data();
+            const float* in = incoming[std::min(ch, incoming.size() - 1)].data();
+            float* seam = seam_[ch].data();
+            for (int i = 0; i < frames; ++i) {
+                const double angle = 0.5 * M_PI * (i + 0.5) / frames;
+                seam[i] = static_cast<float>(out[i] * std::cos(angle) + in[i] * std::sin(angle));
+            }
+        }
+    }
+
+    size_t LoopSeam::fold_position(size_t position) const {
+        if (position < plan_.end_frame || !plan_.is_valid()) {
+            return position;
+        }
+        return plan_.resume_frame + (position - plan_.end_frame) % (plan_.end_frame - plan_.resume_frame);
+    }
+
+} // namespace SharedAudio
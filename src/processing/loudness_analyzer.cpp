@@ -0,0 +1,503 @@
+﻿#include "processing/loudness_analyzer.h"
+#include "core/audio_tap.h"
+#include "core/loader_thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr double kAbsoluteGateLufs = -70.0;
+        constexpr double kRelativeGateLu = -10.0;
+        constexpr double kRangeRelativeGateLu = -20.0;
+        constexpr int kSubBlocksPerMomentary = 4;  // 400 ms in 100 ms steps
+        constexpr int kSubBlocksPerShortTerm = 30; // 3 s in 100 ms steps
+
+        double energy_to_lufs(double energy) {
+            return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : -HUGE_VAL;
+        }
+
+        double lufs_to_energy(double lufs) {
+            return std::pow(10.0, (lufs + 0.691) / 10.0);
+        }
+
+        double clamp_to_floor(double lufs) {
+            return std::max(lufs, kLoudnessFloorLufs);
+        }
+
+        // Two-pass gating over a list of block energies
+        double gated_loudness(const std::vector<double>& block_energies) {
+            const double absolute_gate = lufs_to_energy(kAbsoluteGateLufs);
+            double sum = 0.0;
+            int count = 0;
+            for (double energy : block_energies) {
+                if (energy > absolute_gate) {
+                    sum += energy;
+                    ++count;
+                }
+            }
+            if (count == 0) {
+                return kLoudnessFloorLufs;
+            }
+
+            const double relative_gate = lufs_to_energy(energy_to_lufs(sum / count) + kRelativeGateLu);
+            sum = 0.0;
+            count = 0;
+            for (double energy : block_energies) {
+                if (energy > absolute_gate && energy > relative_gate) {
+                    sum += energy;
+                    ++count;
+                }
+            }
+            return count > 0 ? clamp_to_floor(energy_to_lufs(sum / count)) : kLoudnessFloorLufs;
+        }
+
+        // EBU Tech 3342: 10th to 95th percentile of gated short-term loudness
+        double loudness_range(const std::vector<double>& short_term_energies) {
+            const double absolute_gate = lufs_to_energy(kAbsoluteGateLufs);
+            double sum = 0.0;
+            int count = 0;
+            for (double energy : short_term_energies) {
+                if (energy > absolute_gate) {
+                    sum += energy;
+                    ++count;
+                }
+            }
+            if (count == 0) {
+                return 0.0;
+            }
+
+            const double relative_gate = lufs_to_energy(energy_to_lufs(sum / count) + kRangeRelativeGateLu);
+            std::vector<double> gated;
+            gated.reserve(count);
+            for (double energy : short_term_energies) {
+                if (energy > absolute_gate && energy > relative_gate) {
+                    gated.push_back(energy_to_lufs(energy));
+                }
+            }
+            if (gated.size() < 2) {
+                return 0.0;
+            }
+
+            std::sort(gated.begin(), gated.end());
+            const size_t low = static_cast<size_t>(std::lround(0.10 * (gated.size() - 1)));
+            const size_t high = static_cast<size_t>(std::lround(0.95 * (gated.size() - 1)));
+            return gated[high] - gated[low];
+        }
+
+    } // namespace
+
+    // KWeightingFilter implementation
+    void KWeightingFilter::prepare(double sample_rate) {
+        // Stage 1: high shelf (+4 dB above ~1.7 kHz), BS.1770 analogue prototype
+        {
+            const double f0 = 1681.974450955533;
+            const double gain_db = 3.999843853973347;
+            const double q = 0.7071752369554196;
+            const double k = std::tan(M_PI * f0 / sample_rate);
+            const double vh = std::pow(10.0, gain_db / 20.0);
+            const double vb = std::pow(vh, 0.4996667741545416);
+            const double a0 = 1.0 + k / q + k * k;
+            shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+            shelf_.b1 = 2.0 * (k * k - vh) / a0;
+            shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+            shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+            shelf_.a2 = (1.0 - k / q + k * k) / a0;
+        }
+
+        // Stage 2: RLB high-pass (~38 Hz)
+        {
+            const double f0 = 38.13547087602444;
+            const double q = 0.5003270373238773;
+            const double k = std::tan(M_PI * f0 / sample_rate);
+            const double a0 = 1.0 + k / q + k * k;
+            high_pass_.b0 = 1.0;
+            high_pass_.b1 = -2.0;
+            high_pass_.b2 = 1.0;
+            high_pass_.a1 = 2.0 * (k * k - 1.0) / a0;
+            high_pass_.a2 = (1.0 - k / q + k * k) / a0;
+        }
+
+        reset();
+    }
+
+    void KWeightingFilter::reset() {
+        shelf_.z1 = shelf_.z2 = 0.0;
+        high_pass_.z1 = high_pass_.z2 = 0.0;
+    }
+
+    double KWeightingFilter::process_energy(const float* data, int num_samples) {
+        // Transposed direct form II, state kept in locals for the loop
+        double s1 = shelf_.z1, s2 = shelf_.z2;
+        double h1 = high_pass_.z1, h2 = high_pass_.z2;
+        double energy = 0.0;
+
+        for (int i = 0; i < num_samples; ++i) {
+            const double x = data[i];
+            const double y = shelf_.b0 * x + s1;
+            s1 = shelf_.b1 * x - shelf_.a1 * y + s2;
+            s2 = shelf_.b2 * x - shelf_.a2 * y;
+
+            const double z = high_pass_.b0 * y + h1;
+            h1 = high_pass_.b1 * y - high_pass_.a1 * z + h2;
+            h2 = high_pass_.b2 * y - high_pass_.a2 * z;
+
+            energy += z * z;
+        }
+
+        shelf_.z1 = s1;
+        shelf_.z2 = s2;
+        high_pass_.z1 = h1;
+        high_pass_.z2 = h2;
+        return energy;
+    }
+
+    double loudness_channel_weight(int channel, int num_channels) {
+        if (num_channels == 6) {
+            // L R C LFE Ls Rs
+            if (channel == 3) return 0.0;
+            if (channel >= 4) return 1.41;
+        }
+        return 1.0;
+    }
+
+    LoudnessInfo analyze_loudness(const AudioBuffer& channels, int sample_rate, LoaderThreadPool* pool) {
+        LoudnessInfo info;
+        if (channels.empty() || sample_rate <= 0) {
+            return info;
+        }
+
+        const int num_channels = static_cast<int>(channels.size());
+        const size_t num_frames = channels[0].size();
+        const int sub_block = std::max(1, static_cast<int>(std::lround(sample_rate * 0.1)));
+
+        // Assets shorter than one gating block are measured as a single block
+        const size_t num_sub_blocks = std::max<size_t>(num_frames / sub_block, 1);
+        const int block_sub_blocks = num_frames >= static_cast<size_t>(sub_block) * kSubBlocksPerMomentary
+            ? kSubBlocksPerMomentary : static_cast<int>(num_sub_blocks);
+
+        // Per-channel K-weighted energy of every 100 ms step. The filters are
+        // recursive, so the work is split across channels, not time.
+        std::vector<std::vector<double>> channel_energy(num_channels, std::vector<double>(num_sub_blocks, 0.0));
+        auto filter_channel = [&](int ch) {
+            KWeightingFilter filter;
+            filter.prepare(sample_rate);
+            const float* data = channels[ch].data();
+            const size_t available = std::min(channels[ch].size(), num_frames);
+            for (size_t j = 0; j < num_sub_blocks; ++j) {
+                const size_t start = j * sub_block;
+                const size_t end = (j + 1 == num_sub_blocks) ? available : std::min(available, start + sub_block);
+                if (end > start) {
+                    channel_energy[ch][j] = filter.process_energy(data + start, static_cast<int>(end - start));
+                }
+            }
+        };
+
+        if (pool != nullptr && pool->get_num_threads() > 0 && num_channels > 1) {
+            pool->parallel_for(num_channels, filter_channel);
+        }
+        else {
+            for (int ch = 0; ch < num_channels; ++ch) {
+                filter_channel(ch);
+            }
+        }
+
+        std::vector<double> step_energy(num_sub_blocks, 0.0);
+        for (int ch = 0; ch < num_channels; ++ch) {
+            const double weight = loudness_channel_weight(ch, num_channels);
+            if (weight == 0.0) continue;
+            for (size_t j = 0; j < num_sub_blocks; ++j) {
+                step_energy[j] += weight * channel_energy[ch][j];
+            }
+        }
+
+        auto window_energy = [&](size_t first, int length) {
+            double sum = 0.0;
+            for (int k = 0; k < length; ++k) {
+                sum += step_energy[first + k];
+            }
+            const size_t samples = (first + length == num_sub_blocks)
+                ? num_frames - first * sub_block : static_cast<size_t>(length) * sub_block;
+            return samples > 0 ? sum / static_cast<double>(samples) : 0.0;
+        };
+
+        // Momentary blocks (400 ms, 75% overlap) drive the integrated gate
+        std::vector<double> block_energies;
+        block_energies.reserve(num_sub_blocks);
+        double max_momentary = 0.0;
+        for (size_t j = 0; j + block_sub_blocks <= num_sub_blocks; ++j) {
+            const double energy = window_energy(j, block_sub_blocks);
+            block_energies.push_back(energy);
+            max_momentary = std::max(max_momentary, energy);
+        }
+
+        std::vector<double> short_term_energies;
+        double max_short_term = 0.0;
+        for (size_t j = 0; j + kSubBlocksPerShortTerm <= num_sub_blocks; ++j) {
+            const double energy = window_energy(j, kSubBlocksPerShortTerm);
+            short_term_energies.push_back(energy);
+            max_short_term = std::max(max_short_term, energy);
+        }
+
+        info.is_valid = true;
+        info.integrated_lufs = gated_loudness(block_energies);
+        info.max_momentary_lufs = clamp_to_floor(energy_to_lufs(max_momentary));
+        info.max_short_term_lufs = short_term_energies.empty()
+            ? info.max_momentary_lufs : clamp_to_floor(energy_to_lufs(max_short_term));
+        info.loudness_range_lu = loudness_range(short_term_energies);
+        return info;
+    }
+
+    // LoudnessMonitor implementation
+    class LoudnessMonitor::Impl {
+    public:
+        ~Impl() {
+            stop();
+        }
+
+        bool start(int sample_rate, int first_channel, int num_channels) {
+            stop();
+            if (sample_rate <= 0 || num_channels <= 0) {
+                return false;
+            }
+
+            sample_rate_ = sample_rate;
+            num_channels_ = num_channels;
+            sub_block_size_ = std::max(1, static_cast<int>(std::lround(sample_rate * 0.1)));
+
+            // Two seconds of headroom before the tap starts dropping blocks
+            tap_.prepare(first_channel, num_channels, sample_rate * 2);
+            filters_.assign(num_channels, KWeightingFilter{});
+            for (auto& filter : filters_) {
+                filter.prepare(sample_rate);
+            }
+            scratch_.assign(num_channels, std::vector<float>(kReadChunk, 0.0f));
+            scratch_ptrs_.resize(num_channels);
+            for (int ch = 0; ch < num_channels; ++ch) {
+                scratch_ptrs_[ch] = scratch_[ch].data();
+            }
+            reset_measurement();
+
+            running_ = true;
+            thread_ = std::thread(&Impl::analysis_loop, this);
+
+            std::cout << "[LOUDNESS] Monitoring outputs " << first_channel << "-"
+                << (first_channel + num_channels - 1) << std::endl;
+            return true;
+        }
+
+        void stop() {
+            running_ = false;
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        bool is_running() const {
+            return running_;
+        }
+
+        AudioTap* get_tap() {
+            return &tap_;
+        }
+
+        LiveLoudness get_loudness() const {
+            std::lock_guard<std::mutex> lock(result_mutex_);
+            return result_;
+        }
+
+        void reset() {
+            reset_requested_ = true;
+        }
+
+    private:
+        static constexpr int kReadChunk = 4096;
+        static constexpr int kHistogramBins = 800; // 0.1 LU bins from -70 to +10 LUFS
+
+        void analysis_loop() {
+            while (running_) {
+                if (reset_requested_.exchange(false)) {
+                    reset_measurement();
+                }
+
+                int frames;
+                while ((frames = tap_.read(scratch_ptrs_.data(), kReadChunk)) > 0) {
+                    consume(frames);
+                }
+                publish();
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+
+        void consume(int frames) {
+            int offset = 0;
+            while (offset < frames) {
+                const int count = std::min(frames - offset, sub_block_size_ - sub_block_filled_);
+                for (int ch = 0; ch < num_channels_; ++ch) {
+                    const double weight = loudness_channel_weight(ch, num_channels_);
+                    const double energy = filters_[ch].process_energy(scratch_[ch].data() + offset, count);
+                    sub_block_energy_ += weight * energy;
+                }
+                sub_block_filled_ += count;
+                offset += count;
+
+                if (sub_block_filled_ == sub_block_size_) {
+                    complete_sub_block();
+                }
+            }
+        }
+
+        void complete_sub_block() {
+            steps_[step_write_ % kSubBlocksPerShortTerm] = sub_block_energy_ / sub_block_size_;
+            ++step_write_;
+            sub_block_energy_ = 0.0;
+            sub_block_filled_ = 0;
+
+            if (step_write_ >= kSubBlocksPerMomentary) {
+                momentary_energy_ = mean_of_last(kSubBlocksPerMomentary);
+                max_momentary_energy_ = std::max(max_momentary_energy_, momentary_energy_);
+                add_gating_block(momentary_energy_);
+            }
+            if (step_write_ >= kSubBlocksPerShortTerm) {
+                short_term_energy_ = mean_of_last(kSubBlocksPerShortTerm);
+            }
+        }
+
+        double mean_of_last(int count) const {
+            double sum = 0.0;
+            for (int k = 1; k <= count; ++k) {
+                sum += steps_[(step_write_ - k) % kSubBlocksPerShortTerm];
+            }
+            return sum / count;
+        }
+
+        // Histogram gating keeps memory bounded for shows that run for hours
+        void add_gating_block(double energy) {
+            const double lufs = energy_to_lufs(energy);
+            if (lufs <= kAbsoluteGateLufs) {
+                return;
+            }
+            const int bin = std::min(kHistogramBins - 1, static_cast<int>((lufs - kAbsoluteGateLufs) * 10.0));
+            histogram_count_[bin] += 1;
+            histogram_energy_[bin] += energy;
+        }
+
+        double integrated_from_histogram() const {
+            double sum = 0.0;
+            uint64_t count = 0;
+            for (int bin = 0; bin < kHistogramBins; ++bin) {
+                sum += histogram_energy_[bin];
+                count += histogram_count_[bin];
+            }
+            if (count == 0) {
+                return kLoudnessFloorLufs;
+            }
+
+            const double relative_gate = energy_to_lufs(sum / count) + kRelativeGateLu;
+            const int first_bin = std::max(0, static_cast<int>((relative_gate - kAbsoluteGateLufs) * 10.0));
+            sum = 0.0;
+            count = 0;
+            for (int bin = first_bin; bin < kHistogramBins; ++bin) {
+                sum += histogram_energy_[bin];
+                count += histogram_count_[bin];
+            }
+            return count > 0 ? clamp_to_floor(energy_to_lufs(sum / count)) : kLoudnessFloorLufs;
+        }
+
+        void publish() {
+            LiveLoudness result;
+            result.is_valid = step_write_ >= kSubBlocksPerMomentary;
+            result.momentary_lufs = clamp_to_floor(energy_to_lufs(momentary_energy_));
+            result.short_term_lufs = clamp_to_floor(energy_to_lufs(short_term_energy_));
+            result.integrated_lufs = integrated_from_histogram();
+            result.max_momentary_lufs = clamp_to_floor(energy_to_lufs(max_momentary_energy_));
+            result.measured_seconds = static_cast<double>(step_write_) * sub_block_size_ / sample_rate_;
+
+            std::lock_guard<std::mutex> lock(result_mutex_);
+            result_ = result;
+        }
+
+        void reset_measurement() {
+            for (auto& filter : filters_) {
+                filter.reset();
+            }
+            steps_.fill(0.0);
+            step_write_ = 0;
+            sub_block_energy_ = 0.0;
+            sub_block_filled_ = 0;
+            momentary_energy_ = 0.0;
+            short_term_energy_ = 0.0;
+            max_momentary_energy_ = 0.0;
+            histogram_count_.fill(0);
+            histogram_energy_.fill(0.0);
+        }
+
+        AudioTap tap_;
+        std::thread thread_;
+        std::atomic<bool> running_{ false };
+        std::atomic<bool> reset_requested_{ false };
+
+        // Analysis thread state
+        int sample_rate_ = 48000;
+        int num_channels_ = 0;
+        int sub_block_size_ = 4800;
+        std::vector<KWeightingFilter> filters_;
+        std::vector<std::vector<float>> scratch_;
+        std::vector<float*> scratch_ptrs_;
+        std::array<double, kSubBlocksPerShortTerm> steps_{};
+        uint64_t step_write_ = 0;
+        double sub_block_energy_ = 0.0;
+        int sub_block_filled_ = 0;
+        double momentary_energy_ = 0.0;
+        double short_term_energy_ = 0.0;
+        double max_momentary_energy_ = 0.0;
+        std::array<uint64_t, kHistogramBins> histogram_count_{};
+        std::array<double, kHistogramBins> histogram_energy_{};
+
+        mutable std::mutex result_mutex_;
+        LiveLoudness result_;
+    };
+
+    // LoudnessMonitor public interface
+    LoudnessMonitor::LoudnessMonitor() : impl_(std::make_unique<Impl>()) {}
+    LoudnessMonitor::~LoudnessMonitor() = default;
+
+    bool LoudnessMonitor::start(int sample_rate, int first_channel, int num_channels) {
+        return impl_->start(sample_rate, first_channel, num_channels);
+    }
+
+    void LoudnessMonitor::stop() {
+        impl_->stop();
+    }
+
+    bool LoudnessMonitor::is_running() const {
+        return impl_->is_running();
+    }
+
+    AudioTap* LoudnessMonitor::get_tap() {
+        return impl_->get_tap();
+    }
+
+    LiveLoudness LoudnessMonitor::get_loudness() const {
+        return impl_->get_loudness();
+    }
+
+    void LoudnessMonitor::reset() {
+        impl_->reset();
+    }
+
+} // namespace SharedAudio
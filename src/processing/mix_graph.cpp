@@ -0,0 +1,804 @@
+﻿#include "processing/mix_graph.h"
+#include "processing/plugin_host.h"
+#include "processing/delay_line_pool.h"
+#include "processing/level_meter.h"
+#include "core/realtime_worker_pool.h"
+#include "core/audio_tap.h"
+#include "core/block_boundary.h"
+#include "core/triple_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace SharedAudio {
+
+    namespace {
+        struct BusStrip {
+            std::string name; // guarded by config_mutex_
+            int num_channels = 0;
+            AudioBuffer buffer;
+            std::vector<float*> channel_ptrs;
+            std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip> inserts;
+            std::vector<DelayLine*> delay_lines; // one per channel, may be empty if the pool ran dry
+            std::array<std::atomic<AudioTap*>, MixGraph::kMaxTapsPerBus> taps{}; // post-insert analysis taps
+
+            std::atomic<int> first_output_channel{ 0 };
+            std::atomic<float> gain{ 1.0f };
+            std::atomic<bool> muted{ false };
+
+            std::atomic<int> compensation_samples{ 0 };
+
+            float applied_gain = 1.0f; // audio thread only, for de-zippering
+            int latency_samples = 0;   // audio thread only
+
+            // Silence tracking, audio thread only
+            bool written = false;      // Someone asked for the buffer this block
+            bool dirty = false;        // Buffer holds non-zero data until the next begin_block
+            int tail_samples = 0;      // Delay compensation still draining after the last write
+            std::atomic<bool> silent{ true };
+        };
+
+        struct OutputGroup {
+            int first_channel = 0; // audio thread only, from the published layout
+            int num_channels = 0;
+            std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip> inserts;
+            std::array<float*, MixGraph::kMaxBusChannels> channel_ptrs{};
+            int latency_samples = 0; // audio thread only
+        };
+
+        struct OutputGroupLayout {
+            int num_groups = 0;
+            std::array<int, MixGraph::kMaxOutputGroups> group_sizes{};
+        };
+
+        template <size_t N>
+        bool attach_tap(std::array<std::atomic<AudioTap*>, N>& taps, AudioTap* tap) {
+            for (auto& slot : taps) {
+                AudioTap* expected = nullptr;
+                if (slot.compare_exchange_strong(expected, tap)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <size_t N>
+        void detach_tap(std::array<std::atomic<AudioTap*>, N>& taps, AudioTap* tap) {
+            for (auto& slot : taps) {
+                AudioTap* expected = tap;
+                slot.compare_exchange_strong(expected, nullptr);
+            }
+        }
+
+        template <size_t N>
+        void write_taps(std::array<std::atomic<AudioTap*>, N>& taps, const AudioBuffer& buffer, int num_samples) {
+            for (auto& slot : taps) {
+                if (AudioTap* tap = slot.load(std::memory_order_acquire)) {
+                    tap->write(buffer, num_samples);
+                }
+            }
+        }
+
+        bool chain_is_offloaded(const std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip>& inserts) {
+            for (const auto& slot : inserts) {
+                if (slot.is_active() && slot.is_offloaded_to_worker()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool chain_is_active(const std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip>& inserts) {
+            for (const auto& slot : inserts) {
+                if (slot.is_active()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        int chain_latency(const std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip>& inserts) {
+            int latency = 0;
+            for (const auto& slot : inserts) {
+                latency += slot.get_active_latency_samples();
+            }
+            return latency;
+        }
+
+        void run_chain(std::array<PluginInsertSlot, MixGraph::kMaxInsertsPerStrip>& inserts,
+            float* const* channels, int num_channels, int num_samples) {
+            for (auto& slot : inserts) {
+                slot.process(channels, num_channels, num_samples);
+            }
+        }
+
+        void process_bus(BusStrip& strip, int num_samples) {
+            if (chain_is_active(strip.inserts)) {
+                run_chain(strip.inserts, strip.channel_ptrs.data(), strip.num_channels, num_samples);
+            }
+            for (size_t ch = 0; ch < strip.delay_lines.size(); ++ch) {
+                strip.delay_lines[ch]->process(strip.channel_ptrs[ch], num_samples);
+            }
+        }
+    }
+
+    class MixGraph::Impl {
+    public:
+        Impl()
+            : sample_rate_(48000)
+            , max_block_size_(256)
+            , num_outputs_(2)
+            , plugin_host_(nullptr)
+            , initialized_(false)
+            , current_block_size_(0)
+        {
+        }
+
+        bool initialize(int sample_rate, int max_block_size, int num_outputs, PluginHost* plugin_host) {
+            sample_rate_ = sample_rate;
+            max_block_size_ = max_block_size;
+            num_outputs_ = num_outputs;
+            plugin_host_ = plugin_host;
+
+            // One compensation line per bus channel and per device output
+            delay_pool_.prepare(kMaxBuses * 2 + num_outputs, kMaxCompensationSamples, max_block_size);
+            output_delays_.clear();
+            for (int ch = 0; ch < num_outputs; ++ch) {
+                output_delays_.push_back(delay_pool_.acquire());
+            }
+            output_gains_ = std::make_unique<std::atomic<float>[]>(num_outputs);
+            for (int ch = 0; ch < num_outputs; ++ch) {
+                output_gains_[ch].store(1.0f);
+            }
+            applied_output_gains_.assign(num_outputs, 1.0f);
+
+            bus_meters_.prepare(kMaxBuses * kMaxBusChannels, true);
+            output_meters_.prepare(num_outputs, true);
+
+            // Stereo output pairs, with a trailing mono output for odd counts
+            std::vector<int> pairs;
+            for (int ch = 0; ch < num_outputs; ch += 2) {
+                pairs.push_back(std::min(2, num_outputs - ch));
+            }
+            set_output_groups(pairs);
+
+            // Default main bus feeding the first output pair
+            if (num_buses_.load(std::memory_order_acquire) == 0) {
+                add_bus("Main", 2, 0);
+            }
+
+            initialized_ = true;
+            std::cout << "[MIX] MixGraph initialized (" << num_outputs << " outputs, "
+                << num_output_groups_.load() << " output groups)" << std::endl;
+            return true;
+        }
+
+        void shutdown() {
+            worker_pool_.stop();
+            initialized_ = false;
+            std::cout << "[MIX] MixGraph shutdown" << std::endl;
+        }
+
+        int add_bus(const std::string& name, int num_channels, int first_output_channel) {
+            std::lock_guard<std::mutex> lock(config_mutex_);
+
+            const int index = num_buses_.load(std::memory_order_relaxed);
+            if (index >= kMaxBuses || num_channels <= 0 || num_channels > kMaxBusChannels) {
+                return -1;
+            }
+
+            auto bus = std::make_unique<BusStrip>();
+            bus->name = name;
+            bus->num_channels = num_channels;
+            bus->buffer.assign(num_channels, std::vector<AudioSample>(max_block_size_, 0.0f));
+            for (auto& channel : bus->buffer) {
+                bus->channel_ptrs.push_back(channel.data());
+            }
+            bus->first_output_channel.store(first_output_channel);
+            for (int ch = 0; ch < num_channels; ++ch) {
+                DelayLine* line = delay_pool_.acquire();
+                if (line == nullptr) {
+                    // Keep the bus usable, it just won't be latency compensated
+                    std::cout << "[MIX] Delay line pool exhausted, bus '" << name
+                        << "' runs without delay compensation" << std::endl;
+                    for (auto* acquired : bus->delay_lines) delay_pool_.release(acquired);
+                    bus->delay_lines.clear();
+                    break;
+                }
+                bus->delay_lines.push_back(line);
+            }
+            for (auto& slot : bus->inserts) {
+                if (plugin_host_) plugin_host_->attach_slot(&slot, num_channels);
+            }
+
+            buses_[index] = std::move(bus);
+            num_buses_.store(index + 1, std::memory_order_release);
+
+            std::cout << "[MIX] Added bus " << index << " '" << name << "' (" << num_channels
+                << " ch -> output " << first_output_channel << ")" << std::endl;
+            return index;
+        }
+
+        BusStrip* bus(int bus_index) const {
+            if (bus_index < 0 || bus_index >= num_buses_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return buses_[bus_index].get();
+        }
+
+        // The audio thread switches to the new layout at its next block. A
+        // group whose channel count changes (or that goes away) must have no
+        // plugins loaded, since they were prepared for the old count.
+        bool set_output_groups(const std::vector<int>& group_sizes) {
+            std::lock_guard<std::mutex> lock(config_mutex_);
+
+            const int num_groups = static_cast<int>(group_sizes.size());
+            if (num_groups > kMaxOutputGroups) {
+                return false;
+            }
+            for (const int size : group_sizes) {
+                if (size <= 0 || size > kMaxBusChannels) {
+                    return false;
+                }
+            }
+
+            for (int g = 0; g < kMaxOutputGroups; ++g) {
+                const int old_size = g < layout_.num_groups ? layout_.group_sizes[g] : 0;
+                const int new_size = g < num_groups ? group_sizes[g] : 0;
+                if (new_size == old_size) {
+                    continue;
+                }
+                for (const auto& slot : output_groups_[g].inserts) {
+                    if (slot.is_loaded()) {
+                        std::cout << "[MIX] Output group " << g << " has plugins loaded, unload them before "
+                            << "changing its channels" << std::endl;
+                        return false;
+                    }
+                }
+            }
+
+            for (int g = 0; g < num_groups; ++g) {
+                const int old_size = g < layout_.num_groups ? layout_.group_sizes[g] : 0;
+                if (group_sizes[g] != old_size && plugin_host_) {
+                    for (auto& slot : output_groups_[g].inserts) {
+                        plugin_host_->attach_slot(&slot, group_sizes[g]);
+                    }
+                }
+            }
+
+            OutputGroupLayout& layout = group_layout_.write_buffer();
+            layout.num_groups = num_groups;
+            layout.group_sizes.fill(0);
+            std::copy(group_sizes.begin(), group_sizes.end(), layout.group_sizes.begin());
+            layout_ = layout;
+            group_layout_.publish();
+            num_output_groups_.store(num_groups, std::memory_order_release);
+            return true;
+        }
+
+        MixBusInfo get_bus_info(int bus_index) const {
+            MixBusInfo info{};
+            info.bus_index = -1;
+
+            BusStrip* strip = bus(bus_index);
+            if (strip == nullptr) {
+                return info;
+            }
+
+            std::lock_guard<std::mutex> lock(config_mutex_);
+            info.bus_index = bus_index;
+            info.name = strip->name;
+            info.num_channels = strip->num_channels;
+            info.first_output_channel = strip->first_output_channel.load();
+            info.gain = strip->gain.load();
+            info.is_muted = strip->muted.load();
+            info.insert_latency_samples = 0;
+            for (const auto& slot : strip->inserts) {
+                info.insert_latency_samples += slot.get_latency_samples();
+            }
+            info.compensation_delay_samples = strip->compensation_samples.load(std::memory_order_acquire);
+            info.is_silent = strip->silent.load(std::memory_order_relaxed);
+            return info;
+        }
+
+        bool add_output_tap(AudioTap* tap) {
+            return attach_tap(output_taps_, tap);
+        }
+
+        void remove_output_tap(AudioTap* tap, std::shared_ptr<void> owner) {
+            detach_tap(output_taps_, tap);
+            if (!boundary_.wait()) {
+                boundary_.retire(std::move(owner));
+            }
+        }
+
+        bool add_bus_tap(int bus_index, AudioTap* tap) {
+            BusStrip* strip = bus(bus_index);
+            return strip != nullptr && attach_tap(strip->taps, tap);
+        }
+
+        // After a tap is detached the audio thread may still be writing to it
+        // for the rest of the current block
+        void remove_bus_tap(int bus_index, AudioTap* tap, std::shared_ptr<void> owner) {
+            if (BusStrip* strip = bus(bus_index)) {
+                detach_tap(strip->taps, tap);
+                if (!boundary_.wait()) {
+                    boundary_.retire(std::move(owner));
+                }
+            }
+        }
+
+        bool set_num_worker_threads(int num_workers) {
+            worker_pool_.stop();
+            return num_workers == 0 || worker_pool_.start(num_workers);
+        }
+
+        // REAL-TIME THREAD
+        void begin_block(int num_samples) {
+            const int num_buses = num_buses_.load(std::memory_order_acquire);
+            current_block_size_ = std::min(num_samples, max_block_size_);
+
+            // Only buses that were touched need clearing, idle ones are still zero
+            for (int b = 0; b < num_buses; ++b) {
+                BusStrip& strip = *buses_[b];
+                if (strip.dirty) {
+                    for (auto& channel : strip.buffer) {
+                        std::fill(channel.begin(), channel.end(), 0.0f);
+                    }
+                    strip.dirty = false;
+                }
+                strip.written = false;
+            }
+        }
+
+        BusStrip* write_bus(int bus_index) {
+            BusStrip* strip = bus(bus_index);
+            if (strip != nullptr) {
+                strip->written = true;
+                strip->dirty = true;
+            }
+            return strip;
+        }
+
+        // A bus is silent when nothing was mixed into it and nothing from
+        // earlier blocks can still come out of its inserts or delay lines
+        bool update_bus_silence(BusStrip& strip, int num_samples) {
+            if (strip.written) {
+                strip.tail_samples = strip.compensation_samples.load(std::memory_order_relaxed);
+            }
+            else {
+                strip.tail_samples = std::max(0, strip.tail_samples - num_samples);
+            }
+
+            const bool silent = !strip.written && strip.tail_samples == 0 && !chain_is_active(strip.inserts);
+            strip.silent.store(silent, std::memory_order_relaxed);
+            if (!silent) {
+                strip.dirty = true; // Inserts and delay lines write into the buffer
+            }
+            return silent;
+        }
+
+        void process(AudioBuffer& outputs, int num_samples, DirectFeedFunction direct_feed, void* direct_context) {
+            boundary_.enter();
+            num_samples = std::min(num_samples, max_block_size_);
+            current_block_size_ = num_samples;
+            const int num_buses = num_buses_.load(std::memory_order_acquire);
+            if (group_layout_.update()) {
+                apply_output_layout(group_layout_.read_buffer());
+            }
+            const int num_groups = num_active_groups_;
+
+            // Pick up plugins published by the loader thread at this block boundary
+            for (int b = 0; b < num_buses; ++b) {
+                for (auto& slot : buses_[b]->inserts) slot.update_active_plugin();
+            }
+            for (int g = 0; g < num_groups; ++g) {
+                for (auto& slot : output_groups_[g].inserts) slot.update_active_plugin();
+            }
+
+            update_delay_compensation(num_buses, num_groups);
+            bus_meters_.begin_block();
+            output_meters_.begin_block();
+
+            for (int b = 0; b < num_buses; ++b) {
+                bus_silent_[b] = update_bus_silence(*buses_[b], num_samples);
+            }
+
+            // Bus insert chains: offloaded chains go to the workers while the
+            // audio thread runs the inline ones
+            int num_jobs = 0;
+            for (int b = 0; b < num_buses; ++b) {
+                if (chain_is_offloaded(buses_[b]->inserts)) {
+                    job_indices_[num_jobs++] = b;
+                }
+            }
+            worker_pool_.dispatch_jobs(&Impl::run_bus_job, this, num_jobs);
+            for (int b = 0; b < num_buses; ++b) {
+                BusStrip& strip = *buses_[b];
+                if (!bus_silent_[b] && !chain_is_offloaded(strip.inserts)) {
+                    process_bus(strip, num_samples);
+                }
+            }
+            worker_pool_.wait_for_jobs();
+
+            // Sum buses into the device outputs. Silent buses only feed their
+            // taps (the buffer is still zero) and count meter time.
+            for (int b = 0; b < num_buses; ++b) {
+                write_taps(buses_[b]->taps, buses_[b]->buffer, num_samples);
+                if (bus_silent_[b]) {
+                    skip_silent_bus(b, *buses_[b], num_samples);
+                }
+                else {
+                    sum_bus_to_outputs(b, *buses_[b], outputs, num_samples);
+                }
+            }
+
+            // Output group insert chains
+            num_jobs = 0;
+            for (int g = 0; g < num_groups; ++g) {
+                OutputGroup& group = output_groups_[g];
+                if (!chain_is_active(group.inserts) || !bind_output_group(group, outputs)) {
+                    continue;
+                }
+                if (chain_is_offloaded(group.inserts)) {
+                    job_indices_[num_jobs++] = g;
+                }
+            }
+            worker_pool_.dispatch_jobs(&Impl::run_output_job, this, num_jobs);
+            for (int g = 0; g < num_groups; ++g) {
+                OutputGroup& group = output_groups_[g];
+                if (!chain_is_offloaded(group.inserts) && chain_is_active(group.inserts)
+                    && bind_output_group(group, outputs)) {
+                    run_chain(group.inserts, group.channel_ptrs.data(), group.num_channels, num_samples);
+                }
+            }
+            worker_pool_.wait_for_jobs();
+
+            // Align output groups with the slowest group
+            const int num_delayed_outputs = std::min(static_cast<int>(outputs.size()),
+                static_cast<int>(output_delays_.size()));
+            for (int ch = 0; ch < num_delayed_outputs; ++ch) {
+                if (output_delays_[ch] != nullptr) {
+                    output_delays_[ch]->process(outputs[ch].data(), num_samples);
+                }
+            }
+
+            // Direct feeds join here, then trim and meter the final signal
+            if (direct_feed != nullptr) {
+                direct_feed(direct_context, outputs, num_samples);
+            }
+            for (int ch = 0; ch < num_delayed_outputs; ++ch) {
+                apply_output_gain(ch, outputs[ch].data(), num_samples);
+                output_meters_.measure(ch, outputs[ch].data(), num_samples);
+            }
+
+            bus_meters_.publish();
+            output_meters_.publish();
+
+            // Hand the final signal to the analysis taps (copy only)
+            write_taps(output_taps_, outputs, num_samples);
+
+            boundary_.leave();
+        }
+
+        // Takes over a layout published by set_output_groups
+        void apply_output_layout(const OutputGroupLayout& layout) {
+            int first_channel = 0;
+            for (int g = 0; g < layout.num_groups; ++g) {
+                OutputGroup& group = output_groups_[g];
+                group.first_channel = first_channel;
+                group.num_channels = layout.group_sizes[g];
+                group.latency_samples = -1; // Forces a compensation retarget
+                first_channel += group.num_channels;
+            }
+            num_active_groups_ = layout.num_groups;
+
+            // Outputs that left a delayed group must not keep its delay
+            for (auto* line : output_delays_) {
+                if (line != nullptr) line->set_delay(0);
+            }
+        }
+
+        // Recomputes path latencies and retargets the compensation delays.
+        // Only integer sums and compares unless a latency actually changed.
+        void update_delay_compensation(int num_buses, int num_groups) {
+            bool changed = false;
+            int max_bus_latency = 0;
+            for (int b = 0; b < num_buses; ++b) {
+                BusStrip& strip = *buses_[b];
+                const int latency = chain_latency(strip.inserts);
+                changed |= (latency != strip.latency_samples);
+                strip.latency_samples = latency;
+                max_bus_latency = std::max(max_bus_latency, latency);
+            }
+
+            int max_group_latency = 0;
+            for (int g = 0; g < num_groups; ++g) {
+                OutputGroup& group = output_groups_[g];
+                const int latency = chain_latency(group.inserts);
+                changed |= (latency != group.latency_samples);
+                group.latency_samples = latency;
+                max_group_latency = std::max(max_group_latency, latency);
+            }
+
+            if (!changed && num_buses == compensated_buses_) {
+                return;
+            }
+            compensated_buses_ = num_buses;
+
+            for (int b = 0; b < num_buses; ++b) {
+                BusStrip& strip = *buses_[b];
+                const int compensation = max_bus_latency - strip.latency_samples;
+                for (auto* line : strip.delay_lines) {
+                    line->set_delay(compensation);
+                }
+                strip.compensation_samples.store(compensation, std::memory_order_release);
+            }
+
+            for (int g = 0; g < num_groups; ++g) {
+                OutputGroup& group = output_groups_[g];
+                const int first = group.first_channel;
+                const int count = group.num_channels;
+                for (int ch = first; ch < first + count && ch < static_cast<int>(output_delays_.size()); ++ch) {
+                    if (output_delays_[ch] != nullptr) {
+                        output_delays_[ch]->set_delay(max_group_latency - group.latency_samples);
+                    }
+                }
+            }
+
+            total_latency_samples_.store(max_bus_latency + max_group_latency, std::memory_order_release);
+        }
+
+        static void run_bus_job(void* context, int job_index) {
+            auto* self = static_cast<Impl*>(context);
+            process_bus(*self->buses_[self->job_indices_[job_index]], self->current_block_size_);
+        }
+
+        static void run_output_job(void* context, int job_index) {
+            auto* self = static_cast<Impl*>(context);
+            OutputGroup& group = self->output_groups_[self->job_indices_[job_index]];
+            run_chain(group.inserts, group.channel_ptrs.data(), group.num_channels, self->current_block_size_);
+        }
+
+        bool bind_output_group(OutputGroup& group, AudioBuffer& outputs) {
+            const int first = group.first_channel;
+            const int count = group.num_channels;
+            if (first + count > static_cast<int>(outputs.size())) {
+                return false;
+            }
+            for (int ch = 0; ch < count; ++ch) {
+                group.channel_ptrs[ch] = outputs[first + ch].data();
+            }
+            return true;
+        }
+
+        // Output trim, ramped across the block like the bus faders
+        void apply_output_gain(int channel, float* data, int num_samples) {
+            const float target = output_gains_[channel].load(std::memory_order_relaxed);
+            const float start = applied_output_gains_[channel];
+            applied_output_gains_[channel] = target;
+            if (start == 1.0f && target == 1.0f) {
+                return;
+            }
+
+            const float step = (target - start) / static_cast<float>(num_samples);
+            for (int i = 0; i < num_samples; ++i) {
+                data[i] *= start + step * static_cast<float>(i + 1);
+            }
+        }
+
+        void skip_silent_bus(int bus_index, BusStrip& strip, int num_samples) {
+            strip.applied_gain = strip.muted.load(std::memory_order_relaxed)
+                ? 0.0f : strip.gain.load(std::memory_order_relaxed);
+            for (int ch = 0; ch < strip.num_channels; ++ch) {
+                bus_meters_.accumulator(bus_index * kMaxBusChannels + ch).num_samples += num_samples;
+            }
+        }
+
+        void sum_bus_to_outputs(int bus_index, BusStrip& strip, AudioBuffer& outputs, int num_samples) {
+            const float target_gain = strip.muted.load(std::memory_order_relaxed)
+                ? 0.0f : strip.gain.load(std::memory_order_relaxed);
+            const float start_gain = strip.applied_gain;
+            strip.applied_gain = target_gain;
+
+            const int first_output = strip.first_output_channel.load(std::memory_order_relaxed);
+
+            for (int ch = 0; ch < strip.num_channels; ++ch) {
+                const int meter_index = bus_index * kMaxBusChannels + ch;
+                if (start_gain == 0.0f && target_gain == 0.0f) {
+                    bus_meters_.accumulator(meter_index).num_samples += num_samples;
+                    continue;
+                }
+
+                const int out_ch = first_output + ch;
+                float* dst = (out_ch >= 0 && out_ch < static_cast<int>(outputs.size()))
+                    ? outputs[out_ch].data() : nullptr;
+
+                // Post-fader bus level is measured in the same pass that sums it,
+                // with the gain ramped over the block so changes don't zipper
+                const float* src = strip.buffer[ch].data();
+                mix_and_measure(src, dst, start_gain, target_gain, num_samples,
+                    bus_meters_.accumulator(meter_index));
+                bus_meters_.measure_true_peak(meter_index, src, num_samples,
+                    std::max(start_gain, target_gain));
+            }
+        }
+
+        int sample_rate_;
+        int max_block_size_;
+        int num_outputs_;
+        PluginHost* plugin_host_;
+        bool initialized_;
+
+        mutable std::mutex config_mutex_;
+        std::array<std::unique_ptr<BusStrip>, kMaxBuses> buses_;
+        std::atomic<int> num_buses_{ 0 };
+        std::array<OutputGroup, kMaxOutputGroups> output_groups_;
+        std::atomic<int> num_output_groups_{ 0 }; // Latest set_output_groups
+        OutputGroupLayout layout_;                // Same, under config_mutex_
+        TripleBuffer<OutputGroupLayout> group_layout_; // To the audio thread
+        int num_active_groups_ = 0;               // audio thread only
+
+        // Metering (bus meters indexed bus * kMaxBusChannels + channel)
+        MeterBank bus_meters_;
+        MeterBank output_meters_;
+
+        // Non-realtime analysis taps on the device outputs
+        std::array<std::atomic<AudioTap*>, kMaxOutputTaps> output_taps_{};
+        BlockBoundary boundary_;
+
+        // Plugin delay compensation
+        DelayLinePool delay_pool_;
+        std::vector<DelayLine*> output_delays_;
+        std::unique_ptr<std::atomic<float>[]> output_gains_; // num_outputs_, fixed at initialize
+        std::vector<float> applied_output_gains_;            // audio thread only
+        std::atomic<int> total_latency_samples_{ 0 };
+        int compensated_buses_ = 0; // audio thread only
+
+        // Realtime worker threads for offloaded insert chains
+        RealtimeWorkerPool worker_pool_;
+        std::array<int, (kMaxBuses > kMaxOutputGroups ? kMaxBuses : kMaxOutputGroups)> job_indices_{};
+        std::array<bool, kMaxBuses> bus_silent_{};
+        int current_block_size_;
+    };
+
+    // MixGraph public interface
+    MixGraph::MixGraph() : impl_(std::make_unique<Impl>()) {}
+    MixGraph::~MixGraph() = default;
+
+    bool MixGraph::initialize(int sample_rate, int max_block_size, int num_outputs, PluginHost* plugin_host) {
+        return impl_->initialize(sample_rate, max_block_size, num_outputs, plugin_host);
+    }
+
+    void MixGraph::shutdown() {
+        impl_->shutdown();
+    }
+
+    int MixGraph::add_bus(const std::string& name, int num_channels, int first_output_channel) {
+        return impl_->add_bus(name, num_channels, first_output_channel);
+    }
+
+    bool MixGraph::set_bus_output(int bus_index, int first_output_channel) {
+        auto* strip = impl_->bus(bus_index);
+        if (strip == nullptr) return false;
+        strip->first_output_channel.store(first_output_channel, std::memory_order_release);
+        return true;
+    }
+
+    bool MixGraph::set_bus_gain(int bus_index, float gain) {
+        auto* strip = impl_->bus(bus_index);
+        if (strip == nullptr) return false;
+        strip->gain.store(std::max(0.0f, gain), std::memory_order_release);
+        return true;
+    }
+
+    bool MixGraph::set_bus_mute(int bus_index, bool muted) {
+        auto* strip = impl_->bus(bus_index);
+        if (strip == nullptr) return false;
+        strip->muted.store(muted, std::memory_order_release);
+        return true;
+    }
+
+    float MixGraph::get_bus_gain(int bus_index) const {
+        auto* strip = impl_->bus(bus_index);
+        return strip != nullptr ? strip->gain.load(std::memory_order_acquire) : 0.0f;
+    }
+
+    int MixGraph::get_num_outputs() const {
+        return impl_->num_outputs_;
+    }
+
+    bool MixGraph::set_output_gain(int output_channel, float gain) {
+        if (output_channel < 0 || output_channel >= impl_->num_outputs_ || !impl_->output_gains_) return false;
+        impl_->output_gains_[output_channel].store(std::max(0.0f, gain), std::memory_order_release);
+        return true;
+    }
+
+    float MixGraph::get_output_gain(int output_channel) const {
+        if (output_channel < 0 || output_channel >= impl_->num_outputs_ || !impl_->output_gains_) return 0.0f;
+        return impl_->output_gains_[output_channel].load(std::memory_order_acquire);
+    }
+
+    int MixGraph::get_num_buses() const {
+        return impl_->num_buses_.load(std::memory_order_acquire);
+    }
+
+    MixBusInfo MixGraph::get_bus_info(int bus_index) const {
+        return impl_->get_bus_info(bus_index);
+    }
+
+    int MixGraph::get_num_output_groups() const {
+        return impl_->num_output_groups_.load(std::memory_order_acquire);
+    }
+
+    bool MixGraph::set_output_groups(const std::vector<int>& group_sizes) {
+        return impl_->set_output_groups(group_sizes);
+    }
+
+    PluginInsertSlot* MixGraph::get_bus_insert(int bus_index, int slot_index) {
+        auto* strip = impl_->bus(bus_index);
+        if (strip == nullptr || slot_index < 0 || slot_index >= kMaxInsertsPerStrip) return nullptr;
+        return &strip->inserts[slot_index];
+    }
+
+    PluginInsertSlot* MixGraph::get_output_insert(int group_index, int slot_index) {
+        if (group_index < 0 || group_index >= get_num_output_groups()
+            || slot_index < 0 || slot_index >= kMaxInsertsPerStrip) {
+            return nullptr;
+        }
+        return &impl_->output_groups_[group_index].inserts[slot_index];
+    }
+
+    bool MixGraph::set_num_worker_threads(int num_workers) {
+        return impl_->set_num_worker_threads(num_workers);
+    }
+
+    int MixGraph::get_total_latency_samples() const {
+        return impl_->total_latency_samples_.load(std::memory_order_acquire);
+    }
+
+    MeterBank* MixGraph::get_bus_meters() {
+        return &impl_->bus_meters_;
+    }
+
+    int MixGraph::get_sample_rate() const {
+        return impl_->sample_rate_;
+    }
+
+    bool MixGraph::add_output_tap(AudioTap* tap) {
+        return tap != nullptr && impl_->add_output_tap(tap);
+    }
+
+    void MixGraph::remove_output_tap(AudioTap* tap, std::shared_ptr<void> owner) {
+        impl_->remove_output_tap(tap, std::move(owner));
+    }
+
+    bool MixGraph::add_bus_tap(int bus_index, AudioTap* tap) {
+        return tap != nullptr && impl_->add_bus_tap(bus_index, tap);
+    }
+
+    void MixGraph::remove_bus_tap(int bus_index, AudioTap* tap, std::shared_ptr<void> owner) {
+        impl_->remove_bus_tap(bus_index, tap, std::move(owner));
+    }
+
+    MeterBank* MixGraph::get_output_meters() {
+        return &impl_->output_meters_;
+    }
+
+    AudioBuffer* MixGraph::get_bus_buffer(int bus_index) {
+        auto* strip = impl_->write_bus(bus_index);
+        return strip ? &strip->buffer : nullptr;
+    }
+
+    void MixGraph::begin_block(int num_samples) {
+        impl_->begin_block(num_samples);
+    }
+
+    void MixGraph::process(AudioBuffer& outputs, int num_samples, DirectFeedFunction direct_feed, void* direct_context) {
+        impl_->process(outputs, num_samples, direct_feed, direct_context);
+    }
+
+} // namespace SharedAudio
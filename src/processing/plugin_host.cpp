@@ -0,0 +1,481 @@
+﻿#include "processing/plugin_host.h"
+#include "processing/delay_line_pool.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <thread>
+
+namespace SharedAudio {
+
+    struct LoadedPlugin {
+        std::unique_ptr<juce::AudioPluginInstance> instance;
+        juce::MidiBuffer midi;
+        std::string name;
+
+        // Plugins with more channels than the slot (e.g. sidechain inputs)
+        // get silent scratch channels, preallocated at load time
+        std::vector<std::vector<float>> scratch_channels;
+        std::vector<float*> channel_ptrs;
+
+        // Plugins without a bypass parameter of their own, one line per slot
+        // channel: bypassed, the dry signal runs through these delayed by the
+        // plugin's latency (up to twice what it reported at load)
+        std::vector<DelayLine> bypass_delays;
+        bool was_bypassed = false; // audio thread only
+    };
+
+    namespace {
+        // Published into a slot to request an unload at the next block boundary
+        LoadedPlugin unload_sentinel;
+
+        void destroy_plugin(LoadedPlugin* plugin) {
+            if (plugin != nullptr && plugin != &unload_sentinel) {
+                plugin->instance->releaseResources();
+                delete plugin;
+            }
+        }
+    }
+
+    // PluginInsertSlot implementation
+    PluginInsertSlot::PluginInsertSlot() = default;
+
+    PluginInsertSlot::~PluginInsertSlot() {
+        // Only destroyed once the audio thread no longer runs this slot
+        destroy_plugin(pending_.exchange(nullptr));
+        destroy_plugin(active_);
+    }
+
+    std::string PluginInsertSlot::get_plugin_name() const {
+        std::lock_guard<std::mutex> lock(name_mutex_);
+        return plugin_name_;
+    }
+
+    void PluginInsertSlot::publish(LoadedPlugin* plugin, int latency_samples) {
+        LoadedPlugin* replaced = pending_.exchange(plugin ? plugin : &unload_sentinel,
+            std::memory_order_acq_rel);
+
+        // The audio thread never saw an instance that was replaced while pending
+        destroy_plugin(replaced);
+
+        published_ = plugin;
+        latency_samples_.store(plugin ? latency_samples : 0, std::memory_order_release);
+        has_plugin_.store(plugin != nullptr, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(name_mutex_);
+        plugin_name_ = plugin ? plugin->name : std::string();
+    }
+
+    void PluginInsertSlot::update_active_plugin() {
+        // If the loader thread has fallen so far behind that it cannot take
+        // the current instance back, keep running it; the new one stays
+        // pending until a later block
+        if (active_ != nullptr && retire_queue_ != nullptr && retire_queue_->is_full()) {
+            return;
+        }
+
+        LoadedPlugin* incoming = pending_.exchange(nullptr, std::memory_order_acq_rel);
+        if (incoming == nullptr) {
+            return;
+        }
+
+        LoadedPlugin* previous = active_;
+        active_ = (incoming == &unload_sentinel) ? nullptr : incoming;
+
+        if (previous != nullptr && retire_queue_ != nullptr) {
+            retire_queue_->push(previous);
+        }
+    }
+
+    int PluginInsertSlot::get_active_latency_samples() const {
+        // Plugins may change their latency at runtime (e.g. lookahead settings)
+        return active_ ? active_->instance->getLatencySamples() : 0;
+    }
+
+    void PluginInsertSlot::process(float* const* channels, int num_channels, int num_samples) {
+        if (active_ == nullptr) {
+            return;
+        }
+
+        LoadedPlugin& plugin = *active_;
+        const bool bypassed = bypassed_.load(std::memory_order_relaxed);
+
+        // A plugin with its own bypass parameter keeps its latency through
+        // processBlockBypassed. For the others JUCE passes the input straight
+        // through, which would run ahead of the delay compensation, so the
+        // dry signal goes through the bypass lines instead.
+        const int num_lines = std::min(num_channels, static_cast<int>(plugin.bypass_delays.size()));
+        if (num_lines > 0) {
+            if (bypassed) {
+                const int latency = plugin.instance->getLatencySamples();
+                for (int ch = 0; ch < num_lines; ++ch) {
+                    plugin.bypass_delays[ch].set_delay(latency);
+                    plugin.bypass_delays[ch].process(channels[ch], num_samples);
+                }
+                plugin.was_bypassed = true;
+                return;
+            }
+
+            // At zero delay the lines only record the input, ready for a bypass
+            for (int ch = 0; ch < num_lines; ++ch) {
+                if (plugin.was_bypassed) {
+                    plugin.bypass_delays[ch].reset();
+                }
+                plugin.bypass_delays[ch].process(channels[ch], num_samples);
+            }
+            plugin.was_bypassed = false;
+        }
+
+        const int total_channels = static_cast<int>(plugin.channel_ptrs.size());
+
+        for (int ch = 0; ch < total_channels; ++ch) {
+            if (ch < num_channels) {
+                plugin.channel_ptrs[ch] = channels[ch];
+            }
+            else {
+                float* scratch = plugin.scratch_channels[ch].data();
+                std::fill(scratch, scratch + num_samples, 0.0f);
+                plugin.channel_ptrs[ch] = scratch;
+            }
+        }
+
+        juce::AudioBuffer<float> buffer(plugin.channel_ptrs.data(), total_channels, num_samples);
+        plugin.midi.clear();
+
+        if (bypassed) {
+            plugin.instance->processBlockBypassed(buffer, plugin.midi);
+        }
+        else {
+            plugin.instance->processBlock(buffer, plugin.midi);
+        }
+    }
+
+    // PluginHost implementation
+    class PluginHost::Impl {
+    public:
+        Impl() : sample_rate_(48000.0), max_block_size_(256), initialized_(false), running_(false) {}
+
+        ~Impl() {
+            shutdown();
+        }
+
+        bool initialize(double sample_rate, int max_block_size) {
+            if (initialized_) {
+                return true;
+            }
+
+            sample_rate_ = sample_rate;
+            max_block_size_ = max_block_size;
+
+            format_manager_.addDefaultFormats();
+
+            running_ = true;
+            loader_thread_ = std::thread(&Impl::loader_loop, this);
+            initialized_ = true;
+
+            std::cout << "[PLUGIN] PluginHost initialized with " << format_manager_.getNumFormats()
+                << " format(s) (SR: " << sample_rate << " Hz, Block: " << max_block_size << ")" << std::endl;
+            return true;
+        }
+
+        void shutdown() {
+            if (!initialized_) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(jobs_mutex_);
+                running_ = false;
+            }
+            jobs_cv_.notify_all();
+            if (loader_thread_.joinable()) {
+                loader_thread_.join();
+            }
+
+            // Back to the thread shutting down, which also owns the slots
+            juce::MessageManager::getInstance()->setCurrentThreadAsMessageThread();
+            drain_retire_queue();
+            initialized_ = false;
+            std::cout << "[PLUGIN] PluginHost shutdown" << std::endl;
+        }
+
+        void attach_slot(PluginInsertSlot* slot, int num_channels) {
+            slot->num_channels_.store(num_channels, std::memory_order_release);
+            slot->retire_queue_ = &retire_queue_;
+        }
+
+        std::vector<PluginInfo> scan_plugin_file(const std::string& file_or_identifier) {
+            auto result = std::make_shared<std::promise<std::vector<PluginInfo>>>();
+            auto future = result->get_future();
+
+            if (!enqueue([this, file_or_identifier, result]() {
+                std::vector<PluginInfo> found;
+                juce::OwnedArray<juce::PluginDescription> types;
+                find_types(file_or_identifier, types);
+
+                for (auto* type : types) {
+                    PluginInfo info;
+                    info.name = type->name.toStdString();
+                    info.manufacturer = type->manufacturerName.toStdString();
+                    info.format_name = type->pluginFormatName.toStdString();
+                    info.file_or_identifier = type->fileOrIdentifier.toStdString();
+                    info.num_input_channels = type->numInputChannels;
+                    info.num_output_channels = type->numOutputChannels;
+                    found.push_back(info);
+                }
+                result->set_value(std::move(found));
+            })) {
+                return {};
+            }
+
+            return future.get();
+        }
+
+        bool load_plugin_async(PluginInsertSlot* slot, const std::string& file_or_identifier,
+            const std::vector<uint8_t>& state, LoadCallback callback) {
+            if (slot == nullptr || slot->retire_queue_ == nullptr) {
+                set_error("Plugin slot is not attached to the host");
+                return false;
+            }
+
+            return enqueue([this, slot, file_or_identifier, state, callback]() {
+                std::string error;
+                LoadedPlugin* plugin = instantiate(file_or_identifier, slot->get_num_channels(), state, error);
+
+                if (plugin == nullptr) {
+                    set_error(error);
+                    std::cout << "[PLUGIN] Failed to load " << file_or_identifier << ": " << error << std::endl;
+                    if (callback) callback(false, error);
+                    return;
+                }
+
+                const int latency = plugin->instance->getLatencySamples();
+                slot->publish(plugin, latency);
+
+                std::cout << "[PLUGIN] Loaded " << plugin->name << " (latency: " << latency
+                    << " samples)" << std::endl;
+                if (callback) callback(true, std::string());
+            });
+        }
+
+        bool unload_plugin_async(PluginInsertSlot* slot, LoadCallback callback) {
+            if (slot == nullptr) {
+                return false;
+            }
+
+            return enqueue([slot, callback]() {
+                slot->publish(nullptr, 0);
+                if (callback) callback(true, std::string());
+            });
+        }
+
+        bool get_plugin_state_async(PluginInsertSlot* slot,
+            std::function<void(std::vector<uint8_t> state)> callback) {
+            if (slot == nullptr || !callback) {
+                return false;
+            }
+
+            return enqueue([slot, callback]() {
+                std::vector<uint8_t> state;
+                if (slot->published_ != nullptr) {
+                    juce::MemoryBlock block;
+                    slot->published_->instance->getStateInformation(block);
+                    const auto* bytes = static_cast<const uint8_t*>(block.getData());
+                    state.assign(bytes, bytes + block.getSize());
+                }
+                callback(std::move(state));
+            });
+        }
+
+        std::string get_last_error() const {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            return last_error_;
+        }
+
+    private:
+        bool enqueue(std::function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(jobs_mutex_);
+                if (!running_) {
+                    set_error("PluginHost is not running");
+                    return false;
+                }
+                jobs_.push_back(std::move(job));
+            }
+            jobs_cv_.notify_one();
+            return true;
+        }
+
+        void loader_loop() {
+            juce::MessageManager::getInstance()->setCurrentThreadAsMessageThread();
+
+            for (;;) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(jobs_mutex_);
+                    // Wake periodically to delete instances retired by the audio thread
+                    jobs_cv_.wait_for(lock, std::chrono::milliseconds(50),
+                        [this]() { return !jobs_.empty() || !running_; });
+
+                    if (!running_ && jobs_.empty()) {
+                        break;
+                    }
+                    if (!jobs_.empty()) {
+                        job = std::move(jobs_.front());
+                        jobs_.pop_front();
+                    }
+                }
+
+                if (job) {
+                    job();
+                }
+                drain_retire_queue();
+            }
+        }
+
+        void drain_retire_queue() {
+            LoadedPlugin* retired = nullptr;
+            while (retire_queue_.pop(retired)) {
+                destroy_plugin(retired);
+            }
+        }
+
+        void find_types(const std::string& file_or_identifier, juce::OwnedArray<juce::PluginDescription>& types) {
+            const juce::String id(file_or_identifier);
+            for (auto* format : format_manager_.getFormats()) {
+                if (format->fileMightContainThisPluginType(id)) {
+                    format->findAllTypesForFile(types, id);
+                }
+                if (!types.isEmpty()) {
+                    break;
+                }
+            }
+        }
+
+        LoadedPlugin* instantiate(const std::string& file_or_identifier, int num_channels,
+            const std::vector<uint8_t>& state, std::string& error) {
+            juce::OwnedArray<juce::PluginDescription> types;
+            find_types(file_or_identifier, types);
+
+            if (types.isEmpty()) {
+                error = "No plugin found in " + file_or_identifier;
+                return nullptr;
+            }
+
+            juce::String juce_error;
+            auto instance = format_manager_.createPluginInstance(*types[0], sample_rate_, max_block_size_, juce_error);
+            if (!instance) {
+                error = juce_error.toStdString();
+                return nullptr;
+            }
+
+            // Match the plugin's main buses to the slot; mono/stereo-only plugins
+            // that refuse the layout still run on their own channels
+            juce::AudioProcessor::BusesLayout layout = instance->getBusesLayout();
+            const auto channel_set = juce::AudioChannelSet::canonicalChannelSet(num_channels);
+            if (!layout.inputBuses.isEmpty()) layout.inputBuses.getReference(0) = channel_set;
+            if (!layout.outputBuses.isEmpty()) layout.outputBuses.getReference(0) = channel_set;
+            instance->setBusesLayout(layout);
+
+            if (instance->getMainBusNumOutputChannels() > num_channels) {
+                error = "Plugin needs " + std::to_string(instance->getMainBusNumOutputChannels())
+                    + " output channels, slot has " + std::to_string(num_channels);
+                return nullptr;
+            }
+
+            if (!state.empty()) {
+                instance->setStateInformation(state.data(), static_cast<int>(state.size()));
+            }
+
+            instance->prepareToPlay(sample_rate_, max_block_size_);
+
+            auto* plugin = new LoadedPlugin();
+            plugin->name = types[0]->name.toStdString();
+            plugin->midi.ensureSize(256);
+
+            // Scratch for every channel, not just the extra ones: a slot may be
+            // handed fewer channels than it had when this load started
+            const int total_channels = std::max(num_channels,
+                std::max(instance->getTotalNumInputChannels(), instance->getTotalNumOutputChannels()));
+            plugin->scratch_channels.assign(total_channels, std::vector<float>(max_block_size_, 0.0f));
+            plugin->channel_ptrs.resize(total_channels, nullptr);
+
+            if (instance->getBypassParameter() == nullptr) {
+                const int max_delay = std::max(64, instance->getLatencySamples() * 2);
+                plugin->bypass_delays.resize(num_channels);
+                for (auto& line : plugin->bypass_delays) {
+                    line.prepare(max_delay, max_block_size_);
+                }
+            }
+            plugin->instance = std::move(instance);
+            return plugin;
+        }
+
+        void set_error(const std::string& error) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            last_error_ = error;
+        }
+
+        double sample_rate_;
+        int max_block_size_;
+        bool initialized_;
+
+        juce::AudioPluginFormatManager format_manager_;
+
+        // Loader thread
+        std::thread loader_thread_;
+        std::mutex jobs_mutex_;
+        std::condition_variable jobs_cv_;
+        std::deque<std::function<void()>> jobs_;
+        bool running_;
+
+        // Instances swapped out by the audio thread, deleted by the loader thread
+        LockFreeFIFO<LoadedPlugin*, 64> retire_queue_;
+
+        mutable std::mutex error_mutex_;
+        std::string last_error_;
+    };
+
+    // PluginHost public interface
+    PluginHost::PluginHost() : impl_(std::make_unique<Impl>()) {}
+    PluginHost::~PluginHost() = default;
+
+    bool PluginHost::initialize(double sample_rate, int max_block_size) {
+        return impl_->initialize(sample_rate, max_block_size);
+    }
+
+    void PluginHost::shutdown() {
+        impl_->shutdown();
+    }
+
+    std::vector<PluginInfo> PluginHost::scan_plugin_file(const std::string& file_or_identifier) {
+        return impl_->scan_plugin_file(file_or_identifier);
+    }
+
+    bool PluginHost::load_plugin_async(PluginInsertSlot* slot, const std::string& file_or_identifier,
+        const std::vector<uint8_t>& state, LoadCallback callback) {
+        return impl_->load_plugin_async(slot, file_or_identifier, state, callback);
+    }
+
+    bool PluginHost::unload_plugin_async(PluginInsertSlot* slot, LoadCallback callback) {
+        return impl_->unload_plugin_async(slot, callback);
+    }
+
+    bool PluginHost::get_plugin_state_async(PluginInsertSlot* slot,
+        std::function<void(std::vector<uint8_t> state)> callback) {
+        return impl_->get_plugin_state_async(slot, callback);
+    }
+
+    void PluginHost::attach_slot(PluginInsertSlot* slot, int num_channels) {
+        impl_->attach_slot(slot, num_channels);
+    }
+
+    std::string PluginHost::get_last_error() const {
+        return impl_->get_last_error();
+    }
+
+} // namespace SharedAudio
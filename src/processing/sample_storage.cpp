@@ -0,0 +1,831 @@
+﻿#include "processing/sample_storage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHARED_AUDIO_STORAGE_SSE 1
+#endif
+
+// F16C is not part of the x86-64 baseline: compile the half-float path for
+// it separately and pick it at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHARED_AUDIO_F16C 1
+#define SHARED_AUDIO_F16C_TARGET __attribute__((target("avx,f16c")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#include <intrin.h>
+#define SHARED_AUDIO_F16C 1
+#define SHARED_AUDIO_F16C_TARGET
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr float kInt16Scale = 1.0f / 32768.0f;
+        constexpr float kInt24Scale = 1.0f / 8388608.0f;
+
+        int32_t to_int16(float sample) {
+            return std::max(-32768, std::min(32767, static_cast<int32_t>(std::lrint(sample * 32768.0f))));
+        }
+
+        int32_t to_int24(float sample) {
+            return std::max(-8388608, std::min(8388607, static_cast<int32_t>(std::lrint(sample * 8388608.0f))));
+        }
+
+        int32_t load_int24(const uint8_t* p) {
+            return static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16)
+                | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+        }
+
+        // Round-to-nearest-even float -> half (matches F16C's _MM_FROUND_TO_NEAREST_INT)
+        uint16_t float_to_half(float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+            bits &= 0x7fffffffu;
+
+            if (bits >= 0x7f800000u) {
+                return sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u); // NaN / infinity
+            }
+            if (bits >= 0x477ff000u) {
+                return sign | 0x7c00u; // Rounds past the largest half
+            }
+            if (bits < 0x38800000u) {
+                // Half subnormal: units of 2^-24, the scaling is exact
+                float magnitude;
+                std::memcpy(&magnitude, &bits, sizeof(magnitude));
+                return sign | static_cast<uint16_t>(std::lrint(magnitude * 16777216.0f));
+            }
+
+            uint32_t half = ((((bits >> 23) & 0xffu) - 112u) << 10) | ((bits & 0x7fffffu) >> 13);
+            const uint32_t remainder = bits & 0x1fffu;
+            if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+                ++half; // A carry into the exponent is still correct
+            }
+            return sign | static_cast<uint16_t>(half);
+        }
+
+        float half_to_float(uint16_t half) {
+            const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+            const uint32_t exponent = (half >> 10) & 0x1fu;
+            const uint32_t mantissa = half & 0x3ffu;
+
+            uint32_t bits;
+            if (exponent == 0) {
+                const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+                std::memcpy(&bits, &magnitude, sizeof(bits));
+                bits |= sign;
+            }
+            else if (exponent == 31) {
+                bits = sign | 0x7f800000u | (mantissa << 13);
+            }
+            else {
+                bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+            }
+
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+#ifdef SHARED_AUDIO_F16C
+        bool detect_f16c() {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+            return os_saves_ymm && (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 29)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+        }
+
+        const bool kHasF16C = detect_f16c();
+
+        SHARED_AUDIO_F16C_TARGET
+        void half_to_float_f16c(const uint16_t* src, int count, float* dest) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+            }
+            for (; i < count; ++i) {
+                dest[i] = half_to_float(src[i]);
+            }
+        }
+#endif
+
+        void read_int16(const int16_t* src, int count, float* dest) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            const __m128 scale = _mm_set1_ps(kInt16Scale);
+            for (; i + 8 <= count; i += 8) {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+                const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+                _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+            }
+#endif
+            for (; i < count; ++i) {
+                dest[i] = static_cast<float>(src[i]) * kInt16Scale;
+            }
+        }
+
+        void read_int24(const uint8_t* src, int count, float* dest) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            const __m128 scale = _mm_set1_ps(kInt24Scale);
+            for (; i + 4 <= count; i += 4, src += 12) {
+                const __m128i x = _mm_setr_epi32(load_int24(src), load_int24(src + 3), load_int24(src + 6), load_int24(src + 9));
+                _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+            }
+#endif
+            for (; i < count; ++i, src += 3) {
+                dest[i] = static_cast<float>(load_int24(src)) * kInt24Scale;
+            }
+        }
+
+        void read_half(const uint16_t* src, int count, float* dest) {
+#ifdef SHARED_AUDIO_F16C
+            if (kHasF16C) {
+                half_to_float_f16c(src, count, dest);
+                return;
+            }
+#endif
+            for (int i = 0; i < count; ++i) {
+                dest[i] = half_to_float(src[i]);
+            }
+        }
+
+        // Mix kernels: expand (when the format needs it), scale by gain then
+        // pan_gain, add into dest and track the level of what was added
+        void mix_one(float x, float gain, float pan_gain, float* dest, float* expanded, MixSpanLevels& levels) {
+            if (expanded != nullptr) {
+                *expanded = x;
+            }
+            const float y = x * gain * pan_gain;
+            *dest += y;
+            levels.peak = std::max(levels.peak, std::fabs(y));
+            levels.sum_sq += y * y;
+        }
+
+#ifdef SHARED_AUDIO_STORAGE_SSE
+        struct MixLanes {
+            __m128 gain;
+            __m128 pan_gain;
+            __m128 peak = _mm_setzero_ps();
+            __m128 sum_sq = _mm_setzero_ps();
+
+            MixLanes(float g, float p) : gain(_mm_set1_ps(g)), pan_gain(_mm_set1_ps(p)) {}
+
+            void mix(__m128 x, float* dest, float* expanded) {
+                if (expanded != nullptr) {
+                    _mm_storeu_ps(expanded, x);
+                }
+                const __m128 y = _mm_mul_ps(_mm_mul_ps(x, gain), pan_gain);
+                _mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), y));
+                peak = _mm_max_ps(peak, _mm_andnot_ps(_mm_set1_ps(-0.0f), y));
+                sum_sq = _mm_add_ps(sum_sq, _mm_mul_ps(y, y));
+            }
+
+            void finish(MixSpanLevels& levels) const {
+                alignas(16) float peaks[4];
+                alignas(16) float sums[4];
+                _mm_store_ps(peaks, peak);
+                _mm_store_ps(sums, sum_sq);
+                levels.peak = std::max(levels.peak, std::max(std::max(peaks[0], peaks[1]), std::max(peaks[2], peaks[3])));
+                levels.sum_sq += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+            }
+        };
+#endif
+
+        void mix_float(const float* src, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            MixLanes lanes(gain, pan_gain);
+            for (; i + 4 <= count; i += 4) {
+                lanes.mix(_mm_loadu_ps(src + i), dest + i, expanded != nullptr ? expanded + i : nullptr);
+            }
+            lanes.finish(levels);
+#endif
+            for (; i < count; ++i) {
+                mix_one(src[i], gain, pan_gain, dest + i, expanded != nullptr ? expanded + i : nullptr, levels);
+            }
+        }
+
+        void mix_int16(const int16_t* src, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            MixLanes lanes(gain, pan_gain);
+            const __m128 scale = _mm_set1_ps(kInt16Scale);
+            for (; i + 4 <= count; i += 4) {
+                const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+                const __m128 value = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale);
+                lanes.mix(value, dest + i, expanded != nullptr ? expanded + i : nullptr);
+            }
+            lanes.finish(levels);
+#endif
+            for (; i < count; ++i) {
+                mix_one(static_cast<float>(src[i]) * kInt16Scale, gain, pan_gain, dest + i,
+                    expanded != nullptr ? expanded + i : nullptr, levels);
+            }
+        }
+
+        void mix_int24(const uint8_t* src, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            MixLanes lanes(gain, pan_gain);
+            const __m128 scale = _mm_set1_ps(kInt24Scale);
+            for (; i + 4 <= count; i += 4, src += 12) {
+                const __m128i x = _mm_setr_epi32(load_int24(src), load_int24(src + 3), load_int24(src + 6), load_int24(src + 9));
+                lanes.mix(_mm_mul_ps(_mm_cvtepi32_ps(x), scale), dest + i, expanded != nullptr ? expanded + i : nullptr);
+            }
+            lanes.finish(levels);
+#endif
+            for (; i < count; ++i, src += 3) {
+                mix_one(static_cast<float>(load_int24(src)) * kInt24Scale, gain, pan_gain, dest + i,
+                    expanded != nullptr ? expanded + i : nullptr, levels);
+            }
+        }
+
+#ifdef SHARED_AUDIO_F16C
+        SHARED_AUDIO_F16C_TARGET
+        void mix_half_f16c(const uint16_t* src, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) {
+            MixLanes lanes(gain, pan_gain);
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128 value = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+                lanes.mix(value, dest + i, expanded != nullptr ? expanded + i : nullptr);
+            }
+            lanes.finish(levels);
+            for (; i < count; ++i) {
+                mix_one(half_to_float(src[i]), gain, pan_gain, dest + i, expanded != nullptr ? expanded + i : nullptr, levels);
+            }
+        }
+#endif
+
+        void mix_half(const uint16_t* src, int count, float gain, float pan_gain, float* dest, float* expanded,
+            MixSpanLevels& levels) {
+#ifdef SHARED_AUDIO_F16C
+            if (kHasF16C) {
+                mix_half_f16c(src, count, gain, pan_gain, dest, expanded, levels);
+                return;
+            }
+#endif
+            for (int i = 0; i < count; ++i) {
+                mix_one(half_to_float(src[i]), gain, pan_gain, dest + i, expanded != nullptr ? expanded + i : nullptr, levels);
+            }
+        }
+
+        uint32_t zigzag(uint32_t value) {
+            return (value << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(value) >> 31);
+        }
+
+        int bit_width(uint32_t value) {
+            int width = 0;
+            while (value != 0) {
+                ++width;
+                value >>= 1;
+            }
+            return width;
+        }
+
+        // Sub-blocks are 32 samples, so w bits each is exactly 4 * w bytes
+        void pack_sub_block(const uint32_t* values, int width, std::vector<uint8_t>& out) {
+            uint64_t buffer = 0;
+            int bits = 0;
+            for (int i = 0; i < kCompressedSubBlockFrames; ++i) {
+                buffer |= static_cast<uint64_t>(values[i]) << bits;
+                bits += width;
+                while (bits >= 8) {
+                    out.push_back(static_cast<uint8_t>(buffer));
+                    buffer >>= 8;
+                    bits -= 8;
+                }
+            }
+        }
+
+        void unpack_sub_block(const uint8_t* src, int width, int32_t* values) {
+            if (width == 0) {
+                std::memset(values, 0, kCompressedSubBlockFrames * sizeof(int32_t));
+                return;
+            }
+            const uint64_t mask = (uint64_t(1) << width) - 1;
+            uint64_t buffer = 0;
+            int bits = 0;
+            for (int i = 0; i < kCompressedSubBlockFrames; ++i) {
+                while (bits < width) {
+                    buffer |= static_cast<uint64_t>(*src++) << bits;
+                    bits += 8;
+                }
+                const uint32_t value = static_cast<uint32_t>(buffer & mask);
+                buffer >>= width;
+                bits -= width;
+                values[i] = static_cast<int32_t>((value >> 1) ^ (0u - (value & 1u)));
+            }
+        }
+
+        // In-place running sum continuing from carry (undoes one difference stage).
+        // Wrapping int32 arithmetic keeps it exact whatever the intermediate range.
+        void integrate(int32_t* values, int count, uint32_t& carry) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            __m128i running = _mm_set1_epi32(static_cast<int32_t>(carry));
+            for (; i + 4 <= count; i += 4) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+                x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+                x = _mm_add_epi32(x, running);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), x);
+                running = _mm_shuffle_epi32(x, 0xFF);
+            }
+            carry = static_cast<uint32_t>(_mm_cvtsi128_si32(running));
+#endif
+            for (; i < count; ++i) {
+                carry += static_cast<uint32_t>(values[i]);
+                values[i] = static_cast<int32_t>(carry);
+            }
+        }
+
+        void int_to_float(const int32_t* values, int count, float scale, float* dest) {
+            int i = 0;
+#ifdef SHARED_AUDIO_STORAGE_SSE
+            const __m128 scale4 = _mm_set1_ps(scale);
+            for (; i + 4 <= count; i += 4) {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale4));
+            }
+#endif
+            for (; i < count; ++i) {
+                dest[i] = static_cast<float>(values[i]) * scale;
+            }
+        }
+
+        constexpr int kMaxPredictorOrder = kCompressedMaxPredictorOrder;
+        constexpr int kSubBlocksPerBlock = kCompressedSubBlocksPerBlock;
+
+        bool is_exact(const AudioBuffer& channels, SampleFormat format) {
+            for (const auto& channel : channels) {
+                for (float sample : channel) {
+                    const float decoded = format == SampleFormat::INT16
+                        ? static_cast<float>(to_int16(sample)) * kInt16Scale
+                        : static_cast<float>(to_int24(sample)) * kInt24Scale;
+                    if (decoded != sample) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    size_t sample_format_bytes(SampleFormat format) {
+        switch (format) {
+        case SampleFormat::FLOAT32: return 4;
+        case SampleFormat::INT16: return 2;
+        case SampleFormat::INT24: return 3;
+        case SampleFormat::FLOAT16: return 2;
+        case SampleFormat::COMPRESSED: return 0;
+        }
+        return 4;
+    }
+
+    const char* sample_format_name(SampleFormat format) {
+        switch (format) {
+        case SampleFormat::FLOAT32: return "float32";
+        case SampleFormat::INT16: return "int16";
+        case SampleFormat::INT24: return "int24";
+        case SampleFormat::FLOAT16: return "float16";
+        case SampleFormat::COMPRESSED: return "compressed";
+        }
+        return "float32";
+    }
+
+    SampleFormat choose_sample_format(const AudioBuffer& channels, SampleStoragePolicy policy) {
+        if (policy == SampleStoragePolicy::FLOAT32) {
+            return SampleFormat::FLOAT32;
+        }
+
+        // Decoded 16/24-bit PCM lands exactly on these grids
+        if (policy == SampleStoragePolicy::COMPRESSED) {
+            return is_exact(channels, SampleFormat::INT24) ? SampleFormat::COMPRESSED : SampleFormat::FLOAT32;
+        }
+        if (is_exact(channels, SampleFormat::INT16)) {
+            return SampleFormat::INT16;
+        }
+        if (policy == SampleStoragePolicy::HALF_FLOAT) {
+            return SampleFormat::FLOAT16;
+        }
+        return is_exact(channels, SampleFormat::INT24) ? SampleFormat::INT24 : SampleFormat::FLOAT32;
+    }
+
+    std::shared_ptr<SampleArena> get_default_sample_arena() {
+        static const std::shared_ptr<SampleArena> arena = std::make_shared<SampleArena>();
+        return arena;
+    }
+
+    void mix_samples(const float* src, int count, float gain, float pan_gain, float* dest, MixSpanLevels& levels) {
+        mix_float(src, count, gain, pan_gain, dest, nullptr, levels);
+    }
+
+    SampleChannel::~SampleChannel() {
+        release();
+    }
+
+    SampleChannel::SampleChannel(SampleChannel&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SampleChannel& SampleChannel::operator=(SampleChannel&& other) noexcept {
+        if (this != &other) {
+            release();
+            format_ = other.format_;
+            num_samples_ = std::exchange(other.num_samples_, 0);
+            arena_ = std::move(other.arena_);
+            storage_ = std::exchange(other.storage_, nullptr);
+            storage_bytes_ = std::exchange(other.storage_bytes_, 0);
+            block_offsets_ = std::move(other.block_offsets_);
+            compressed_bits_ = other.compressed_bits_;
+        }
+        return *this;
+    }
+
+    void SampleChannel::release() {
+        if (arena_) {
+            arena_->free(storage_);
+        }
+        storage_ = nullptr;
+        storage_bytes_ = 0;
+        block_offsets_.clear();
+    }
+
+    void SampleChannel::store(const void* data, size_t bytes) {
+        storage_ = arena_->store(data, bytes);
+        if (storage_ == nullptr) {
+            throw std::bad_alloc();
+        }
+        storage_bytes_ = bytes;
+    }
+
+    void SampleChannel::encode(const float* samples, size_t num_samples, SampleFormat format,
+        std::shared_ptr<SampleArena> arena) {
+        release();
+        arena_ = arena ? std::move(arena) : get_default_sample_arena();
+        format_ = format;
+        num_samples_ = num_samples;
+
+        switch (format) {
+        case SampleFormat::FLOAT32:
+            store(samples, num_samples * sizeof(float));
+            break;
+
+        case SampleFormat::INT16: {
+            std::vector<int16_t> encoded(num_samples);
+            for (size_t i = 0; i < num_samples; ++i) {
+                encoded[i] = static_cast<int16_t>(to_int16(samples[i]));
+            }
+            store(encoded.data(), encoded.size() * sizeof(int16_t));
+            break;
+        }
+
+        case SampleFormat::INT24: {
+            std::vector<uint8_t> encoded(num_samples * 3);
+            for (size_t i = 0; i < num_samples; ++i) {
+                const int32_t value = to_int24(samples[i]);
+                encoded[i * 3] = static_cast<uint8_t>(value);
+                encoded[i * 3 + 1] = static_cast<uint8_t>(value >> 8);
+                encoded[i * 3 + 2] = static_cast<uint8_t>(value >> 16);
+            }
+            store(encoded.data(), encoded.size());
+            break;
+        }
+
+        case SampleFormat::FLOAT16: {
+            std::vector<uint16_t> encoded(num_samples);
+            for (size_t i = 0; i < num_samples; ++i) {
+                encoded[i] = float_to_half(samples[i]);
+            }
+            store(encoded.data(), encoded.size() * sizeof(uint16_t));
+            break;
+        }
+
+        case SampleFormat::COMPRESSED:
+            encode_compressed(samples, num_samples);
+            break;
+        }
+    }
+
+    void SampleChannel::encode_compressed(const float* samples, size_t num_samples) {
+        // Channels on the 16-bit grid are coded at that scale, anything else at 24 bits
+        compressed_bits_ = 16;
+        for (size_t i = 0; i < num_samples; ++i) {
+            if (static_cast<float>(to_int16(samples[i])) * kInt16Scale != samples[i]) {
+                compressed_bits_ = 24;
+                break;
+            }
+        }
+
+        const size_t num_blocks = (num_samples + kCompressedBlockFrames - 1) / kCompressedBlockFrames;
+        std::vector<uint8_t> compressed;
+        block_offsets_.reserve(num_blocks);
+        compressed.reserve(num_samples * (compressed_bits_ / 8) / 2);
+
+        // residuals[k] holds the k-th difference of the block (zero history before it)
+        std::vector<uint32_t> residuals[kMaxPredictorOrder + 1];
+        for (auto& residual : residuals) {
+            residual.resize(kCompressedBlockFrames);
+        }
+        uint8_t widths[kMaxPredictorOrder + 1][kSubBlocksPerBlock];
+        std::vector<uint32_t> zigzagged(kCompressedBlockFrames);
+
+        for (size_t block = 0; block < num_blocks; ++block) {
+            const size_t first = block * kCompressedBlockFrames;
+            const size_t count = std::min<size_t>(kCompressedBlockFrames, num_samples - first);
+            for (int i = 0; i < kCompressedBlockFrames; ++i) {
+                // The tail of the last block repeats the final sample, which predicts for free
+                const float sample = samples[first + std::min<size_t>(i, count - 1)];
+                residuals[0][i] = static_cast<uint32_t>(compressed_bits_ == 16 ? to_int16(sample) : to_int24(sample));
+            }
+            for (int order = 1; order <= kMaxPredictorOrder; ++order) {
+                uint32_t previous = 0;
+                for (int i = 0; i < kCompressedBlockFrames; ++i) {
+                    residuals[order][i] = residuals[order - 1][i] - previous;
+                    previous = residuals[order - 1][i];
+                }
+            }
+
+            // Pick the predictor order with the smallest packed size
+            int best_order = 0;
+            size_t best_bits = static_cast<size_t>(-1);
+            for (int order = 0; order <= kMaxPredictorOrder; ++order) {
+                size_t bits = 0;
+                for (int sub = 0; sub < kSubBlocksPerBlock; ++sub) {
+                    uint32_t max_value = 0;
+                    for (int i = 0; i < kCompressedSubBlockFrames; ++i) {
+                        max_value |= zigzag(residuals[order][sub * kCompressedSubBlockFrames + i]);
+                    }
+                    widths[order][sub] = static_cast<uint8_t>(bit_width(max_value));
+                    bits += widths[order][sub];
+                }
+                if (bits < best_bits) {
+                    best_bits = bits;
+                    best_order = order;
+                }
+            }
+
+            block_offsets_.push_back(static_cast<uint32_t>(compressed.size()));
+            compressed.push_back(static_cast<uint8_t>(best_order));
+            compressed.insert(compressed.end(), widths[best_order], widths[best_order] + kSubBlocksPerBlock);
+            for (int i = 0; i < kCompressedBlockFrames; ++i) {
+                zigzagged[i] = zigzag(residuals[best_order][i]);
+            }
+            for (int sub = 0; sub < kSubBlocksPerBlock; ++sub) {
+                pack_sub_block(&zigzagged[sub * kCompressedSubBlockFrames], widths[best_order][sub], compressed);
+            }
+        }
+        store(compressed.data(), compressed.size());
+    }
+
+    void SampleChannel::decode_block(size_t block, float* dest) const {
+        CompressedBlockCursor cursor;
+        begin_block(block, cursor);
+        decode_sub_blocks(cursor, kSubBlocksPerBlock, dest);
+    }
+
+    int SampleChannel::get_block_order(size_t block) const {
+        return data()[block_offsets_[block]];
+    }
+
+    void SampleChannel::begin_block(size_t block, CompressedBlockCursor& cursor) const {
+        cursor.block = block;
+        cursor.next_sub_block = 0;
+        cursor.byte_offset = block_offsets_[block] + 1 + kSubBlocksPerBlock; // Past the order and widths
+        std::fill(std::begin(cursor.carries), std::end(cursor.carries), 0u);
+    }
+
+    bool SampleChannel::decode_sub_blocks(CompressedBlockCursor& cursor, int max_sub_blocks, float* dest) const {
+        // One sub-block at a time so the working set is a few cache lines
+        const int end = std::min(kSubBlocksPerBlock, cursor.next_sub_block + std::max(max_sub_blocks, 0));
+        while (cursor.next_sub_block < end) {
+            decode_next_sub_block(cursor, dest + cursor.next_sub_block * kCompressedSubBlockFrames);
+        }
+        return end == kSubBlocksPerBlock;
+    }
+
+    void SampleChannel::decode_next_sub_block(CompressedBlockCursor& cursor, float* out) const {
+        // Offsets, not pointers, survive the arena moving the data between calls
+        const uint8_t* header = data() + block_offsets_[cursor.block];
+        const int order = header[0];
+        const int width = header[1 + cursor.next_sub_block];
+        const uint8_t* src = data() + cursor.byte_offset;
+
+        alignas(16) int32_t values[kCompressedSubBlockFrames];
+        unpack_sub_block(src, width, values);
+        for (int stage = 0; stage < order; ++stage) {
+            integrate(values, kCompressedSubBlockFrames, cursor.carries[stage]);
+        }
+        int_to_float(values, kCompressedSubBlockFrames, compressed_bits_ == 16 ? kInt16Scale : kInt24Scale, out);
+
+        cursor.byte_offset += static_cast<size_t>(width) * (kCompressedSubBlockFrames / 8);
+        ++cursor.next_sub_block;
+    }
+
+    size_t SampleChannel::get_memory_bytes() const {
+        return storage_bytes_ + block_offsets_.size() * sizeof(uint32_t);
+    }
+
+    const float* SampleChannel::float_data() const {
+        return format_ == SampleFormat::FLOAT32 ? reinterpret_cast<const float*>(data()) : nullptr;
+    }
+
+    void SampleChannel::read(size_t start, int count, float* dest) const {
+        switch (format_) {
+        case SampleFormat::FLOAT32:
+            std::memcpy(dest, reinterpret_cast<const float*>(data()) + start, count * sizeof(float));
+            break;
+        case SampleFormat::INT16:
+            read_int16(reinterpret_cast<const int16_t*>(data()) + start, count, dest);
+            break;
+        case SampleFormat::INT24:
+            read_int24(data() + start * 3, count, dest);
+            break;
+        case SampleFormat::FLOAT16:
+            read_half(reinterpret_cast<const uint16_t*>(data()) + start, count, dest);
+            break;
+        case SampleFormat::COMPRESSED: {
+            // Sub-blocks before the span still run, they carry the predictor state
+            alignas(16) float sub_samples[kCompressedSubBlockFrames];
+            while (count > 0) {
+                const int offset = static_cast<int>(start % kCompressedBlockFrames);
+                const int n = std::min(count, kCompressedBlockFrames - offset);
+                CompressedBlockCursor cursor;
+                begin_block(start / kCompressedBlockFrames, cursor);
+                const int last_sub = (offset + n - 1) / kCompressedSubBlockFrames;
+                while (cursor.next_sub_block <= last_sub) {
+                    const int sub_start = cursor.next_sub_block * kCompressedSubBlockFrames;
+                    decode_next_sub_block(cursor, sub_samples);
+                    const int from = std::max(offset, sub_start);
+                    const int to = std::min(offset + n, sub_start + kCompressedSubBlockFrames);
+                    if (from < to) {
+                        std::memcpy(dest + (from - offset), sub_samples + (from - sub_start), (to - from) * sizeof(float));
+                    }
+                }
+                start += n;
+                dest += n;
+                count -= n;
+            }
+            break;
+        }
+        }
+    }
+
+    void SampleChannel::mix(size_t start, int count, float gain, float pan_gain, float* dest, float* expanded,
+        MixSpanLevels& levels) const {
+        switch (format_) {
+        case SampleFormat::FLOAT32:
+            mix_float(reinterpret_cast<const float*>(data()) + start, count, gain, pan_gain, dest, expanded, levels);
+            break;
+        case SampleFormat::INT16:
+            mix_int16(reinterpret_cast<const int16_t*>(data()) + start, count, gain, pan_gain, dest, expanded, levels);
+            break;
+        case SampleFormat::INT24:
+            mix_int24(data() + start * 3, count, gain, pan_gain, dest, expanded, levels);
+            break;
+        case SampleFormat::FLOAT16:
+            mix_half(reinterpret_cast<const uint16_t*>(data()) + start, count, gain, pan_gain, dest, expanded, levels);
+            break;
+        case SampleFormat::COMPRESSED: {
+            alignas(16) float chunk[kCompressedSubBlockFrames];
+            while (count > 0) {
+                const int n = std::min(count, kCompressedSubBlockFrames);
+                read(start, n, chunk);
+                mix_float(chunk, n, gain, pan_gain, dest, expanded, levels);
+                start += n;
+                dest += n;
+                expanded = expanded != nullptr ? expanded + n : nullptr;
+                count -= n;
+            }
+            break;
+        }
+        }
+    }
+
+    // ActivityMap implementation
+    void ActivityMap::build(const AudioBuffer& channels) {
+        const size_t num_frames = channels.empty() ? 0 : channels[0].size();
+        peaks_.assign((num_frames + kBlockFrames - 1) / kBlockFrames, 0.0f);
+
+        for (const auto& channel : channels) {
+            const size_t available = std::min(channel.size(), num_frames);
+            for (size_t block = 0; block < peaks_.size(); ++block) {
+                const size_t first = block * kBlockFrames;
+                const size_t last = std::min(first + kBlockFrames, available);
+                float peak = peaks_[block];
+                for (size_t i = first; i < last; ++i) {
+                    peak = std::max(peak, std::fabs(channel[i]));
+                }
+                peaks_[block] = peak;
+            }
+        }
+    }
+
+    float ActivityMap::get_peak(size_t start, size_t count) const {
+        if (peaks_.empty()) {
+            return 1.0f;
+        }
+        if (count == 0) {
+            return 0.0f;
+        }
+
+        const size_t first = std::min(start / kBlockFrames, peaks_.size() - 1);
+        const size_t last = std::min((start + count - 1) / kBlockFrames, peaks_.size() - 1);
+        float peak = 0.0f;
+        for (size_t block = first; block <= last; ++block) {
+            peak = std::max(peak, peaks_[block]);
+        }
+        return peak;
+    }
+
+    // SampleReader implementation
+    void SampleReader::attach(const SampleChannel* channel) {
+        channel_ = channel;
+        cached_block_ = static_cast<size_t>(-1);
+        ahead_ = CompressedBlockCursor();
+        if (channel != nullptr && channel->get_format() == SampleFormat::COMPRESSED) {
+            cache_.assign(kCompressedBlockFrames * 2, 0.0f);
+        }
+        else {
+            std::vector<float>().swap(cache_);
+        }
+    }
+
+    const float* SampleReader::cached_block(size_t block) {
+        if (block == cached_block_) {
+            return cache_slot(current_slot_);
+        }
+
+        const int other = 1 - current_slot_;
+        if (block == ahead_.block) {
+            // Usually already complete; otherwise only the rest is decoded now
+            channel_->decode_sub_blocks(ahead_, kCompressedSubBlocksPerBlock, cache_slot(other));
+            current_slot_ = other;
+        }
+        else {
+            channel_->decode_block(block, cache_slot(current_slot_));
+        }
+        cached_block_ = block;
+        ahead_.block = static_cast<size_t>(-1);
+        return cache_slot(current_slot_);
+    }
+
+    void SampleReader::decode_ahead(int count) {
+        const size_t next = cached_block_ + 1;
+        if (cached_block_ == static_cast<size_t>(-1) || next >= channel_->get_num_blocks()) {
+            return;
+        }
+        if (ahead_.block != next) {
+            channel_->begin_block(next, ahead_);
+        }
+        if (ahead_.next_sub_block < kCompressedSubBlocksPerBlock) {
+            channel_->decode_sub_blocks(ahead_, count / kCompressedSubBlockFrames + 2, cache_slot(1 - current_slot_));
+        }
+    }
+
+    const float* SampleReader::view(size_t start, int count, float* scratch) {
+        if (channel_->get_format() != SampleFormat::COMPRESSED) {
+            return channel_->view(start, count, scratch);
+        }
+
+        const size_t block = start / kCompressedBlockFrames;
+        const int offset = static_cast<int>(start % kCompressedBlockFrames);
+        const float* span;
+        if (offset + count <= kCompressedBlockFrames) {
+            span = cached_block(block) + offset;
+        }
+        else {
+            // Straddles a block boundary: stitch both halves into scratch
+            const int first = kCompressedBlockFrames - offset;
+            std::memcpy(scratch, cached_block(block) + offset, first * sizeof(float));
+            std::memcpy(scratch + first, cached_block(block + 1), (count - first) * sizeof(float));
+            span = scratch;
+        }
+
+        // Writes only the other slot, so span stays valid
+        decode_ahead(count);
+        return span;
+    }
+
+} // namespace SharedAudio
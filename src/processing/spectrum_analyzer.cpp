@@ -0,0 +1,312 @@
+﻿#include "processing/spectrum_analyzer.h"
+#include "core/audio_tap.h"
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace SharedAudio {
+
+    class SpectrumAnalyzer::Impl {
+    public:
+        ~Impl() {
+            stop();
+        }
+
+        bool start(int sample_rate, int first_channel, int num_channels, const SpectrumSettings& settings) {
+            stop();
+            if (sample_rate <= 0 || num_channels <= 0) {
+                return false;
+            }
+
+            settings_ = settings;
+            settings_.fft_order = std::max(8, std::min(15, settings.fft_order));
+            settings_.overlap = std::max(0.0f, std::min(0.9375f, settings.overlap));
+            settings_.smoothing = std::max(0.0f, std::min(0.99f, settings.smoothing));
+
+            sample_rate_ = sample_rate;
+            num_channels_ = num_channels;
+            fft_size_ = 1 << settings_.fft_order;
+            num_bins_ = fft_size_ / 2 + 1;
+            hop_size_ = std::max(1, static_cast<int>(fft_size_ * (1.0f - settings_.overlap)));
+
+            fft_ = std::make_unique<juce::dsp::FFT>(settings_.fft_order);
+
+            // Hann window, scaled so a full-scale sine reads 0 dBFS
+            window_.resize(fft_size_);
+            double window_sum = 0.0;
+            for (int i = 0; i < fft_size_; ++i) {
+                window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / fft_size_));
+                window_sum += window_[i];
+            }
+            magnitude_scale_ = static_cast<float>(2.0 / window_sum);
+
+            history_.assign(num_channels, std::vector<float>(fft_size_, 0.0f));
+            history_fill_ = 0;
+            samples_since_frame_ = 0;
+            fft_buffer_.assign(fft_size_ * 2, 0.0f);
+            power_.assign(num_bins_, 0.0f);
+            smoothed_power_.assign(num_bins_, 0.0f);
+
+            read_chunk_ = std::max(hop_size_, 1024);
+            scratch_.assign(num_channels, std::vector<float>(read_chunk_, 0.0f));
+            scratch_ptrs_.resize(num_channels);
+            for (int ch = 0; ch < num_channels; ++ch) {
+                scratch_ptrs_[ch] = scratch_[ch].data();
+            }
+
+            allocate_shared_frame();
+
+            // Enough ring for a few hops even if the analysis thread is late
+            tap_.prepare(first_channel, num_channels, std::max(fft_size_ * 4, sample_rate / 2));
+            frames_analyzed_ = 0;
+
+            running_ = true;
+            thread_ = std::thread(&Impl::analysis_loop, this);
+
+            std::cout << "[SPECTRUM] Analyzer started (FFT " << fft_size_ << ", hop " << hop_size_
+                << ", " << num_channels << " ch)" << std::endl;
+            return true;
+        }
+
+        void stop() {
+            running_ = false;
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        bool is_running() const {
+            return running_;
+        }
+
+        AudioTap* get_tap() {
+            return &tap_;
+        }
+
+        int get_num_bins() const {
+            return num_bins_;
+        }
+
+        uint64_t get_frames_analyzed() const {
+            return frames_analyzed_.load(std::memory_order_relaxed);
+        }
+
+        bool read_frame(std::vector<float>& bins_db) const {
+            const SpectrumFrameHeader* header = frame_header();
+            if (header == nullptr) {
+                return false;
+            }
+
+            bins_db.resize(num_bins_);
+            for (int attempt = 0; attempt < 8; ++attempt) {
+                const uint32_t before = header->sequence.load(std::memory_order_acquire);
+                if (before & 1u) {
+                    continue;
+                }
+                std::memcpy(bins_db.data(), frame_bins(), num_bins_ * sizeof(float));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (header->sequence.load(std::memory_order_relaxed) == before) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const void* get_shared_frame() const {
+            return shared_frame_.get();
+        }
+
+        size_t get_shared_frame_bytes() const {
+            return shared_frame_bytes_;
+        }
+
+    private:
+        void allocate_shared_frame() {
+            shared_frame_bytes_ = sizeof(SpectrumFrameHeader) + num_bins_ * sizeof(float);
+            shared_frame_.reset(new uint32_t[(shared_frame_bytes_ + 3) / 4]());
+            auto* header = new (shared_frame_.get()) SpectrumFrameHeader;
+            header->sequence.store(0, std::memory_order_relaxed);
+            header->num_bins = static_cast<uint32_t>(num_bins_);
+            header->sample_rate = static_cast<float>(sample_rate_);
+            header->fft_size = static_cast<uint32_t>(fft_size_);
+            std::fill(frame_bins(), frame_bins() + num_bins_, settings_.floor_db);
+        }
+
+        SpectrumFrameHeader* frame_header() const {
+            return reinterpret_cast<SpectrumFrameHeader*>(shared_frame_.get());
+        }
+
+        float* frame_bins() const {
+            return reinterpret_cast<float*>(shared_frame_.get() + sizeof(SpectrumFrameHeader) / 4);
+        }
+
+        void analysis_loop() {
+            const auto hop_time = std::chrono::microseconds(
+                std::max<int64_t>(2000, static_cast<int64_t>(hop_size_) * 500000 / sample_rate_));
+
+            while (running_) {
+                int frames;
+                while ((frames = tap_.read(scratch_ptrs_.data(), read_chunk_)) > 0) {
+                    consume(frames);
+                }
+                std::this_thread::sleep_for(hop_time);
+            }
+        }
+
+        void consume(int frames) {
+            int offset = 0;
+            while (offset < frames) {
+                // Fill the sliding history up to the next hop
+                const int until_frame = history_fill_ < fft_size_
+                    ? fft_size_ - history_fill_ : hop_size_ - samples_since_frame_;
+                const int count = std::min(frames - offset, until_frame);
+
+                for (int ch = 0; ch < num_channels_; ++ch) {
+                    auto& history = history_[ch];
+                    std::memmove(history.data(), history.data() + count, (fft_size_ - count) * sizeof(float));
+                    std::memcpy(history.data() + fft_size_ - count, scratch_[ch].data() + offset, count * sizeof(float));
+                }
+                offset += count;
+
+                if (history_fill_ < fft_size_) {
+                    history_fill_ += count;
+                    if (history_fill_ == fft_size_) {
+                        analyze_frame();
+                    }
+                }
+                else {
+                    samples_since_frame_ += count;
+                    if (samples_since_frame_ >= hop_size_) {
+                        analyze_frame();
+                    }
+                }
+            }
+        }
+
+        void analyze_frame() {
+            samples_since_frame_ = 0;
+            std::fill(power_.begin(), power_.end(), 0.0f);
+
+            // Power is averaged across the tap's channels
+            for (int ch = 0; ch < num_channels_; ++ch) {
+                const float* history = history_[ch].data();
+                for (int i = 0; i < fft_size_; ++i) {
+                    fft_buffer_[i] = history[i] * window_[i];
+                }
+                std::fill(fft_buffer_.begin() + fft_size_, fft_buffer_.end(), 0.0f);
+                fft_->performFrequencyOnlyForwardTransform(fft_buffer_.data(), true);
+
+                for (int bin = 0; bin < num_bins_; ++bin) {
+                    const float magnitude = fft_buffer_[bin] * magnitude_scale_;
+                    power_[bin] += magnitude * magnitude;
+                }
+            }
+
+            const float channel_scale = 1.0f / num_channels_;
+            const float keep = settings_.smoothing;
+            for (int bin = 0; bin < num_bins_; ++bin) {
+                smoothed_power_[bin] = keep * smoothed_power_[bin] + (1.0f - keep) * power_[bin] * channel_scale;
+            }
+
+            publish();
+        }
+
+        void publish() {
+            SpectrumFrameHeader* header = frame_header();
+            float* bins = frame_bins();
+            const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+
+            header->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (int bin = 0; bin < num_bins_; ++bin) {
+                const float power = smoothed_power_[bin];
+                bins[bin] = power > 0.0f ? std::max(settings_.floor_db, 10.0f * std::log10(power)) : settings_.floor_db;
+            }
+            header->sequence.store(sequence + 2, std::memory_order_release);
+
+            frames_analyzed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        SpectrumSettings settings_;
+        AudioTap tap_;
+        std::thread thread_;
+        std::atomic<bool> running_{ false };
+        std::atomic<uint64_t> frames_analyzed_{ 0 };
+
+        int sample_rate_ = 48000;
+        int num_channels_ = 0;
+        int fft_size_ = 0;
+        int num_bins_ = 0;
+        int hop_size_ = 0;
+        int read_chunk_ = 0;
+        float magnitude_scale_ = 1.0f;
+
+        // Analysis thread state
+        std::unique_ptr<juce::dsp::FFT> fft_;
+        std::vector<float> window_;
+        std::vector<std::vector<float>> history_;
+        int history_fill_ = 0;
+        int samples_since_frame_ = 0;
+        std::vector<float> fft_buffer_;
+        std::vector<float> power_;
+        std::vector<float> smoothed_power_;
+        std::vector<std::vector<float>> scratch_;
+        std::vector<float*> scratch_ptrs_;
+
+        // Shared frame block (SpectrumFrameHeader + bins)
+        std::unique_ptr<uint32_t[]> shared_frame_;
+        size_t shared_frame_bytes_ = 0;
+    };
+
+    // SpectrumAnalyzer public interface
+    SpectrumAnalyzer::SpectrumAnalyzer() : impl_(std::make_unique<Impl>()) {}
+    SpectrumAnalyzer::~SpectrumAnalyzer() = default;
+
+    bool SpectrumAnalyzer::start(int sample_rate, int first_channel, int num_channels, const SpectrumSettings& settings) {
+        return impl_->start(sample_rate, first_channel, num_channels, settings);
+    }
+
+    void SpectrumAnalyzer::stop() {
+        impl_->stop();
+    }
+
+    bool SpectrumAnalyzer::is_running() const {
+        return impl_->is_running();
+    }
+
+    AudioTap* SpectrumAnalyzer::get_tap() {
+        return impl_->get_tap();
+    }
+
+    int SpectrumAnalyzer::get_num_bins() const {
+        return impl_->get_num_bins();
+    }
+
+    uint64_t SpectrumAnalyzer::get_frames_analyzed() const {
+        return impl_->get_frames_analyzed();
+    }
+
+    bool SpectrumAnalyzer::read_frame(std::vector<float>& bins_db) const {
+        return impl_->read_frame(bins_db);
+    }
+
+    const void* SpectrumAnalyzer::get_shared_frame() const {
+        return impl_->get_shared_frame();
+    }
+
+    size_t SpectrumAnalyzer::get_shared_frame_bytes() const {
+        return impl_->get_shared_frame_bytes();
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,201 @@
+﻿#include "processing/waveform_pyramid.h"
+#include "core/loader_thread_pool.h"
+#include "processing/sample_storage.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHARED_AUDIO_WAVEFORM_SSE 1
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr size_t kPointsPerTask = 4096; // ~1M samples per loader task
+
+        WaveformPoint reduce_samples(const float* data, int num_samples) {
+            float min_value = data[0];
+            float max_value = data[0];
+            float sum_squares = 0.0f;
+            int i = 0;
+
+#ifdef SHARED_AUDIO_WAVEFORM_SSE
+            if (num_samples >= 4) {
+                __m128 min_v = _mm_set1_ps(data[0]);
+                __m128 max_v = min_v;
+                __m128 sum_v = _mm_setzero_ps();
+                for (; i + 4 <= num_samples; i += 4) {
+                    const __m128 x = _mm_loadu_ps(data + i);
+                    min_v = _mm_min_ps(min_v, x);
+                    max_v = _mm_max_ps(max_v, x);
+                    sum_v = _mm_add_ps(sum_v, _mm_mul_ps(x, x));
+                }
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, min_v);
+                min_value = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+                _mm_store_ps(lanes, max_v);
+                max_value = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+                _mm_store_ps(lanes, sum_v);
+                sum_squares = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            }
+#endif
+            for (; i < num_samples; ++i) {
+                min_value = std::min(min_value, data[i]);
+                max_value = std::max(max_value, data[i]);
+                sum_squares += data[i] * data[i];
+            }
+
+            return { min_value, max_value, std::sqrt(sum_squares / num_samples) };
+        }
+
+        // Merge points that each cover the same number of samples (except
+        // possibly the last one, which is weighted by its real length)
+        WaveformPoint merge_points(const WaveformPoint* points, size_t count, double last_weight = 1.0) {
+            WaveformPoint result = points[0];
+            double sum_squares = 0.0;
+            double weight = 0.0;
+            for (size_t i = 0; i < count; ++i) {
+                const double w = (i + 1 == count) ? last_weight : 1.0;
+                result.min = std::min(result.min, points[i].min);
+                result.max = std::max(result.max, points[i].max);
+                sum_squares += w * points[i].rms * points[i].rms;
+                weight += w;
+            }
+            result.rms = weight > 0.0 ? static_cast<float>(std::sqrt(sum_squares / weight)) : 0.0f;
+            return result;
+        }
+
+    } // namespace
+
+    void WaveformPyramid::build(const AudioBuffer& channels, LoaderThreadPool* pool) {
+        levels_.clear();
+        num_frames_ = channels.empty() ? 0 : channels[0].size();
+        if (num_frames_ == 0) {
+            return;
+        }
+
+        const int num_channels = static_cast<int>(channels.size());
+        const size_t base_points = (num_frames_ + kBaseSamplesPerPoint - 1) / kBaseSamplesPerPoint;
+        levels_.assign(num_channels, {});
+        for (auto& channel_levels : levels_) {
+            channel_levels.emplace_back(base_points);
+        }
+
+        // Level 0: independent chunks of every channel, spread over the pool
+        const size_t chunks_per_channel = (base_points + kPointsPerTask - 1) / kPointsPerTask;
+        auto build_chunk = [&](int task) {
+            const int ch = static_cast<int>(task / chunks_per_channel);
+            const size_t first_point = (task % chunks_per_channel) * kPointsPerTask;
+            const size_t last_point = std::min(base_points, first_point + kPointsPerTask);
+            const float* data = channels[ch].data();
+            const size_t available = std::min(channels[ch].size(), num_frames_);
+            auto& level = levels_[ch][0];
+
+            for (size_t p = first_point; p < last_point; ++p) {
+                const size_t start = p * kBaseSamplesPerPoint;
+                const size_t count = std::min<size_t>(kBaseSamplesPerPoint, available > start ? available - start : 0);
+                level[p] = count > 0 ? reduce_samples(data + start, static_cast<int>(count)) : WaveformPoint{ 0.0f, 0.0f, 0.0f };
+            }
+        };
+
+        const int num_tasks = static_cast<int>(chunks_per_channel) * num_channels;
+        if (pool != nullptr && pool->get_num_threads() > 0 && num_tasks > 1) {
+            pool->parallel_for(num_tasks, build_chunk);
+        }
+        else {
+            for (int task = 0; task < num_tasks; ++task) {
+                build_chunk(task);
+            }
+        }
+
+        // Coarser levels are tiny next to level 0, reduce them per channel
+        for (int ch = 0; ch < num_channels; ++ch) {
+            auto& channel_levels = levels_[ch];
+            while (channel_levels.back().size() > 1) {
+                const auto& finer = channel_levels.back();
+                const size_t finer_samples = get_samples_per_point(static_cast<int>(channel_levels.size()) - 1);
+                const size_t finer_tail = num_frames_ - (finer.size() - 1) * finer_samples;
+                const double tail_weight = static_cast<double>(finer_tail) / finer_samples;
+
+                std::vector<WaveformPoint> coarser((finer.size() + kLevelFactor - 1) / kLevelFactor);
+                for (size_t p = 0; p < coarser.size(); ++p) {
+                    const size_t first = p * kLevelFactor;
+                    const size_t count = std::min<size_t>(kLevelFactor, finer.size() - first);
+                    const bool has_tail = first + count == finer.size();
+                    coarser[p] = merge_points(&finer[first], count, has_tail ? tail_weight : 1.0);
+                }
+                channel_levels.push_back(std::move(coarser));
+            }
+        }
+    }
+
+    size_t WaveformPyramid::get_samples_per_point(int level) const {
+        size_t samples = kBaseSamplesPerPoint;
+        for (int i = 0; i < level; ++i) {
+            samples *= kLevelFactor;
+        }
+        return samples;
+    }
+
+    const std::vector<WaveformPoint>* WaveformPyramid::get_level(int channel, int level) const {
+        if (channel < 0 || channel >= get_num_channels() || level < 0 || level >= get_num_levels()) {
+            return nullptr;
+        }
+        return &levels_[channel][level];
+    }
+
+    int WaveformPyramid::select_level(double samples_per_pixel) const {
+        int level = 0;
+        while (level + 1 < get_num_levels()
+            && static_cast<double>(get_samples_per_point(level + 1)) <= samples_per_pixel) {
+            ++level;
+        }
+        return level;
+    }
+
+    void WaveformPyramid::render(int channel, double start_sample, double end_sample, int num_pixels,
+        std::vector<WaveformPoint>& points, const SampleChannel* samples) const {
+        points.assign(std::max(num_pixels, 0), WaveformPoint{ 0.0f, 0.0f, 0.0f });
+        if (num_pixels <= 0 || end_sample <= start_sample || channel < 0 || channel >= get_num_channels()) {
+            return;
+        }
+
+        const double samples_per_pixel = (end_sample - start_sample) / num_pixels;
+        const bool use_samples = samples != nullptr && samples_per_pixel < kBaseSamplesPerPoint;
+        const int level = select_level(samples_per_pixel);
+        const auto& level_points = levels_[channel][level];
+        const double point_samples = static_cast<double>(get_samples_per_point(level));
+        const double total = static_cast<double>(num_frames_);
+        std::vector<float> scratch(use_samples ? static_cast<size_t>(std::ceil(samples_per_pixel)) + 2 : 0);
+
+        for (int px = 0; px < num_pixels; ++px) {
+            const double s0 = std::max(0.0, start_sample + px * samples_per_pixel);
+            const double s1 = std::min(total, start_sample + (px + 1) * samples_per_pixel);
+            if (s1 <= s0) {
+                continue; // Past either end of the asset
+            }
+
+            if (use_samples) {
+                const size_t first = static_cast<size_t>(s0);
+                const size_t last = std::min({ samples->size(), first + scratch.size(),
+                    std::max(first + 1, static_cast<size_t>(std::ceil(s1))) });
+                if (first < last) {
+                    const int count = static_cast<int>(last - first);
+                    points[px] = reduce_samples(samples->view(first, count, scratch.data()), count);
+                }
+                continue;
+            }
+
+            const size_t first = static_cast<size_t>(s0 / point_samples);
+            const size_t last = std::min(level_points.size(),
+                std::max(first + 1, static_cast<size_t>(std::ceil(s1 / point_samples))));
+            if (first < last) {
+                points[px] = merge_points(&level_points[first], last - first);
+            }
+        }
+    }
+
+} // namespace SharedAudio
@@ -1,7 +1,19 @@
 ﻿#include "show_control/cue_audio_manager.h"
+#include "processing/mix_graph.h"
+#include "processing/level_meter.h"
+#include "processing/audio_asset_cache.h"
+#include "core/triple_buffer.h"
+#include "processing/loop_seam.h"
+#include "show_control/scene_manager.h"
+#include "core/lock_free_fifo.h"
 #include <iostream>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include <mutex>
 #include <map>
 
@@ -27,156 +39,554 @@ namespace SharedAudio {
             , fade_samples_total_(0)
             , is_looping_(false)
             , sample_rate_(48000)
+            , bus_index_(0)
+            , meter_index_(-1)
+            , trim_gain_(1.0f)
         {
         }
 
-        bool load_audio_file() {
-            std::cout << "[LOAD] Loading audio file: " << file_path_ << std::endl;
+        // Cues share decoded assets with the cache, the samples are never copied
+        void set_asset(std::shared_ptr<const AudioAsset> asset) {
+            asset_ = std::move(asset);
+            const auto& channels = asset_->channels;
+            left_.attach(channels.empty() ? nullptr : &channels[0]);
+            right_.attach(channels.size() >= 2 ? &channels[1] : nullptr); // Mono plays on both sides
+            loop_seam_.reset(); // Seams are built against one asset
+            tail_left_.attach(left_.get_channel());
+            tail_right_.attach(right_.get_channel());
+            duration_samples_ = asset_->metadata.num_frames;
+            sample_rate_ = asset_->metadata.sample_rate > 0 ? asset_->metadata.sample_rate : sample_rate_;
 
-            // TODO: Implement proper audio file loading with actual file format support
-            // For now, generate test content based on filename
-            duration_samples_ = sample_rate_ * 10; // 10 seconds
-            audio_data_.resize(2); // Stereo
-            audio_data_[0].resize(duration_samples_);
-            audio_data_[1].resize(duration_samples_);
-
-            // Generate test tone based on filename
-            float frequency = 440.0f; // Default A4
-            if (file_path_.find("880") != std::string::npos) frequency = 880.0f;
-            if (file_path_.find("220") != std::string::npos) frequency = 220.0f;
-            if (file_path_.find("background") != std::string::npos) frequency = 110.0f;
-
-            for (size_t i = 0; i < duration_samples_; ++i) {
-                float t = static_cast<float>(i) / sample_rate_;
-                float sample = 0.3f * std::sin(2.0f * M_PI * frequency * t);
-
-                // Add some envelope to prevent clicks
-                if (i < 1000) sample *= static_cast<float>(i) / 1000.0f;
-                if (i > duration_samples_ - 1000) {
-                    sample *= static_cast<float>(duration_samples_ - i) / 1000.0f;
-                }
-
-                audio_data_[0][i] = sample;
-                audio_data_[1][i] = sample;
+            // Equal-power quarter sine, read forwards to fade in and backwards to fade out
+            micro_fade_samples_ = std::max(1, static_cast<int>(kMicroFadeSeconds * sample_rate_));
+            micro_fade_curve_.resize(micro_fade_samples_ + 1);
+            for (int i = 0; i <= micro_fade_samples_; ++i) {
+                micro_fade_curve_[i] = static_cast<float>(std::sin(0.5 * M_PI * i / micro_fade_samples_));
             }
+            entry_fade_position_ = micro_fade_samples_;
+            tail_remaining_ = 0;
 
-            std::cout << "[PASS] Audio cue loaded: " << cue_id_ << " (" << frequency << "Hz, "
-                << duration_samples_ / sample_rate_ << "s)" << std::endl;
-            return true;
+            std::cout << "[PASS] Audio cue loaded: " << cue_id_ << " ("
+                << asset_->metadata.duration_seconds << "s)" << std::endl;
         }
 
         void start() {
+            begin_tail();
             state_ = CueState::PLAYING;
             current_position_ = 0;
-            std::cout << "[PLAY] Started cue: " << cue_id_ << std::endl;
+            entry_fade_position_ = micro_fade_samples_; // The top of the file plays as authored
         }
 
         void stop() {
-            state_ = CueState::STOPPED;
-            current_position_ = 0;
-            std::cout << "[STOP] Stopped cue: " << cue_id_ << std::endl;
+            begin_tail();
+            halt();
         }
 
-        void pause() {
-            if (state_ == CueState::PLAYING) {
-                state_ = CueState::PAUSED;
-                std::cout << "[PAUSE] Paused cue: " << cue_id_ << std::endl;
+        // False when the voice was not playing
+        bool pause() {
+            if (state_ != CueState::PLAYING) {
+                return false;
             }
+            begin_tail();
+            state_ = CueState::PAUSED;
+            return true;
         }
 
-        void resume() {
-            if (state_ == CueState::PAUSED) {
-                state_ = CueState::PLAYING;
-                std::cout << "[PLAY] Resumed cue: " << cue_id_ << std::endl;
+        bool resume() {
+            if (state_ != CueState::PAUSED) {
+                return false;
             }
+            state_ = CueState::PLAYING;
+            entry_fade_position_ = current_position_ > 0 ? 0 : micro_fade_samples_;
+            return true;
         }
 
-        void process_audio(AudioBuffer& outputs, int num_samples) {
-            if (state_ != CueState::PLAYING && state_ != CueState::FADING_IN && state_ != CueState::FADING_OUT) {
-                return;
+        // Advances the voice without mixing when the block cannot be heard:
+        // the voice is not playing, its gain is zero, or the asset's activity
+        // map shows the source is silent under it. Returns false when the
+        // block has to go through process_audio (fades and declick tails always do).
+        bool skip_silent_block(int num_samples, MeterBank* meters, bool skip_silence) {
+            if (tail_remaining_ > 0) {
+                return false;
+            }
+            if (state_ == CueState::STOPPED || state_ == CueState::PAUSED) {
+                return true;
+            }
+            if (!skip_silence) {
+                return false;
+            }
+            const size_t boundary = get_boundary();
+            if (state_ != CueState::PLAYING || fade_samples_remaining_ > 0 || ramp_remaining_ > 0
+                || left_.get_channel() == nullptr || current_position_ >= boundary) {
+                return false;
             }
 
-            if (audio_data_.empty() || current_position_ >= duration_samples_) {
-                if (is_looping_) {
-                    current_position_ = 0;
+            // Blocks that reach a crossfaded seam play it, the seam's level is not in the activity map
+            const size_t seam_start = is_looping_ && has_seam() ? loop_seam_->get_plan().seam_start : boundary;
+            const size_t first_count = std::min<size_t>(num_samples, boundary - current_position_);
+            const size_t wrapped_count = num_samples - first_count;
+            const size_t resume = get_resume_frame();
+            if (current_position_ + first_count > seam_start
+                || (wrapped_count > 0 && (!is_looping_ || wrapped_count > get_boundary_after(resume) - resume))) {
+                return false; // Ends, reaches a seam or loops more than once in this block
+            }
+
+            const float gain = volume_ * trim_gain_;
+            if (gain > 0.0f) {
+                const ActivityMap& activity = asset_->activity;
+                float peak = activity.get_peak(current_position_, first_count);
+                if (wrapped_count > 0) {
+                    peak = std::max(peak, activity.get_peak(resume, wrapped_count));
                 }
-                else {
-                    stop();
-                    return;
+                if (peak * gain >= kSilenceThreshold) {
+                    return false;
                 }
             }
 
-            for (int sample = 0; sample < num_samples; ++sample) {
-                if (current_position_ >= duration_samples_) {
+            current_position_ = wrapped_count > 0 ? resume + wrapped_count : current_position_ + first_count;
+            entry_fade_position_ = std::min(wrapped_count > 0 ? static_cast<int>(wrapped_count)
+                : entry_fade_position_ + num_samples, micro_fade_samples_);
+            last_volume_ = gain;
+            block_peak_left_ = block_peak_right_ = 0.0f;
+            if (meters != nullptr && meter_index_ >= 0) {
+                fold_meter(*meters, meter_index_ * 2, 0.0f, 0.0f, num_samples);
+                fold_meter(*meters, meter_index_ * 2 + 1, 0.0f, 0.0f, num_samples);
+            }
+            return true;
+        }
+
+        // Renders num_samples frames into outputs from frame offset on (a
+        // block is split where a timed command lands inside it)
+        void process_audio(AudioBuffer& outputs, int offset, int num_samples, MeterBank* meters) {
+            const bool metering = meters != nullptr && meter_index_ >= 0;
+            const bool has_tail = tail_remaining_ > 0;
+            block_peak_left_ = block_peak_right_ = 0.0f;
+            if (has_tail) {
+                render_tail(outputs, offset, num_samples, metering ? meters : nullptr);
+            }
+
+            if (state_ != CueState::PLAYING && state_ != CueState::FADING_IN && state_ != CueState::FADING_OUT) {
+                if (has_tail && metering) {
+                    fold_meter(*meters, meter_index_ * 2, 0.0f, 0.0f, num_samples);
+                    fold_meter(*meters, meter_index_ * 2 + 1, 0.0f, 0.0f, num_samples);
+                }
+                return;
+            }
+
+            if (left_.get_channel() == nullptr || duration_samples_ == 0) {
+                halt();
+                return;
+            }
+            if (current_position_ >= duration_samples_ && !is_looping_) {
+                halt(); // Played out to the authored end, nothing to declick
+                return;
+            }
+
+            // Compact sample formats are expanded a chunk at a time into L1-sized
+            // scratch right before mixing (compressed blocks via the voice's
+            // readers); float assets are read in place.
+            // Voice levels are folded in while mixing, no second pass over the block.
+            alignas(16) float left_scratch[kDecodeChunk];
+            alignas(16) float right_scratch[kDecodeChunk];
+            int sample = 0;
+            bool done = false;
+
+            while (sample < num_samples && !done) {
+                size_t boundary = get_boundary();
+                if (current_position_ >= boundary) {
                     if (is_looping_) {
-                        current_position_ = 0;
+                        // Leaving through a crossfaded seam is already continuous,
+                        // anything else dips through a micro-fade
+                        const bool seamless = has_seam() && boundary == loop_seam_->get_plan().end_frame;
+                        current_position_ = get_resume_frame();
+                        if (!seamless) {
+                            entry_fade_position_ = 0;
+                        }
+                        boundary = get_boundary();
                     }
                     else {
                         break;
                     }
                 }
 
-                float current_volume = volume_;
+                // Inside the seam window the voice reads the precomputed crossfade
+                // instead of the asset - a pointer switch, never a second read head
+                const bool seam_boundary = is_looping_ && has_seam() && boundary == loop_seam_->get_plan().end_frame;
+                const size_t seam_start = seam_boundary ? loop_seam_->get_plan().seam_start : boundary;
+                const bool in_seam = current_position_ >= seam_start;
+                const size_t span_end = in_seam ? boundary : seam_start;
 
-                // Handle fading
-                if (fade_samples_remaining_ > 0) {
-                    float fade_progress = 1.0f - (static_cast<float>(fade_samples_remaining_) / fade_samples_total_);
-                    if (state_ == CueState::FADING_IN) {
-                        current_volume = target_volume_ * fade_progress;
+                const int count = static_cast<int>(std::min<size_t>(
+                    std::min<size_t>(kDecodeChunk, static_cast<size_t>(num_samples - sample)),
+                    span_end - current_position_));
+
+                // Declicking only costs per-sample work in chunks that touch an
+                // entry fade or a hard end that cuts into the content: a loop
+                // jump without a seam, or a region end before the asset's end.
+                // A one-shot playing out to the end of the asset plays as authored.
+                const size_t fade_end = !seam_boundary && (is_looping_ || boundary < duration_samples_) ? boundary : 0;
+                const bool micro_fading = entry_fade_position_ < micro_fade_samples_
+                    || (fade_end > 0 && fade_end - current_position_ < static_cast<size_t>(count + micro_fade_samples_));
+
+                // Chunks at a steady gain (most of them) go through the vector
+                // mix kernels, which expand int16/int24/half in the same pass;
+                // ramps, fades and micro-fades take the per-sample loop below
+                const bool steady = ramp_remaining_ == 0 && fade_samples_remaining_ == 0 && !micro_fading
+                    && outputs.size() >= 2;
+                const bool expand_in_mix = steady && !in_seam && expands_in_mix(left_)
+                    && (right_.get_channel() == nullptr || expands_in_mix(right_));
+                const float gain = volume_ * trim_gain_;
+                const float pan_left = pan_ > 0.0f ? 1.0f - pan_ : 1.0f;
+                const float pan_right = pan_ < 0.0f ? 1.0f + pan_ : 1.0f;
+                MixSpanLevels levels_left, levels_right;
+
+                const float* left_source;
+                const float* right_source;
+                if (expand_in_mix) {
+                    float* out_left = outputs[0].data() + offset + sample;
+                    float* out_right = outputs[1].data() + offset + sample;
+                    left_.get_channel()->mix(current_position_, count, gain, pan_left, out_left, left_scratch, levels_left);
+                    left_source = left_scratch;
+                    if (right_.get_channel() != nullptr) {
+                        right_.get_channel()->mix(current_position_, count, gain, pan_right, out_right, right_scratch, levels_right);
+                        right_source = right_scratch;
+                    }
+                    else {
+                        right_source = left_source;
+                        mix_samples(right_source, count, gain, pan_right, out_right, levels_right);
+                    }
+                }
+                else {
+                    if (in_seam) {
+                        const LoopSeam& seam = *loop_seam_;
+                        left_source = seam.get_channel(0) + (current_position_ - seam_start);
+                        right_source = seam.get_channel(std::min(1, seam.get_num_channels() - 1)) + (current_position_ - seam_start);
+                    }
+                    else {
+                        left_source = left_.view(current_position_, count, left_scratch);
+                        right_source = right_.get_channel() == nullptr
+                            ? left_source : right_.view(current_position_, count, right_scratch);
                     }
-                    else if (state_ == CueState::FADING_OUT) {
-                        current_volume = volume_ * (1.0f - fade_progress);
+                    if (steady) {
+                        mix_samples(left_source, count, gain, pan_left, outputs[0].data() + offset + sample, levels_left);
+                        mix_samples(right_source, count, gain, pan_right, outputs[1].data() + offset + sample, levels_right);
                     }
-                    fade_samples_remaining_--;
+                }
 
-                    if (fade_samples_remaining_ == 0) {
-                        if (state_ == CueState::FADING_OUT) {
-                            stop();
-                            break;
+                float peak_left = 0.0f, peak_right = 0.0f;
+                float sum_sq_left = 0.0f, sum_sq_right = 0.0f;
+                float max_gain_left = 0.0f, max_gain_right = 0.0f;
+                int i = 0;
+                if (steady) {
+                    peak_left = levels_left.peak;
+                    peak_right = levels_right.peak;
+                    sum_sq_left = levels_left.sum_sq;
+                    sum_sq_right = levels_right.sum_sq;
+                    max_gain_left = gain * pan_left;
+                    max_gain_right = gain * pan_right;
+                    last_volume_ = gain;
+                    current_position_ += static_cast<size_t>(count);
+                    i = count; // Nothing left for the per-sample loop
+                }
+
+                for (; i < count; ++i) {
+                    if (ramp_remaining_ > 0) {
+                        advance_ramp();
+                    }
+                    float current_volume = volume_ * trim_gain_;
+
+                    // Handle fading
+                    if (fade_samples_remaining_ > 0) {
+                        float fade_progress = 1.0f - (static_cast<float>(fade_samples_remaining_) / fade_samples_total_);
+                        if (state_ == CueState::FADING_IN) {
+                            current_volume = target_volume_ * trim_gain_ * fade_progress;
                         }
-                        else {
-                            state_ = CueState::PLAYING;
-                            volume_ = target_volume_;
+                        else if (state_ == CueState::FADING_OUT) {
+                            current_volume = volume_ * trim_gain_ * (1.0f - fade_progress);
                         }
-                    }
-                }
+                        fade_samples_remaining_--;
 
-                // Mix into output buffer
-                if (outputs.size() >= 2 && current_position_ < audio_data_[0].size()) {
-                    float left = audio_data_[0][current_position_] * current_volume;
-                    float right = audio_data_[1][current_position_] * current_volume;
+                        if (fade_samples_remaining_ == 0) {
+                            if (state_ == CueState::FADING_OUT) {
+                                halt(); // Already at zero, nothing to declick
+                                done = true;
+                                break;
+                            }
+                            else {
+                                state_ = CueState::PLAYING;
+                                volume_ = target_volume_;
+                            }
+                        }
+                    }
 
-                    // Apply panning
-                    if (pan_ < 0.0f) {
-                        right *= (1.0f + pan_);
+                    if (micro_fading) {
+                        current_volume *= micro_fade_gain(current_position_, fade_end);
                     }
-                    else if (pan_ > 0.0f) {
-                        left *= (1.0f - pan_);
+                    last_volume_ = current_volume;
+
+                    // Mix into output buffer
+                    if (outputs.size() >= 2) {
+                        float left = left_source[i] * current_volume;
+                        float right = right_source[i] * current_volume;
+
+                        // Apply panning
+                        if (pan_ < 0.0f) {
+                            right *= (1.0f + pan_);
+                        }
+                        else if (pan_ > 0.0f) {
+                            left *= (1.0f - pan_);
+                        }
+
+                        outputs[0][offset + sample + i] += left;
+                        outputs[1][offset + sample + i] += right;
+
+                        peak_left = std::max(peak_left, std::fabs(left));
+                        peak_right = std::max(peak_right, std::fabs(right));
+                        sum_sq_left += left * left;
+                        sum_sq_right += right * right;
+                        max_gain_left = std::max(max_gain_left, current_volume * (pan_ > 0.0f ? 1.0f - pan_ : 1.0f));
+                        max_gain_right = std::max(max_gain_right, current_volume * (pan_ < 0.0f ? 1.0f + pan_ : 1.0f));
                     }
 
-                    outputs[0][sample] += left;
-                    outputs[1][sample] += right;
+                    current_position_++;
+                }
+
+                // Gain and pan are linear, so the voice's true-peak is the source
+                // chunk's true-peak scaled by the largest gain used in the chunk
+                block_peak_left_ = std::max(block_peak_left_, peak_left);
+                block_peak_right_ = std::max(block_peak_right_, peak_right);
+                if (metering && i > 0) {
+                    fold_meter(*meters, meter_index_ * 2, peak_left, sum_sq_left, 0);
+                    fold_meter(*meters, meter_index_ * 2 + 1, peak_right, sum_sq_right, 0);
+                    meters->measure_true_peak(meter_index_ * 2, left_source, i, max_gain_left);
+                    meters->measure_true_peak(meter_index_ * 2 + 1, right_source, i, max_gain_right);
+                }
+                sample += i;
+            }
+
+            if (metering) {
+                fold_meter(*meters, meter_index_ * 2, 0.0f, 0.0f, num_samples);
+                fold_meter(*meters, meter_index_ * 2 + 1, 0.0f, 0.0f, num_samples);
+            }
+        }
+
+        // Formats the mix kernels expand themselves; float is read in place and
+        // compressed blocks come decoded from the reader's cache
+        static bool expands_in_mix(const SampleReader& reader) {
+            const SampleFormat format = reader.get_channel()->get_format();
+            return format == SampleFormat::INT16 || format == SampleFormat::INT24 || format == SampleFormat::FLOAT16;
+        }
+
+        // Stops without declicking (fade-outs and the end of the asset are already at zero)
+        void halt() {
+            state_ = CueState::STOPPED;
+            current_position_ = 0;
+            last_volume_ = 0.0f;
+        }
+
+        // Hands the current read position to the tail head, which fades it
+        // out over the next micro-fade while the voice moves on (seek,
+        // restart) or goes quiet (stop, pause)
+        void begin_tail() {
+            const bool audible = state_ == CueState::PLAYING || state_ == CueState::FADING_IN
+                || state_ == CueState::FADING_OUT;
+            if (!audible || left_.get_channel() == nullptr || last_volume_ <= 0.0f
+                || current_position_ >= duration_samples_) {
+                return;
+            }
+            tail_position_ = current_position_;
+            tail_remaining_ = micro_fade_samples_;
+            tail_volume_ = last_volume_;
+        }
+
+        // Equal-power entry fade after a seek/resume/loop wrap, times the
+        // fade into a hard loop or region end (fade_end 0: none)
+        float micro_fade_gain(size_t position, size_t fade_end) {
+            float gain = 1.0f;
+            if (entry_fade_position_ < micro_fade_samples_) {
+                gain = micro_fade_curve_[entry_fade_position_++];
+            }
+            if (fade_end > 0 && fade_end - position < static_cast<size_t>(micro_fade_samples_)) {
+                gain *= micro_fade_curve_[fade_end - position];
+            }
+            return gain;
+        }
+
+        void advance_ramp() {
+            if (--ramp_remaining_ == 0) {
+                volume_ = volume_target_;
+                pan_ = pan_target_;
+                trim_gain_ = trim_target_;
+                return;
+            }
+            volume_ += volume_step_;
+            pan_ += pan_step_;
+            trim_gain_ += trim_step_;
+        }
+
+        bool has_seam() const { return loop_seam_ != nullptr && loop_seam_->has_crossfade(); }
+
+        // Where the voice stops reading forwards from position: the loop end
+        // while looping and still ahead of it, else the end of the asset
+        size_t get_boundary_after(size_t position) const {
+            if (is_looping_ && loop_seam_ != nullptr && position < loop_seam_->get_plan().end_frame) {
+                return loop_seam_->get_plan().end_frame;
+            }
+            return duration_samples_;
+        }
+        size_t get_boundary() const { return get_boundary_after(current_position_); }
+        size_t get_resume_frame() const { return loop_seam_ != nullptr ? loop_seam_->get_plan().resume_frame : 0; }
+
+        void render_tail(AudioBuffer& outputs, int offset, int num_samples, MeterBank* meters) {
+            if (outputs.size() < 2) {
+                tail_remaining_ = 0;
+                return;
+            }
+
+            alignas(16) float left_scratch[kDecodeChunk];
+            alignas(16) float right_scratch[kDecodeChunk];
+            const float pan_left = pan_ > 0.0f ? 1.0f - pan_ : 1.0f;
+            const float pan_right = pan_ < 0.0f ? 1.0f + pan_ : 1.0f;
+            float peak_left = 0.0f, peak_right = 0.0f;
+            float sum_sq_left = 0.0f, sum_sq_right = 0.0f;
+            int sample = 0;
+
+            while (sample < num_samples && tail_remaining_ > 0 && tail_position_ < duration_samples_) {
+                const int count = static_cast<int>(std::min<size_t>(
+                    std::min(kDecodeChunk, std::min(num_samples - sample, tail_remaining_)),
+                    duration_samples_ - tail_position_));
+                const float* left_source = tail_left_.view(tail_position_, count, left_scratch);
+                const float* right_source = tail_right_.get_channel() == nullptr
+                    ? left_source : tail_right_.view(tail_position_, count, right_scratch);
+
+                for (int i = 0; i < count; ++i) {
+                    const float gain = tail_volume_ * micro_fade_curve_[tail_remaining_ - i];
+                    const float left = left_source[i] * gain * pan_left;
+                    const float right = right_source[i] * gain * pan_right;
+                    outputs[0][offset + sample + i] += left;
+                    outputs[1][offset + sample + i] += right;
+
+                    peak_left = std::max(peak_left, std::fabs(left));
+                    peak_right = std::max(peak_right, std::fabs(right));
+                    sum_sq_left += left * left;
+                    sum_sq_right += right * right;
                 }
 
-                current_position_++;
+                tail_remaining_ -= count;
+                tail_position_ += count;
+                sample += count;
+            }
+            if (tail_position_ >= duration_samples_) {
+                tail_remaining_ = 0; // Ran off the authored end of the asset
+            }
+
+            block_peak_left_ = std::max(block_peak_left_, peak_left);
+            block_peak_right_ = std::max(block_peak_right_, peak_right);
+            if (meters != nullptr) {
+                fold_meter(*meters, meter_index_ * 2, peak_left, sum_sq_left, 0);
+                fold_meter(*meters, meter_index_ * 2 + 1, peak_right, sum_sq_right, 0);
             }
         }
 
+        static void fold_meter(MeterBank& meters, int index, float peak, float sum_squares, int num_samples) {
+            MeterAccumulator& meter = meters.accumulator(index);
+            meter.peak = std::max(meter.peak, peak);
+            meter.sum_squares += sum_squares;
+            meter.num_samples += num_samples;
+        }
+
         // Getters and setters
         const std::string& get_id() const { return cue_id_; }
+        const std::string& get_file_path() const { return file_path_; }
         CueState get_state() const { return state_; }
         double get_duration_seconds() const { return static_cast<double>(duration_samples_) / sample_rate_; }
         double get_position_seconds() const { return static_cast<double>(current_position_) / sample_rate_; }
         float get_volume() const { return volume_; }
         float get_pan() const { return pan_; }
         bool is_looping() const { return is_looping_; }
+        int get_bus() const { return bus_index_; }
+        int get_meter_index() const { return meter_index_; }
+        float get_trim_gain() const { return trim_gain_; }
+        size_t get_position_frames() const { return current_position_; }
+        size_t get_duration_frames() const { return duration_samples_; }
+        int get_sample_rate() const { return sample_rate_; }
+        int get_num_channels() const { return asset_ ? asset_->metadata.num_channels : 0; }
+        // Output peak of the last block (0 when the block was skipped as silent)
+        float get_block_peak_left() const { return block_peak_left_; }
+        float get_block_peak_right() const { return block_peak_right_; }
+        const AudioAssetMetadata& get_metadata() const { return asset_->metadata; }
+        std::shared_ptr<const AudioAsset> get_asset() const { return asset_; }
+
+        // Direct sets take over from a running scene ramp on that parameter
+        void set_volume(float volume) {
+            volume_ = volume_target_ = std::max(0.0f, std::min(1.0f, volume));
+            volume_step_ = 0.0f;
+        }
+        void set_pan(float pan) {
+            pan_ = pan_target_ = std::max(-1.0f, std::min(1.0f, pan));
+            pan_step_ = 0.0f;
+        }
+
+        // Scene recall: moves volume, pan and trim linearly over num_samples,
+        // per sample inside the kernel. Voices that are not sounding jump.
+        void ramp_to(float volume, float pan, float trim_gain, int num_samples) {
+            volume_target_ = std::max(0.0f, std::min(1.0f, volume));
+            pan_target_ = std::max(-1.0f, std::min(1.0f, pan));
+            trim_target_ = std::max(0.0f, trim_gain);
 
-        void set_volume(float volume) { volume_ = std::max(0.0f, std::min(1.0f, volume)); }
-        void set_pan(float pan) { pan_ = std::max(-1.0f, std::min(1.0f, pan)); }
+            const bool sounding = state_ == CueState::PLAYING || state_ == CueState::FADING_IN
+                || state_ == CueState::FADING_OUT;
+            if (num_samples <= 0 || !sounding) {
+                volume_ = volume_target_;
+                pan_ = pan_target_;
+                trim_gain_ = trim_target_;
+                ramp_remaining_ = 0;
+                return;
+            }
+
+            const float scale = 1.0f / static_cast<float>(num_samples);
+            volume_step_ = (volume_target_ - volume_) * scale;
+            pan_step_ = (pan_target_ - pan_) * scale;
+            trim_step_ = (trim_target_ - trim_gain_) * scale;
+            ramp_remaining_ = num_samples;
+        }
         void set_looping(bool loop) { is_looping_ = loop; }
+        // Built for this cue's asset; nullptr loops the whole asset
+        void set_loop_seam(std::shared_ptr<const LoopSeam> seam) { loop_seam_ = std::move(seam); }
+        const LoopSeam* get_loop_seam() const { return loop_seam_.get(); }
+        void set_bus(int bus_index) { bus_index_ = bus_index; }
+        void set_meter_index(int meter_index) { meter_index_ = meter_index; }
+        void set_trim_gain(float trim_gain) {
+            trim_gain_ = trim_target_ = std::max(0.0f, trim_gain);
+            trim_step_ = 0.0f;
+        }
         void seek(double position_seconds) {
-            current_position_ = static_cast<size_t>(position_seconds * sample_rate_);
-            current_position_ = std::min(current_position_, duration_samples_);
+            const size_t position = std::min(static_cast<size_t>(std::max(0.0, position_seconds) * sample_rate_),
+                duration_samples_);
+
+            // Playing voices crossfade from the old read position to the new one;
+            // a paused or stopped voice fades in when it resumes
+            begin_tail();
+            current_position_ = position;
+            entry_fade_position_ = position > 0 ? 0 : micro_fade_samples_;
+        }
+
+        // Replay: the voice resumes exactly where a capture found it, no fades
+        void restore(const VoicePlaybackState& state) {
+            const bool sounding = state.state == CueState::PLAYING || state.state == CueState::FADING_IN
+                || state.state == CueState::FADING_OUT;
+            state_ = sounding ? CueState::PLAYING : state.state;
+            current_position_ = std::min<size_t>(static_cast<size_t>(state.position_frames), duration_samples_);
+            is_looping_ = state.is_looping;
+            bus_index_ = state.bus_index;
+            set_volume(state.volume);
+            set_pan(state.pan);
+            set_trim_gain(state.trim_gain);
+            fade_samples_remaining_ = 0;
+            ramp_remaining_ = 0;
+            tail_remaining_ = 0;
+            entry_fade_position_ = micro_fade_samples_;
+            last_volume_ = sounding ? volume_ * trim_gain_ : 0.0f;
         }
 
         void fade_in(double fade_time_seconds) {
@@ -204,17 +614,109 @@ namespace SharedAudio {
         int fade_samples_total_;
         bool is_looping_;
         int sample_rate_;
-        AudioBuffer audio_data_;
+        int bus_index_;
+        int meter_index_;
+        float trim_gain_; // Level-matching trim on top of the cue volume
+        std::shared_ptr<const AudioAsset> asset_;
+        SampleReader left_;
+        SampleReader right_;
+        std::shared_ptr<const LoopSeam> loop_seam_;
+
+        float block_peak_left_ = 0.0f;
+        float block_peak_right_ = 0.0f;
+
+        // Scene ramp (volume, pan and trim share one counter)
+        float volume_target_ = 1.0f, pan_target_ = 0.0f, trim_target_ = 1.0f;
+        float volume_step_ = 0.0f, pan_step_ = 0.0f, trim_step_ = 0.0f;
+        int ramp_remaining_ = 0;
+
+        // Declicking (audio thread once playing; allocated in set_asset)
+        SampleReader tail_left_;
+        SampleReader tail_right_;
+        std::vector<float> micro_fade_curve_;
+        int micro_fade_samples_ = 1;
+        int entry_fade_position_ = 1;  // == micro_fade_samples_ when no entry fade is running
+        size_t tail_position_ = 0;     // Old read position fading out after stop/pause/seek/restart
+        int tail_remaining_ = 0;
+        float tail_volume_ = 0.0f;
+        float last_volume_ = 0.0f;     // Gain of the last sample mixed, where a tail starts from
+
+        static constexpr int kDecodeChunk = 64; // Frames expanded per step, 256 bytes per channel
+        static constexpr float kSilenceThreshold = 1.0e-5f; // -100 dBFS after gain
+        static constexpr double kMicroFadeSeconds = 0.005;
     };
 
+    namespace {
+
+        // One voice as published by the audio thread each block
+        struct VoiceStatus {
+            bool loaded = false;
+            CueState state = CueState::STOPPED;
+            bool is_looping = false;
+            uint64_t position_frames = 0;
+            uint64_t duration_frames = 0;
+            int sample_rate = 0;
+            int num_channels = 0;
+            float volume = 0.0f;
+            float pan = 0.0f;
+            float trim_gain = 1.0f;
+            float peak_left = 0.0f;
+            float peak_right = 0.0f;
+        };
+
+        constexpr int kMaxStatusVoices = 256; // One per voice meter slot
+
+        struct StatusFrame {
+            uint64_t block = 0;
+            int64_t time_ns = 0;  // steady_clock at publish, for position interpolation
+            int num_slots = 0;    // Slots written this block
+            std::array<VoiceStatus, kMaxStatusVoices> voices;
+        };
+
+        int64_t steady_now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        bool is_active_state(CueState state) {
+            return state != CueState::STOPPED;
+        }
+
+        constexpr size_t kMaxRealtimeIdBytes = sizeof(AudioThreadMessage::cue_id) - 1;
+
+        // FNV-1a over the id as the command queues carry it (at most 63 bytes)
+        uint64_t hash_cue_id(const char* cue_id) {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < kMaxRealtimeIdBytes && cue_id[i] != '\0'; ++i) {
+                hash = (hash ^ static_cast<uint8_t>(cue_id[i])) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        // A transport or parameter command waiting for process_audio
+        struct RealtimeCommand {
+            AudioThreadMessage::Type type = AudioThreadMessage::NONE;
+            int offset = 0; // Frame within the block it takes effect at
+            uint64_t cue_hash = 0;
+            char cue_id[sizeof(AudioThreadMessage::cue_id)] = { 0 };
+            double value = 0.0;
+        };
+
+        constexpr int kMaxRealtimeCommands = 256;
+
+    } // namespace
+
     // CueAudioManager implementation
     class CueAudioManager::Impl {
     public:
-        Impl() : sample_rate_(48000), buffer_size_(256), initialized_(false) {}
+        Impl() : sample_rate_(48000), buffer_size_(256), initialized_(false), mix_graph_(nullptr) {}
 
         bool initialize(int sample_rate, int buffer_size) {
             sample_rate_ = sample_rate;
             buffer_size_ = buffer_size;
+            voice_meters_.prepare(kMaxVoiceMeters * 2, true);
+            meter_slot_used_.assign(kMaxVoiceMeters, false);
+            asset_cache_.initialize(sample_rate);
             initialized_ = true;
 
             std::cout << "[AUDIO] CueAudioManager initialized (SR: " << sample_rate
@@ -223,21 +725,40 @@ namespace SharedAudio {
         }
 
         void shutdown() {
-            std::lock_guard<std::mutex> lock(cues_mutex_);
-            audio_cues_.clear();
+            {
+                std::lock_guard<std::mutex> lock(cues_mutex_);
+                audio_cues_.clear();
+                rebuild_voice_table();
+            }
+            asset_cache_.shutdown();
             initialized_ = false;
             std::cout << "[AUDIO] CueAudioManager shutdown" << std::endl;
         }
 
         bool load_audio_cue(const std::string& cue_id, const std::string& file_path) {
+            // Decode outside the lock so playback is not held up by file I/O
+            auto asset = asset_cache_.load(file_path);
+            if (!asset) {
+                return false;
+            }
+
             std::lock_guard<std::mutex> lock(cues_mutex_);
 
             auto cue = std::make_unique<AudioCue>(cue_id, file_path);
-            if (!cue->load_audio_file()) {
-                return false;
+            cue->set_asset(std::move(asset));
+
+            // Reloading a cue id keeps its meter slot
+            auto existing = audio_cues_.find(cue_id);
+            if (existing != audio_cues_.end()) {
+                cue->set_meter_index(existing->second->get_meter_index());
+            }
+            else {
+                cue->set_meter_index(allocate_meter_slot());
             }
+            register_status_slot(cue->get_meter_index(), cue_id, file_path);
 
             audio_cues_[cue_id] = std::move(cue);
+            rebuild_voice_table();
             return true;
         }
 
@@ -247,7 +768,10 @@ namespace SharedAudio {
             auto it = audio_cues_.find(cue_id);
             if (it != audio_cues_.end()) {
                 it->second->stop();
+                register_status_slot(it->second->get_meter_index(), std::string(), std::string());
+                release_meter_slot(it->second->get_meter_index());
                 audio_cues_.erase(it);
+                rebuild_voice_table();
                 return true;
             }
             return false;
@@ -259,6 +783,7 @@ namespace SharedAudio {
             auto it = audio_cues_.find(cue_id);
             if (it != audio_cues_.end()) {
                 it->second->start();
+                std::cout << "[PLAY] Started cue: " << cue_id << std::endl;
                 return true;
             }
             return false;
@@ -270,31 +795,656 @@ namespace SharedAudio {
             auto it = audio_cues_.find(cue_id);
             if (it != audio_cues_.end()) {
                 it->second->stop();
+                std::cout << "[STOP] Stopped cue: " << cue_id << std::endl;
                 return true;
             }
             return false;
         }
 
+        bool pause_cue(const std::string& cue_id) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            if (it->second->pause()) {
+                std::cout << "[PAUSE] Paused cue: " << cue_id << std::endl;
+            }
+            return true;
+        }
+
+        bool resume_cue(const std::string& cue_id) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            if (it->second->resume()) {
+                std::cout << "[PLAY] Resumed cue: " << cue_id << std::endl;
+            }
+            return true;
+        }
+
+        bool seek_cue(const std::string& cue_id, double position_seconds) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->seek(position_seconds);
+            return true;
+        }
+
+        void stop_all_cues() {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            for (auto& [cue_id, cue] : audio_cues_) {
+                cue->stop();
+            }
+        }
+
+        void pause_all_cues() {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            for (auto& [cue_id, cue] : audio_cues_) {
+                cue->pause();
+            }
+        }
+
+        void resume_all_cues() {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            for (auto& [cue_id, cue] : audio_cues_) {
+                cue->resume();
+            }
+        }
+
+        void set_mix_graph(MixGraph* mix_graph) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            mix_graph_ = mix_graph;
+        }
+
+        bool set_cue_bus(const std::string& cue_id, int bus_index) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            // get_bus_buffer() belongs to the audio thread, the count is safe here
+            if (it == audio_cues_.end()
+                || (mix_graph_ && (bus_index < 0 || bus_index >= mix_graph_->get_num_buses()))) {
+                return false;
+            }
+            it->second->set_bus(bus_index);
+            return true;
+        }
+
+        void set_silence_skipping(bool enabled) {
+            skip_silence_.store(enabled, std::memory_order_relaxed);
+        }
+
+        bool set_cue_volume(const std::string& cue_id, float volume) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->set_volume(volume);
+            return true;
+        }
+
+        bool set_cue_pan(const std::string& cue_id, float pan) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->set_pan(pan);
+            return true;
+        }
+
+        uint64_t capture_voices(std::vector<VoiceSnapshot>& voices) const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            voices.clear();
+            voices.reserve(audio_cues_.size());
+            for (const auto& [cue_id, cue] : audio_cues_) {
+                VoiceSnapshot voice;
+                voice.cue_id = cue_id;
+                voice.volume = cue->get_volume();
+                voice.pan = cue->get_pan();
+                voice.trim_gain = cue->get_trim_gain();
+                voice.voice_index = static_cast<int>(voices.size()); // Same order as voice_list_
+                voices.push_back(std::move(voice));
+            }
+            return voice_layout_;
+        }
+
+        // REAL-TIME THREAD - picked up by the next process_audio, in the same block
+        void apply_scene_realtime(const SceneSnapshot* scene, int default_ramp_samples) {
+            pending_scene_ = scene;
+            pending_scene_ramp_samples_ = default_ramp_samples;
+        }
+
+        void capture_playback_state_realtime(std::vector<VoicePlaybackState>& states) const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            states.clear();
+            for (const auto& [cue_id, cue] : audio_cues_) {
+                if (states.size() == states.capacity()) {
+                    break;
+                }
+                states.emplace_back();
+                VoicePlaybackState& state = states.back();
+                std::strncpy(state.cue_id, cue_id.c_str(), sizeof(state.cue_id) - 1);
+                state.state = cue->get_state();
+                state.is_looping = cue->is_looping();
+                state.bus_index = cue->get_bus();
+                state.position_frames = cue->get_position_frames();
+                state.volume = cue->get_volume();
+                state.pan = cue->get_pan();
+                state.trim_gain = cue->get_trim_gain();
+            }
+        }
+
+        bool restore_playback_state(const VoicePlaybackState& state) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(std::string(state.cue_id, strnlen(state.cue_id, sizeof(state.cue_id))));
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->restore(state);
+            return true;
+        }
+
+        // REAL-TIME THREAD - no lookup here, the id is resolved in process_audio.
+        // The list stays sorted by offset, arrival order among equals.
+        bool push_realtime(AudioThreadMessage::Type type, const char* cue_id, double value, int offset) {
+            if (num_realtime_commands_ >= kMaxRealtimeCommands) {
+                return false;
+            }
+            offset = std::max(0, offset);
+            int index = num_realtime_commands_++;
+            while (index > 0 && realtime_commands_[index - 1].offset > offset) {
+                realtime_commands_[index] = realtime_commands_[index - 1];
+                --index;
+            }
+            RealtimeCommand& command = realtime_commands_[index];
+            command.type = type;
+            command.offset = offset;
+            command.cue_hash = hash_cue_id(cue_id);
+            const size_t length = strnlen(cue_id, kMaxRealtimeIdBytes);
+            std::memcpy(command.cue_id, cue_id, length);
+            command.cue_id[length] = '\0';
+            command.value = value;
+            return true;
+        }
+
         void process_audio(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
             std::lock_guard<std::mutex> lock(cues_mutex_);
+            SampleArena::ReadGuard samples_guard(*asset_cache_.get_arena()); // Pins sample data against compaction
+
+            int next_command = apply_realtime_commands(0, 0);
+
+            if (pending_scene_ != nullptr) {
+                const bool indexed = pending_scene_->voice_layout == voice_layout_;
+                for (const VoiceSnapshot& voice : pending_scene_->voices) {
+                    AudioCue* cue = indexed ? indexed_voice(voice) : nullptr;
+                    if (cue == nullptr) {
+                        cue = find_voice(hash_cue_id(voice.cue_id.c_str()), voice.cue_id.c_str());
+                    }
+                    if (cue != nullptr) {
+                        const int ramp = voice.ramp_seconds < 0.0f ? pending_scene_ramp_samples_
+                            : static_cast<int>(voice.ramp_seconds * sample_rate_);
+                        cue->ramp_to(voice.volume, voice.pan, voice.trim_gain, ramp);
+                    }
+                }
+                pending_scene_ = nullptr;
+            }
+
+            // Timed commands split the block: every voice renders up to the
+            // command's frame, the command lands, rendering carries on
+            voice_meters_.begin_block();
+            int start = 0;
+            while (start < num_samples) {
+                next_command = apply_realtime_commands(next_command, start);
+                const int end = next_command < num_realtime_commands_
+                    ? std::min(num_samples, realtime_commands_[next_command].offset) : num_samples;
+                render_voices(outputs, start, end - start);
+                start = end;
+            }
+            apply_realtime_commands(next_command, std::numeric_limits<int>::max()); // Beyond this block
+            num_realtime_commands_ = 0;
+            voice_meters_.publish();
+            publish_status();
+        }
 
+        void render_voices(AudioBuffer& outputs, int offset, int num_samples) {
             for (auto& [cue_id, cue] : audio_cues_) {
-                cue->process_audio(outputs, num_samples);
+                // Silent voices never touch a bus, so an idle bus stays flagged silent
+                if (cue->skip_silent_block(num_samples, &voice_meters_, skip_silence_.load(std::memory_order_relaxed))) {
+                    continue;
+                }
+
+                // Cues without a valid bus fall back to the device outputs
+                AudioBuffer* bus = mix_graph_ ? mix_graph_->get_bus_buffer(cue->get_bus()) : nullptr;
+                cue->process_audio(bus ? *bus : outputs, offset, num_samples, &voice_meters_);
             }
         }
 
+        // Status readers never touch cues_mutex_: they read the last block's
+        // frame from the triple buffer and names from the slot registry
+        std::vector<AudioCueInfo> get_active_cues() {
+            std::lock_guard<std::mutex> lock(status_read_mutex_);
+            const StatusFrame& frame = read_status();
+            std::lock_guard<std::mutex> registry_lock(registry_mutex_);
+
+            std::vector<AudioCueInfo> cues;
+            for (int slot = 0; slot < frame.num_slots; ++slot) {
+                const VoiceStatus& voice = frame.voices[slot];
+                if (voice.loaded && is_active_state(voice.state) && !slot_cue_ids_[slot].empty()) {
+                    cues.push_back(make_cue_info(frame, slot));
+                }
+            }
+            return cues;
+        }
+
+        AudioCueInfo get_cue_info(const std::string& cue_id) {
+            std::lock_guard<std::mutex> lock(status_read_mutex_);
+            const StatusFrame& frame = read_status();
+            std::lock_guard<std::mutex> registry_lock(registry_mutex_);
+
+            const int slot = find_status_slot(cue_id);
+            if (slot >= 0 && slot < frame.num_slots && frame.voices[slot].loaded) {
+                return make_cue_info(frame, slot);
+            }
+
+            AudioCueInfo info{};
+            info.cue_id = cue_id;
+            info.state = CueState::STOPPED;
+            info.is_loaded = slot >= 0; // Loaded, not yet seen by the audio thread
+            if (slot >= 0) {
+                info.file_path = slot_file_paths_[slot];
+            }
+            return info;
+        }
+
+        bool is_cue_playing(const std::string& cue_id) {
+            const AudioCueInfo info = get_cue_info(cue_id);
+            return info.state == CueState::PLAYING || info.state == CueState::FADING_IN
+                || info.state == CueState::FADING_OUT;
+        }
+
+        MeterBank* get_voice_meters() {
+            return &voice_meters_;
+        }
+
+        bool set_cue_loop(const std::string& cue_id, bool loop) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->set_looping(loop);
+            return true;
+        }
+
+        // The seam is mixed here, on the calling thread, and handed to the
+        // cue ready to play; the audio thread only switches pointers
+        bool set_cue_loop_region(const std::string& cue_id, double start_seconds, double end_seconds,
+            double crossfade_seconds) {
+            auto asset = get_cue_asset(cue_id);
+            if (!asset || asset->channels.empty()) {
+                return false;
+            }
+
+            const int sample_rate = asset->metadata.sample_rate > 0 ? asset->metadata.sample_rate : sample_rate_;
+            LoopRegion region;
+            region.start_frame = static_cast<size_t>(std::max(0.0, start_seconds) * sample_rate);
+            region.end_frame = end_seconds > 0.0 ? static_cast<size_t>(end_seconds * sample_rate) : 0;
+            region.crossfade_frames = static_cast<int>(std::max(0.0, crossfade_seconds) * sample_rate);
+
+            const LoopSeamPlan plan = LoopSeam::plan(region, asset->metadata.num_frames);
+            if (!plan.is_valid()) {
+                return false;
+            }
+
+            const size_t frames = static_cast<size_t>(plan.crossfade_frames);
+            AudioBuffer outgoing(asset->channels.size(), std::vector<float>(frames));
+            AudioBuffer incoming(asset->channels.size(), std::vector<float>(frames));
+            if (frames > 0) {
+                SampleArena::ReadGuard samples_guard(*asset_cache_.get_arena());
+                for (size_t ch = 0; ch < asset->channels.size(); ++ch) {
+                    asset->channels[ch].read(plan.seam_start, plan.crossfade_frames, outgoing[ch].data());
+                    asset->channels[ch].read(plan.incoming_start, plan.crossfade_frames, incoming[ch].data());
+                }
+            }
+            auto seam = std::make_shared<LoopSeam>();
+            seam->build(plan, outgoing, incoming);
+
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end() || it->second->get_asset() != asset) {
+                return false; // Reloaded meanwhile
+            }
+            it->second->set_loop_seam(std::move(seam));
+            std::cout << "[AUDIO] Loop region for " << cue_id << ": " << plan.resume_frame << "-" << plan.end_frame
+                << " (" << plan.crossfade_frames << " frame seam)" << std::endl;
+            return true;
+        }
+
+        bool clear_cue_loop_region(const std::string& cue_id) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            it->second->set_loop_seam(nullptr);
+            return true;
+        }
+
+        bool set_cue_trim(const std::string& cue_id, float trim_db) {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+
+            auto it = audio_cues_.find(cue_id);
+            if (it == audio_cues_.end()) {
+                return false;
+            }
+            trim_db = std::max(-kMaxTrimDb, std::min(kMaxTrimDb, trim_db));
+            it->second->set_trim_gain(std::pow(10.0f, trim_db / 20.0f));
+            return true;
+        }
+
+        // Trim the cue so its integrated loudness lands on the target
+        bool normalize_cue_loudness(const std::string& cue_id, double target_lufs) {
+            LoudnessInfo loudness = get_cue_loudness(cue_id);
+            if (!loudness.is_valid || loudness.integrated_lufs <= kLoudnessFloorLufs) {
+                return false; // Silent or unanalysed - nothing to match
+            }
+            return set_cue_trim(cue_id, static_cast<float>(target_lufs - loudness.integrated_lufs));
+        }
+
+        LoudnessInfo get_cue_loudness(const std::string& cue_id) const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            auto it = audio_cues_.find(cue_id);
+            return it != audio_cues_.end() ? it->second->get_metadata().loudness : LoudnessInfo{};
+        }
+
+        AudioAssetCache* get_asset_cache() {
+            return &asset_cache_;
+        }
+
+        std::shared_ptr<const AudioAsset> get_cue_asset(const std::string& cue_id) const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            auto it = audio_cues_.find(cue_id);
+            return it != audio_cues_.end() ? it->second->get_asset() : nullptr;
+        }
+
+        int get_cue_meter_index(const std::string& cue_id) const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            auto it = audio_cues_.find(cue_id);
+            return it != audio_cues_.end() ? it->second->get_meter_index() : -1;
+        }
+
         // Additional methods for completeness...
         bool is_cue_loaded(const std::string& cue_id) const {
             std::lock_guard<std::mutex> lock(cues_mutex_);
             return audio_cues_.find(cue_id) != audio_cues_.end();
         }
 
+        std::vector<std::pair<std::string, std::string>> get_loaded_assets() const {
+            std::lock_guard<std::mutex> lock(cues_mutex_);
+            std::vector<std::pair<std::string, std::string>> assets;
+            for (const auto& [cue_id, cue] : audio_cues_) {
+                assets.emplace_back(cue_id, cue->get_file_path());
+            }
+            return assets;
+        }
+
     private:
         int sample_rate_;
         int buffer_size_;
         bool initialized_;
         mutable std::mutex cues_mutex_;
         std::map<std::string, std::unique_ptr<AudioCue>> audio_cues_;
+        MixGraph* mix_graph_;
+        AudioAssetCache asset_cache_;
+
+        // Voice status, one slot per meter slot. The audio thread writes a
+        // whole frame per block; readers (serialised among themselves) pick
+        // up the newest one wait-free.
+        TripleBuffer<StatusFrame> status_;
+        uint64_t status_block_ = 0; // audio thread only
+        std::mutex status_read_mutex_;
+        mutable std::mutex registry_mutex_;
+        std::array<std::string, kMaxStatusVoices> slot_cue_ids_;
+        std::array<std::string, kMaxStatusVoices> slot_file_paths_;
+        const SceneSnapshot* pending_scene_ = nullptr; // audio thread only, kept alive by SceneManager
+        int pending_scene_ramp_samples_ = 0;
+
+        static constexpr float kMaxTrimDb = 24.0f;
+        static constexpr double kMaxExtrapolationSeconds = 0.1; // Stalled callbacks freeze the readout
+
+        // Commands from the audio thread's queues, applied by process_audio
+        std::array<RealtimeCommand, kMaxRealtimeCommands> realtime_commands_;
+        int num_realtime_commands_ = 0; // audio thread only
+
+        // Hashed cue id -> voice, open addressing, at most half full. Rebuilt
+        // under cues_mutex_ whenever the cue set changes; process_audio reads
+        // it under the same lock, so a lookup never allocates or compares
+        // more than a few entries.
+        struct VoiceTableEntry {
+            uint64_t cue_hash = 0;
+            AudioCue* cue = nullptr; // nullptr: empty
+        };
+        std::vector<VoiceTableEntry> voice_table_;
+        size_t voice_table_mask_ = 0;
+
+        // Voices in cue id order, as capture_voices indexes them. The layout
+        // changes with every rebuild, so a scene captured before a cue was
+        // loaded or unloaded goes back to looking voices up by id.
+        std::vector<AudioCue*> voice_list_;
+        uint64_t voice_layout_ = 1;
+
+        void rebuild_voice_table() {
+            size_t size = 64;
+            while (size < audio_cues_.size() * 2) {
+                size <<= 1;
+            }
+            voice_table_.assign(size, VoiceTableEntry());
+            voice_table_mask_ = size - 1;
+            for (auto& [cue_id, cue] : audio_cues_) {
+                const uint64_t hash = hash_cue_id(cue_id.c_str());
+                size_t index = hash & voice_table_mask_;
+                while (voice_table_[index].cue != nullptr) {
+                    index = (index + 1) & voice_table_mask_;
+                }
+                voice_table_[index] = { hash, cue.get() };
+            }
+
+            voice_list_.clear();
+            voice_list_.reserve(audio_cues_.size());
+            for (auto& [cue_id, cue] : audio_cues_) {
+                voice_list_.push_back(cue.get());
+            }
+            ++voice_layout_;
+        }
+
+        // REAL-TIME THREAD, under cues_mutex_. The id check catches snapshots
+        // copied and edited after capture.
+        AudioCue* indexed_voice(const VoiceSnapshot& voice) const {
+            if (voice.voice_index < 0 || voice.voice_index >= static_cast<int>(voice_list_.size())) {
+                return nullptr;
+            }
+            AudioCue* cue = voice_list_[voice.voice_index];
+            return cue->get_id() == voice.cue_id ? cue : nullptr;
+        }
+
+        // REAL-TIME THREAD, under cues_mutex_
+        AudioCue* find_voice(uint64_t cue_hash, const char* cue_id) const {
+            if (voice_table_.empty()) {
+                return nullptr;
+            }
+            for (size_t index = cue_hash & voice_table_mask_; voice_table_[index].cue != nullptr;
+                index = (index + 1) & voice_table_mask_) {
+                const VoiceTableEntry& entry = voice_table_[index];
+                if (entry.cue_hash == cue_hash
+                    && std::strncmp(entry.cue->get_id().c_str(), cue_id, kMaxRealtimeIdBytes) == 0) {
+                    return entry.cue;
+                }
+            }
+            return nullptr;
+        }
+
+        // REAL-TIME THREAD, under cues_mutex_ - applies the commands from
+        // index first on whose offset is at most up_to, returns the next one.
+        // Commands for cues that are not loaded are dropped.
+        int apply_realtime_commands(int first, int up_to) {
+            int i = first;
+            for (; i < num_realtime_commands_ && realtime_commands_[i].offset <= up_to; ++i) {
+                const RealtimeCommand& command = realtime_commands_[i];
+                AudioCue* cue = find_voice(command.cue_hash, command.cue_id);
+                if (cue == nullptr) {
+                    continue;
+                }
+                switch (command.type) {
+                case AudioThreadMessage::START_CUE:
+                    cue->start();
+                    break;
+                case AudioThreadMessage::STOP_CUE:
+                    cue->stop();
+                    break;
+                case AudioThreadMessage::SET_VOLUME:
+                    cue->set_volume(static_cast<float>(command.value));
+                    break;
+                case AudioThreadMessage::SET_PAN:
+                    cue->set_pan(static_cast<float>(command.value));
+                    break;
+                case AudioThreadMessage::SEEK:
+                    cue->seek(command.value);
+                    break;
+                default:
+                    break;
+                }
+            }
+            return i;
+        }
+
+        // Voice meters, two channels per cue (index meter_index * 2 + channel)
+        static constexpr int kMaxVoiceMeters = 256;
+        MeterBank voice_meters_;
+        std::atomic<bool> skip_silence_{ true };
+        std::vector<bool> meter_slot_used_;
+
+        int allocate_meter_slot() {
+            for (size_t i = 0; i < meter_slot_used_.size(); ++i) {
+                if (!meter_slot_used_[i]) {
+                    meter_slot_used_[i] = true;
+                    return static_cast<int>(i);
+                }
+            }
+            return -1; // More cues than meters - the cue plays unmetered
+        }
+
+        // REAL-TIME THREAD - a few hundred bytes per loaded cue, no locks beyond
+        // the cues_mutex_ process_audio already holds
+        void publish_status() {
+            StatusFrame& frame = status_.write_buffer();
+            const int num_slots = static_cast<int>(std::min<size_t>(meter_slot_used_.size(), kMaxStatusVoices));
+            for (int slot = 0; slot < std::min(num_slots, frame.num_slots); ++slot) {
+                frame.voices[slot].loaded = false;
+            }
+            frame.num_slots = 0;
+
+            for (const auto& [cue_id, cue] : audio_cues_) {
+                const int slot = cue->get_meter_index();
+                if (slot < 0 || slot >= num_slots) {
+                    continue;
+                }
+                VoiceStatus& voice = frame.voices[slot];
+                voice.loaded = true;
+                voice.state = cue->get_state();
+                voice.is_looping = cue->is_looping();
+                voice.position_frames = cue->get_position_frames();
+                voice.duration_frames = cue->get_duration_frames();
+                voice.sample_rate = cue->get_sample_rate();
+                voice.num_channels = cue->get_num_channels();
+                voice.volume = cue->get_volume();
+                voice.pan = cue->get_pan();
+                voice.trim_gain = cue->get_trim_gain();
+                voice.peak_left = cue->get_block_peak_left();
+                voice.peak_right = cue->get_block_peak_right();
+                frame.num_slots = std::max(frame.num_slots, slot + 1);
+            }
+
+            frame.block = ++status_block_;
+            frame.time_ns = steady_now_ns();
+            status_.publish();
+        }
+
+        const StatusFrame& read_status() {
+            status_.update();
+            return status_.read_buffer();
+        }
+
+        // Positions move on between callbacks; extrapolate playing voices from
+        // the publish time so UI readouts are smooth at any polling rate
+        AudioCueInfo make_cue_info(const StatusFrame& frame, int slot) const {
+            const VoiceStatus& voice = frame.voices[slot];
+            AudioCueInfo info{};
+            info.cue_id = slot_cue_ids_[slot];
+            info.file_path = slot_file_paths_[slot];
+            info.state = voice.state;
+            info.is_looping = voice.is_looping;
+            info.is_loaded = true;
+            info.volume = voice.volume;
+            info.pan = voice.pan;
+            info.trim_gain = voice.trim_gain;
+            info.peak_left = voice.peak_left;
+            info.peak_right = voice.peak_right;
+            info.sample_rate = voice.sample_rate;
+            info.channels = voice.num_channels;
+
+            const double rate = voice.sample_rate > 0 ? voice.sample_rate : sample_rate_;
+            info.duration_seconds = voice.duration_frames / rate;
+            double position = voice.position_frames / rate;
+            if (voice.state == CueState::PLAYING || voice.state == CueState::FADING_IN
+                || voice.state == CueState::FADING_OUT) {
+                const double elapsed = (steady_now_ns() - frame.time_ns) * 1.0e-9;
+                position += std::max(0.0, std::min(elapsed, kMaxExtrapolationSeconds));
+                if (position >= info.duration_seconds) {
+                    position = voice.is_looping ? voice.position_frames / rate : info.duration_seconds;
+                }
+            }
+            info.current_position_seconds = position;
+            return info;
+        }
+
+        int find_status_slot(const std::string& cue_id) const {
+            for (int slot = 0; slot < kMaxStatusVoices; ++slot) {
+                if (slot_cue_ids_[slot] == cue_id) {
+                    return slot;
+                }
+            }
+            return -1;
+        }
+
+        void register_status_slot(int slot, const std::string& cue_id, const std::string& file_path) {
+            if (slot < 0 || slot >= kMaxStatusVoices) {
+                return; // Unmetered cues have no status slot either
+            }
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            slot_cue_ids_[slot] = cue_id;
+            slot_file_paths_[slot] = file_path;
+        }
+
+        void release_meter_slot(int index) {
+            if (index >= 0 && index < static_cast<int>(meter_slot_used_.size())) {
+                meter_slot_used_[index] = false;
+            }
+        }
     };
 
     // CueAudioManager public interface
@@ -313,6 +1463,10 @@ namespace SharedAudio {
         return impl_->load_audio_cue(cue_id, file_path);
     }
 
+    bool CueAudioManager::unload_audio_cue(const std::string& cue_id) {
+        return impl_->unload_audio_cue(cue_id);
+    }
+
     bool CueAudioManager::start_cue(const std::string& cue_id) {
         return impl_->start_cue(cue_id);
     }
@@ -321,49 +1475,149 @@ namespace SharedAudio {
         return impl_->stop_cue(cue_id);
     }
 
+    bool CueAudioManager::pause_cue(const std::string& cue_id) {
+        return impl_->pause_cue(cue_id);
+    }
+
+    bool CueAudioManager::resume_cue(const std::string& cue_id) {
+        return impl_->resume_cue(cue_id);
+    }
+
+    bool CueAudioManager::seek_cue(const std::string& cue_id, double position_seconds) {
+        return impl_->seek_cue(cue_id, position_seconds);
+    }
+
+    void CueAudioManager::stop_all_cues() {
+        impl_->stop_all_cues();
+    }
+
+    void CueAudioManager::pause_all_cues() {
+        impl_->pause_all_cues();
+    }
+
+    void CueAudioManager::resume_all_cues() {
+        impl_->resume_all_cues();
+    }
+
+    void CueAudioManager::set_mix_graph(MixGraph* mix_graph) {
+        impl_->set_mix_graph(mix_graph);
+    }
+
+    bool CueAudioManager::set_cue_bus(const std::string& cue_id, int bus_index) {
+        return impl_->set_cue_bus(cue_id, bus_index);
+    }
+
+    void CueAudioManager::set_silence_skipping(bool enabled) {
+        impl_->set_silence_skipping(enabled);
+    }
+
+    bool CueAudioManager::set_cue_volume(const std::string& cue_id, float volume) {
+        return impl_->set_cue_volume(cue_id, volume);
+    }
+
+    bool CueAudioManager::set_cue_pan(const std::string& cue_id, float pan) {
+        return impl_->set_cue_pan(cue_id, pan);
+    }
+
+    uint64_t CueAudioManager::capture_voices(std::vector<VoiceSnapshot>& voices) const {
+        return impl_->capture_voices(voices);
+    }
+
+    void CueAudioManager::apply_scene_realtime(const SceneSnapshot* scene, int default_ramp_samples) {
+        impl_->apply_scene_realtime(scene, default_ramp_samples);
+    }
+
+    bool CueAudioManager::set_cue_loop(const std::string& cue_id, bool loop) {
+        return impl_->set_cue_loop(cue_id, loop);
+    }
+
+    bool CueAudioManager::set_cue_loop_region(const std::string& cue_id, double start_seconds, double end_seconds,
+        double crossfade_seconds) {
+        return impl_->set_cue_loop_region(cue_id, start_seconds, end_seconds, crossfade_seconds);
+    }
+
+    bool CueAudioManager::clear_cue_loop_region(const std::string& cue_id) {
+        return impl_->clear_cue_loop_region(cue_id);
+    }
+
+    MeterBank* CueAudioManager::get_voice_meters() {
+        return impl_->get_voice_meters();
+    }
+
+    int CueAudioManager::get_cue_meter_index(const std::string& cue_id) const {
+        return impl_->get_cue_meter_index(cue_id);
+    }
+
+    bool CueAudioManager::set_cue_trim(const std::string& cue_id, float trim_db) {
+        return impl_->set_cue_trim(cue_id, trim_db);
+    }
+
+    bool CueAudioManager::normalize_cue_loudness(const std::string& cue_id, double target_lufs) {
+        return impl_->normalize_cue_loudness(cue_id, target_lufs);
+    }
+
+    LoudnessInfo CueAudioManager::get_cue_loudness(const std::string& cue_id) const {
+        return impl_->get_cue_loudness(cue_id);
+    }
+
+    AudioAssetCache* CueAudioManager::get_asset_cache() {
+        return impl_->get_asset_cache();
+    }
+
+    std::shared_ptr<const AudioAsset> CueAudioManager::get_cue_asset(const std::string& cue_id) const {
+        return impl_->get_cue_asset(cue_id);
+    }
+
+    void CueAudioManager::capture_playback_state_realtime(std::vector<VoicePlaybackState>& states) const {
+        impl_->capture_playback_state_realtime(states);
+    }
+
+    bool CueAudioManager::restore_playback_state(const VoicePlaybackState& state) {
+        return impl_->restore_playback_state(state);
+    }
+
     void CueAudioManager::process_audio(const AudioBuffer& inputs, AudioBuffer& outputs, int num_samples) {
         impl_->process_audio(inputs, outputs, num_samples);
     }
 
+    std::vector<AudioCueInfo> CueAudioManager::get_active_cues() const {
+        return impl_->get_active_cues();
+    }
+
+    AudioCueInfo CueAudioManager::get_cue_info(const std::string& cue_id) const {
+        return impl_->get_cue_info(cue_id);
+    }
+
+    bool CueAudioManager::is_cue_playing(const std::string& cue_id) const {
+        return impl_->is_cue_playing(cue_id);
+    }
+
     bool CueAudioManager::is_cue_loaded(const std::string& cue_id) const {
         return impl_->is_cue_loaded(cue_id);
     }
 
-    bool CueAudioManager::start_cue_realtime(const char* cue_id) {
-        // This is called from audio thread - NO LOCKS!
-        auto* cue = find_cue_lockfree(cue_id);
-        if (cue) {
-            cue->start_realtime();
-            return true;
-        }
-        return false;
+    std::vector<std::pair<std::string, std::string>> CueAudioManager::get_loaded_assets() const {
+        return impl_->get_loaded_assets();
     }
 
-    bool CueAudioManager::stop_cue_realtime(const char* cue_id) {
-        // This is called from audio thread - NO LOCKS!
-        auto* cue = find_cue_lockfree(cue_id);
-        if (cue) {
-            cue->stop_realtime();
-            return true;
-        }
-        return false;
+    bool CueAudioManager::start_cue_realtime(const char* cue_id, int sample_offset) {
+        return impl_->push_realtime(AudioThreadMessage::START_CUE, cue_id, 0.0, sample_offset);
     }
 
-    // Non-realtime thread methods send messages
-    bool CueAudioManager::start_cue(const std::string& cue_id) {
-        AudioThreadMessage msg;
-        msg.type = AudioThreadMessage::START_CUE;
-        strncpy(msg.cue_id, cue_id.c_str(), sizeof(msg.cue_id) - 1);
+    bool CueAudioManager::stop_cue_realtime(const char* cue_id, int sample_offset) {
+        return impl_->push_realtime(AudioThreadMessage::STOP_CUE, cue_id, 0.0, sample_offset);
+    }
 
-        return parent_core_->sendAudioThreadMessage(msg);
+    bool CueAudioManager::set_cue_volume_realtime(const char* cue_id, float volume, int sample_offset) {
+        return impl_->push_realtime(AudioThreadMessage::SET_VOLUME, cue_id, volume, sample_offset);
     }
 
-    bool CueAudioManager::stop_cue(const std::string& cue_id) {
-        AudioThreadMessage msg;
-        msg.type = AudioThreadMessage::STOP_CUE;
-        strncpy(msg.cue_id, cue_id.c_str(), sizeof(msg.cue_id) - 1);
+    bool CueAudioManager::set_cue_pan_realtime(const char* cue_id, float pan, int sample_offset) {
+        return impl_->push_realtime(AudioThreadMessage::SET_PAN, cue_id, pan, sample_offset);
+    }
 
-        return parent_core_->sendAudioThreadMessage(msg);
+    bool CueAudioManager::seek_cue_realtime(const char* cue_id, double position_seconds, int sample_offset) {
+        return impl_->push_realtime(AudioThreadMessage::SEEK, cue_id, position_seconds, sample_offset);
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,353 @@
+﻿#include "show_control/midi_trigger_input.h"
+#include "core/lock_free_fifo.h"
+
+#include <juce_audio_devices/juce_audio_devices.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr int kNumChannels = 16;
+        constexpr int kNumNotes = 128;
+        constexpr size_t kMaxCueNumberBytes = 32;
+
+        // MSC command bytes
+        constexpr uint8_t kMscGo = 0x01;
+        constexpr uint8_t kMscStop = 0x02;
+        constexpr uint8_t kMscGoOff = 0x0B;
+        constexpr uint8_t kMscAllCall = 0x7F;
+
+        // MSC command formats: the sound range and "all types"
+        constexpr uint8_t kMscSoundFirst = 0x10;
+        constexpr uint8_t kMscSoundLast = 0x1F;
+        constexpr uint8_t kMscAllTypes = 0x7F;
+
+        // "012.50" and "12.5" name the same cue. Writes into out, returns the length.
+        size_t normalise_cue_number(const char* data, size_t length, char* out) {
+            size_t begin = 0;
+            while (begin + 1 < length && data[begin] == '0' && data[begin + 1] != '.') {
+                ++begin;
+            }
+            size_t end = length;
+            if (std::find(data + begin, data + end, '.') != data + end) {
+                while (end > begin && data[end - 1] == '0') {
+                    --end;
+                }
+                if (end > begin && data[end - 1] == '.') {
+                    --end;
+                }
+            }
+            const size_t count = std::min(end - begin, kMaxCueNumberBytes);
+            std::memcpy(out, data + begin, count);
+            return count;
+        }
+
+    } // namespace
+
+    class MidiTriggerInput::Impl : public juce::MidiInputCallback {
+    public:
+        struct Action {
+            AudioThreadMessage::Type type;
+            std::string cue_id;
+        };
+
+        struct MscEntry {
+            std::string cue_number; // Normalised
+            std::string cue_id;
+        };
+
+        // Everything a message needs, built off the MIDI thread
+        struct CompiledMap {
+            std::array<int16_t, kNumChannels * kNumNotes> notes; // Index into actions, -1 = unmapped
+            std::vector<Action> actions;
+            std::vector<MscEntry> msc_cues;                     // Sorted by cue number
+            int msc_device_id = kMscAllCall;
+            int msc_command_format = 0;
+        };
+
+        explicit Impl(SharedAudioCore* core)
+            : core_(core)
+            , map_(std::make_unique<CompiledMap>())
+        {
+            map_->notes.fill(-1);
+        }
+
+        ~Impl() override {
+            close();
+        }
+
+        bool open(const std::string& device_name) {
+            close();
+            for (const auto& device : juce::MidiInput::getAvailableDevices()) {
+                if (device.name.toStdString().find(device_name) == std::string::npos) {
+                    continue;
+                }
+                input_ = juce::MidiInput::openDevice(device.identifier, this);
+                if (!input_) {
+                    last_error_ = "Failed to open MIDI input: " + device.name.toStdString();
+                    return false;
+                }
+                return start_input();
+            }
+            last_error_ = "MIDI input not found: " + device_name;
+            return false;
+        }
+
+        bool open_virtual(const std::string& port_name) {
+            close();
+#ifdef _WIN32
+            last_error_ = "Virtual MIDI ports are not supported on Windows";
+            return false;
+#else
+            input_ = juce::MidiInput::createNewDevice(port_name, this);
+            if (!input_) {
+                last_error_ = "Failed to create virtual MIDI input: " + port_name;
+                return false;
+            }
+            return start_input();
+#endif
+        }
+
+        void close() {
+            if (input_) {
+                input_->stop();
+                std::cout << "[MIDI] Closed " << input_->getName().toStdString() << std::endl;
+                input_.reset();
+            }
+        }
+
+        bool is_open() const { return input_ != nullptr; }
+        std::string get_device_name() const { return input_ ? input_->getName().toStdString() : std::string(); }
+
+        void set_mappings(const MidiTriggerMap& mappings) {
+            auto map = std::make_unique<CompiledMap>();
+            map->notes.fill(-1);
+            map->msc_device_id = mappings.msc_device_id;
+            map->msc_command_format = mappings.msc_command_format;
+
+            for (const auto& trigger : mappings.notes) {
+                if (trigger.note < 0 || trigger.note >= kNumNotes || trigger.channel < 0 || trigger.channel > kNumChannels
+                    || trigger.cue_id.empty() || trigger.cue_id.size() >= sizeof(AudioThreadMessage::cue_id)) {
+                    continue;
+                }
+                const auto index = static_cast<int16_t>(map->actions.size());
+                map->actions.push_back({ trigger.stop ? AudioThreadMessage::STOP_CUE : AudioThreadMessage::START_CUE, trigger.cue_id });
+                const int first = trigger.channel == 0 ? 0 : trigger.channel - 1;
+                const int last = trigger.channel == 0 ? kNumChannels - 1 : trigger.channel - 1;
+                for (int channel = first; channel <= last; ++channel) {
+                    map->notes[channel * kNumNotes + trigger.note] = index;
+                }
+            }
+
+            for (const auto& trigger : mappings.msc_cues) {
+                if (trigger.cue_number.empty() || trigger.cue_id.empty()
+                    || trigger.cue_id.size() >= sizeof(AudioThreadMessage::cue_id)) {
+                    continue;
+                }
+                char number[kMaxCueNumberBytes];
+                const size_t length = normalise_cue_number(trigger.cue_number.data(), trigger.cue_number.size(), number);
+                map->msc_cues.push_back({ std::string(number, length), trigger.cue_id });
+            }
+            std::sort(map->msc_cues.begin(), map->msc_cues.end(),
+                [](const MscEntry& a, const MscEntry& b) { return a.cue_number < b.cue_number; });
+
+            std::lock_guard<std::mutex> lock(map_mutex_);
+            map_.swap(map);
+        }
+
+        // MIDI thread
+        void handle_message(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point event_time) {
+            if (size == 0) {
+                return;
+            }
+            messages_received_.fetch_add(1, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(map_mutex_); // Only contended by set_mappings
+            AudioThreadMessage::Type type = AudioThreadMessage::NONE;
+            const std::string* cue_id = nullptr;
+            if ((data[0] & 0xF0) == 0x90 && size >= 3) {
+                if (data[2] == 0) {
+                    return; // Note-off sent as note-on
+                }
+                const int16_t index = map_->notes[(data[0] & 0x0F) * kNumNotes + (data[1] & 0x7F)];
+                if (index >= 0) {
+                    type = map_->actions[index].type;
+                    cue_id = &map_->actions[index].cue_id;
+                }
+            } else if (data[0] != 0xF0 || !find_msc_cue(data, size, type, cue_id)) {
+                return; // Not a trigger message
+            }
+
+            if (cue_id == nullptr) {
+                messages_unmatched_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            AudioThreadMessage msg;
+            msg.type = type;
+            std::memcpy(msg.cue_id, cue_id->c_str(), cue_id->size() + 1);
+            const double latency_ms = std::max(latency_ms_.load(std::memory_order_relaxed),
+                MidiTriggerInput::kMinSchedulingLatencyMs);
+            msg.timestamp_samples = core_->get_sample_time(event_time
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::milli>(latency_ms)));
+
+            if (!core_->send_command(msg)) {
+                commands_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            commands_dispatched_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Driver callback: JUCE stamps messages in seconds on the hi-res millisecond counter
+        void handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message) override {
+            const double age_seconds = juce::Time::getMillisecondCounterHiRes() * 0.001 - message.getTimeStamp();
+            const auto event_time = std::chrono::steady_clock::now()
+                - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(std::max(0.0, age_seconds)));
+            handle_message(message.getRawData(), static_cast<size_t>(message.getRawDataSize()), event_time);
+        }
+
+        MidiTriggerStats get_stats() const {
+            MidiTriggerStats stats;
+            stats.messages_received = messages_received_.load(std::memory_order_relaxed);
+            stats.commands_dispatched = commands_dispatched_.load(std::memory_order_relaxed);
+            stats.messages_unmatched = messages_unmatched_.load(std::memory_order_relaxed);
+            stats.commands_dropped = commands_dropped_.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        std::atomic<double> latency_ms_{ 0.0 };
+        std::string last_error_;
+
+    private:
+        bool start_input() {
+            input_->start();
+            std::cout << "[MIDI] Listening on " << input_->getName().toStdString() << std::endl;
+            return true;
+        }
+
+        // F0 7F <device> 02 <format> <command> [cue number] [00 list [00 path]] F7.
+        // False if this is not MSC for us; cue_id stays null for an unmapped cue.
+        bool find_msc_cue(const uint8_t* data, size_t size, AudioThreadMessage::Type& type,
+                          const std::string*& cue_id) const {
+            if (size < 7 || data[1] != 0x7F || data[3] != 0x02 || data[size - 1] != 0xF7) {
+                return false;
+            }
+            const int device_id = data[2];
+            if (map_->msc_device_id != kMscAllCall && device_id != kMscAllCall && device_id != map_->msc_device_id) {
+                return false;
+            }
+
+            // A lighting or video GO for the same cue number is not ours
+            const uint8_t format = data[4];
+            const bool format_matches = map_->msc_command_format != 0
+                ? format == map_->msc_command_format
+                : format >= kMscSoundFirst && format <= kMscSoundLast;
+            if (format != kMscAllTypes && !format_matches) {
+                return false;
+            }
+
+            const uint8_t command = data[5];
+            if (command == kMscGo) {
+                type = AudioThreadMessage::START_CUE;
+            } else if (command == kMscStop || command == kMscGoOff) {
+                type = AudioThreadMessage::STOP_CUE;
+            } else {
+                return false; // Other MSC commands have no audio meaning here
+            }
+
+            const char* number = reinterpret_cast<const char*>(data + 6);
+            const char* end = reinterpret_cast<const char*>(data + size - 1);
+            const char* number_end = std::find(number, end, '\0');
+            if (number_end == number) {
+                return false; // GO without a cue number: the desk's own next cue
+            }
+
+            char normalised[kMaxCueNumberBytes];
+            const std::string_view key(normalised, normalise_cue_number(number, number_end - number, normalised));
+            const auto it = std::lower_bound(map_->msc_cues.begin(), map_->msc_cues.end(), key,
+                [](const MscEntry& entry, std::string_view value) { return std::string_view(entry.cue_number) < value; });
+
+            if (it != map_->msc_cues.end() && std::string_view(it->cue_number) == key) {
+                cue_id = &it->cue_id;
+            }
+            return true;
+        }
+
+        SharedAudioCore* core_;
+        std::unique_ptr<juce::MidiInput> input_;
+
+        std::unique_ptr<CompiledMap> map_;
+        std::mutex map_mutex_;
+
+        std::atomic<uint64_t> messages_received_{ 0 };
+        std::atomic<uint64_t> commands_dispatched_{ 0 };
+        std::atomic<uint64_t> messages_unmatched_{ 0 };
+        std::atomic<uint64_t> commands_dropped_{ 0 };
+    };
+
+    MidiTriggerInput::MidiTriggerInput(SharedAudioCore* core)
+        : impl_(std::make_unique<Impl>(core))
+    {
+    }
+
+    MidiTriggerInput::~MidiTriggerInput() = default;
+
+    std::vector<std::string> MidiTriggerInput::get_available_devices() {
+        std::vector<std::string> names;
+        for (const auto& device : juce::MidiInput::getAvailableDevices()) {
+            names.push_back(device.name.toStdString());
+        }
+        return names;
+    }
+
+    bool MidiTriggerInput::open(const std::string& device_name) {
+        return impl_->open(device_name);
+    }
+
+    bool MidiTriggerInput::open_virtual(const std::string& port_name) {
+        return impl_->open_virtual(port_name);
+    }
+
+    void MidiTriggerInput::close() {
+        impl_->close();
+    }
+
+    bool MidiTriggerInput::is_open() const {
+        return impl_->is_open();
+    }
+
+    std::string MidiTriggerInput::get_device_name() const {
+        return impl_->get_device_name();
+    }
+
+    void MidiTriggerInput::set_mappings(const MidiTriggerMap& mappings) {
+        impl_->set_mappings(mappings);
+    }
+
+    void MidiTriggerInput::set_latency_ms(double latency_ms) {
+        impl_->latency_ms_.store(std::max(0.0, latency_ms), std::memory_order_relaxed);
+    }
+
+    void MidiTriggerInput::handle_message(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point event_time) {
+        impl_->handle_message(data, size, event_time);
+    }
+
+    MidiTriggerStats MidiTriggerInput::get_stats() const {
+        return impl_->get_stats();
+    }
+
+    std::string MidiTriggerInput::get_last_error() const {
+        return impl_->last_error_;
+    }
+
+} // namespace SharedAudio
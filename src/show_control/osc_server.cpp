@@ -0,0 +1,412 @@
+﻿#include "show_control/osc_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace SharedAudio {
+
+    namespace {
+
+        constexpr const char* kCuePrefix = "/cue/";
+        constexpr uint64_t kImmediateTimetag = 1;
+        constexpr int64_t kNtpToUnixSeconds = 2208988800LL; // 1900 -> 1970
+
+        uint64_t hash_address(const char* data, size_t length) {
+            uint64_t hash = 1469598103934665603ULL; // FNV-1a
+            for (size_t i = 0; i < length; ++i) {
+                hash ^= static_cast<uint8_t>(data[i]);
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        uint32_t read_u32(const char* data) {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+            return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+        }
+
+        uint64_t read_u64(const char* data) {
+            return (uint64_t(read_u32(data)) << 32) | read_u32(data + 4);
+        }
+
+        // Length of the padded OSC string at data, 0 if it is not terminated in range
+        size_t padded_string_length(const char* data, size_t size) {
+            const void* terminator = std::memchr(data, '\0', size);
+            if (terminator == nullptr) {
+                return 0;
+            }
+            const size_t length = static_cast<const char*>(terminator) - data;
+            const size_t padded = (length + 4) & ~size_t(3);
+            return padded <= size ? padded : 0;
+        }
+
+        // First numeric argument of a message, false if there is none
+        bool read_first_value(const char* type_tags, const char* arguments, size_t size, double& value) {
+            const char tag = type_tags[1]; // type_tags[0] is ','
+            switch (tag) {
+            case 'f': {
+                if (size < 4) return false;
+                const uint32_t bits = read_u32(arguments);
+                float f;
+                std::memcpy(&f, &bits, sizeof(f));
+                value = f;
+                return true;
+            }
+            case 'i':
+                if (size < 4) return false;
+                value = static_cast<int32_t>(read_u32(arguments));
+                return true;
+            case 'd': {
+                if (size < 8) return false;
+                const uint64_t bits = read_u64(arguments);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                value = d;
+                return true;
+            }
+            case 'h':
+                if (size < 8) return false;
+                value = static_cast<double>(static_cast<int64_t>(read_u64(arguments)));
+                return true;
+            case 'T':
+                value = 1.0;
+                return true;
+            case 'F':
+                value = 0.0;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        struct CueVerb {
+            const char* name;
+            AudioThreadMessage::Type type;
+        };
+
+        constexpr CueVerb kCueVerbs[] = {
+            { "start", AudioThreadMessage::START_CUE },
+            { "stop", AudioThreadMessage::STOP_CUE },
+            { "volume", AudioThreadMessage::SET_VOLUME },
+            { "pan", AudioThreadMessage::SET_PAN },
+            { "seek", AudioThreadMessage::SEEK },
+        };
+
+    } // namespace
+
+    OscServer::OscServer(SharedAudioCore* core)
+        : core_(core)
+    {
+    }
+
+    OscServer::~OscServer() {
+        stop();
+    }
+
+    bool OscServer::start(int port, const std::string& bind_address) {
+        if (running_.load(std::memory_order_acquire)) {
+            last_error_ = "OSC server already running";
+            return false;
+        }
+
+#ifdef _WIN32
+        WSADATA wsa_data;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+            last_error_ = "Failed to initialize Winsock";
+            return false;
+        }
+        SOCKET handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == INVALID_SOCKET) {
+            last_error_ = "Failed to create OSC socket";
+            WSACleanup();
+            return false;
+        }
+        socket_ = static_cast<intptr_t>(handle);
+
+        const DWORD timeout_ms = 100; // Lets the listener notice stop()
+        setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+#else
+        const int handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle < 0) {
+            last_error_ = "Failed to create OSC socket";
+            return false;
+        }
+        socket_ = handle;
+
+        timeval timeout{};
+        timeout.tv_usec = 100000; // Lets the listener notice stop()
+        setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+        const int receive_buffer = 1 << 20; // Absorbs bursts from fader banks
+        setsockopt(handle, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receive_buffer), sizeof(receive_buffer));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, bind_address.c_str(), &address.sin_addr) != 1) {
+            last_error_ = "Invalid OSC bind address: " + bind_address;
+            close_socket();
+            return false;
+        }
+        if (bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            last_error_ = "Failed to bind OSC port " + std::to_string(port);
+            close_socket();
+            return false;
+        }
+
+        socklen_t address_length = sizeof(address);
+        getsockname(handle, reinterpret_cast<sockaddr*>(&address), &address_length);
+        port_ = ntohs(address.sin_port);
+
+        running_.store(true, std::memory_order_release);
+        listener_ = std::thread(&OscServer::listen_loop, this);
+        std::cout << "[OSC] Listening on " << bind_address << ":" << port_ << std::endl;
+        return true;
+    }
+
+    void OscServer::stop() {
+        if (!running_.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        if (listener_.joinable()) {
+            listener_.join();
+        }
+        close_socket();
+        std::cout << "[OSC] Stopped" << std::endl;
+    }
+
+    void OscServer::close_socket() {
+        if (socket_ < 0) {
+            return;
+        }
+#ifdef _WIN32
+        closesocket(static_cast<SOCKET>(socket_));
+        WSACleanup();
+#else
+        close(static_cast<int>(socket_));
+#endif
+        socket_ = -1;
+    }
+
+    void OscServer::set_cues(const std::vector<std::string>& cue_ids) {
+        const size_t num_entries = cue_ids.size() * (sizeof(kCueVerbs) / sizeof(kCueVerbs[0]));
+        size_t capacity = 16;
+        while (capacity < num_entries * 2) { // Load factor <= 0.5 keeps probes short
+            capacity <<= 1;
+        }
+
+        std::vector<DispatchEntry> table(capacity);
+        for (const auto& cue_id : cue_ids) {
+            if (cue_id.empty() || cue_id.size() >= sizeof(AudioThreadMessage::cue_id)) {
+                continue; // Cannot be carried by a command
+            }
+            for (const auto& verb : kCueVerbs) {
+                std::string address = kCuePrefix + cue_id + "/" + verb.name;
+                const uint64_t hash = hash_address(address.data(), address.size());
+                size_t slot = hash & (capacity - 1);
+                while (!table[slot].address.empty() && table[slot].address != address) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                DispatchEntry& entry = table[slot];
+                entry.hash = hash;
+                entry.address = std::move(address);
+                entry.type = verb.type;
+                entry.cue_id = cue_id;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        table_.swap(table);
+    }
+
+    void OscServer::set_schedule_horizon(double seconds) {
+        schedule_horizon_seconds_.store(std::max(0.0, seconds), std::memory_order_relaxed);
+    }
+
+    OscServerStats OscServer::get_stats() const {
+        OscServerStats stats;
+        stats.packets_received = packets_received_.load(std::memory_order_relaxed);
+        stats.messages_dispatched = messages_dispatched_.load(std::memory_order_relaxed);
+        stats.messages_unmatched = messages_unmatched_.load(std::memory_order_relaxed);
+        stats.packets_malformed = packets_malformed_.load(std::memory_order_relaxed);
+        stats.commands_dropped = commands_dropped_.load(std::memory_order_relaxed);
+        stats.bundles_scheduled = bundles_scheduled_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void OscServer::listen_loop() {
+        while (running_.load(std::memory_order_acquire)) {
+#ifdef _WIN32
+            const int received = recv(static_cast<SOCKET>(socket_), packet_.data(), static_cast<int>(packet_.size()), 0);
+#else
+            const ssize_t received = recv(static_cast<int>(socket_), packet_.data(), packet_.size(), 0);
+#endif
+            if (received <= 0) {
+                continue; // Timeout, or a datagram larger than the buffer
+            }
+
+            packets_received_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(table_mutex_); // Only contended by set_cues
+            handle_packet(packet_.data(), static_cast<size_t>(received), -1, 0);
+        }
+    }
+
+    void OscServer::handle_packet(const char* data, size_t size, int64_t timestamp_samples, int depth) {
+        if (size < 4 || (size & 3) != 0) {
+            packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (data[0] == '/') {
+            handle_message(data, size, timestamp_samples);
+            return;
+        }
+        if (size < 16 || std::memcmp(data, "#bundle", 8) != 0 || depth >= kMaxBundleDepth) {
+            packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // A nested bundle's timetag replaces its parent's
+        int64_t bundle_time = -1;
+        if (!timetag_to_sample(read_u64(data + 8), bundle_time)) {
+            packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (bundle_time >= 0) {
+            bundles_scheduled_.fetch_add(1, std::memory_order_relaxed);
+            timestamp_samples = bundle_time;
+        }
+
+        size_t offset = 16;
+        while (offset + 4 <= size) {
+            const size_t element_size = read_u32(data + offset);
+            offset += 4;
+            if (element_size > size - offset) {
+                packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            handle_packet(data + offset, element_size, timestamp_samples, depth + 1);
+            offset += element_size;
+        }
+    }
+
+    void OscServer::handle_message(const char* data, size_t size, int64_t timestamp_samples) {
+        const size_t address_bytes = padded_string_length(data, size);
+        if (address_bytes == 0) {
+            packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const DispatchEntry* entry = find_entry(data, std::strlen(data));
+        if (entry == nullptr) {
+            messages_unmatched_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Type tags are optional in old senders; no tags means no arguments
+        double value = 0.0;
+        bool has_value = false;
+        if (address_bytes < size && data[address_bytes] == ',') {
+            const char* type_tags = data + address_bytes;
+            const size_t tag_bytes = padded_string_length(type_tags, size - address_bytes);
+            if (tag_bytes == 0) {
+                packets_malformed_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            has_value = read_first_value(type_tags, type_tags + tag_bytes, size - address_bytes - tag_bytes, value);
+        }
+
+        AudioThreadMessage msg;
+        msg.type = entry->type;
+        std::memcpy(msg.cue_id, entry->cue_id.c_str(), entry->cue_id.size() + 1);
+        msg.timestamp_samples = timestamp_samples;
+
+        switch (entry->type) {
+        case AudioThreadMessage::START_CUE:
+        case AudioThreadMessage::STOP_CUE:
+            if (has_value && value == 0.0) {
+                return; // Button release
+            }
+            break;
+        case AudioThreadMessage::SET_VOLUME:
+            if (!has_value) return;
+            msg.param1.float_value = static_cast<float>(std::max(0.0, value));
+            break;
+        case AudioThreadMessage::SET_PAN:
+            if (!has_value) return;
+            msg.param1.float_value = static_cast<float>(std::clamp(value, -1.0, 1.0));
+            break;
+        case AudioThreadMessage::SEEK:
+            if (!has_value) return;
+            msg.param1.double_value = std::max(0.0, value);
+            break;
+        default:
+            return;
+        }
+
+        if (!core_->send_command(msg)) {
+            commands_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        messages_dispatched_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const OscServer::DispatchEntry* OscServer::find_entry(const char* address, size_t length) const {
+        if (table_.empty()) {
+            return nullptr;
+        }
+
+        const uint64_t hash = hash_address(address, length);
+        const size_t mask = table_.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            const DispatchEntry& entry = table_[slot];
+            if (entry.address.empty()) {
+                return nullptr;
+            }
+            if (entry.hash == hash && entry.address.size() == length
+                && std::memcmp(entry.address.data(), address, length) == 0) {
+                return &entry;
+            }
+        }
+    }
+
+    // NTP timetag -> engine sample, -1 for "immediately" or when the engine
+    // clock is not running yet. False if the timetag lies beyond the horizon.
+    bool OscServer::timetag_to_sample(uint64_t timetag, int64_t& sample) const {
+        sample = -1;
+        if (timetag == kImmediateTimetag) {
+            return true;
+        }
+
+        const int64_t seconds = static_cast<int64_t>(timetag >> 32) - kNtpToUnixSeconds;
+        const int64_t fraction_ns = static_cast<int64_t>(((timetag & 0xffffffffULL) * 1000000000ULL) >> 32);
+        const std::chrono::system_clock::time_point wall_time(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::seconds(seconds) + std::chrono::nanoseconds(fraction_ns)));
+
+        // Timetags are wall clock, the engine clock is steady
+        const auto ahead = wall_time - std::chrono::system_clock::now();
+        if (ahead <= std::chrono::system_clock::duration::zero()) {
+            return true;
+        }
+        if (ahead > std::chrono::duration<double>(schedule_horizon_seconds_.load(std::memory_order_relaxed))) {
+            return false;
+        }
+        sample = core_->get_sample_time(std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(ahead));
+        return true;
+    }
+
+} // namespace SharedAudio
@@ -0,0 +1,425 @@
+﻿#include "show_control/scene_manager.h"
+#include "show_control/cue_audio_manager.h"
+#include "processing/mix_graph.h"
+#include "processing/input_router.h"
+#include "core/lock_free_fifo.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+namespace SharedAudio {
+
+    namespace {
+
+        // Linear move of one parameter, advanced a block at a time
+        struct ParameterRamp {
+            float value = 0.0f;
+            float target = 0.0f;
+            float step = 0.0f; // Per sample
+            int remaining = 0;
+
+            void start(float from, float to, int num_samples) {
+                value = from;
+                target = to;
+                remaining = num_samples;
+                step = num_samples > 0 ? (to - from) / static_cast<float>(num_samples) : 0.0f;
+            }
+
+            // Value at the end of the next num_samples
+            float advance(int num_samples) {
+                if (num_samples >= remaining) {
+                    remaining = 0;
+                    value = target;
+                }
+                else {
+                    remaining -= num_samples;
+                    value += step * static_cast<float>(num_samples);
+                }
+                return value;
+            }
+
+            bool is_active() const { return remaining > 0; }
+        };
+
+    } // namespace
+
+    // One recall in flight between the control thread and the audio thread
+    struct PendingRecall {
+        std::shared_ptr<const SceneSnapshot> scene;
+        int ramp_samples = 0;
+    };
+
+    class SceneManager::Impl {
+    public:
+        ~Impl() {
+            // Only destroyed once the audio thread no longer calls process()
+            delete pending_.exchange(nullptr);
+            delete applied_;
+            drain_retired();
+        }
+
+        bool initialize(int sample_rate, CueAudioManager* cue_manager, MixGraph* mix_graph, InputRouter* input_router) {
+            sample_rate_ = sample_rate;
+            cue_manager_ = cue_manager;
+            mix_graph_ = mix_graph;
+            input_router_ = input_router;
+            output_gain_ramps_.assign(mix_graph_ ? mix_graph_->get_num_outputs() : 0, ParameterRamp{});
+            initialized_ = true;
+
+            std::cout << "[SCENE] SceneManager initialized" << std::endl;
+            return true;
+        }
+
+        std::shared_ptr<SceneSnapshot> capture() const {
+            drain_retired();
+
+            auto scene = std::make_shared<SceneSnapshot>();
+            if (cue_manager_ != nullptr) {
+                scene->voice_layout = cue_manager_->capture_voices(scene->voices);
+            }
+
+            if (mix_graph_ != nullptr) {
+                const int num_buses = mix_graph_->get_num_buses();
+                scene->buses.resize(num_buses);
+                for (int b = 0; b < num_buses; ++b) {
+                    const MixBusInfo info = mix_graph_->get_bus_info(b);
+                    scene->buses[b].gain = info.gain;
+                    scene->buses[b].muted = info.is_muted;
+                }
+
+                const int num_outputs = mix_graph_->get_num_outputs();
+                scene->outputs.resize(num_outputs);
+                for (int ch = 0; ch < num_outputs; ++ch) {
+                    scene->outputs[ch].gain = mix_graph_->get_output_gain(ch);
+                }
+            }
+
+            if (input_router_ != nullptr) {
+                const int num_inputs = input_router_->get_num_inputs();
+                scene->inputs.resize(num_inputs);
+                for (int ch = 0; ch < num_inputs; ++ch) {
+                    const InputChannelInfo info = input_router_->get_input_info(ch);
+                    scene->inputs[ch].gain = info.gain;
+                    scene->inputs[ch].pan = info.pan;
+                    scene->inputs[ch].muted = info.is_muted;
+                }
+            }
+            return scene;
+        }
+
+        bool store_scene(const std::string& name, std::shared_ptr<const SceneSnapshot> scene) {
+            drain_retired();
+            if (name.empty() || !scene) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(library_mutex_);
+            scenes_[name] = std::move(scene);
+            return true;
+        }
+
+        bool capture_scene(const std::string& name) {
+            auto scene = capture();
+            scene->name = name;
+            return store_scene(name, std::move(scene));
+        }
+
+        bool remove_scene(const std::string& name) {
+            drain_retired();
+            std::lock_guard<std::mutex> lock(library_mutex_);
+            return scenes_.erase(name) > 0;
+        }
+
+        std::shared_ptr<const SceneSnapshot> get_scene(const std::string& name) const {
+            drain_retired();
+            std::lock_guard<std::mutex> lock(library_mutex_);
+            auto it = scenes_.find(name);
+            return it != scenes_.end() ? it->second : nullptr;
+        }
+
+        std::vector<SceneInfo> get_scenes() const {
+            drain_retired();
+            std::lock_guard<std::mutex> lock(library_mutex_);
+            std::vector<SceneInfo> scenes;
+            scenes.reserve(scenes_.size());
+            for (const auto& [name, scene] : scenes_) {
+                scenes.push_back({ name, scene->get_num_parameters() });
+            }
+            return scenes;
+        }
+
+        bool recall(std::shared_ptr<const SceneSnapshot> scene, double ramp_seconds) {
+            if (!initialized_ || !scene) {
+                return false;
+            }
+            drain_retired();
+
+            auto* recall = new PendingRecall{ std::move(scene), to_samples(ramp_seconds) };
+            PendingRecall* replaced = pending_.exchange(recall, std::memory_order_acq_rel);
+
+            // The audio thread never saw a recall that was replaced while pending
+            delete replaced;
+            return true;
+        }
+
+        uint64_t get_recall_count() const {
+            drain_retired();
+            return recall_count_.load(std::memory_order_acquire);
+        }
+
+        uint64_t get_retire_overflow_count() const {
+            return retire_overflows_.load(std::memory_order_relaxed);
+        }
+
+        bool is_ramping() const {
+            drain_retired();
+            return ramping_.load(std::memory_order_relaxed) || pending_.load(std::memory_order_relaxed) != nullptr;
+        }
+
+        // REAL-TIME THREAD
+        void process(int num_samples) {
+            // The previous recall has been read by every strip, including the
+            // voices. If the queue is full it stays here and is retried next
+            // block.
+            if (applied_ != nullptr && retired_.push(applied_)) {
+                applied_ = nullptr;
+            }
+
+            PendingRecall* recall = pending_.exchange(nullptr, std::memory_order_acq_rel);
+            if (recall != nullptr && applied_ != nullptr) {
+                // The control thread has fallen this far behind: leak the old
+                // recall rather than free it on the audio thread
+                retire_overflows_.fetch_add(1, std::memory_order_relaxed);
+                applied_ = nullptr;
+            }
+            if (cue_manager_ != nullptr) {
+                cue_manager_->apply_scene_realtime(recall ? recall->scene.get() : nullptr,
+                    recall ? recall->ramp_samples : 0);
+            }
+            if (recall != nullptr) {
+                if (apply(*recall)) {
+                    ramping_.store(true, std::memory_order_relaxed);
+                }
+                applied_ = recall;
+                recall_count_.fetch_add(1, std::memory_order_acq_rel);
+            }
+
+            // The first ramp step lands in the recall block too
+            if (ramping_.load(std::memory_order_relaxed)) {
+                ramping_.store(advance_ramps(num_samples), std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        int to_samples(double seconds) const {
+            return seconds > 0.0 ? static_cast<int>(seconds * sample_rate_) : 0;
+        }
+
+        int ramp_for(float ramp_seconds, const PendingRecall& recall) const {
+            return ramp_seconds < 0.0f ? recall.ramp_samples : to_samples(ramp_seconds);
+        }
+
+        // Every strip gets its new value or ramp in this one block. Returns
+        // true if any parameter ramps.
+        bool apply(const PendingRecall& recall) {
+            const SceneSnapshot& scene = *recall.scene;
+            bool ramping = false;
+
+            if (mix_graph_ != nullptr) {
+                const int num_buses = std::min(static_cast<int>(scene.buses.size()),
+                    std::min(mix_graph_->get_num_buses(), MixGraph::kMaxBuses));
+                for (int b = 0; b < num_buses; ++b) {
+                    const BusSnapshot& bus = scene.buses[b];
+                    mix_graph_->set_bus_mute(b, bus.muted); // The bus fader ramps mutes over one block
+                    if (start_ramp(bus_gain_ramps_[b], mix_graph_->get_bus_gain(b), bus.gain,
+                        ramp_for(bus.ramp_seconds, recall))) {
+                        ramping = true;
+                    }
+                    else {
+                        mix_graph_->set_bus_gain(b, bus.gain);
+                    }
+                }
+
+                const int num_outputs = static_cast<int>(std::min(scene.outputs.size(), output_gain_ramps_.size()));
+                for (int ch = 0; ch < num_outputs; ++ch) {
+                    const OutputSnapshot& output = scene.outputs[ch];
+                    if (start_ramp(output_gain_ramps_[ch], mix_graph_->get_output_gain(ch), output.gain,
+                        ramp_for(output.ramp_seconds, recall))) {
+                        ramping = true;
+                    }
+                    else {
+                        mix_graph_->set_output_gain(ch, output.gain);
+                    }
+                }
+            }
+
+            if (input_router_ != nullptr) {
+                const int num_inputs = std::min(static_cast<int>(scene.inputs.size()),
+                    std::min(input_router_->get_num_inputs(), InputRouter::kMaxInputs));
+                for (int ch = 0; ch < num_inputs; ++ch) {
+                    const InputSnapshot& input = scene.inputs[ch];
+                    const InputChannelInfo current = input_router_->get_input_info(ch);
+                    const int ramp = ramp_for(input.ramp_seconds, recall);
+                    input_router_->set_input_mute(ch, input.muted);
+                    if (start_ramp(input_gain_ramps_[ch], current.gain, input.gain, ramp)) {
+                        ramping = true;
+                    }
+                    else {
+                        input_router_->set_input_gain(ch, input.gain);
+                    }
+                    if (start_ramp(input_pan_ramps_[ch], current.pan, input.pan, ramp)) {
+                        ramping = true;
+                    }
+                    else {
+                        input_router_->set_input_pan(ch, input.pan);
+                    }
+                }
+            }
+            return ramping;
+        }
+
+        // False when the parameter should simply jump (no ramp time, or
+        // already there); a recall also replaces any ramp still running
+        static bool start_ramp(ParameterRamp& ramp, float from, float to, int num_samples) {
+            if (num_samples <= 0 || from == to) {
+                ramp.remaining = 0;
+                return false;
+            }
+            ramp.start(from, to, num_samples);
+            return true;
+        }
+
+        bool advance_ramps(int num_samples) {
+            bool active = false;
+
+            if (mix_graph_ != nullptr) {
+                const int num_buses = std::min(mix_graph_->get_num_buses(), MixGraph::kMaxBuses);
+                for (int b = 0; b < num_buses; ++b) {
+                    if (bus_gain_ramps_[b].is_active()) {
+                        mix_graph_->set_bus_gain(b, bus_gain_ramps_[b].advance(num_samples));
+                        active |= bus_gain_ramps_[b].is_active();
+                    }
+                }
+                for (size_t ch = 0; ch < output_gain_ramps_.size(); ++ch) {
+                    if (output_gain_ramps_[ch].is_active()) {
+                        mix_graph_->set_output_gain(static_cast<int>(ch), output_gain_ramps_[ch].advance(num_samples));
+                        active |= output_gain_ramps_[ch].is_active();
+                    }
+                }
+            }
+
+            if (input_router_ != nullptr) {
+                const int num_inputs = std::min(input_router_->get_num_inputs(), InputRouter::kMaxInputs);
+                for (int ch = 0; ch < num_inputs; ++ch) {
+                    if (input_gain_ramps_[ch].is_active()) {
+                        input_router_->set_input_gain(ch, input_gain_ramps_[ch].advance(num_samples));
+                        active |= input_gain_ramps_[ch].is_active();
+                    }
+                    if (input_pan_ramps_[ch].is_active()) {
+                        input_router_->set_input_pan(ch, input_pan_ramps_[ch].advance(num_samples));
+                        active |= input_pan_ramps_[ch].is_active();
+                    }
+                }
+            }
+            return active;
+        }
+
+        // Any control call; the lock keeps the queue single-consumer
+        void drain_retired() const {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            PendingRecall* retired = nullptr;
+            while (retired_.pop(retired)) {
+                delete retired;
+            }
+        }
+
+        int sample_rate_ = 48000;
+        bool initialized_ = false;
+        CueAudioManager* cue_manager_ = nullptr;
+        MixGraph* mix_graph_ = nullptr;
+        InputRouter* input_router_ = nullptr;
+
+        mutable std::mutex library_mutex_;
+        std::map<std::string, std::shared_ptr<const SceneSnapshot>> scenes_;
+
+        std::atomic<PendingRecall*> pending_{ nullptr };
+        PendingRecall* applied_ = nullptr; // audio thread only
+        mutable LockFreeFIFO<PendingRecall*, 64> retired_;
+        mutable std::mutex retired_mutex_;
+        std::atomic<uint64_t> retire_overflows_{ 0 };
+        std::atomic<uint64_t> recall_count_{ 0 };
+        std::atomic<bool> ramping_{ false };
+
+        // Audio thread only
+        std::array<ParameterRamp, MixGraph::kMaxBuses> bus_gain_ramps_{};
+        std::array<ParameterRamp, InputRouter::kMaxInputs> input_gain_ramps_{};
+        std::array<ParameterRamp, InputRouter::kMaxInputs> input_pan_ramps_{};
+        std::vector<ParameterRamp> output_gain_ramps_;
+    };
+
+    // SceneManager public interface
+    SceneManager::SceneManager() : impl_(std::make_unique<Impl>()) {}
+    SceneManager::~SceneManager() = default;
+
+    bool SceneManager::initialize(int sample_rate, CueAudioManager* cue_manager, MixGraph* mix_graph,
+        InputRouter* input_router) {
+        return impl_->initialize(sample_rate, cue_manager, mix_graph, input_router);
+    }
+
+    std::shared_ptr<SceneSnapshot> SceneManager::capture() const {
+        return impl_->capture();
+    }
+
+    bool SceneManager::capture_scene(const std::string& name) {
+        return impl_->capture_scene(name);
+    }
+
+    bool SceneManager::store_scene(const std::string& name, std::shared_ptr<const SceneSnapshot> scene) {
+        return impl_->store_scene(name, std::move(scene));
+    }
+
+    bool SceneManager::remove_scene(const std::string& name) {
+        return impl_->remove_scene(name);
+    }
+
+    std::shared_ptr<const SceneSnapshot> SceneManager::get_scene(const std::string& name) const {
+        return impl_->get_scene(name);
+    }
+
+    std::vector<SceneInfo> SceneManager::get_scenes() const {
+        return impl_->get_scenes();
+    }
+
+    bool SceneManager::recall(std::shared_ptr<const SceneSnapshot> scene, double ramp_seconds) {
+        return impl_->recall(std::move(scene), ramp_seconds);
+    }
+
+    bool SceneManager::recall_scene(const std::string& name, double ramp_seconds) {
+        auto scene = impl_->get_scene(name);
+        if (!scene) {
+            return false;
+        }
+        std::cout << "[SCENE] Recall " << name << " (" << scene->get_num_parameters() << " parameters)" << std::endl;
+        return impl_->recall(std::move(scene), ramp_seconds);
+    }
+
+    uint64_t SceneManager::get_recall_count() const {
+        return impl_->get_recall_count();
+    }
+
+    uint64_t SceneManager::get_retire_overflow_count() const {
+        return impl_->get_retire_overflow_count();
+    }
+
+    bool SceneManager::is_ramping() const {
+        return impl_->is_ramping();
+    }
+
+    void SceneManager::process(int num_samples) {
+        impl_->process(num_samples);
+    }
+
+} // namespace SharedAudio
@@ -1,8 +1,43 @@
 ﻿#include "shared_audio/shared_audio_core.h"
+#include "show_control/cue_audio_manager.h"
+#include "processing/loudness_analyzer.h"
+#include "processing/sample_storage.h"
+#include "processing/audio_asset_cache.h"
+#include "processing/level_meter.h"
+#include "processing/delay_line_pool.h"
+#include "io/multitrack_recorder.h"
+#include "io/multitrack_player.h"
+#include "core/shared_command_ring.h"
+#include "core/command_queue.h"
+#include "core/sample_arena.h"
+#include "core/block_boundary.h"
+#include "show_control/osc_server.h"
+#include "show_control/scene_manager.h"
+#include "show_control/midi_trigger_input.h"
+#include <cstring>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <random>
 #include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 using namespace SharedAudio;
 
@@ -22,6 +57,21 @@ public:
         test_audio_streaming();
         test_performance_metrics();
         test_error_handling();
+        test_loudness_analysis();
+        test_record_and_soundcheck();
+        test_command_ring_to_voices();
+        test_osc_bundle_timing();
+        test_midi_trigger_timing();
+        test_command_queue_order();
+        test_silent_block_skipping();
+        test_arena_compaction_under_readers();
+        test_recorder_dropouts();
+        test_lossless_codec_round_trip();
+        test_compact_formats_mix_exact();
+        test_block_boundary_retire();
+        test_metering_cost();
+        test_plugin_delay_compensation();
+        test_scene_voice_lookup();
 
         print_final_results();
     }
@@ -248,6 +298,1124 @@ private:
         std::cout << "\n";
     }
 
+    void test_loudness_analysis() {
+        std::cout << "Test 9: Loudness Analysis\n";
+        std::cout << "--------------------------\n";
+
+        // BS.1770 reference: 997 Hz full-scale sine in one channel reads -3.01 LUFS
+        const int sample_rate = 48000;
+        AudioBuffer reference(2, std::vector<float>(sample_rate * 10, 0.0f));
+        for (size_t i = 0; i < reference[0].size(); ++i) {
+            reference[0][i] = static_cast<float>(std::sin(2.0 * 3.14159265358979323846 * 997.0 * i / sample_rate));
+        }
+
+        LoudnessInfo loudness = analyze_loudness(reference, sample_rate);
+        assert_test("Loudness analysis valid", loudness.is_valid);
+        assert_test("Reference tone integrated loudness", std::abs(loudness.integrated_lufs + 3.01) < 0.05);
+        assert_test("Steady tone has no loudness range", loudness.loudness_range_lu < 0.1);
+
+        auto audio_core = create_audio_core();
+        assert_test("Audio core initialization for loudness", audio_core->initialize());
+
+        auto* cue_manager = audio_core->get_cue_manager();
+        assert_test("Cue loading for loudness", cue_manager->load_audio_cue("loud1", "test_440.wav"));
+        assert_test("Cue loudness measured on load", cue_manager->get_cue_loudness("loud1").is_valid);
+        assert_test("Cue normalize to target", cue_manager->normalize_cue_loudness("loud1", -23.0));
+        assert_test("Unknown cue cannot be normalized", !cue_manager->normalize_cue_loudness("nonexistent", -23.0));
+
+        audio_core->shutdown();
+        std::cout << "\n";
+    }
+
+    void test_record_and_soundcheck() {
+        std::cout << "Test 10: Recording and Virtual Soundcheck\n";
+        std::cout << "-----------------------------------------\n";
+
+        const int sample_rate = 48000;
+        const int block_size = 256;
+        const int num_blocks = 200;
+        auto ramp = [](long frame, int channel) { return ((frame * (channel + 1)) % 1000) / 1000.0f - 0.5f; };
+
+        MultitrackRecorder recorder;
+        recorder.initialize(sample_rate, 4, 2);
+        RecordingSettings settings;
+        settings.take_name = "soundcheck_test";
+        settings.file_format = RecordingFileFormat::WAV;
+        settings.record_outputs = false;
+        settings.preallocate_minutes = 1.0;
+        assert_test("Recording starts", recorder.start_recording(settings));
+
+        AudioBuffer inputs(4, std::vector<float>(block_size));
+        AudioBuffer outputs(2, std::vector<float>(block_size, 0.0f));
+        long frame = 0;
+        for (int b = 0; b < num_blocks; ++b) {
+            for (int i = 0; i < block_size; ++i, ++frame) {
+                for (int ch = 0; ch < 4; ++ch) inputs[ch][i] = ramp(frame, ch);
+            }
+            recorder.process(inputs, outputs, block_size);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+
+        RecordingStatus status = recorder.get_status();
+        recorder.stop_recording();
+        assert_test("One file for all inputs", status.streams.size() == 1);
+        assert_test("No recorded blocks dropped", !status.streams.empty() && status.streams[0].dropped_frames == 0);
+
+        // Play the take back into inputs 2..5 of an 8-input engine
+        MultitrackPlayer player;
+        player.initialize(sample_rate, 8, block_size);
+        assert_test("Soundcheck loads the recording",
+            !status.streams.empty() && player.load({ { status.streams[0].file_path, 2 } }));
+        player.set_all_inputs_source(true);
+        player.play();
+
+        AudioBuffer device(8, std::vector<float>(block_size));
+        bool matches = true;
+        bool live_untouched = true;
+        for (int b = 0; b < num_blocks; ++b) {
+            for (auto& channel : device) std::fill(channel.begin(), channel.end(), 0.1f);
+            player.process(device, block_size);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+
+            live_untouched &= device[0][0] == 0.1f && device[7][0] == 0.1f;
+            if (b == 0) continue; // First block crossfades from live
+            for (int i = 0; i < block_size; ++i) {
+                for (int ch = 0; ch < 4; ++ch) {
+                    matches &= std::abs(device[2 + ch][i] - ramp(static_cast<long>(b) * block_size + i, ch)) < 1e-6f;
+                }
+            }
+        }
+        assert_test("Recorded tracks replace their inputs", matches);
+        assert_test("Other inputs stay live", live_untouched);
+        assert_test("No read-ahead underruns", player.get_status().underrun_blocks == 0);
+
+        player.unload();
+        std::remove(status.streams.empty() ? "" : status.streams[0].file_path.c_str());
+        std::cout << "\n";
+    }
+
+    void test_command_ring_to_voices() {
+        std::cout << "Test 11: Command Ring to Voices\n";
+        std::cout << "-------------------------------\n";
+
+        const int block_size = 256;
+        auto audio_core = create_audio_core();
+        AudioSettings settings;
+        settings.offline = true;
+        settings.sample_rate = 48000;
+        settings.buffer_size = block_size;
+        settings.input_channels = 0;
+        settings.output_channels = 2;
+        assert_test("Offline engine for ring commands", audio_core->initialize(settings));
+
+        auto* cue_manager = audio_core->get_cue_manager();
+        assert_test("Cue loading for ring commands", cue_manager->load_audio_cue("ring1", "test_440.wav"));
+
+        // The test plays the JS side: it formats the ring and pushes records
+        std::vector<uint32_t> memory(SharedCommandRing::get_bytes_for(16) / sizeof(uint32_t));
+        const size_t ring_bytes = memory.size() * sizeof(uint32_t);
+        SharedCommandRing producer;
+        assert_test("Ring formats", SharedCommandRing::format(memory.data(), ring_bytes, 16) > 0);
+        assert_test("Producer attaches", producer.attach(memory.data(), ring_bytes));
+        assert_test("Engine attaches", audio_core->attach_command_ring(memory.data(), ring_bytes));
+
+        AudioBuffer inputs;
+        AudioBuffer outputs;
+        auto push = [&](AudioThreadMessage::Type type, const char* cue_id, double value) {
+            AudioThreadMessage msg;
+            msg.type = type;
+            std::strncpy(msg.cue_id, cue_id, sizeof(msg.cue_id) - 1);
+            if (type == AudioThreadMessage::SEEK) {
+                msg.param1.double_value = value;
+            }
+            else {
+                msg.param1.float_value = static_cast<float>(value);
+            }
+            return producer.push(msg);
+        };
+        auto render = [&] { return audio_core->render_offline(inputs, outputs, block_size); };
+
+        assert_test("Start pushed", push(AudioThreadMessage::START_CUE, "ring1", 0.0));
+        render();
+        AudioCueInfo info = cue_manager->get_cue_info("ring1");
+        assert_test("Start applied in the next block", info.state == CueState::PLAYING);
+        assert_test("Voice is audible", info.peak_left > 0.0f || info.peak_right > 0.0f);
+
+        push(AudioThreadMessage::SET_VOLUME, "ring1", 0.25);
+        push(AudioThreadMessage::SET_PAN, "ring1", -0.5);
+        render();
+        info = cue_manager->get_cue_info("ring1");
+        assert_test("Volume applied", std::abs(info.volume - 0.25f) < 1e-6f);
+        assert_test("Pan applied", std::abs(info.pan + 0.5f) < 1e-6f);
+
+        push(AudioThreadMessage::SEEK, "ring1", 0.5);
+        render();
+        info = cue_manager->get_cue_info("ring1");
+        const double expected = 0.5 + static_cast<double>(block_size) / 48000.0;
+        assert_test("Seek applied", info.duration_seconds < 0.5 || std::abs(info.current_position_seconds - expected) < 0.11);
+
+        push(AudioThreadMessage::START_CUE, "not_loaded", 0.0);
+        push(AudioThreadMessage::STOP_CUE, "ring1", 0.0);
+        render();
+        info = cue_manager->get_cue_info("ring1");
+        assert_test("Stop applied, unknown cue ignored", info.state == CueState::STOPPED);
+
+        audio_core->detach_command_ring();
+        audio_core->shutdown();
+        std::cout << "\n";
+    }
+
+    void test_osc_bundle_timing() {
+        std::cout << "Test 12: OSC Bundle Timing\n";
+        std::cout << "--------------------------\n";
+
+        const int block_size = 256;
+        const int sample_rate = 48000;
+        auto audio_core = create_audio_core();
+        AudioSettings settings;
+        settings.offline = true;
+        settings.sample_rate = sample_rate;
+        settings.buffer_size = block_size;
+        settings.input_channels = 0;
+        settings.output_channels = 2;
+        assert_test("Offline engine for OSC timing", audio_core->initialize(settings));
+
+        auto* cue_manager = audio_core->get_cue_manager();
+        assert_test("Cue loading for OSC timing", cue_manager->load_audio_cue("osc1", "test_440.wav"));
+
+        OscServer server(audio_core.get());
+        assert_test("OSC server on localhost", server.start(0, "127.0.0.1"));
+        server.set_cues({ "osc1" });
+
+        // One block publishes the sample clock anchor the timetag maps through
+        AudioBuffer inputs;
+        AudioBuffer outputs;
+        audio_core->render_offline(inputs, outputs, block_size);
+
+        // #bundle, NTP timetag 50 ms ahead, one /cue/osc1/start without arguments
+        const auto lead = std::chrono::milliseconds(50);
+        const auto wall_now = std::chrono::system_clock::now();
+        const auto steady_now = std::chrono::steady_clock::now();
+        const int64_t unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (wall_now + lead).time_since_epoch()).count();
+        const uint64_t ntp_seconds = static_cast<uint64_t>(unix_ns / 1000000000LL + 2208988800LL);
+        const uint64_t ntp_fraction = (static_cast<uint64_t>(unix_ns % 1000000000LL) << 32) / 1000000000ULL;
+        const uint64_t timetag = (ntp_seconds << 32) | ntp_fraction;
+
+        const char message[] = "/cue/osc1/start\0,\0\0\0"; // 16 + 4 bytes
+        const uint32_t message_size = sizeof(message) - 1;
+        std::vector<uint8_t> packet(std::begin("#bundle"), std::end("#bundle"));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            packet.push_back(static_cast<uint8_t>(timetag >> shift));
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            packet.push_back(static_cast<uint8_t>(message_size >> shift));
+        }
+        packet.insert(packet.end(), message, message + message_size);
+
+        // The server initialised the socket library in start()
+        const auto send_packet = [&](const std::vector<uint8_t>& bytes) {
+            const auto sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(server.get_port()));
+            inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+            sendto(sender, reinterpret_cast<const char*>(bytes.data()), static_cast<int>(bytes.size()), 0,
+                reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+#ifdef _WIN32
+            closesocket(sender);
+#else
+            close(sender);
+#endif
+        };
+        send_packet(packet);
+
+        for (int i = 0; i < 200 && server.get_stats().messages_dispatched == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert_test("Bundle dispatched", server.get_stats().messages_dispatched == 1);
+
+        // Same anchor the server used: nothing rendered since the bundle arrived
+        const int64_t expected = audio_core->get_sample_time(steady_now + lead);
+        int64_t onset = -1;
+        for (int64_t block_start = block_size; onset < 0 && block_start < expected + 4 * block_size; block_start += block_size) {
+            audio_core->render_offline(inputs, outputs, block_size);
+            for (int i = 0; i < block_size && onset < 0; ++i) {
+                if (outputs[0][i] != 0.0f || outputs[1][i] != 0.0f) {
+                    onset = block_start + i;
+                }
+            }
+        }
+
+        // The tone fades in from an exact zero, so its first audible frame is its second
+        std::cout << "  Timetag sample " << expected << ", first audible sample " << onset << "\n";
+        assert_test("Bundle lands inside its block", onset >= 0 && (expected % block_size == 0 || onset % block_size != 0));
+        assert_test("Bundle lands on its sample", onset >= 0 && std::abs((onset - 1) - expected) <= 2);
+
+        // An hour ahead is past the schedule horizon: dropped, not scheduled
+        const uint64_t far_timetag = timetag + (3600ULL << 32);
+        for (int i = 0; i < 8; ++i) {
+            packet[8 + i] = static_cast<uint8_t>(far_timetag >> (56 - 8 * i));
+        }
+        const OscServerStats before = server.get_stats();
+        send_packet(packet);
+        for (int i = 0; i < 200 && server.get_stats().packets_malformed == before.packets_malformed; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const OscServerStats after = server.get_stats();
+        assert_test("Far-future bundle counted as malformed", after.packets_malformed == before.packets_malformed + 1);
+        assert_test("Far-future bundle not scheduled", after.messages_dispatched == before.messages_dispatched
+            && after.bundles_scheduled == before.bundles_scheduled);
+
+        server.stop();
+        audio_core->shutdown();
+        std::cout << "\n";
+    }
+
+    void test_midi_trigger_timing() {
+        std::cout << "Test 13: MIDI Trigger Timing\n";
+        std::cout << "----------------------------\n";
+
+        const int block_size = 256;
+        const int sample_rate = 48000;
+        auto audio_core = create_audio_core();
+        AudioSettings settings;
+        settings.offline = true;
+        settings.sample_rate = sample_rate;
+        settings.buffer_size = block_size;
+        settings.input_channels = 0;
+        settings.output_channels = 2;
+        assert_test("Offline engine for MIDI timing", audio_core->initialize(settings));
+
+        // One cue per side, so each onset can be found on its own channel
+        auto* cue_manager = audio_core->get_cue_manager();
+        assert_test("Cue loading for MIDI timing", cue_manager->load_audio_cue("midi_left", "test_440.wav")
+            && cue_manager->load_audio_cue("midi_right", "test_440.wav"));
+        cue_manager->set_cue_pan("midi_left", -1.0f);
+        cue_manager->set_cue_pan("midi_right", 1.0f);
+
+        MidiTriggerInput midi(audio_core.get());
+        MidiTriggerMap mappings;
+        mappings.notes.push_back({ 1, 60, "midi_left", false });
+        mappings.notes.push_back({ 1, 62, "midi_right", false });
+        midi.set_mappings(mappings);
+
+        AudioBuffer inputs;
+        AudioBuffer outputs;
+        audio_core->render_offline(inputs, outputs, block_size);
+
+        // Scripted sender: two note-ons 1 ms apart by their driver timestamps,
+        // delivered back to back. Latency stays 0, the minimum still applies.
+        // Offline rendering outruns the clock, so the timestamps sit past the
+        // next block rather than at now.
+        const auto event_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+        const auto spacing = std::chrono::milliseconds(1);
+        const uint8_t note_left[] = { 0x90, 60, 100 };
+        const uint8_t note_right[] = { 0x90, 62, 100 };
+        midi.handle_message(note_left, sizeof(note_left), event_time);
+        midi.handle_message(note_right, sizeof(note_right), event_time + spacing);
+        assert_test("Both notes dispatched", midi.get_stats().commands_dispatched == 2);
+
+        const auto latency = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(MidiTriggerInput::kMinSchedulingLatencyMs));
+        const int64_t expected_left = audio_core->get_sample_time(event_time + latency);
+        const int64_t expected_right = audio_core->get_sample_time(event_time + spacing + latency);
+
+        int64_t onset_left = -1;
+        int64_t onset_right = -1;
+        for (int64_t block_start = block_size; block_start < expected_right + 4 * block_size; block_start += block_size) {
+            audio_core->render_offline(inputs, outputs, block_size);
+            for (int i = 0; i < block_size; ++i) {
+                if (onset_left < 0 && outputs[0][i] != 0.0f) {
+                    onset_left = block_start + i;
+                }
+                if (onset_right < 0 && outputs[1][i] != 0.0f) {
+                    onset_right = block_start + i;
+                }
+            }
+        }
+
+        // The tone fades in from an exact zero, so its first audible frame is its second
+        std::cout << "  Stamped samples " << expected_left << " / " << expected_right
+            << ", first audible " << onset_left << " / " << onset_right << "\n";
+        assert_test("First note lands on its sample", onset_left == expected_left + 1);
+        assert_test("Second note lands on its sample", onset_right == expected_right + 1);
+        assert_test("Event spacing survives", onset_right - onset_left == sample_rate / 1000);
+
+        // MSC STOP for cue 7 in different command formats: sound, lighting, all types
+        mappings.msc_cues.push_back({ "7", "midi_left" });
+        midi.set_mappings(mappings);
+        auto msc_stop = [&](uint8_t format) {
+            const uint8_t message[] = { 0xF0, 0x7F, 0x7F, 0x02, format, 0x02, '7', 0xF7 };
+            const uint64_t before = midi.get_stats().commands_dispatched;
+            midi.handle_message(message, sizeof(message), std::chrono::steady_clock::now());
+            return midi.get_stats().commands_dispatched > before;
+        };
+        assert_test("MSC sound format accepted", msc_stop(0x10) && msc_stop(0x1F));
+        assert_test("MSC lighting format ignored", !msc_stop(0x01));
+        assert_test("MSC all-types accepted", msc_stop(0x7F));
+        mappings.msc_command_format = 0x11;
+        midi.set_mappings(mappings);
+        assert_test("MSC format pinned by the map", msc_stop(0x11) && !msc_stop(0x10));
+
+        audio_core->shutdown();
+        std::cout << "\n";
+    }
+
+    void test_command_queue_order() {
+        std::cout << "Test 14: Command Queue Order and Coalescing\n";
+        std::cout << "--------------------------------------------\n";
+
+        auto make = [](AudioThreadMessage::Type type, const char* cue_id, float value) {
+            AudioThreadMessage msg;
+            msg.type = type;
+            std::strncpy(msg.cue_id, cue_id, sizeof(msg.cue_id) - 1);
+            msg.param1.float_value = value;
+            return msg;
+        };
+
+        // A fader drag folds into the one message in flight
+        AudioCommandQueue queue;
+        AudioThreadMessage msg;
+        queue.push(make(AudioThreadMessage::START_CUE, "a", 0.0f));
+        queue.push(make(AudioThreadMessage::SET_VOLUME, "a", 0.1f));
+        queue.push(make(AudioThreadMessage::SET_VOLUME, "a", 0.2f));
+        queue.push(make(AudioThreadMessage::SET_VOLUME, "a", 0.3f));
+        bool ordered = queue.pop(msg) && msg.type == AudioThreadMessage::START_CUE;
+        ordered = ordered && queue.pop(msg) && msg.type == AudioThreadMessage::SET_VOLUME && msg.param1.float_value == 0.3f;
+        assert_test("Volume changes coalesce behind the start", ordered && !queue.pop(msg));
+        assert_test("Coalesced count", queue.get_stats().coalesced == 2);
+
+        // A transport command is a barrier: later values never fold into an
+        // earlier message
+        queue.push(make(AudioThreadMessage::SET_VOLUME, "a", 0.4f));
+        queue.push(make(AudioThreadMessage::STOP_CUE, "a", 0.0f));
+        queue.push(make(AudioThreadMessage::SET_VOLUME, "a", 0.5f));
+        ordered = queue.pop(msg) && msg.type == AudioThreadMessage::SET_VOLUME && msg.param1.float_value == 0.4f;
+        ordered = ordered && queue.pop(msg) && msg.type == AudioThreadMessage::STOP_CUE;
+        ordered = ordered && queue.pop(msg) && msg.type == AudioThreadMessage::SET_VOLUME && msg.param1.float_value == 0.5f;
+        assert_test("No coalescing across a transport command", ordered && !queue.pop(msg));
+
+        // Concurrent producer and consumer: each volume change is pushed right
+        // after a start carrying the same index and must never overtake it.
+        // The producer stays within the critical lane's capacity.
+        const int kPushes = 20000;
+        const char* cue_ids[] = { "q0", "q1", "q2", "q3" };
+        std::atomic<bool> producing{ true };
+        std::atomic<int> consumed{ 0 };
+        std::thread producer([&] {
+            for (int i = 0; i < kPushes; ++i) {
+                while (2 * i - consumed.load() > 32) {
+                    std::this_thread::yield();
+                }
+                const char* cue_id = cue_ids[i % 4];
+                while (!queue.push(make(AudioThreadMessage::START_CUE, cue_id, static_cast<float>(i)))) {
+                    std::this_thread::yield();
+                }
+                while (!queue.push(make(AudioThreadMessage::SET_VOLUME, cue_id, static_cast<float>(i)))) {
+                    std::this_thread::yield();
+                }
+            }
+            producing.store(false);
+        });
+
+        float last_start[4] = { -1.0f, -1.0f, -1.0f, -1.0f };
+        int overtaken = 0;
+        int volumes = 0;
+        for (;;) {
+            const bool done = !producing.load();
+            while (queue.pop(msg)) {
+                consumed.fetch_add(1);
+                const int cue = msg.cue_id[1] - '0';
+                if (msg.type == AudioThreadMessage::START_CUE) {
+                    last_start[cue] = msg.param1.float_value;
+                }
+                else {
+                    ++volumes;
+                    overtaken += last_start[cue] != msg.param1.float_value;
+                }
+            }
+            if (done) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        producer.join();
+        std::cout << "  " << volumes << " volume changes, " << overtaken << " ahead of their start\n";
+        assert_test("Volume never overtakes the start pushed before it", overtaken == 0);
+        assert_test("Every volume change delivered", volumes == kPushes);
+
+        std::cout << "\n";
+    }
+
+    // 16-bit stereo WAV: tone, digital silence, tone (the silent run spans whole blocks)
+    static bool write_gapped_wav(const char* path, int sample_rate) {
+        const int tone_frames = sample_rate / 4;
+        const int silence_frames = sample_rate / 2 + 77;
+        const int frames = tone_frames * 2 + silence_frames;
+        std::vector<int16_t> samples(static_cast<size_t>(frames) * 2, 0);
+        for (int i = 0; i < frames; ++i) {
+            if (i >= tone_frames && i < tone_frames + silence_frames) {
+                continue;
+            }
+            const double phase = 2.0 * 3.14159265358979 * 440.0 * i / sample_rate;
+            samples[i * 2] = static_cast<int16_t>(std::lround(12000.0 * std::sin(phase)));
+            samples[i * 2 + 1] = static_cast<int16_t>(std::lround(-9000.0 * std::sin(phase)));
+        }
+
+        FILE* file = std::fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        auto put32 = [&](uint32_t v) { std::fwrite(&v, 4, 1, file); };
+        auto put16 = [&](uint16_t v) { std::fwrite(&v, 2, 1, file); };
+        const uint32_t data_bytes = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+        std::fwrite("RIFF", 1, 4, file);
+        put32(36 + data_bytes);
+        std::fwrite("WAVEfmt ", 1, 8, file);
+        put32(16);
+        put16(1);
+        put16(2);
+        put32(static_cast<uint32_t>(sample_rate));
+        put32(static_cast<uint32_t>(sample_rate * 4));
+        put16(4);
+        put16(16);
+        std::fwrite("data", 1, 4, file);
+        put32(data_bytes);
+        std::fwrite(samples.data(), sizeof(int16_t), samples.size(), file);
+        return std::fclose(file) == 0;
+    }
+
+    void test_silent_block_skipping() {
+        std::cout << "Test 15: Silent Block Skipping\n";
+        std::cout << "------------------------------\n";
+
+        const int block_size = 256;
+        const char* path = "test_gapped.wav";
+        assert_test("Gapped WAV written", write_gapped_wav(path, 48000));
+
+        // Same cue in two managers: one skips silent blocks, one renders them
+        CueAudioManager skipping;
+        CueAudioManager rendering;
+        rendering.set_silence_skipping(false);
+        bool ready = true;
+        for (CueAudioManager* manager : { &skipping, &rendering }) {
+            ready = ready && manager->initialize(48000, block_size)
+                && manager->load_audio_cue("gap", path)
+                && manager->set_cue_loop("gap", true)
+                && manager->start_cue("gap");
+        }
+        assert_test("Both managers playing", ready);
+
+        AudioBuffer inputs;
+        AudioBuffer skipped(2, std::vector<float>(block_size));
+        AudioBuffer rendered(2, std::vector<float>(block_size));
+        int mismatched_blocks = 0;
+        int silent_blocks = 0;
+        // Three passes through the file, across the loop point
+        const int num_blocks = (48000 + 48000 / 2 + 77) * 3 / block_size;
+        for (int block = 0; block < num_blocks; ++block) {
+            if (block == num_blocks / 2) {
+                skipping.set_cue_volume("gap", 0.5f);
+                rendering.set_cue_volume("gap", 0.5f);
+            }
+            for (int ch = 0; ch < 2; ++ch) {
+                std::fill(skipped[ch].begin(), skipped[ch].end(), 0.0f);
+                std::fill(rendered[ch].begin(), rendered[ch].end(), 0.0f);
+            }
+            skipping.process_audio(inputs, skipped, block_size);
+            rendering.process_audio(inputs, rendered, block_size);
+
+            bool silent = true;
+            for (int ch = 0; ch < 2; ++ch) {
+                mismatched_blocks += std::memcmp(skipped[ch].data(), rendered[ch].data(), block_size * sizeof(float)) != 0;
+                for (float sample : rendered[ch]) {
+                    silent = silent && sample == 0.0f;
+                }
+            }
+            silent_blocks += silent;
+        }
+        std::cout << "  " << silent_blocks << " of " << num_blocks << " blocks silent\n";
+        assert_test("Silent region reached", silent_blocks > 0);
+        // The tone after each gap only lines up if skipping advanced the position exactly
+        assert_test("Skipped output matches rendered output", mismatched_blocks == 0);
+
+        skipping.shutdown();
+        rendering.shutdown();
+        std::remove(path);
+        std::cout << "\n";
+    }
+
+    void test_arena_compaction_under_readers() {
+        std::cout << "Test 16: Arena Compaction Under Readers\n";
+        std::cout << "---------------------------------------\n";
+
+        // Four slabs of 256 KiB blocks, each filled with its own index,
+        // then three in four freed
+        constexpr size_t kBlockWords = 64 * 1024;
+        SampleArena arena(SampleArena::kHugePageBytes);
+        std::vector<SampleArena::Handle> stored;
+        std::vector<uint32_t> words(kBlockWords);
+        for (uint32_t i = 0; i < 32; ++i) {
+            std::fill(words.begin(), words.end(), i);
+            stored.push_back(arena.store(words.data(), words.size() * sizeof(uint32_t)));
+        }
+        std::vector<SampleArena::Handle> kept;
+        std::vector<uint32_t> kept_values;
+        for (uint32_t i = 0; i < 32; ++i) {
+            if (i % 4 == 0) {
+                kept.push_back(stored[i]);
+                kept_values.push_back(i);
+            }
+            else {
+                arena.free(stored[i]);
+            }
+        }
+        assert_test("Arena fragmented", arena.should_compact());
+
+        // The reader always holds at least one guard: the next one is taken
+        // before the previous one is dropped, like back-to-back audio blocks
+        std::atomic<bool> stop{ false };
+        std::atomic<int> checks{ 0 };
+        std::atomic<int> corrupt{ 0 };
+        std::thread reader([&] {
+            std::optional<SampleArena::ReadGuard> guards[2];
+            guards[0].emplace(arena);
+            for (int turn = 1; !stop.load(); ++turn) {
+                guards[turn & 1].emplace(arena);
+                guards[(turn - 1) & 1].reset();
+                for (size_t i = 0; i < kept.size(); ++i) {
+                    const uint32_t* data = reinterpret_cast<const uint32_t*>(SampleArena::resolve(kept[i]));
+                    if (data[0] != kept_values[i] || data[kBlockWords - 1] != kept_values[i]) {
+                        corrupt.fetch_add(1);
+                    }
+                }
+                checks.fetch_add(1);
+                std::this_thread::yield();
+            }
+        });
+
+        std::vector<const uint8_t*> before;
+        {
+            SampleArena::ReadGuard guard(arena);
+            for (SampleArena::Handle handle : kept) {
+                before.push_back(SampleArena::resolve(handle));
+            }
+        }
+
+        auto compaction = std::async(std::launch::async, [&] { return arena.compact(); });
+        const bool finished = compaction.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        const int checks_at_finish = checks.load();
+        stop.store(true); // Lets a stuck compaction through, so the test reports instead of hanging
+        const size_t moved = compaction.get();
+        reader.join();
+
+        int relocated = 0;
+        {
+            SampleArena::ReadGuard guard(arena);
+            for (size_t i = 0; i < kept.size(); ++i) {
+                relocated += SampleArena::resolve(kept[i]) != before[i];
+            }
+        }
+        std::cout << "  moved " << (moved >> 10) << " KiB, " << relocated << " blocks relocated, "
+            << checks_at_finish << " reader passes\n";
+        assert_test("Compaction finishes while a guard is always held", finished);
+        assert_test("Blocks moved", moved > 0 && relocated > 0);
+        assert_test("Reader never saw freed or torn data", corrupt.load() == 0);
+        assert_test("Slabs returned to the OS", arena.get_stats().num_slabs < 4);
+
+        for (SampleArena::Handle handle : kept) {
+            arena.free(handle);
+        }
+        std::cout << "\n";
+    }
+
+    void test_recorder_dropouts() {
+        std::cout << "Test 17: Recorder Dropouts Keep Time\n";
+        std::cout << "------------------------------------\n";
+
+        const int block_size = 256;
+        const int blocks_per_burst = 200;
+        auto ramp = [](long frame, int channel) { return ((frame + channel) % 1000 + 1) / 1000.0f; }; // Never zero
+
+        MultitrackRecorder recorder;
+        recorder.initialize(48000, 2, 0);
+        RecordingSettings settings;
+        settings.take_name = "dropout_test";
+        settings.file_format = RecordingFileFormat::WAV;
+        settings.record_outputs = false;
+        settings.ring_seconds = 0.0; // Smallest ring, so bursts overflow it
+        settings.preallocate_minutes = 1.0;
+        assert_test("Recording starts", recorder.start_recording(settings));
+
+        // Two bursts far faster than the writer drains, with a pause between
+        // so the first burst's gap closes mid-take
+        AudioBuffer inputs(2, std::vector<float>(block_size));
+        AudioBuffer outputs;
+        long frame = 0;
+        for (int burst = 0; burst < 2; ++burst) {
+            for (int b = 0; b < blocks_per_burst; ++b) {
+                for (int i = 0; i < block_size; ++i, ++frame) {
+                    inputs[0][i] = ramp(frame, 0);
+                    inputs[1][i] = ramp(frame, 1);
+                }
+                recorder.process(inputs, outputs, block_size);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        recorder.stop_recording();
+
+        const RecordingStatus status = recorder.get_status();
+        assert_test("One stream", status.streams.size() == 1);
+        if (status.streams.size() != 1) {
+            std::cout << "\n";
+            return;
+        }
+        const RecordingStreamStatus& stream = status.streams[0];
+        uint64_t dropout_frames = 0;
+        for (const RecordingDropout& dropout : stream.dropouts) {
+            dropout_frames += dropout.frames;
+        }
+        std::cout << "  " << stream.dropped_frames << " frames dropped in " << stream.dropouts.size() << " dropouts\n";
+        assert_test("Ring overflowed", stream.dropped_frames > 0);
+        assert_test("Every dropped frame has a position", dropout_frames == stream.dropped_frames);
+        assert_test("Take keeps its length", stream.frames_written == static_cast<uint64_t>(frame));
+
+        // Every frame is either its own sample or inside a dropout, and silent
+        std::vector<float> data(static_cast<size_t>(frame) * 2);
+        FILE* file = std::fopen(stream.file_path.c_str(), "rb");
+        const bool read_back = file != nullptr && std::fseek(file, static_cast<long>(kRecordingHeaderBytes), SEEK_SET) == 0
+            && std::fread(data.data(), sizeof(float), data.size(), file) == data.size();
+        if (file) std::fclose(file);
+        assert_test("Take reads back", read_back);
+
+        bool in_time = read_back;
+        for (long f = 0; f < frame && in_time; ++f) {
+            bool silent = false;
+            for (const RecordingDropout& dropout : stream.dropouts) {
+                silent |= static_cast<uint64_t>(f) >= dropout.frame && static_cast<uint64_t>(f) < dropout.frame + dropout.frames;
+            }
+            for (int ch = 0; ch < 2; ++ch) {
+                in_time &= data[f * 2 + ch] == (silent ? 0.0f : ramp(f, ch));
+            }
+        }
+        assert_test("Audio after each dropout stays on its frame", in_time);
+
+        std::remove(stream.file_path.c_str());
+        std::cout << "\n";
+    }
+
+    void test_lossless_codec_round_trip() {
+        std::cout << "Test 18: Lossless Codec Round Trip\n";
+        std::cout << "----------------------------------\n";
+
+        for (int bits : { 16, 24 }) {
+            const int full = 1 << (bits - 1);
+            const std::string depth = std::to_string(bits) + "-bit ";
+            std::mt19937 rng(bits);
+            std::uniform_int_distribution<int> any_value(-full, full - 1);
+            std::uniform_int_distribution<int> step(-300, 300);
+
+            // One block per case, then a partial block of noise
+            std::vector<int32_t> values;
+            auto add_block = [&](auto&& generate) {
+                for (int n = 0; n < kCompressedBlockFrames; ++n) {
+                    values.push_back(generate(n));
+                }
+            };
+            int walk = 0;
+            add_block([&](int) { return any_value(rng); });                          // Order 0: white noise
+            add_block([&](int) { walk = std::max(-full, std::min(full - 1, walk + step(rng))); return walk; }); // Order 1
+            add_block([&](int n) { return static_cast<int32_t>(std::lround(0.9 * full * std::sin(n * 0.0003))); }); // Order 2
+            add_block([&](int n) { return static_cast<int32_t>(std::lround(0.9 * full * std::sin(n * 0.05))); });   // Order 3
+            add_block([&](int n) { return n % 2 ? full - 1 : -full; });             // Largest zigzag residuals
+            add_block([&](int n) { return n < kCompressedBlockFrames / 2 ? full - 1 : -full; });
+            add_block([](int) { return 0; });                                        // Zero-width sub-blocks
+            for (int n = 0; n < 37; ++n) {
+                values.push_back(any_value(rng));
+            }
+
+            std::vector<float> samples(values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                samples[i] = static_cast<float>(values[i]) / static_cast<float>(full);
+            }
+            SampleChannel channel;
+            channel.encode(samples.data(), samples.size(), SampleFormat::COMPRESSED);
+            SampleArena::ReadGuard guard(*channel.get_arena());
+
+            bool orders = channel.get_num_blocks() == 8;
+            for (int block = 0; orders && block < 4; ++block) {
+                orders = channel.get_block_order(block) == block;
+            }
+            assert_test(depth + "cases pick predictor orders 0-3", orders);
+
+            std::vector<float> decoded(samples.size());
+            channel.read(0, static_cast<int>(samples.size()), decoded.data());
+            assert_test(depth + "whole channel decodes bit-exact",
+                std::memcmp(decoded.data(), samples.data(), samples.size() * sizeof(float)) == 0);
+
+            // Play-head reads: block crossings, spans straddling two blocks, and jumps
+            SampleReader reader;
+            reader.attach(&channel);
+            std::vector<float> scratch(kCompressedBlockFrames);
+            bool streamed = true;
+            size_t position = 0;
+            for (int call = 0; call < 400; ++call) {
+                const int count = call % 3 == 0 ? 300 : 256;
+                if (call == 150 || call == 300) {
+                    position = static_cast<size_t>(rng() % (samples.size() - count)); // Seek
+                }
+                if (position + count > samples.size()) {
+                    position = 0; // Loop
+                }
+                const float* span = reader.view(position, count, scratch.data());
+                streamed &= std::memcmp(span, samples.data() + position, count * sizeof(float)) == 0;
+                position += count;
+            }
+            assert_test(depth + "reader with decode-ahead matches the source", streamed);
+        }
+
+        // Shorter than one sub-block
+        const float tiny[] = { 0.5f, -1.0f, 32767.0f / 32768.0f, 0.0f, -0.25f };
+        SampleChannel channel;
+        channel.encode(tiny, 5, SampleFormat::COMPRESSED);
+        SampleArena::ReadGuard guard(*channel.get_arena());
+        float decoded[5];
+        channel.read(0, 5, decoded);
+        assert_test("5-sample channel decodes bit-exact", std::memcmp(decoded, tiny, sizeof(tiny)) == 0);
+        std::cout << "\n";
+    }
+
+    void test_compact_formats_mix_exact() {
+        std::cout << "Test 19: Compact Formats Mix Bit-Exact\n";
+        std::cout << "--------------------------------------\n";
+
+        const int block_size = 256;
+        const char* path = "test_formats.wav";
+        assert_test("16-bit WAV written", write_gapped_wav(path, 48000));
+
+        // Same 16-bit file stored as float (reference), int16, half-float policy and compressed
+        const SampleStoragePolicy policies[] = { SampleStoragePolicy::FLOAT32, SampleStoragePolicy::LOSSLESS,
+            SampleStoragePolicy::HALF_FLOAT, SampleStoragePolicy::COMPRESSED };
+        const SampleFormat expected[] = { SampleFormat::FLOAT32, SampleFormat::INT16,
+            SampleFormat::INT16, SampleFormat::COMPRESSED };
+        std::vector<std::unique_ptr<CueAudioManager>> managers;
+        bool ready = true;
+        bool formats = true;
+        for (int m = 0; m < 4; ++m) {
+            managers.push_back(std::make_unique<CueAudioManager>());
+            CueAudioManager& manager = *managers.back();
+            ready = ready && manager.initialize(48000, block_size);
+            manager.get_asset_cache()->set_storage_policy(policies[m]);
+            ready = ready && manager.load_audio_cue("fmt", path) && manager.set_cue_loop("fmt", true)
+                && manager.set_cue_pan("fmt", -0.4f) && manager.start_cue("fmt");
+            auto asset = manager.get_asset_cache()->find(path);
+            formats = formats && asset && asset->metadata.storage_format == expected[m];
+        }
+        assert_test("Managers playing", ready);
+        assert_test("Stored as float, int16, int16 and compressed", formats);
+
+        // Steady gain, a volume ramp, a seek and loop wraps, block by block
+        AudioBuffer inputs;
+        std::vector<AudioBuffer> outputs(4, AudioBuffer(2, std::vector<float>(block_size)));
+        int mismatched_blocks = 0;
+        for (int block = 0; block < 600; ++block) {
+            for (auto& manager : managers) {
+                if (block == 40) manager->set_cue_volume("fmt", 0.6f);
+                if (block == 120) manager->seek_cue("fmt", 0.3);
+            }
+            for (int m = 0; m < 4; ++m) {
+                for (auto& channel : outputs[m]) std::fill(channel.begin(), channel.end(), 0.0f);
+                managers[m]->process_audio(inputs, outputs[m], block_size);
+            }
+            bool same = true;
+            for (int m = 1; m < 4; ++m) {
+                for (int ch = 0; ch < 2; ++ch) {
+                    same &= std::memcmp(outputs[m][ch].data(), outputs[0][ch].data(), block_size * sizeof(float)) == 0;
+                }
+            }
+            mismatched_blocks += !same;
+        }
+        assert_test("16-bit sources mix bit-exact against float", mismatched_blocks == 0);
+
+        for (auto& manager : managers) manager->shutdown();
+        std::remove(path);
+        std::cout << "\n";
+    }
+
+    void test_block_boundary_retire() {
+        std::cout << "Test 20: Block Boundary Retire Queue\n";
+        std::cout << "------------------------------------\n";
+
+        BlockBoundary boundary;
+        assert_test("Idle audio thread passes at once", boundary.wait(std::chrono::milliseconds(10)));
+
+        // Audio thread stalls inside a block while something is detached
+        std::atomic<bool> release{ false };
+        std::atomic<bool> entered{ false };
+        std::thread audio([&]() {
+            boundary.enter();
+            entered.store(true);
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            boundary.leave();
+        });
+        while (!entered.load()) {
+            std::this_thread::yield();
+        }
+
+        auto garbage = std::make_shared<std::vector<float>>(1024, 1.0f);
+        std::weak_ptr<std::vector<float>> watch = garbage;
+        const bool passed = boundary.wait(std::chrono::milliseconds(20));
+        assert_test("Stalled block times out", !passed);
+        boundary.retire(std::move(garbage));
+        boundary.collect();
+        assert_test("Retired object kept while the block runs", !watch.expired() && boundary.get_num_retired() == 1);
+
+        release.store(true);
+        audio.join();
+        assert_test("Next wait passes", boundary.wait(std::chrono::milliseconds(10)));
+        assert_test("Retired object freed after the block", watch.expired() && boundary.get_num_retired() == 0);
+        std::cout << "\n";
+    }
+
+    void test_metering_cost() {
+        std::cout << "Test 21: Metering Cost at 96 Channels\n";
+        std::cout << "-------------------------------------\n";
+
+        // Same work the mix pass does per channel, with and without meters
+        const int num_channels = 96;
+        const int block_size = 128;
+        const int num_blocks = 4000;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        AudioBuffer sources(num_channels, std::vector<float>(block_size));
+        AudioBuffer mix(num_channels, std::vector<float>(block_size, 0.0f));
+        for (auto& channel : sources) {
+            for (auto& sample : channel) sample = noise(rng);
+        }
+
+        MeterBank bank;
+        bank.prepare(num_channels, true);
+        std::vector<MeterValues> values;
+        auto run = [&](bool meter) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int block = 0; block < num_blocks; ++block) {
+                if (meter) bank.begin_block();
+                for (int ch = 0; ch < num_channels; ++ch) {
+                    if (meter) {
+                        mix_and_measure(sources[ch].data(), mix[ch].data(), 0.5f, 0.5f, block_size, bank.accumulator(ch));
+                        bank.measure_true_peak(ch, sources[ch].data(), block_size, 0.5f);
+                    }
+                    else {
+                        for (int i = 0; i < block_size; ++i) mix[ch][i] += sources[ch][i] * 0.5f;
+                    }
+                }
+                if (meter) bank.publish();
+                if (meter && block % 12 == 0) bank.read(values); // ~30 Hz UI poll
+            }
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / num_blocks;
+        };
+        run(true);
+        run(false);
+        const double metered_us = run(true);
+        const double plain_us = run(false);
+
+        const auto publish_start = std::chrono::steady_clock::now();
+        for (int block = 0; block < num_blocks; ++block) bank.publish();
+        const double publish_us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - publish_start).count() / num_blocks;
+
+        const double block_us = 1.0e6 * block_size / 48000.0;
+        const double cost_percent = 100.0 * std::max(0.0, metered_us - plain_us) / block_us;
+        std::cout << "  Metering: " << metered_us - plain_us << " us per block (" << cost_percent
+            << "% of the " << block_us << " us block at 48 kHz)\n";
+        std::cout << "  Snapshot publish: " << publish_us << " us per block\n";
+        assert_test("Meters read back", values.size() == static_cast<size_t>(num_channels));
+#ifdef NDEBUG
+        assert_test("Metering under 2% of the block", cost_percent < 2.0);
+#else
+        std::cout << "  (2% budget checked in release builds only)\n";
+#endif
+        std::cout << "\n";
+    }
+
+    void test_plugin_delay_compensation() {
+        std::cout << "Test 22: Plugin Delay Compensation\n";
+        std::cout << "----------------------------------\n";
+
+        // Plugins can't be loaded without a host, so a delay line at the
+        // plugin's latency stands in for the latent insert. The other paths
+        // are the compensation and latency-matched bypass lines the mix
+        // graph and plugin host put around it.
+        const int latency = 100; // Deliberately not a multiple of the block size
+        const int block_size = 64;
+        const int num_blocks = 12;
+        const int max_delay = std::max(64, latency * 2);
+
+        DelayLinePool pool;
+        pool.prepare(3, max_delay, block_size);
+        DelayLine* plugin = pool.acquire();
+        DelayLine* bypass = pool.acquire();
+        DelayLine* compensation = pool.acquire();
+        plugin->set_delay(latency);
+        compensation->set_delay(latency);
+        assert_test("Pool hands out every line", plugin && bypass && compensation && pool.get_num_free() == 0);
+
+        // Impulse at sample 10 through the latent and compensated paths
+        const int impulse_at = 10;
+        std::vector<float> latent_out;
+        std::vector<float> dry_out;
+        std::vector<float> block(block_size);
+        for (int b = 0; b < num_blocks; ++b) {
+            for (int i = 0; i < block_size; ++i) block[i] = (b * block_size + i == impulse_at) ? 1.0f : 0.0f;
+            std::vector<float> dry = block;
+            plugin->process(block.data(), block_size);
+            compensation->process(dry.data(), block_size);
+            latent_out.insert(latent_out.end(), block.begin(), block.end());
+            dry_out.insert(dry_out.end(), dry.begin(), dry.end());
+        }
+        const auto peak_at = [](const std::vector<float>& v) {
+            return static_cast<int>(std::max_element(v.begin(), v.end()) - v.begin());
+        };
+        assert_test("Latent path delays by its latency across blocks", peak_at(latent_out) == impulse_at + latency);
+        assert_test("Compensated dry path lines up with it", peak_at(dry_out) == peak_at(latent_out) && dry_out == latent_out);
+
+        // Switching the plugin to bypass keeps a ramp continuous when the
+        // bypass line carries the same latency
+        plugin->reset();
+        bypass->reset();
+        plugin->set_delay(latency);
+        bypass->set_delay(latency);
+        std::vector<float> ramp_out;
+        for (int b = 0; b < num_blocks; ++b) {
+            for (int i = 0; i < block_size; ++i) block[i] = static_cast<float>(b * block_size + i);
+            std::vector<float> dry = block;
+            plugin->process(block.data(), block_size); // Runs either way, like the host
+            bypass->process(dry.data(), block_size);
+            const std::vector<float>& out = (b < num_blocks / 2) ? block : dry;
+            ramp_out.insert(ramp_out.end(), out.begin(), out.end());
+        }
+        bool aligned = true;
+        for (int n = latency; n < static_cast<int>(ramp_out.size()); ++n) {
+            aligned = aligned && ramp_out[n] == static_cast<float>(n - latency);
+        }
+        assert_test("Bypass keeps the path latency", aligned);
+
+        // A latency change crossfades over one block and is exact after it
+        compensation->reset();
+        compensation->set_delay(latency);
+        for (int i = 0; i < block_size; ++i) block[i] = 0.0f;
+        for (int b = 0; b < 4; ++b) compensation->process(block.data(), block_size);
+        compensation->set_delay(latency / 2);
+        std::vector<float> settled;
+        for (int b = 0; b < 3; ++b) {
+            for (int i = 0; i < block_size; ++i) block[i] = static_cast<float>(1000 + b * block_size + i);
+            compensation->process(block.data(), block_size);
+            if (b > 0) settled.insert(settled.end(), block.begin(), block.end());
+        }
+        bool exact = true;
+        for (int i = latency / 2; i < static_cast<int>(settled.size()); ++i) {
+            exact = exact && settled[i] == static_cast<float>(1000 + block_size + i - latency / 2);
+        }
+        assert_test("Retarget settles after one block", compensation->get_delay() == latency / 2 && exact);
+
+        compensation->set_delay(max_delay + 1000);
+        assert_test("Delay beyond the line clamps to its maximum", compensation->get_delay() == max_delay);
+
+        pool.release(plugin);
+        pool.release(bypass);
+        pool.release(compensation);
+        assert_test("Lines return to the pool", pool.get_num_free() == 3);
+        std::cout << "\n";
+    }
+
+    void test_scene_voice_lookup() {
+        std::cout << "Test 23: Scene Recall Voice Lookup\n";
+        std::cout << "----------------------------------\n";
+
+        const int block_size = 256;
+        const char* path = "test_scene.wav";
+        assert_test("16-bit WAV written", write_gapped_wav(path, 48000));
+
+        CueAudioManager manager;
+        SceneManager scenes;
+        bool ready = manager.initialize(48000, block_size) && scenes.initialize(48000, &manager, nullptr, nullptr);
+        ready = ready && manager.load_audio_cue("a", path) && manager.load_audio_cue("b", path);
+        assert_test("Manager and scenes ready", ready);
+
+        AudioBuffer inputs;
+        AudioBuffer outputs(2, std::vector<float>(block_size));
+        const auto run_block = [&]() {
+            scenes.process(block_size);
+            manager.process_audio(inputs, outputs, block_size);
+        };
+        const auto volume_of = [&](const std::string& cue_id) {
+            const auto current = scenes.capture();
+            for (const VoiceSnapshot& voice : current->voices) {
+                if (voice.cue_id == cue_id) return voice.volume;
+            }
+            return -1.0f;
+        };
+
+        manager.set_cue_volume("a", 0.25f);
+        manager.set_cue_volume("b", 0.75f);
+        run_block();
+        auto scene = scenes.capture();
+        bool indexed = scene->voice_layout != 0 && scene->voices.size() == 2;
+        for (size_t i = 0; i < scene->voices.size(); ++i) {
+            indexed = indexed && scene->voices[i].voice_index == static_cast<int>(i);
+        }
+        assert_test("Capture records voice indices", indexed);
+
+        // Same cue set: recalled through the captured indices
+        manager.set_cue_volume("a", 1.0f);
+        manager.set_cue_volume("b", 1.0f);
+        run_block();
+        scenes.recall(scene);
+        run_block();
+        assert_test("Recall by index restores levels", volume_of("a") == 0.25f && volume_of("b") == 0.75f);
+
+        // A cue loaded since the capture: the indices are stale, ids still work
+        ready = manager.load_audio_cue("0", path); // Sorts first, shifting every index
+        manager.set_cue_volume("a", 1.0f);
+        manager.set_cue_volume("b", 1.0f);
+        run_block();
+        scenes.recall(scene);
+        run_block();
+        assert_test("Recall after the cue set changed finds voices by id",
+            ready && volume_of("a") == 0.25f && volume_of("b") == 0.75f && volume_of("0") == 1.0f);
+
+        // An edited copy whose index no longer matches its id
+        auto fresh = scenes.capture();
+        auto edited = std::make_shared<SceneSnapshot>(*fresh);
+        for (VoiceSnapshot& voice : edited->voices) {
+            if (voice.cue_id == "a") voice.cue_id = "b";
+            voice.volume = voice.cue_id == "b" ? 0.5f : voice.volume;
+        }
+        scenes.recall(edited);
+        run_block();
+        assert_test("Edited copies are matched by id", volume_of("a") == 0.25f && volume_of("b") == 0.5f);
+
+        // Many recalls, each picked up by a block; every one is retired and freed
+        std::weak_ptr<const SceneSnapshot> watched = edited;
+        for (int i = 0; i < 200; ++i) {
+            scenes.recall(i % 2 ? fresh : std::shared_ptr<const SceneSnapshot>(edited));
+            run_block();
+        }
+        edited.reset();
+        run_block();
+        run_block();
+        scenes.get_scenes(); // Any control call frees retired recalls
+        assert_test("Retired recalls are freed", watched.expired());
+        assert_test("No recall leaked", scenes.get_retire_overflow_count() == 0);
+
+        manager.shutdown();
+        std::remove(path);
+        std::cout << "\n";
+    }
+
     void assert_test(const std::string& test_name, bool condition) {
         test_count_++;
         if (condition) {